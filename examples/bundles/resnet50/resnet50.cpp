@@ -14,9 +14,13 @@
  * limitations under the License.
  */
 #include <assert.h>
+#include <fcntl.h>
 #include <png.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <string>
 #include <vector>
@@ -282,34 +286,36 @@ void *alignedAlloc(const BundleConfig &config, size_t size) {
   return ptr;
 }
 
-/// Initialize the constant weights memory block by loading the weights from the
-/// weights file.
+/// Initialize the constant weights memory block by mapping the weights file
+/// into memory. The weights are only read, so the pages of the file are loaded
+/// on first use and shared by all processes that run the bundle.
 static uint8_t *initConstantWeights(const char *weightsFileName,
                                     const BundleConfig &config) {
-  // Load weights.
-  FILE *weightsFile = fopen(weightsFileName, "rb");
-  if (!weightsFile) {
+  int fd = open(weightsFileName, O_RDONLY);
+  if (fd < 0) {
     fprintf(stderr, "Could not open the weights file: %s\n", weightsFileName);
     exit(1);
   }
-  fseek(weightsFile, 0, SEEK_END);
-  size_t fileSize = ftell(weightsFile);
-  fseek(weightsFile, 0, SEEK_SET);
-  uint8_t *baseConstantWeightVarsAddr =
-      static_cast<uint8_t *>(alignedAlloc(config, fileSize));
-  printf("Allocated weights of size: %lu\n", fileSize);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    perror("Could not get the size of the weights file");
+    exit(1);
+  }
+  size_t fileSize = st.st_size;
   printf("Expected weights of size: %lu\n", config.constantWeightVarsMemSize);
   assert(fileSize == config.constantWeightVarsMemSize &&
          "Wrong weights file size");
-  int result = fread(baseConstantWeightVarsAddr, fileSize, 1, weightsFile);
-  if (result != 1) {
-    perror("Could not read the weights file");
-  } else {
-    printf("Loaded weights of size: %lu from the file %s\n", fileSize,
-           weightsFileName);
+  void *addr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    perror("Could not map the weights file");
+    exit(1);
   }
-  fclose(weightsFile);
-  return baseConstantWeightVarsAddr;
+  // Mappings start at page boundaries, which satisfies the alignment.
+  assert((size_t)addr % config.alignment == 0 && "Wrong alignment");
+  printf("Mapped weights of size: %lu from the file %s\n", fileSize,
+         weightsFileName);
+  return static_cast<uint8_t *>(addr);
 }
 
 /// The assumed layout of the area for mutable WeightVars is:
@@ -381,6 +387,6 @@ int main(int argc, char **argv) {
 
   // Free all resources.
   free(activationsAddr);
-  free(constantWeightVarsAddr);
+  munmap(constantWeightVarsAddr, resnet50_config.constantWeightVarsMemSize);
   free(mutableWeightVarsAddr);
 }
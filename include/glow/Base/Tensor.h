@@ -70,10 +70,10 @@ private:
   /// \returns a pointer to the tensor data buffer.
   char *getData() const { return data_; }
 
+public:
   /// \returns true if it is an unowned tensor.
   bool isUnowned() const { return isUnowned_; }
 
-public:
   /// \returns the type of the tensor.
   const Type &getType() const { return type_; }
 
@@ -282,6 +282,8 @@ public:
       return isEqualImpl<int32_t>(other, allowedError);
     case ElemKind::Int64ITy:
       return isEqualImpl<int64_t>(other, allowedError);
+    case ElemKind::UInt8FusedQTy:
+      return isEqualImpl<uint8_t>(other, allowedError);
     }
 
     // This is to make compiler happy. It can never reach this point as switch
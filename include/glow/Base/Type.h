@@ -185,6 +185,10 @@ enum class ElemKind : unsigned char {
   Int16QTy, // 16-bit quantized type (int16_t)
   Int32QTy, // 32-bit quantized type (int32_t)
   Int64ITy, // 64-bit index type (int64_t)
+  // 8-bit row-wise quantized type (uint8_t). The last 8 bytes of every row of
+  // the innermost dimension hold the float scale and the float offset of the
+  // row, and the value of an element q is q * scale + offset.
+  UInt8FusedQTy,
 };
 
 /// A class that represents a type of a tensor.
@@ -349,6 +353,8 @@ struct Type final {
       return std::is_same<ElemTy, int32_t>::value;
     case ElemKind::Int64ITy:
       return std::is_same<ElemTy, int64_t>::value;
+    case ElemKind::UInt8FusedQTy:
+      return std::is_same<ElemTy, uint8_t>::value;
     }
     GLOW_UNREACHABLE("Invalid type.");
   }
@@ -379,6 +385,8 @@ struct Type final {
       return sizeof(int32_t);
     case ElemKind::Int64ITy:
       return sizeof(int64_t);
+    case ElemKind::UInt8FusedQTy:
+      return sizeof(uint8_t);
     }
     GLOW_UNREACHABLE("Invalid type.");
   }
@@ -391,7 +399,7 @@ struct Type final {
   /// \return the textual name of the element \p Ty.
   static llvm::StringRef getElementName(ElemKind Ty) {
     static const char *names[] = {
-        "float", "i8", "i16", "i32", "index",
+        "float", "i8", "i16", "i32", "index", "ui8fused",
     };
     return names[(int)Ty];
   }
@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_CODEGEN_MEMORYPLANNER_H
+#define GLOW_CODEGEN_MEMORYPLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace glow {
+
+/// Assigns offsets in a memory region to buffers whose lifetimes are known in
+/// advance, such as the activations of a function. Unlike the MemoryAllocator,
+/// which places the buffers one at a time in the order of their allocation,
+/// the planner sees all of the lifetimes up front. It packs the buffers with
+/// several strategies and keeps the placement that needs the least memory.
+///
+/// The lifetime of a buffer is a closed interval of time steps, typically the
+/// positions of the instructions that allocate and deallocate the buffer. Two
+/// buffers may share memory if their lifetimes do not overlap.
+class MemoryPlanner {
+public:
+  /// Type that should be used as a handle.
+  using Handle = const void *;
+
+  /// The strategies that place the buffers.
+  enum class Strategy {
+    /// Place the buffers in the order in which they become live, at the lowest
+    /// offset where they fit. This is what the MemoryAllocator does.
+    FirstFit,
+    /// Place the buffers from the largest to the smallest one, in the smallest
+    /// gap where they fit.
+    GreedyBySize,
+    /// Visit the time steps from the one with the largest total size of live
+    /// buffers to the one with the smallest, and place the buffers that are
+    /// live at each step from the largest to the smallest one, in the
+    /// smallest gap where they fit.
+    GreedyByBreadth,
+  };
+
+  explicit MemoryPlanner(const std::string &name) : name_(name) {}
+
+  /// Add a buffer of \p size bytes associated with \p handle, which is live
+  /// from the time step \p begin up to and including the time step \p end.
+  void addBuffer(Handle handle, uint64_t size, size_t begin, size_t end);
+
+  /// Place the buffers with every strategy and keep the placement that needs
+  /// the least memory. \returns the size of the memory region.
+  uint64_t plan();
+
+  /// Place the buffers with the strategy \p strategy. \returns the size of the
+  /// memory region.
+  uint64_t plan(Strategy strategy);
+
+  /// \returns true if a buffer is associated with \p handle.
+  bool hasAddress(Handle handle) const { return handleToIdx_.count(handle); }
+
+  /// \returns the offset of the buffer associated with \p handle.
+  uint64_t getAddress(Handle handle) const;
+
+  /// \returns the size of the memory region that holds the buffers.
+  uint64_t getMemorySize() const { return memorySize_; }
+
+  /// \returns the largest total size of the buffers that are live at the same
+  /// time. No placement needs less memory.
+  uint64_t getLowerBound() const;
+
+  /// \returns the strategy of the current placement.
+  Strategy getStrategy() const { return strategy_; }
+
+  /// \returns the fraction of the memory region that is wasted compared to
+  /// the lower bound, between 0 and 1.
+  double getFragmentation() const;
+
+  /// \returns the name of the strategy \p strategy.
+  static const char *getStrategyName(Strategy strategy);
+
+  /// Print the size of the memory region, the lower bound and the
+  /// fragmentation of the current placement to \p os.
+  void dump(llvm::raw_ostream &os) const;
+
+  /// \returns the name of the memory region.
+  const std::string &getName() const { return name_; }
+
+private:
+  /// A buffer to place.
+  struct Buffer {
+    /// The handle associated with the buffer.
+    Handle handle;
+    /// The size of the buffer, aligned to hold values of any type.
+    uint64_t size;
+    /// The first time step at which the buffer is live.
+    size_t begin;
+    /// The last time step at which the buffer is live.
+    size_t end;
+  };
+
+  /// The name of the memory region.
+  std::string name_;
+  /// The buffers to place.
+  std::vector<Buffer> buffers_;
+  /// Maps handles to the indices of their buffers.
+  std::unordered_map<Handle, size_t> handleToIdx_;
+  /// The offsets of the buffers in the current placement.
+  std::vector<uint64_t> offsets_;
+  /// The size of the memory region of the current placement.
+  uint64_t memorySize_{0};
+  /// The strategy of the current placement.
+  Strategy strategy_{Strategy::FirstFit};
+
+  /// \returns the indices of the buffers in the order in which the strategy
+  /// \p strategy places them.
+  std::vector<size_t> getPlacementOrder(Strategy strategy) const;
+
+  /// Place the buffers in the order \p order. Each buffer goes into the
+  /// smallest gap between the buffers that overlap with it if \p bestFit is
+  /// true, or into the lowest one otherwise. The offsets are stored in
+  /// \p offsets. \returns the size of the memory region.
+  uint64_t place(const std::vector<size_t> &order, bool bestFit,
+                 std::vector<uint64_t> &offsets) const;
+};
+
+} // namespace glow
+
+#endif // GLOW_CODEGEN_MEMORYPLANNER_H
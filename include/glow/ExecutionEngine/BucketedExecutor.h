@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_EXECUTIONENGINE_BUCKETEDEXECUTOR_H
+#define GLOW_EXECUTIONENGINE_BUCKETEDEXECUTOR_H
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Graph/Context.h"
+#include "glow/Graph/Graph.h"
+
+#include "llvm/ADT/ArrayRef.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace glow {
+
+/// Executes a network whose inputs have dynamic dimensions, such as the batch
+/// size or the sequence length, with code that was compiled for fixed shapes.
+/// The network is specialized for a set of buckets, each of which assigns a
+/// size to every dynamic dimension. A request runs the smallest bucket that
+/// fits it: the inputs are padded with zeros up to the sizes of the bucket,
+/// and the outputs are cut back to the sizes of the request.
+///
+/// The specializations are functions of a single module, so the variables that
+/// hold the weights are shared by all of them.
+class BucketedExecutor final {
+public:
+  /// The function of a bucket, its input and output placeholders, and which of
+  /// their dimensions are dynamic.
+  struct Specialization {
+    Function *F{nullptr};
+    std::vector<Placeholder *> inputs;
+    std::vector<Placeholder *> outputs;
+    /// For every dimension of every input, the index of the dynamic dimension
+    /// that it follows, or -1 if the dimension is static.
+    std::vector<std::vector<int>> inputDims;
+    /// For every dimension of every output, the index of the dynamic
+    /// dimension that it follows, or -1 if the dimension is static.
+    std::vector<std::vector<int>> outputDims;
+  };
+
+  /// Creates the specialization for the sizes \p sizes of the dynamic
+  /// dimensions in the module \p M. The specializations of all buckets must
+  /// use the same weights, list their placeholders in the same order and
+  /// declare the same dynamic dimensions, and their functions need distinct
+  /// names. The dynamic dimensions are declared rather than derived from the
+  /// shapes, because a static dimension may have the size of a bucket, and
+  /// two dynamic dimensions may have the same size in every bucket.
+  using Builder =
+      std::function<Specialization(Module &M, llvm::ArrayRef<size_t> sizes)>;
+
+private:
+  /// A compiled specialization.
+  struct Bucket {
+    /// The sizes of the dynamic dimensions.
+    std::vector<size_t> sizes;
+    /// The function and its placeholders.
+    Specialization spec;
+    /// Backs the placeholders of the specialization.
+    std::unique_ptr<Context> ctx;
+    /// The engine that holds the compiled code of the specialization.
+    std::unique_ptr<ExecutionEngine> EE;
+  };
+
+  /// The backend used to compile the specializations.
+  BackendKind backendKind_;
+  /// The module of the specializations, which holds the shared weights.
+  Module M_;
+  /// The buckets, from the smallest to the largest number of elements.
+  std::vector<Bucket> buckets_;
+  /// For every dimension of every input, the index of the dynamic dimension
+  /// that it follows, or -1 if the dimension is static.
+  std::vector<std::vector<int>> inputDims_;
+  /// For every dimension of every output, the index of the dynamic dimension
+  /// that it follows, or -1 if the dimension is static.
+  std::vector<std::vector<int>> outputDims_;
+
+  /// \returns the sizes of the dynamic dimensions of the tensors \p inputs.
+  std::vector<size_t>
+  getRequestSizes(llvm::ArrayRef<const Tensor *> inputs) const;
+
+public:
+  /// Ctor. The specializations are compiled for \p backendKind.
+  explicit BucketedExecutor(BackendKind backendKind = BackendKind::Interpreter);
+
+  ~BucketedExecutor();
+
+  /// \returns the module of the specializations. The weights that the
+  /// specializations share are created in it before compile is called.
+  Module &getModule() { return M_; }
+
+  /// Create a specialization with \p build for every bucket in \p buckets, and
+  /// compile all of them for the given compilation \p mode. Every bucket
+  /// assigns a size to each of the dynamic dimensions.
+  void compile(CompilationMode mode,
+               llvm::ArrayRef<std::vector<size_t>> buckets,
+               const Builder &build);
+
+  /// \returns the index of the smallest bucket that fits the tensors
+  /// \p inputs.
+  size_t selectBucket(llvm::ArrayRef<const Tensor *> inputs) const;
+
+  /// \returns the sizes of the dynamic dimensions of the bucket \p idx.
+  llvm::ArrayRef<size_t> getBucketSizes(size_t idx) const {
+    return buckets_[idx].sizes;
+  }
+
+  /// Run the smallest bucket that fits the tensors \p inputs. The tensors
+  /// \p outputs are reset to the shapes of the request and receive the
+  /// results.
+  void run(llvm::ArrayRef<const Tensor *> inputs,
+           llvm::ArrayRef<Tensor *> outputs);
+};
+
+} // namespace glow
+
+#endif // GLOW_EXECUTIONENGINE_BUCKETEDEXECUTOR_H
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_EXECUTIONENGINE_DAGEXECUTOR_H
+#define GLOW_EXECUTIONENGINE_DAGEXECUTOR_H
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Graph/Context.h"
+#include "glow/Optimizer/Partition.h"
+#include "glow/Support/ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace glow {
+
+/// Executes the partitions of a FunctionDAG. Every partition is compiled by
+/// its own ExecutionEngine, and partitions whose dependencies have finished
+/// run concurrently on a thread pool. All of the partitions share a single
+/// Context, so the tensors that flow between partitions are passed by reference
+/// and are never copied.
+class DAGExecutor final {
+  /// A compiled partition and its position in the DAG.
+  struct Partition {
+    /// The function that this partition executes.
+    Function *F;
+    /// The engine that holds the compiled code of \p F.
+    std::unique_ptr<ExecutionEngine> EE;
+    /// The number of distinct partitions that must finish before this one.
+    unsigned numDependencies{0};
+    /// Indices of the partitions that depend on this one.
+    std::vector<size_t> users;
+  };
+
+  /// The backend used to compile the partitions.
+  BackendKind backendKind_;
+  /// The partitions, in topological order.
+  std::vector<Partition> partitions_;
+  /// Backs the placeholders of all partitions. Placeholders that are bound by
+  /// the caller refer to the caller's tensors; the placeholders that carry
+  /// values between partitions are backed by tensors owned by this context.
+  Context ctx_;
+  /// The number of unfinished dependencies of each partition in the current
+  /// run.
+  std::vector<std::atomic<unsigned>> pending_;
+  /// The number of partitions that finished in the current run.
+  size_t numFinished_{0};
+  /// Protects numFinished_.
+  std::mutex finishedMtx_;
+  /// Signalled when the last partition of a run finishes.
+  std::condition_variable allFinished_;
+  /// Runs the partitions. Declared last so that the workers are joined before
+  /// the state that they use is destroyed.
+  ThreadPool pool_;
+
+  /// Run partition \p idx followed by the partitions that it makes ready. The
+  /// first ready user is run on the current thread and the others are handed
+  /// to the thread pool.
+  void runPartition(size_t idx);
+
+public:
+  /// Ctor. Partitions are compiled for \p backendKind and executed by
+  /// \p numThreads threads. If \p numThreads is zero then one thread per
+  /// hardware thread is used.
+  explicit DAGExecutor(BackendKind backendKind = BackendKind::Interpreter,
+                       unsigned numThreads = 0);
+
+  ~DAGExecutor();
+
+  /// Optimize and compile all of the partitions of \p G for the given
+  /// compilation \p mode. The context \p ctx binds the placeholders of the
+  /// original function; it must outlive this executor. Tensors for the
+  /// placeholders that connect the partitions are allocated by the executor.
+  void compile(CompilationMode mode, const FunctionDAG &G, const Context &ctx);
+
+  /// Runs a single execution of all of the partitions, and returns once the
+  /// last one has finished.
+  void run();
+
+  /// \returns the tensor that backs the placeholder \p P, or null if \p P is
+  /// not used by any of the partitions.
+  Tensor *getTensor(Placeholder *P) const { return ctx_.get(P); }
+};
+
+} // namespace glow
+
+#endif // GLOW_EXECUTIONENGINE_DAGEXECUTOR_H
@@ -26,8 +26,19 @@
 
 #include "llvm/ADT/ArrayRef.h"
 
+#include <list>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+namespace sys {
+namespace fs {
+class mapped_file_region;
+} // namespace fs
+} // namespace sys
+} // namespace llvm
 
 namespace glow {
 
@@ -41,11 +52,66 @@ class ExecutionEngine final {
   /// The network execution backend.
   std::unique_ptr<Backend> backend_;
   /// A glow function compiled for this ExecutionEngine's backend.
-  std::unique_ptr<CompiledFunction> function_;
+  std::shared_ptr<CompiledFunction> function_;
+
+  /// The addresses and sizes of the payloads of tensors.
+  using PayloadList = std::vector<std::pair<const void *, size_t>>;
+
+  /// A compiled function and the state that its code depends on.
+  struct CachedFunction {
+    /// The structural hash of the Function.
+    std::string hash;
+    /// The storage that the Function uses, in the order of first use. The
+    /// hash identifies the storage by that order, so two Functions that only
+    /// differ in which storage of the same type they use have the same hash.
+    std::vector<const Storage *> storage;
+    /// The compilation mode.
+    CompilationMode mode;
+    /// The module whose variables the code references.
+    const Module *module;
+    /// The placeholder bindings of the context that the code references.
+    Context::PlaceholderMap bindings;
+    /// The memory of the payloads of the variables and of the bound tensors,
+    /// which the backends may bake into the code.
+    PayloadList payloads;
+    /// The compiled code.
+    std::shared_ptr<CompiledFunction> function;
+  };
+
+  /// The maximal number of compiled functions that the cache holds.
+  static constexpr size_t maxCachedFunctions = 8;
+  /// The recently compiled functions, from the least to the most recently
+  /// used.
+  std::list<CachedFunction> cache_;
+  /// The number of compilations that were served by the cache.
+  size_t numCacheHits_{0};
+  /// The mapped weights files that back the payloads of the constants.
+  std::vector<std::unique_ptr<llvm::sys::fs::mapped_file_region>>
+      mappedWeights_;
 
   /// Optimize the Function \p F given compilation mode \p mode.
   void optimizeFunction(CompilationMode mode, Function *F);
 
+  /// \returns the memory of the payloads of the variables of the module \p M
+  /// and of the tensors bound by \p ctx.
+  static PayloadList getPayloads(const Module *M, const Context &ctx);
+
+  /// \returns the cached function with the structural hash \p hash and the
+  /// storage \p storage that was compiled for \p mode with the variables of
+  /// the module \p M and the bindings of \p ctx, or nullptr if there is none.
+  std::shared_ptr<CompiledFunction>
+  lookupCache(llvm::StringRef hash, llvm::ArrayRef<const Storage *> storage,
+              CompilationMode mode, const Module *M, const Context &ctx);
+
+  /// Add \p function, which was compiled for \p mode with the variables of
+  /// the module \p M and the bindings of \p ctx, to the cache under the
+  /// structural hash \p hash and the storage \p storage. Evicts the least
+  /// recently used function when the cache is full.
+  void addToCache(llvm::StringRef hash,
+                  llvm::ArrayRef<const Storage *> storage, CompilationMode mode,
+                  const Module *M, const Context &ctx,
+                  std::shared_ptr<CompiledFunction> function);
+
 public:
   ExecutionEngine(BackendKind backendKind = BackendKind::Interpreter);
 
@@ -69,9 +135,17 @@ public:
   /// Optimize the graph and pass it to the backend to compile it for a specific
   /// target. This method should be invoked before the run method. The context
   /// \p ctx contains the mapping between symbolic values to concrete backing
-  /// tensors.
+  /// tensors. If a Function with the same structural hash was recently
+  /// compiled for \p mode with the same variables and bindings, the compiled
+  /// code is reused, and \p F is neither optimized nor compiled again.
   void compile(CompilationMode mode, Function *F, const Context &ctx);
 
+  /// \returns the number of calls to compile that reused compiled code.
+  size_t getNumCacheHits() const { return numCacheHits_; }
+
+  /// \returns the number of weights files that back payloads of constants.
+  size_t getNumMappedFiles() const { return mappedWeights_.size(); }
+
   /// Save a bundle for a standalone execution. This method takes care of
   /// everything when preparing the bundle for saving. There is no need to
   /// invoke the compile method before it.
@@ -81,6 +155,22 @@ public:
   void save(CompilationMode mode, Function *F, llvm::StringRef outputDir,
             llvm::StringRef networkName);
 
+  /// Save the payloads of the constants of the module, which are the private
+  /// variables that are not trained, to the file \p filename. The payloads
+  /// are aligned in the file, so that mapConstantWeights can use them in
+  /// place.
+  void saveConstantWeights(llvm::StringRef filename);
+
+  /// Map the file \p filename, which was written by saveConstantWeights, into
+  /// memory and make the constants of the module with the same names and
+  /// types use the mapped payloads. The pages of the file are loaded lazily
+  /// and shared by all processes that map it, as long as they are not
+  /// written. This drops the compiled code, so it should be invoked before
+  /// the compile method. It may be invoked again, for example to switch to
+  /// updated weights; the files that no payload uses any more are unmapped.
+  /// \returns the number of constants that were mapped.
+  size_t mapConstantWeights(llvm::StringRef filename);
+
   /// Runs a single execution of the function.
   void run();
 };
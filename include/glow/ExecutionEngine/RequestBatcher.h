@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_EXECUTIONENGINE_REQUESTBATCHER_H
+#define GLOW_EXECUTIONENGINE_REQUESTBATCHER_H
+
+#include "glow/Base/Tensor.h"
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Graph/Context.h"
+
+#include "llvm/ADT/ArrayRef.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace glow {
+
+/// Groups inference requests of a single sample into batches for a function
+/// that was compiled for a batch of samples. The first dimension of the input
+/// and output placeholders of the function is the batch dimension. Each
+/// request is copied into one slice of the inputs, the function runs once per
+/// batch, and the slices of the outputs are handed back to the requests.
+///
+/// A batch starts as soon as enough requests are pending to fill it, or when
+/// the oldest pending request has waited for the maximal delay. The delay
+/// bounds the time that a request spends waiting for others, which is the
+/// latency that is traded for throughput.
+class RequestBatcher final {
+public:
+  /// The result of a request: one tensor per output placeholder, in the order
+  /// of the output placeholders. The first dimension of each tensor is 1.
+  using Result = std::vector<Tensor>;
+
+private:
+  /// A request that waits for a batch.
+  struct Request {
+    /// One tensor per input placeholder.
+    std::vector<Tensor> inputs;
+    /// Fulfilled when the batch of the request has run.
+    std::promise<Result> result;
+    /// The time at which the request was submitted.
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  /// The engine that holds the compiled function.
+  ExecutionEngine &EE_;
+  /// The context that the function was compiled with.
+  Context &ctx_;
+  /// The input placeholders of the function.
+  std::vector<Placeholder *> inputs_;
+  /// The output placeholders of the function.
+  std::vector<Placeholder *> outputs_;
+  /// The maximal number of requests in a batch.
+  size_t maxBatchSize_;
+  /// The maximal time that a request waits for a batch to fill up.
+  std::chrono::microseconds maxDelay_;
+
+  /// The pending requests, in the order of their arrival.
+  std::deque<Request> queue_;
+  /// Protects queue_ and stop_.
+  std::mutex mutex_;
+  /// Signalled when a request arrives or the batcher stops.
+  std::condition_variable cond_;
+  /// Set when the batcher is destroyed.
+  bool stop_{false};
+
+  /// The number of batches that were run.
+  std::atomic<size_t> numBatches_{0};
+  /// The number of requests that were run.
+  std::atomic<size_t> numRequests_{0};
+
+  /// Forms the batches and runs them. Declared last so that it starts after
+  /// the rest of the state was initialized.
+  std::thread worker_;
+
+  /// The loop of the worker thread.
+  void loop();
+
+  /// Copy the requests \p batch into the inputs, run the function and return
+  /// the results to the requests.
+  void runBatch(std::vector<Request> &batch);
+
+public:
+  /// Ctor. Batches run the function that \p EE compiled with the context
+  /// \p ctx, which binds the input placeholders \p inputs and the output
+  /// placeholders \p outputs. A batch holds up to \p maxBatchSize requests,
+  /// which may not exceed the batch dimension of the placeholders; zero selects
+  /// the batch dimension. A request waits at most \p maxDelay for its batch to
+  /// fill up.
+  RequestBatcher(ExecutionEngine &EE, Context &ctx,
+                 llvm::ArrayRef<Placeholder *> inputs,
+                 llvm::ArrayRef<Placeholder *> outputs, size_t maxBatchSize,
+                 std::chrono::microseconds maxDelay);
+
+  /// Runs the pending requests and stops the worker.
+  ~RequestBatcher();
+
+  RequestBatcher(const RequestBatcher &) = delete;
+  RequestBatcher &operator=(const RequestBatcher &) = delete;
+
+  /// Enqueue a request with one tensor per input placeholder in \p inputs. The
+  /// first dimension of each tensor is 1 and the others match the
+  /// placeholder. \returns the future result of the request.
+  std::future<Result> submit(std::vector<Tensor> &&inputs);
+
+  /// \returns the number of batches that were run.
+  size_t getNumBatches() const { return numBatches_; }
+
+  /// \returns the number of requests that were run.
+  size_t getNumRequests() const { return numRequests_; }
+};
+
+} // namespace glow
+
+#endif // GLOW_EXECUTIONENGINE_REQUESTBATCHER_H
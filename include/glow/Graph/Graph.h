@@ -159,6 +159,13 @@ public:
                            VisibilityKind visibility = VisibilityKind::Private,
                            bool isTrainable = true);
 
+  /// Create a new variable \p name that takes over the payload \p tensor
+  /// instead of copying it. If \p tensor is unowned then the variable
+  /// references memory that must outlive the module.
+  Variable *createVariable(llvm::StringRef name, Tensor &&tensor,
+                           VisibilityKind visibility = VisibilityKind::Private,
+                           bool isTrainable = true);
+
   ///@}
 
   /// Verify the correctness of the Module.
@@ -493,6 +500,68 @@ public:
                                  NodeValue weights, NodeValue indices,
                                  NodeValue lengths);
 
+  /// Same as SparseLengthsWeightedSum, but the int8 \p data is quantized row
+  /// by row: the i-th row is dequantized as data[i] * scales[i] + offsets[i].
+  /// The result is in float.
+  RowwiseQuantizedSparseLengthsWeightedSumNode *
+  createRowwiseQuantizedSparseLengthsWeightedSum(
+      llvm::StringRef name, NodeValue data, NodeValue scales,
+      NodeValue offsets, NodeValue weights, NodeValue indices,
+      NodeValue lengths);
+
+  /// Create a RowwiseQuantizedSparseLengthsWeightedSum node, whose data is
+  /// the float tensor \p data quantized row by row. Each row is mapped to the
+  /// int8 range with its own scale and offset, which are stored in new
+  /// private variables together with the quantized data.
+  RowwiseQuantizedSparseLengthsWeightedSumNode *
+  createRowwiseQuantizedSparseLengthsWeightedSum(llvm::StringRef name,
+                                                 Tensor &data,
+                                                 NodeValue weights,
+                                                 NodeValue indices,
+                                                 NodeValue lengths);
+
+  /// Same as createRowwiseQuantizedSparseLengthsWeightedSum, but all the
+  /// weights are 1.
+  RowwiseQuantizedSparseLengthsWeightedSumNode *
+  createRowwiseQuantizedSparseLengthsSum(llvm::StringRef name, Tensor &data,
+                                         NodeValue indices, NodeValue lengths);
+
+  /// Same as createRowwiseQuantizedSparseLengthsWeightedSum, but the scale and
+  /// the offset of each row are stored in the last 8 bytes of the row of the
+  /// UInt8FusedQTy \p data.
+  FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+  createFusedRowwiseQuantizedSparseLengthsWeightedSum(llvm::StringRef name,
+                                                      NodeValue data,
+                                                      NodeValue weights,
+                                                      NodeValue indices,
+                                                      NodeValue lengths);
+
+  /// Create a FusedRowwiseQuantizedSparseLengthsWeightedSum node, whose data
+  /// is the 2D float tensor \p data quantized row by row into a new private
+  /// variable. Each row is mapped to the uint8 range, and its scale and offset
+  /// are appended to the row.
+  FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+  createFusedRowwiseQuantizedSparseLengthsWeightedSum(llvm::StringRef name,
+                                                      Tensor &data,
+                                                      NodeValue weights,
+                                                      NodeValue indices,
+                                                      NodeValue lengths);
+
+  /// Same as createFusedRowwiseQuantizedSparseLengthsWeightedSum, but all the
+  /// weights are 1.
+  FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+  createFusedRowwiseQuantizedSparseLengthsSum(llvm::StringRef name,
+                                              NodeValue data,
+                                              NodeValue indices,
+                                              NodeValue lengths);
+
+  /// Same as createFusedRowwiseQuantizedSparseLengthsWeightedSum, but all the
+  /// weights are 1.
+  FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+  createFusedRowwiseQuantizedSparseLengthsSum(llvm::StringRef name,
+                                              Tensor &data, NodeValue indices,
+                                              NodeValue lengths);
+
   SaveNode *createSave(llvm::StringRef name, NodeValue input);
   SaveNode *createSave(llvm::StringRef name, NodeValue input, Storage *output);
 
@@ -664,6 +733,17 @@ public:
   /// Verify the correctness of the Function.
   void verify() const;
 
+  /// \returns a hash of the structure of the Function: the kinds, members and
+  /// types of its nodes, the edges between them, and the content of the
+  /// constant variables that it uses. Functions with the same hash compile to
+  /// the same code, up to the storage that they use. The hash is the hex SHA1
+  /// digest of a form that does not depend on the addresses or the names of
+  /// the nodes, so it is the same in every process and may key an on-disk
+  /// cache. The storage is identified by the order in which it is first used;
+  /// if \p storage is given, the storage is appended to it in that order.
+  std::string
+  getStructuralHash(std::vector<const Storage *> *storage = nullptr) const;
+
   /// Dumps the textual representation of the network.
   void dump() const;
 
@@ -28,6 +28,10 @@
 
 #include <list>
 
+namespace llvm {
+class SHA1;
+}
+
 namespace glow {
 
 class Function;
@@ -309,6 +313,12 @@ public:
   /// \returns a hash code of the node.
   llvm::hash_code getHash() const;
 
+  /// Add the kind, the mode and the members of the node to the digest
+  /// \p hasher. Unlike getHash, this does not cover the operands of the node
+  /// and does not depend on the addresses or the name of the node, so the
+  /// digest is the same in every process.
+  void updateMembersDigest(llvm::SHA1 &hasher) const;
+
   /// This method implements the visitor pattern that scans the compute DAG top
   /// to bottom. The visitor \p visitor is sent by the parent node \p parent,
   /// or nullptr if this is the first node to be visited.
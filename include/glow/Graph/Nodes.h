@@ -23,6 +23,7 @@
 
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/SHA1.h"
 
 #include <tuple>
 
@@ -89,6 +90,16 @@ public:
     payload_.reset(*Ty);
   }
 
+  /// Create a new variable of the type \p Ty that takes over \p payload, which
+  /// may be an unowned tensor.
+  Variable(llvm::StringRef name, TypeRef Ty, VisibilityKind visibility,
+           bool isTrainable, Tensor &&payload)
+      : Storage(Kinded::Kind::VariableKind, name, isTrainable),
+        visibility_(visibility), payload_(std::move(payload)) {
+    assert(payload_.getType().isEqual(*Ty) && "Mismatch on payload type");
+    addResult(Ty);
+  }
+
   Variable(llvm::StringRef name, VisibilityKind visibility, Tensor &&payload)
       : Storage(Kinded::Kind::VariableKind, name, false),
         visibility_(visibility), payload_(std::move(payload)) {
@@ -118,6 +129,8 @@ public:
   std::string getDebugDesc() const;
 
   llvm::hash_code getHash() const;
+
+  void updateMembersDigest(llvm::SHA1 &hasher) const;
 };
 
 /// Placeholder nodes are unbound-storage. The content tensors are attached to
@@ -138,6 +151,8 @@ public:
   std::string getDebugDesc() const;
 
   llvm::hash_code getHash() const;
+
+  void updateMembersDigest(llvm::SHA1 &hasher) const;
 };
 
 /// Calculate the size of the output tensor based on the convolution/pooling
@@ -169,6 +184,18 @@ llvm::hash_code hash_value(const glow::Tensor &T);
 
 llvm::hash_code hash_value(const glow::Type *T);
 
+/// Add a value to the digest \p hasher in a form that does not depend on any
+/// addresses, so that the digest is the same in every process. Types are
+/// added by their element kind, dimensions and quantization parameters
+/// rather than by the address at which they were uniqued.
+void updateDigest(llvm::SHA1 &hasher, uint64_t value);
+void updateDigest(llvm::SHA1 &hasher, float value);
+void updateDigest(llvm::SHA1 &hasher, llvm::StringRef value);
+void updateDigest(llvm::SHA1 &hasher, llvm::ArrayRef<float> values);
+void updateDigest(llvm::SHA1 &hasher, llvm::ArrayRef<unsigned_t> values);
+void updateDigest(llvm::SHA1 &hasher, llvm::ArrayRef<size_t> values);
+void updateDigest(llvm::SHA1 &hasher, const glow::Type *T);
+
 llvm::hash_code hash_value(glow::Node *T);
 
 llvm::hash_code hash_value(const glow::NodeValue &T);
@@ -30,26 +30,36 @@ class ModelLoader : public ONNXModelLoader {
 private:
   ModelLoader(Function &F) : ONNXModelLoader(F) {}
 
-  /// Load the inputs from the GraphProto. This is useful when the
-  /// initializers are not available.
+  /// Load the inputs from the GraphProto as Placeholders. This is useful when
+  /// the initializers are not available.
   void loadInputs(ONNX_NAMESPACE::GraphProto &net);
 
-  /// Load pre-trained weights from \p weightDescriptors.
+  /// Load pre-trained weights from \p weightDescriptors. The weights reference
+  /// the memory of the descriptors whenever it is suitably aligned, so the
+  /// caller must keep it alive for the lifetime of the graph.
   bool loadWeights(uint32_t weightsCount,
                    const onnxTensorDescriptorV1 *weightDescriptors);
 
-  /// Mapping between ONNX names for inputs and actual Glow input vars.
-  llvm::StringMap<Variable *> onnxNameToInputVars_;
+  /// Save the outputs of the network \p net into Placeholders.
+  /// \returns false if the network has no outputs.
+  bool setOutputPlaceholders(ONNX_NAMESPACE::GraphProto &net);
+
+  /// Mapping between ONNX names for inputs and actual Glow input placeholders.
+  llvm::StringMap<Placeholder *> onnxNameToInputPlaceholders_;
+
+  /// Mapping between ONNX names for outputs and actual Glow output
+  /// placeholders.
+  llvm::StringMap<Placeholder *> onnxNameToOutputPlaceholders_;
 
 public:
-  /// \returns mapping between ONNX names and actual Glow input vars.
-  const llvm::StringMap<Variable *> &getInputVarsMapping() const {
-    return onnxNameToInputVars_;
+  /// \returns mapping between ONNX names and actual Glow input placeholders.
+  const llvm::StringMap<Placeholder *> &getInputPlaceholdersMapping() const {
+    return onnxNameToInputPlaceholders_;
   }
 
-  /// \returns mapping between ONNX names and actual Glow output nodes.
-  const llvm::StringMap<Variable *> &getOutputVarsMapping() const {
-    return outputVarsByName_;
+  /// \returns mapping between ONNX names and actual Glow output placeholders.
+  const llvm::StringMap<Placeholder *> &getOutputPlaceholdersMapping() const {
+    return onnxNameToOutputPlaceholders_;
   }
 
   /// \returns unique pointer to ModelLoader if \p onnxModel can be parsed
@@ -32,8 +32,11 @@ enum class CompilationMode {
 
 /// Perform optimizations on the IR representation.
 void optimize(IRFunction &M, bool shouldShareBuffers);
-/// Perform optimizations on the graph representation.
-void optimize(Function *F, CompilationMode mode);
+/// Perform optimizations on the graph representation. If the backend \p B is
+/// given, the subgraphs that only depend on constants are evaluated with it
+/// at compile time when compiling for inference.
+void optimize(Function *F, CompilationMode mode,
+              const Backend *B = nullptr);
 
 /// Lower the high-level neural network operators into low-level linear algebra
 /// operators.
@@ -20,6 +20,8 @@
 
 #include <llvm/ADT/DenseMap.h>
 
+#include <cstdint>
+
 namespace glow {
 
 /// Maps a set of functions to the set of functions it depends on.  The
@@ -73,8 +75,65 @@ public:
   bool verify() const;
 };
 
-/// Split an input Function into a FunctionDAG.
-FunctionDAG partition(Function *F);
+/// The strategy that partition() uses to assign nodes to partitions.
+enum class PartitionKind {
+  /// Regions end after a node with multiple outputs or before a node with
+  /// multiple inputs, like basic blocks in a control flow graph.
+  BasicBlock,
+  /// Partitions are grown along the edges that carry the most bytes until they
+  /// reach a target cost or a memory budget. Costs come from estimateCost().
+  CostModel,
+};
+
+/// Parameters of partition().
+struct PartitionConfig {
+  /// The partitioning strategy.
+  PartitionKind kind{PartitionKind::BasicBlock};
+  /// CostModel only: the estimated cost of the function is split into about
+  /// this many partitions of similar cost.
+  unsigned numPartitions{1};
+  /// CostModel only: the maximum number of bytes of weights and activations
+  /// that a partition may use, or zero for no limit. A single node that does
+  /// not fit in the budget is placed in a partition of its own.
+  uint64_t memoryBudget{0};
+};
+
+/// The estimated cost of executing a node.
+struct NodeCost {
+  /// Number of arithmetic operations.
+  uint64_t flops{0};
+  /// Number of bytes read and written.
+  uint64_t bytes{0};
+
+  /// \returns a single cost value, assuming that moving one byte costs about
+  /// as much as one arithmetic operation.
+  uint64_t getTotal() const { return flops + bytes; }
+
+  NodeCost &operator+=(const NodeCost &other) {
+    flops += other.flops;
+    bytes += other.bytes;
+    return *this;
+  }
+};
+
+/// \returns the estimated cost of \p N, derived from its kind and the shapes
+/// of its operands. Variables and placeholders have no cost.
+NodeCost estimateCost(Node *N);
+
+/// \returns the estimated cost of all of the nodes in \p F.
+NodeCost estimateCost(Function *F);
+
+/// \returns the total cost of the most expensive chain of dependent functions
+/// in \p G. This bounds the latency of executing \p G when every independent
+/// function runs in parallel.
+uint64_t estimateCriticalPath(const FunctionDAG &G);
+
+/// Split an input Function into a FunctionDAG, using the strategy selected by
+/// \p config. Values that flow from one partition to another are saved into
+/// new Placeholders, which must be backed by tensors in the Context used to
+/// compile and run the partitions.
+FunctionDAG partition(Function *F,
+                      const PartitionConfig &config = PartitionConfig());
 
 } // namespace glow
 
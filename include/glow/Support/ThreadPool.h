@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_SUPPORT_THREADPOOL_H
+#define GLOW_SUPPORT_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace glow {
+
+/// A simple thread pool with a fixed number of workers that execute work items
+/// from a shared FIFO queue.
+class ThreadPool final {
+  /// The worker threads.
+  std::vector<std::thread> workers_;
+  /// Work items waiting to be picked up by a worker.
+  std::queue<std::packaged_task<void()>> workQueue_;
+  /// Protects the work queue and the stop flag.
+  std::mutex workQueueMtx_;
+  /// Signalled when a new work item is queued or the pool is shutting down.
+  std::condition_variable queueNotEmpty_;
+  /// Set when the pool is destroyed; workers exit once the queue is drained.
+  bool shouldStop_{false};
+
+  /// The main loop of each worker thread.
+  void threadMain();
+
+public:
+  /// Ctor. Creates a pool with \p numWorkers worker threads. If \p numWorkers
+  /// is zero then one worker per hardware thread is created.
+  explicit ThreadPool(unsigned numWorkers = 0);
+
+  /// Dtor. Waits for all queued work items to complete.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Enqueue \p fn for execution on one of the workers. \returns a future that
+  /// becomes ready once \p fn has run.
+  std::future<void> submit(std::function<void()> fn);
+
+  /// \returns the number of worker threads in the pool.
+  unsigned getNumWorkers() const { return workers_.size(); }
+
+  /// Run \p fn(i) for every i in [0, \p numTasks) using the workers of the
+  /// pool and the calling thread, and return once all of them have finished.
+  /// The calling thread participates in the execution, so this is safe to call
+  /// even when all of the workers are busy.
+  void parallelFor(size_t numTasks, const std::function<void(size_t)> &fn);
+};
+
+} // namespace glow
+
+#endif // GLOW_SUPPORT_THREADPOOL_H
@@ -17,6 +17,7 @@
 
 #include "AllocationsInfo.h"
 #include "glow/CodeGen/MemoryAllocator.h"
+#include "glow/CodeGen/MemoryPlanner.h"
 #include "glow/Graph/Context.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Nodes.h"
@@ -34,7 +35,8 @@ using llvm::isa;
 
 void AllocationsInfo::allocateWeightVars(const IRFunction *F,
                                          const Context &ctx,
-                                         bool absoluteAddr) {
+                                         bool absoluteConstantAddr,
+                                         bool absoluteMutableAddr) {
   // Use two different allocators, because constant weights and mutable weights
   // may use different memory blocks.
   MemoryAllocator constantWeightVarsAllocator("ConstantWeights", 0);
@@ -49,7 +51,7 @@ void AllocationsInfo::allocateWeightVars(const IRFunction *F,
       continue;
     auto numBytes = w->getSizeInBytes();
     size_t addr = constantWeightVarsAllocator.allocate(numBytes, w);
-    if (!absoluteAddr) {
+    if (!absoluteConstantAddr) {
       allocatedAddressed_[w] = addr;
     } else {
       // Reuse the address used by the payload.
@@ -66,7 +68,7 @@ void AllocationsInfo::allocateWeightVars(const IRFunction *F,
       continue;
     auto numBytes = w->getSizeInBytes();
     size_t addr = mutableWeightVarsAllocator.allocate(numBytes, w);
-    if (!absoluteAddr) {
+    if (!absoluteMutableAddr) {
       allocatedAddressed_[w] = addr;
     } else {
       // Reuse the address used by the payload.
@@ -81,7 +83,7 @@ void AllocationsInfo::allocateWeightVars(const IRFunction *F,
     auto *w = cast<WeightVar>(F->getWeightForNode(PH.first));
     auto numBytes = w->getSizeInBytes();
     size_t addr = mutableWeightVarsAllocator.allocate(numBytes, w);
-    if (!absoluteAddr) {
+    if (!absoluteMutableAddr) {
       allocatedAddressed_[w] = addr;
     } else {
       // Reuse the address used by the payload.
@@ -113,36 +115,39 @@ void AllocationsInfo::allocateWeightVars(const IRFunction *F,
 }
 
 void AllocationsInfo::allocateActivations(const IRFunction *F) {
-  // Use a memory allocator with no upper bound on how much memory we can
-  // allocate.
-  MemoryAllocator activationsAllocator("Activations", 0);
-
-  // Maps activations and views to some offset within the heap.
-  llvm::DenseMap<const Value *, uint64_t> activationAddr;
-
-  // Assign device-space addresses to the activations.
+  // Plan the placement of all of the activations at once. An activation is
+  // live from its allocation up to its deallocation.
+  MemoryPlanner activationsPlanner("Activations");
+  llvm::DenseMap<const Value *, size_t> allocIdx;
+  size_t idx = 0;
   for (const auto &I : F->getInstrs()) {
+    idx++;
     if (auto *A = dyn_cast<AllocActivationInst>(&I)) {
-      auto numBytes = I.getSizeInBytes();
-      size_t addr = activationsAllocator.allocate(numBytes, A);
-      assert(!activationAddr.count(A) && "Allocation already made!");
-      activationAddr[A] = addr;
+      assert(!allocIdx.count(A) && "Allocation already made!");
+      allocIdx[A] = idx;
       continue;
     }
 
     if (auto *D = dyn_cast<DeallocActivationInst>(&I)) {
       auto *A = D->getAlloc();
-      assert(activationAddr.count(A) && "Invalid deallocation!");
-      activationsAllocator.deallocate(A);
+      assert(allocIdx.count(A) && "Invalid deallocation!");
+      activationsPlanner.addBuffer(A, A->getSizeInBytes(), allocIdx[A], idx);
       continue;
     }
   }
+  // The activations that are never deallocated live up to the end.
+  for (const auto &I : F->getInstrs()) {
+    auto *A = dyn_cast<AllocActivationInst>(&I);
+    if (A && !activationsPlanner.hasAddress(A)) {
+      activationsPlanner.addBuffer(A, A->getSizeInBytes(), allocIdx[A], idx);
+    }
+  }
 
-  activationsMemSize_ = activationsAllocator.getMaxMemoryUsage();
+  activationsMemSize_ = activationsPlanner.plan();
 
   // Register specific addresses within the heap to activations.
-  for (auto &A : activationAddr) {
-    allocatedAddressed_[A.first] = A.second;
+  for (auto &A : allocIdx) {
+    allocatedAddressed_[A.first] = activationsPlanner.getAddress(A.first);
   }
   DEBUG_GLOW(for (auto &A
                   : allocatedAddressed_) {
@@ -240,3 +245,11 @@ void AllocationsInfo::numberValues(const IRFunction *F) {
     }
   }
 }
+
+std::vector<size_t> AllocationsInfo::getOffsets() const {
+  std::vector<size_t> offsets(valueNumbers_.size());
+  for (auto &I : valueNumbers_) {
+    offsets[I.second.second] = allocatedAddressed_.lookup(I.first);
+  }
+  return offsets;
+}
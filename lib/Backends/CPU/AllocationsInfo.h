@@ -19,6 +19,7 @@
 #include "llvm/IR/Module.h"
 
 #include <functional>
+#include <vector>
 
 namespace glow {
 class Value;
@@ -61,7 +62,15 @@ struct AllocationsInfo {
   /// This is useful in a JIT setup. If \p absoluteAddr is false, then all the
   /// WeightVars will get new offsets assigned.
   void allocateWeightVars(const IRFunction *F, const Context &ctx,
-                          bool absoluteAddr);
+                          bool absoluteAddr) {
+    allocateWeightVars(F, ctx, absoluteAddr, absoluteAddr);
+  }
+  /// Same as above, but decide separately for constant and mutable WeightVars
+  /// whether the addresses of their payloads should be reused. A reentrant JIT
+  /// reuses the addresses of the constant weights, but assigns new offsets to
+  /// the mutable ones, which are allocated for each execution.
+  void allocateWeightVars(const IRFunction *F, const Context &ctx,
+                          bool absoluteConstantAddr, bool absoluteMutableAddr);
   /// Assign offsets to all activations.
   /// No actual memory allocation is performed. All the allocations should be
   /// performed by the client based on the information provided by the
@@ -75,6 +84,9 @@ struct AllocationsInfo {
   /// Number all allocations and weight variables by assigning them unique
   /// numbers.
   void numberValues(const IRFunction *F);
+  /// \returns the offsets of all numbered values, indexed by their numbers.
+  /// This is the offsets array that is passed to the entry function.
+  std::vector<size_t> getOffsets() const;
 };
 
 } // namespace glow
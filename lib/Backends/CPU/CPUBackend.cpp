@@ -17,20 +17,53 @@
 #include "CPUBackend.h"
 #include "BundleSaver.h"
 #include "CPUFunction.h"
+#include "CommandLine.h"
 
+#include "glow/Graph/Context.h"
 #include "glow/Graph/Graph.h"
+#include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
 #include "glow/Support/Debug.h"
+#include "glow/Support/ThreadPool.h"
 
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 
 using namespace glow;
+using llvm::dyn_cast;
+using llvm::isa;
 
 static llvm::cl::opt<std::string> target("target", llvm::cl::desc("target"));
 
+static llvm::cl::opt<unsigned> cpuThreads(
+    "cpu-threads",
+    llvm::cl::desc("Maximal number of threads used to execute the JITed code "
+                   "(0 means one thread per hardware thread)"),
+    llvm::cl::init(0), llvm::cl::cat(CPUBackendCat));
+
+static llvm::cl::opt<std::string> jitObjectCacheDir(
+    "jit-object-cache-dir",
+    llvm::cl::desc("Directory that caches the object files of the JITed code "
+                   "across processes (the cache is disabled if it is empty). "
+                   "The cached code does not have any address baked in"),
+    llvm::cl::init(""), llvm::cl::cat(CPUBackendCat));
+
+static llvm::cl::opt<unsigned> jitObjectCacheSize(
+    "jit-object-cache-size",
+    llvm::cl::desc("Maximal size in megabytes of the object files in the "
+                   "directory of -jit-object-cache-dir. The least recently "
+                   "used ones are removed once it is exceeded"),
+    llvm::cl::init(1024), llvm::cl::cat(CPUBackendCat));
+
+static llvm::cl::opt<unsigned> jitCodeGenParts(
+    "jit-codegen-parts",
+    llvm::cl::desc("Number of parts the JITed code is split into, which are "
+                   "optimized and compiled to machine code in parallel"),
+    llvm::cl::init(1), llvm::cl::cat(CPUBackendCat));
+
 namespace glow {
 Backend *createCPUBackend() { return new CPUBackend(); }
 } // namespace glow
@@ -47,10 +80,25 @@ namespace {
 /// propagate them into relative addressing computations and the like and
 /// produce a very efficient code that uses absolute addressing whenever
 /// possible.
-static void emitJitMain(LLVMIRGen &irgen) {
+///
+/// If \p reentrant is true, "jitmain" takes the offsets array and the base
+/// addresses of the mutable weights and of the activations as its three
+/// arguments, similarly to the entry point of a bundle. Only a \p relocatable
+/// function uses the offsets array argument. The others have the offsets, and
+/// with them the addresses of the constant weights, baked in.
+static void emitJitMain(LLVMIRGen &irgen, bool reentrant, bool relocatable) {
+  assert((reentrant || !relocatable) && "A relocatable jitmain is reentrant");
   AllocationsInfo &allocationsInfo = irgen.getAllocationsInfo();
   llvm::Type *voidTy = llvm::Type::getVoidTy(irgen.getLLVMContext());
-  llvm::FunctionType *jitFuncTy = llvm::FunctionType::get(voidTy, {}, false);
+  auto int8PtrTy = llvm::Type::getInt8PtrTy(irgen.getLLVMContext());
+  auto sizeTPtrTy =
+      llvm::Type::getIntNPtrTy(irgen.getLLVMContext(), sizeof(size_t) * 8);
+  llvm::SmallVector<llvm::Type *, 3> jitFuncArgTys;
+  if (reentrant) {
+    jitFuncArgTys.append({sizeTPtrTy, int8PtrTy, int8PtrTy});
+  }
+  llvm::FunctionType *jitFuncTy =
+      llvm::FunctionType::get(voidTy, jitFuncArgTys, false);
   auto *func =
       llvm::Function::Create(jitFuncTy, llvm::Function::ExternalLinkage,
                              "jitmain", &irgen.getModule());
@@ -62,27 +110,35 @@ static void emitJitMain(LLVMIRGen &irgen) {
   llvm::SmallVector<llvm::Value *, 4> initFunctionCallArgs;
   // Get the integer type having the same size in bits as size_t.
   auto *sizeTType = builder.getIntNTy(sizeof(size_t) * 8);
-  auto int8PtrTy = llvm::Type::getInt8PtrTy(irgen.getLLVMContext());
 
   initFunctionCallArgs.push_back(builder.CreateIntToPtr(
       llvm::ConstantInt::get(
           sizeTType, reinterpret_cast<size_t>(
                          allocationsInfo.baseConstantWeightVarsAddress_)),
       int8PtrTy));
-  initFunctionCallArgs.push_back(builder.CreateIntToPtr(
-      llvm::ConstantInt::get(
-          sizeTType, reinterpret_cast<size_t>(
-                         allocationsInfo.baseMutableWeightVarsAddress_)),
-      int8PtrTy));
-  initFunctionCallArgs.push_back(builder.CreateIntToPtr(
-      llvm::ConstantInt::get(
-          sizeTType,
-          reinterpret_cast<size_t>(allocationsInfo.baseActivationsAddress_)),
-      int8PtrTy));
+  if (reentrant) {
+    initFunctionCallArgs.push_back(func->args().begin() + 1);
+    initFunctionCallArgs.push_back(func->args().begin() + 2);
+  } else {
+    initFunctionCallArgs.push_back(builder.CreateIntToPtr(
+        llvm::ConstantInt::get(
+            sizeTType, reinterpret_cast<size_t>(
+                           allocationsInfo.baseMutableWeightVarsAddress_)),
+        int8PtrTy));
+    initFunctionCallArgs.push_back(builder.CreateIntToPtr(
+        llvm::ConstantInt::get(
+            sizeTType,
+            reinterpret_cast<size_t>(allocationsInfo.baseActivationsAddress_)),
+        int8PtrTy));
+  }
   // Now form the offsets array and pass it as the last argument.
-  auto offsetsArray =
-      irgen.emitConstOffsetsArray(irgen.getBuilder(), allocationsInfo);
-  initFunctionCallArgs.push_back(offsetsArray);
+  if (relocatable) {
+    initFunctionCallArgs.push_back(func->args().begin());
+  } else {
+    auto offsetsArray =
+        irgen.emitConstOffsetsArray(irgen.getBuilder(), allocationsInfo);
+    initFunctionCallArgs.push_back(offsetsArray);
+  }
   // Invoke the main entry with constant arguments and let LLVM optimizer make
   // use of it.
   auto *entryF = irgen.getModule().getFunction(irgen.getMainEntryName());
@@ -94,6 +150,160 @@ static void emitJitMain(LLVMIRGen &irgen) {
   irgen.generateFunctionDebugInfo(func);
 }
 
+//===----------------------------------------------------------------------===//
+//                   Multi-threaded execution of the JITed code
+//===----------------------------------------------------------------------===//
+
+/// The amount of work (in multiply-adds or element-wise operations) that
+/// justifies executing a function with one more thread.
+static constexpr size_t workPerThread = 1 << 20;
+
+/// \returns the thread pool shared by all of the functions compiled by the
+/// CPU backend, or null if the code should be single-threaded. The calling
+/// thread takes part in the parallel loops, so the pool has one worker less
+/// than the maximal number of threads.
+static std::shared_ptr<ThreadPool> getThreadPool() {
+  static std::shared_ptr<ThreadPool> pool = []() {
+    unsigned numThreads =
+        cpuThreads ? cpuThreads : std::thread::hardware_concurrency();
+    if (numThreads <= 1) {
+      return std::shared_ptr<ThreadPool>();
+    }
+    return std::make_shared<ThreadPool>(numThreads - 1);
+  }();
+  return pool;
+}
+
+/// \returns an estimate of the amount of work performed by the function \p F.
+static size_t estimateWork(const IRFunction *F) {
+  size_t work = 0;
+  for (const auto &I : F->getInstrs()) {
+    if (auto *MM = dyn_cast<MatMulInst>(&I)) {
+      work += MM->getDest()->size() * MM->getLHS()->dims()[1];
+      continue;
+    }
+    if (auto *MM = dyn_cast<CPUFusedMatMulInst>(&I)) {
+      work += MM->getDest()->size() * MM->getLHS()->dims()[1];
+      continue;
+    }
+    // The filter size per output channel is the number of multiply-adds per
+    // output element of a convolution.
+    const Value *convDest = nullptr;
+    const Value *convFilter = nullptr;
+    if (auto *CI = dyn_cast<ConvolutionInst>(&I)) {
+      convDest = CI->getDest();
+      convFilter = CI->getFilter();
+    } else if (auto *CI = dyn_cast<CPUConvDKKC8Inst>(&I)) {
+      convDest = CI->getDest();
+      convFilter = CI->getFilter();
+    } else if (auto *CI = dyn_cast<CPUConvDKKC16Inst>(&I)) {
+      convDest = CI->getDest();
+      convFilter = CI->getFilter();
+    } else if (auto *CI = dyn_cast<CPUDepthwiseConvInst>(&I)) {
+      convDest = CI->getDest();
+      convFilter = CI->getFilter();
+    } else if (auto *CI = dyn_cast<CPUFusedConvInst>(&I)) {
+      convDest = CI->getDest();
+      convFilter = CI->getFilter();
+    } else if (auto *CI = dyn_cast<CPUFusedConvAddInst>(&I)) {
+      convDest = CI->getDest();
+      convFilter = CI->getFilter();
+    }
+    if (convDest) {
+      work += convDest->size() * (convFilter->size() / convDest->dims()[3]);
+      continue;
+    }
+    if (auto *WI = dyn_cast<CPUWinogradConvInst>(&I)) {
+      // Count the multiply-adds of the equivalent direct 3x3 convolution.
+      work += WI->getDest()->size() * 9 * WI->getSrc()->dims()[3];
+      continue;
+    }
+    if (I.isDataParallel()) {
+      work += I.getOperand(0).first->size();
+    }
+  }
+  return work;
+}
+
+/// \returns the number of threads that should execute the function \p F
+/// using the thread pool \p pool.
+static unsigned selectNumThreads(const IRFunction *F, const ThreadPool *pool) {
+  if (!pool) {
+    return 1;
+  }
+  size_t numThreads = estimateWork(F) / workPerThread;
+  numThreads = std::min<size_t>(numThreads, pool->getNumWorkers() + 1);
+  return std::max<size_t>(numThreads, 1);
+}
+
+/// Run the \p numTasks tasks \p fn of a parallel loop of the JITed code on the
+/// thread pool \p pool. This is the dispatcher invoked by libjit_parallel_for.
+static void dispatchParallelFor(void *pool, void (*fn)(void *, size_t, size_t),
+                                void *ctx, size_t numTasks) {
+  static_cast<ThreadPool *>(pool)->parallelFor(
+      numTasks, [=](size_t taskId) { fn(ctx, taskId, numTasks); });
+}
+
+/// The names that the variables of the parallel runtime of libjit, which hold
+/// the dispatcher and the thread pool, get in a relocatable function.
+static constexpr const char *relocatableDispatcherName =
+    "glow_parallel_dispatcher";
+static constexpr const char *relocatablePoolName = "glow_parallel_pool";
+
+/// Set up the parallel runtime of libjit, so that the code generated by
+/// \p irgen executes its parallel loops on \p pool. The state is baked into
+/// the module as constant initializers, which lets LLVM fold it. A
+/// \p relocatable function only has the number of threads baked in. Its
+/// dispatcher and pool are set by bindParallelRuntime once it is loaded.
+static void initParallelRuntime(LLVMIRGen &irgen, ThreadPool *pool,
+                                bool relocatable) {
+  // The libjit defaults make the code single-threaded.
+  if (irgen.getNumThreads() <= 1) {
+    return;
+  }
+  auto *sizeTType =
+      llvm::Type::getIntNTy(irgen.getLLVMContext(), sizeof(size_t) * 8);
+  auto setInitializer = [&](llvm::StringRef name, size_t value) {
+    auto *GV = irgen.getModule().getNamedGlobal(name);
+    GLOW_ASSERT(GV && "Unable to find the parallel runtime variable");
+    llvm::Constant *init = llvm::ConstantInt::get(sizeTType, value);
+    if (GV->getValueType()->isPointerTy()) {
+      init = llvm::ConstantExpr::getIntToPtr(init, GV->getValueType());
+    }
+    GV->setInitializer(init);
+  };
+  setInitializer("libjit_num_threads", irgen.getNumThreads());
+  if (relocatable) {
+    // The libjit symbols are internalized. The renamed variables stay visible
+    // outside of the module.
+    irgen.getModule()
+        .getNamedGlobal("libjit_parallel_dispatcher")
+        ->setName(relocatableDispatcherName);
+    irgen.getModule()
+        .getNamedGlobal("libjit_parallel_pool")
+        ->setName(relocatablePoolName);
+    return;
+  }
+  setInitializer("libjit_parallel_dispatcher",
+                 reinterpret_cast<size_t>(&dispatchParallelFor));
+  setInitializer("libjit_parallel_pool", reinterpret_cast<size_t>(pool));
+}
+
+/// Make the parallel loops of the relocatable function loaded by \p JIT
+/// execute on \p pool.
+static void bindParallelRuntime(llvm::orc::GlowJIT &JIT, ThreadPool *pool) {
+  auto getAddress = [&](const char *name) {
+    auto sym = JIT.findSymbol(name);
+    auto address = sym.getAddress();
+    GLOW_ASSERT(address && address.get() &&
+                "Unable to find the parallel runtime variable");
+    return address.get();
+  };
+  *reinterpret_cast<decltype(&dispatchParallelFor) *>(
+      getAddress(relocatableDispatcherName)) = &dispatchParallelFor;
+  *reinterpret_cast<void **>(getAddress(relocatablePoolName)) = pool;
+}
+
 /// Perform memory allocation for a JIT execution.
 static void *allocateJITMemory(const IRFunction *F,
                                AllocationsInfo &allocationsInfo,
@@ -114,6 +324,102 @@ static void *allocateJITMemory(const IRFunction *F,
   return heap;
 }
 
+/// Perform the address assignment for a reentrant JIT execution. Only the
+/// constant weights use the absolute addresses of their payloads. The mutable
+/// weights and the activations get offsets inside memory areas that are
+/// allocated separately for each execution context.
+/// \returns the memory requirements of a single execution.
+static CPUFunction::MemoryLayout
+allocateReentrantJITMemory(const IRFunction *F,
+                           AllocationsInfo &allocationsInfo,
+                           const Context &ctx) {
+  allocationsInfo.numberValues(F);
+  allocationsInfo.allocateActivations(F);
+  allocationsInfo.allocateWeightVars(F, ctx, /* absoluteConstantAddr */ true,
+                                     /* absoluteMutableAddr */ false);
+  allocationsInfo.allocateTensorViews(F);
+
+  // Find the weights that are read and written by the function. A weight that
+  // is only read after it is overwritten does not need to be copied in, but
+  // the order of the accesses is not tracked, so any read makes it an input.
+  // A write to a part of a weight keeps the rest of it, like a read.
+  llvm::DenseSet<const Value *> inputs;
+  llvm::DenseSet<const Value *> outputs;
+  for (const auto &I : F->getInstrs()) {
+    // The views are only accessed through the instructions that use them.
+    if (isa<TensorViewInst>(&I)) {
+      continue;
+    }
+    for (const auto &op : I.getOperands()) {
+      auto *origin = getOrigin(op.first);
+      if (!isa<WeightVar>(origin)) {
+        continue;
+      }
+      bool isPartialWrite = op.second == OperandKind::Out &&
+                            op.first->getType()->size() <
+                                origin->getType()->size();
+      if (op.second != OperandKind::Out || isPartialWrite) {
+        inputs.insert(origin);
+      }
+      if (op.second != OperandKind::In) {
+        outputs.insert(origin);
+      }
+    }
+  }
+
+  CPUFunction::MemoryLayout layout;
+  layout.mutableWeightsSize = allocationsInfo.mutableWeightVarsMemSize_;
+  layout.activationsSize = allocationsInfo.activationsMemSize_;
+  auto addMutableWeight = [&](const Storage *S, Tensor *payload) {
+    auto *w = F->getWeightForNode(S);
+    layout.mutableWeights[S] = {payload,
+                                allocationsInfo.allocatedAddressed_[w],
+                                inputs.count(w) != 0, outputs.count(w) != 0};
+  };
+  for (auto *v : F->getGraph()->getParent()->getVars()) {
+    if (v->getVisibilityKind() == VisibilityKind::Public) {
+      addMutableWeight(v, &v->getPayload());
+    }
+  }
+  for (auto PH : ctx.pairs()) {
+    addMutableWeight(PH.first, PH.second);
+  }
+  return layout;
+}
+
+/// \returns the offsets of the values of the relocatable function \p F, in
+/// which the mutable weights and the views of them have the addresses of the
+/// tensors bound to the weights in \p layout. The function is executed with a
+/// null base address of the mutable weights, so that it reads and writes the
+/// tensors in place. The code is generated with the offsets assigned by
+/// \p allocationsInfo, which are independent of the addresses of the tensors,
+/// so that it can be cached.
+static std::vector<size_t>
+bindMutableWeightsInPlace(const IRFunction *F,
+                          const AllocationsInfo &allocationsInfo,
+                          const CPUFunction::MemoryLayout &layout) {
+  llvm::DenseMap<const Value *, const Tensor *> payloads;
+  for (const auto &MW : layout.mutableWeights) {
+    payloads[F->getWeightForNode(MW.first)] = MW.second.payload;
+  }
+  auto offsets = allocationsInfo.getOffsets();
+  for (const auto &I : allocationsInfo.valueNumbers_) {
+    if (I.second.first != AllocationsInfo::ValueKind::MutableWeight) {
+      continue;
+    }
+    auto *origin = getOrigin(I.first);
+    auto it = payloads.find(origin);
+    if (it == payloads.end()) {
+      // A placeholder that is not bound in the context is not accessed.
+      continue;
+    }
+    size_t &offset = offsets[I.second.second];
+    offset = offset - allocationsInfo.allocatedAddressed_.lookup(origin) +
+             (it->second->getUnsafePtr() - static_cast<char *>(nullptr));
+  }
+  return offsets;
+}
+
 } // end namespace
 
 std::unique_ptr<LLVMIRGen>
@@ -123,6 +429,19 @@ CPUBackend::createIRGen(IRFunction *IR,
   return std::unique_ptr<LLVMIRGen>(irgen);
 }
 
+CPUBackend::CPUBackend(bool reentrant) : reentrant_(reentrant) {
+  setObjectCacheDir(jitObjectCacheDir);
+}
+
+void CPUBackend::setObjectCacheDir(llvm::StringRef dir) {
+  if (dir.empty()) {
+    objectCache_.reset();
+    return;
+  }
+  objectCache_ = llvm::make_unique<JITObjectCache>(
+      dir, uint64_t(jitObjectCacheSize) << 20);
+}
+
 std::unique_ptr<CompiledFunction>
 CPUBackend::compileIR(std::unique_ptr<IRFunction> IR,
                       const Context &ctx) const {
@@ -130,17 +449,83 @@ CPUBackend::compileIR(std::unique_ptr<IRFunction> IR,
   std::unique_ptr<LLVMIRGen> irgen = createIRGen(IR.get(), allocationsInfo);
   irgen->initTargetMachine(target.empty() ? "" : target.getValue(),
                            llvm::CodeModel::Model::Large);
-  irgen->initCodeGen();
-  // Perform the address assignment for activations and WeightVars.
-  auto heap = allocateJITMemory(IR.get(), irgen->getAllocationsInfo(), ctx);
-  // Create the jitmain function to be invoked by JIT.
-  emitJitMain(*irgen);
-  // Emit the code for the body of the entry function.
-  irgen->performCodeGen();
-  // Hand over the module to JIT for the machine code generation.
+  // Split the work of large functions among multiple threads.
+  auto threadPool = getThreadPool();
+  irgen->setNumThreads(selectNumThreads(IR.get(), threadPool.get()));
+  irgen->setNumCodeGenParts(numCodeGenParts_ ? numCodeGenParts_
+                                             : jitCodeGenParts);
+  // Only the code that does not have any address baked in can be cached.
+  bool relocatable = objectCache_ != nullptr;
+  // Perform the address assignment for activations and WeightVars. The code
+  // of a relocatable function uses the offsets of a reentrant function, which
+  // do not depend on the addresses of the tensors.
+  void *heap = nullptr;
+  CPUFunction::MemoryLayout layout;
+  if (reentrant_ || relocatable) {
+    layout = allocateReentrantJITMemory(IR.get(), irgen->getAllocationsInfo(),
+                                        ctx);
+    if (!reentrant_ && layout.activationsSize) {
+      heap = alignedAlloc(layout.activationsSize, TensorAlignment);
+    }
+  } else {
+    heap = allocateJITMemory(IR.get(), irgen->getAllocationsInfo(), ctx);
+  }
+  // Look the code up in the cache before any LLVM IR is generated for it.
+  std::string key = relocatable ? irgen->getCodeDigest() : "";
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+  if (!key.empty()) {
+    objects = objectCache_->lookup(key);
+  }
+  if (objects.empty()) {
+    irgen->initCodeGen();
+    initParallelRuntime(*irgen, threadPool.get(), relocatable);
+    // Create the jitmain function to be invoked by JIT.
+    emitJitMain(*irgen, reentrant_ || relocatable, relocatable);
+    // Emit the code for the body of the entry function.
+    irgen->performCodeGen();
+    // Compile the parts of the code that were split off the module, using the
+    // threads that will execute it.
+    objects = irgen->compileCodeGenParts(threadPool.get());
+    // A relocatable module is compiled here rather than by the JIT, so that
+    // its object file can be cached.
+    if (relocatable) {
+      objects.push_back(irgen->compileModule());
+      if (!key.empty()) {
+        objectCache_->store(key, objects);
+      }
+    }
+  }
   auto JIT = llvm::make_unique<llvm::orc::GlowJIT>(irgen->getTargetMachine());
-  JIT->addModule(irgen->borrowModule());
-  return llvm::make_unique<CPUFunction>(std::move(JIT), heap);
+  for (auto &obj : objects) {
+    JIT->addObject(std::move(obj));
+  }
+  // Hand over the module to JIT for the machine code generation.
+  if (!relocatable) {
+    JIT->addModule(irgen->borrowModule());
+  }
+  if (irgen->getNumThreads() <= 1) {
+    threadPool.reset();
+  } else if (relocatable) {
+    bindParallelRuntime(*JIT, threadPool.get());
+  }
+  if (relocatable && reentrant_) {
+    return llvm::make_unique<CPUFunction>(
+        std::move(JIT), std::move(layout), std::move(threadPool),
+        irgen->getAllocationsInfo().getOffsets());
+  }
+  if (relocatable) {
+    auto offsets = bindMutableWeightsInPlace(
+        IR.get(), irgen->getAllocationsInfo(), layout);
+    return llvm::make_unique<CPUFunction>(std::move(JIT), heap,
+                                          std::move(threadPool),
+                                          std::move(offsets));
+  }
+  if (reentrant_) {
+    return llvm::make_unique<CPUFunction>(std::move(JIT), std::move(layout),
+                                          std::move(threadPool));
+  }
+  return llvm::make_unique<CPUFunction>(std::move(JIT), heap,
+                                        std::move(threadPool));
 }
 
 std::unique_ptr<CompiledFunction>
@@ -157,6 +542,12 @@ void CPUBackend::save(Function *F, llvm::StringRef outputDir,
 }
 
 bool CPUBackend::isOpSupported(Kinded::Kind opKind, ElemKind elementTy) const {
+  // Fused row-wise quantized data is only read by the embedding lookups.
+  if (elementTy == ElemKind::UInt8FusedQTy) {
+    return opKind ==
+           Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind;
+  }
+
   // Check for quantization support.
   if (elementTy == ElemKind::Int8QTy) {
     switch (opKind) {
@@ -180,6 +571,7 @@ bool CPUBackend::isOpSupported(Kinded::Kind opKind, ElemKind elementTy) const {
     case Kinded::Kind::ReluNodeKind:
     case Kinded::Kind::RescaleQuantizedNodeKind:
     case Kinded::Kind::ReshapeNodeKind:
+    case Kinded::Kind::RowwiseQuantizedSparseLengthsWeightedSumNodeKind:
     case Kinded::Kind::SelectNodeKind:
     case Kinded::Kind::SliceNodeKind:
     case Kinded::Kind::SigmoidNodeKind:
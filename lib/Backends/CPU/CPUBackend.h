@@ -17,6 +17,7 @@
 #define GLOW_BACKENDS_CPU_CPUBACKEND_H
 
 #include "AllocationsInfo.h"
+#include "JITObjectCache.h"
 #include "LLVMIRGen.h"
 #include "glow/Backends/Backend.h"
 #include "glow/Base/Tensor.h"
@@ -33,9 +34,22 @@ llvm::CallInst *createCall(llvm::IRBuilder<> &builder, llvm::Function *callee,
                            llvm::ArrayRef<llvm::Value *> args);
 
 class CPUBackend : public BackendUsingGlowIR {
+  /// Whether the compiled functions should be reentrant.
+  bool reentrant_{false};
+  /// The number of parts the code of the compiled functions is split into, or
+  /// 0 to use the -jit-codegen-parts option.
+  unsigned numCodeGenParts_{0};
+  /// The cache of the object files of the compiled functions, or null if
+  /// their code is always generated.
+  std::unique_ptr<JITObjectCache> objectCache_;
+
 public:
-  /// Ctor.
-  CPUBackend() = default;
+  /// Ctor. If \p reentrant is true, the compiled functions do not have the
+  /// addresses of the activations and of the mutable weights baked into their
+  /// code. Such functions can be executed concurrently by several threads using
+  /// per-thread execution contexts (see CPUFunction::ExecutionContext).
+  /// The object cache is set up from the -jit-object-cache-dir option.
+  explicit CPUBackend(bool reentrant = false);
 
   /// @name Backend methods.
   /// This is the implementation of the Backend interface.
@@ -58,6 +72,20 @@ public:
   bool shouldLower(const Node *N) const override;
   /// @}
 
+  /// Split the code of the compiled functions into \p numParts parts, which
+  /// are optimized and compiled to machine code in parallel. Zero selects the
+  /// -jit-codegen-parts option.
+  void setNumCodeGenParts(unsigned numParts) { numCodeGenParts_ = numParts; }
+
+  /// Cache the object files of the compiled functions in the directory
+  /// \p dir, which may be shared with other processes. The cache is disabled
+  /// if \p dir is empty. The functions compiled with a cache are relocatable
+  /// (see CPUFunction).
+  void setObjectCacheDir(llvm::StringRef dir);
+
+  /// \returns the object cache of the backend, or null if it has none.
+  const JITObjectCache *getObjectCache() const { return objectCache_.get(); }
+
 protected:
   /// Method that creates the LLVM IR generator. This gives the possibility to
   /// create a backend that inherits from the CPU backend, while providing
@@ -16,17 +16,73 @@
 
 #include "CPUFunction.h"
 
+#include "glow/Graph/Nodes.h"
 #include "glow/Support/Compiler.h"
 #include "glow/Support/Memory.h"
+#include "glow/Support/ThreadPool.h"
+
+#include <cstring>
 
 using namespace glow;
 
-CPUFunction::CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, void *heap)
-    : JIT_(std::move(JIT)), heap_(heap) {}
+CPUFunction::CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, void *heap,
+                         std::shared_ptr<ThreadPool> threadPool)
+    : JIT_(std::move(JIT)), heap_(heap), threadPool_(std::move(threadPool)) {}
+
+CPUFunction::CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, void *heap,
+                         std::shared_ptr<ThreadPool> threadPool,
+                         std::vector<size_t> offsets)
+    : JIT_(std::move(JIT)), heap_(heap), threadPool_(std::move(threadPool)),
+      offsets_(std::move(offsets)) {
+  resolveEntry();
+}
+
+CPUFunction::CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT,
+                         MemoryLayout layout,
+                         std::shared_ptr<ThreadPool> threadPool,
+                         std::vector<size_t> offsets)
+    : JIT_(std::move(JIT)), threadPool_(std::move(threadPool)),
+      reentrant_(true), layout_(std::move(layout)),
+      offsets_(std::move(offsets)) {
+  resolveEntry();
+}
+
+void CPUFunction::resolveEntry() {
+  // Resolve the entry point once, so that the executions do not need to touch
+  // the JIT, which is not thread-safe.
+  auto sym = JIT_->findSymbol("jitmain");
+  assert(sym && "Unable to JIT the code!");
+  auto address = sym.getAddress();
+  GLOW_ASSERT(address && "Error getting address.");
+  reentrantEntry_ = reinterpret_cast<ReentrantEntryTy>(address.get());
+}
 
 CPUFunction::~CPUFunction() { alignedFree(heap_); }
 
+std::unique_ptr<CPUFunction::ExecutionContext>
+CPUFunction::createExecutionContext() const {
+  assert(reentrant_ && "Only reentrant functions have execution contexts");
+  return std::unique_ptr<ExecutionContext>(new ExecutionContext(this));
+}
+
 void CPUFunction::execute() {
+  if (reentrant_) {
+    std::lock_guard<std::mutex> lock(defaultContextMtx_);
+    if (!defaultContext_) {
+      defaultContext_ = createExecutionContext();
+    }
+    defaultContext_->copyInputsFromPayloads();
+    defaultContext_->execute();
+    defaultContext_->copyOutputsToPayloads();
+    return;
+  }
+
+  if (reentrantEntry_) {
+    // The mutable weights are bound in place, so their base address is null.
+    reentrantEntry_(offsets_.data(), nullptr, static_cast<uint8_t *>(heap_));
+    return;
+  }
+
   auto sym = JIT_->findSymbol("jitmain");
   assert(sym && "Unable to JIT the code!");
   using JitFuncType = void (*)(void);
@@ -38,3 +94,55 @@ void CPUFunction::execute() {
     GLOW_ASSERT(false && "Error getting address.");
   }
 }
+
+/// Allocate \p size bytes of memory for a tensor buffer. \returns null if
+/// \p size is zero.
+static uint8_t *allocateContextMemory(size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+  return static_cast<uint8_t *>(alignedAlloc(size, TensorAlignment));
+}
+
+CPUFunction::ExecutionContext::ExecutionContext(const CPUFunction *F)
+    : F_(F),
+      mutableWeights_(allocateContextMemory(F->layout_.mutableWeightsSize)),
+      activations_(allocateContextMemory(F->layout_.activationsSize)) {}
+
+CPUFunction::ExecutionContext::~ExecutionContext() {
+  alignedFree(mutableWeights_);
+  alignedFree(activations_);
+}
+
+Tensor CPUFunction::ExecutionContext::getTensor(const Storage *S) const {
+  auto it = F_->layout_.mutableWeights.find(S);
+  GLOW_ASSERT(it != F_->layout_.mutableWeights.end() &&
+              "Not a mutable weight of the function");
+  return Tensor(mutableWeights_ + it->second.offset, S->getType());
+}
+
+void CPUFunction::ExecutionContext::copyInputsFromPayloads() {
+  for (const auto &MW : F_->layout_.mutableWeights) {
+    if (!MW.second.isInput) {
+      continue;
+    }
+    auto *payload = MW.second.payload;
+    memcpy(mutableWeights_ + MW.second.offset, payload->getUnsafePtr(),
+           payload->getType().getSizeInBytes());
+  }
+}
+
+void CPUFunction::ExecutionContext::copyOutputsToPayloads() const {
+  for (const auto &MW : F_->layout_.mutableWeights) {
+    if (!MW.second.isOutput) {
+      continue;
+    }
+    auto *payload = MW.second.payload;
+    memcpy(payload->getUnsafePtr(), mutableWeights_ + MW.second.offset,
+           payload->getType().getSizeInBytes());
+  }
+}
+
+void CPUFunction::ExecutionContext::execute() {
+  F_->reentrantEntry_(F_->offsets_.data(), mutableWeights_, activations_);
+}
@@ -19,25 +19,164 @@
 #include "GlowJIT.h"
 
 #include "glow/Backends/CompiledFunction.h"
+#include "glow/Base/Tensor.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace glow {
 
+class Storage;
+class ThreadPool;
+
 /// A Glow IR function compiled for the CPU using LLVM.
+///
+/// A function compiled in the reentrant mode does not have any memory for the
+/// activations and the mutable weights baked into its code. Instead, every
+/// execution uses the memory of an ExecutionContext, so that several threads
+/// can run the same compiled function at once, each with its own context.
+///
+/// A relocatable function does not have any address baked into its code. The
+/// offsets of all of its values, including the addresses of the constant
+/// weights, are passed to its code on every execution. Its code can be cached
+/// and reused by other processes. A relocatable function that is not
+/// reentrant binds its mutable weights in place: their offsets are the
+/// addresses of the tensors bound to them at compile time.
 class CPUFunction final : public CompiledFunction {
+public:
+  /// Describes where a mutable weight lives inside the mutable weights memory
+  /// of a reentrant function.
+  struct MutableWeight {
+    /// The tensor bound to the weight at compile time.
+    Tensor *payload;
+    /// The offset of the weight in the mutable weights memory.
+    size_t offset;
+    /// Whether the function reads the weight or only writes a part of it.
+    bool isInput;
+    /// Whether the function writes the weight.
+    bool isOutput;
+  };
+
+  /// The memory requirements of a single execution of a reentrant function.
+  struct MemoryLayout {
+    /// Size of the mutable weights memory.
+    size_t mutableWeightsSize{0};
+    /// Size of the activations memory.
+    size_t activationsSize{0};
+    /// Maps the Variables and Placeholders to their mutable weights.
+    std::unordered_map<const Storage *, MutableWeight> mutableWeights;
+  };
+
+  /// The memory used by a single execution of a reentrant function. Contexts
+  /// are not thread-safe, but different contexts of the same function can be
+  /// used concurrently.
+  class ExecutionContext final {
+    friend class CPUFunction;
+    /// The function this context belongs to.
+    const CPUFunction *F_;
+    /// The mutable weights memory.
+    uint8_t *mutableWeights_;
+    /// The activations memory.
+    uint8_t *activations_;
+
+    /// Ctor.
+    explicit ExecutionContext(const CPUFunction *F);
+
+  public:
+    /// Dtor.
+    ~ExecutionContext();
+
+    ExecutionContext(const ExecutionContext &) = delete;
+    ExecutionContext &operator=(const ExecutionContext &) = delete;
+
+    /// \returns an unowned tensor that aliases the memory of the Variable or
+    /// Placeholder \p S in this context. Inputs should be written into it
+    /// before calling execute() and outputs read from it afterwards.
+    Tensor getTensor(const Storage *S) const;
+
+    /// Copy the contents of the tensors bound to the mutable weights that are
+    /// inputs of the function at compile time into this context.
+    void copyInputsFromPayloads();
+
+    /// Copy the mutable weights of this context that are outputs of the
+    /// function back into the tensors bound to them at compile time.
+    void copyOutputsToPayloads() const;
+
+    /// Execute the function using the memory of this context.
+    void execute();
+  };
+
+private:
+  /// The signature of the entry point of a reentrant function. The
+  /// \p offsets are only used by relocatable functions.
+  using ReentrantEntryTy = void (*)(const size_t *offsets,
+                                    uint8_t *mutableWeights,
+                                    uint8_t *activations);
+
   /// The LLVM JIT engine. The jit must be initialized after the ctor
   /// initializes the LLVM backends.
   std::unique_ptr<llvm::orc::GlowJIT> JIT_;
-  /// This represents the heap, that stores the activations at runtime.
-  void *heap_;
+  /// This represents the heap, that stores the activations at runtime. It is
+  /// null for reentrant functions.
+  void *heap_{nullptr};
+  /// The thread pool used by the parallel kernels of the JITed code. The code
+  /// refers to the pool, so the function keeps it alive. It is null if the
+  /// code is single-threaded.
+  std::shared_ptr<ThreadPool> threadPool_;
+  /// Whether the function is reentrant.
+  bool reentrant_{false};
+  /// The memory requirements of the reentrant function.
+  MemoryLayout layout_;
+  /// The offsets of the values of a relocatable function, indexed by their
+  /// numbers. It is empty for the other functions.
+  std::vector<size_t> offsets_;
+  /// The entry point of the reentrant or relocatable function.
+  ReentrantEntryTy reentrantEntry_{nullptr};
+  /// The context used by execute() for reentrant functions. It is created on
+  /// the first use.
+  std::unique_ptr<ExecutionContext> defaultContext_;
+  /// Serializes the executions using the default context.
+  std::mutex defaultContextMtx_;
+
+  /// Look up the entry point of a reentrant or relocatable function.
+  void resolveEntry();
 
 public:
-  /// Ctor.
-  CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, void *heap);
+  /// Ctor. Creates a function that uses the activations memory \p heap and
+  /// the absolute addresses of the weights.
+  CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, void *heap,
+              std::shared_ptr<ThreadPool> threadPool);
+
+  /// Ctor. Creates a relocatable function that uses the activations memory
+  /// \p heap and the \p offsets of its values, in which the mutable weights
+  /// have the addresses of the tensors bound to them.
+  CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, void *heap,
+              std::shared_ptr<ThreadPool> threadPool,
+              std::vector<size_t> offsets);
+
+  /// Ctor. Creates a reentrant function with the memory requirements
+  /// \p layout. The function is relocatable if \p offsets is not empty.
+  CPUFunction(std::unique_ptr<llvm::orc::GlowJIT> JIT, MemoryLayout layout,
+              std::shared_ptr<ThreadPool> threadPool,
+              std::vector<size_t> offsets = {});
+
+  /// \returns true if the function can be executed concurrently using
+  /// different execution contexts.
+  bool isReentrant() const { return reentrant_; }
+
+  /// \returns a new execution context for the reentrant function.
+  std::unique_ptr<ExecutionContext> createExecutionContext() const;
 
   /// \name CompiledFunction interface
   ///@{
   ~CPUFunction() override;
 
+  /// Execute the function. Reentrant functions are executed using a default
+  /// context. Its inputs are copied from the tensors bound to the mutable
+  /// weights at compile time before the execution, and its outputs are copied
+  /// back afterwards. The other mutable weights stay in the context.
   void execute() override;
   ///@}
 };
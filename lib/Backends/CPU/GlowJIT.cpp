@@ -125,11 +125,32 @@ GlowJIT::ModuleHandle GlowJIT::addModule(std::unique_ptr<Module> M) {
   cantFail(compileLayer_.addModule(K, std::move(M)));
   return K;
 #else
+  return cantFail(compileLayer_.addModule(std::move(M), createResolver()));
+#endif
+}
+
+GlowJIT::ModuleHandle GlowJIT::addObject(std::unique_ptr<MemoryBuffer> obj) {
+#if LLVM_VERSION_MAJOR > 6
+  auto K = ES_.allocateVModule();
+  cantFail(objectLayer_.addObject(K, std::move(obj)));
+  return K;
+#else
+  auto objFile =
+      cantFail(object::ObjectFile::createObjectFile(obj->getMemBufferRef()));
+  auto owningObj = std::make_shared<object::OwningBinary<object::ObjectFile>>(
+      std::move(objFile), std::move(obj));
+  return cantFail(
+      objectLayer_.addObject(std::move(owningObj), createResolver()));
+#endif
+}
+
+#if LLVM_VERSION_MAJOR <= 6
+std::shared_ptr<llvm::JITSymbolResolver> GlowJIT::createResolver() {
   // Build our symbol resolver:
   // Lambda 1: Look back into the JIT itself to find symbols that are part of
   //           the same "logical dylib".
   // Lambda 2: Search for external symbols in the host process.
-  auto resolver = createLambdaResolver(
+  return createLambdaResolver(
       [&](const std::string &name) {
         if (auto sym = compileLayer_.findSymbol(name, false))
           return sym;
@@ -140,10 +161,8 @@ GlowJIT::ModuleHandle GlowJIT::addModule(std::unique_ptr<Module> M) {
           return JITSymbol(symAddr, JITSymbolFlags::Exported);
         return JITSymbol(nullptr);
       });
-
-  return cantFail(compileLayer_.addModule(std::move(M), std::move(resolver)));
-#endif
 }
+#endif
 
 void GlowJIT::removeModule(GlowJIT::ModuleHandle H) {
   cantFail(compileLayer_.removeModule(H));
@@ -29,6 +29,7 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include <algorithm>
@@ -53,6 +54,12 @@ private:
   RTDyldObjectLinkingLayer objectLayer_;
   IRCompileLayer<decltype(objectLayer_), SimpleCompiler> compileLayer_;
 
+#if LLVM_VERSION_MAJOR <= 6
+  /// \returns a resolver that looks up the symbols in the modules and object
+  /// files of the JIT, and then in the host process.
+  std::shared_ptr<JITSymbolResolver> createResolver();
+#endif
+
 public:
   GlowJIT(llvm::TargetMachine &TM);
 
@@ -68,6 +75,10 @@ public:
 
   ModuleHandle addModule(std::unique_ptr<Module> M);
 
+  /// Add the object file \p obj, which was compiled for the target machine of
+  /// the JIT. Its symbols and the symbols of the modules resolve each other.
+  ModuleHandle addObject(std::unique_ptr<MemoryBuffer> obj);
+
   void removeModule(ModuleHandle H);
 };
 
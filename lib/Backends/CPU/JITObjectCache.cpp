@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "JITObjectCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace glow;
+
+/// The extension of the files of the entries. Only the files that have it
+/// are ever removed from the directory.
+static const llvm::StringRef entryExtension = ".glowobj";
+
+/// The first bytes of every entry. An entry then holds the number of its
+/// object files, followed by the size and the contents of each of them.
+static const llvm::StringRef entryMagic = "GLOWJIT1";
+
+/// \returns the object files of the entry \p data, or an empty list if it is
+/// malformed.
+static std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+parseEntry(llvm::StringRef data) {
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+  auto readSize = [&](uint64_t &size) {
+    if (data.size() < sizeof(size)) {
+      return false;
+    }
+    memcpy(&size, data.data(), sizeof(size));
+    data = data.drop_front(sizeof(size));
+    return true;
+  };
+  uint64_t numObjects;
+  if (!data.consume_front(entryMagic) || !readSize(numObjects)) {
+    return objects;
+  }
+  for (uint64_t i = 0; i < numObjects; i++) {
+    uint64_t size;
+    if (!readSize(size) || data.size() < size) {
+      objects.clear();
+      return objects;
+    }
+    // The object files are copied, so that each of them is suitably aligned
+    // for the object file parser.
+    objects.push_back(llvm::MemoryBuffer::getMemBufferCopy(
+        data.take_front(size), "cached object"));
+    data = data.drop_front(size);
+  }
+  if (!data.empty()) {
+    objects.clear();
+  }
+  return objects;
+}
+
+JITObjectCache::JITObjectCache(llvm::StringRef dir, uint64_t maxSize)
+    : dir_(dir), maxSize_(maxSize) {
+  llvm::sys::fs::create_directories(dir_);
+}
+
+std::string JITObjectCache::getPath(llvm::StringRef key) const {
+  llvm::SmallString<128> path(dir_);
+  llvm::sys::path::append(path, key + entryExtension);
+  return path.str().str();
+}
+
+std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+JITObjectCache::lookup(llvm::StringRef key) {
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+  auto path = getPath(key);
+  int fd;
+  if (!llvm::sys::fs::openFileForRead(path, fd)) {
+    auto buffer =
+        llvm::MemoryBuffer::getOpenFile(fd, path, /* FileSize */ -1,
+                                        /* RequiresNullTerminator */ false);
+    if (buffer) {
+      objects = parseEntry((*buffer)->getBuffer());
+    }
+    // Mark the entry as used, which makes it the last one to be evicted.
+    auto now = std::chrono::time_point_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now());
+#if LLVM_VERSION_MAJOR > 7
+    llvm::sys::fs::setLastAccessAndModificationTime(fd, now);
+#else
+    llvm::sys::fs::setLastModificationAndAccessTime(fd, now);
+#endif
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  }
+  if (objects.empty()) {
+    numMisses_++;
+  } else {
+    numHits_++;
+  }
+  return objects;
+}
+
+void JITObjectCache::store(
+    llvm::StringRef key,
+    llvm::ArrayRef<std::unique_ptr<llvm::MemoryBuffer>> objects) {
+  // Write the entry into a temporary file and rename it, so that other
+  // processes never load a partially written entry.
+  auto path = getPath(key);
+  int fd;
+  llvm::SmallString<128> tmpPath;
+  if (llvm::sys::fs::createUniqueFile(path + ".tmp%%%%%%", fd, tmpPath)) {
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /* shouldClose */ true);
+    auto writeSize = [&](uint64_t size) {
+      os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    };
+    os << entryMagic;
+    writeSize(objects.size());
+    for (const auto &obj : objects) {
+      writeSize(obj->getBufferSize());
+      os << obj->getBuffer();
+    }
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(tmpPath, path)) {
+    llvm::sys::fs::remove(tmpPath);
+    return;
+  }
+  evict();
+}
+
+void JITObjectCache::evict() {
+  struct Entry {
+    std::string path;
+    uint64_t size;
+    llvm::sys::TimePoint<> lastUse;
+  };
+  std::vector<Entry> entries;
+  uint64_t totalSize = 0;
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator it(dir_, EC), end; it != end && !EC;
+       it.increment(EC)) {
+    // The temporary files of the entries that are being written, or whose
+    // process was interrupted, are evicted as well.
+    auto name = llvm::sys::path::filename(it->path());
+    if (name.find(entryExtension) == llvm::StringRef::npos) {
+      continue;
+    }
+    llvm::sys::fs::file_status status;
+    if (llvm::sys::fs::status(it->path(), status)) {
+      continue;
+    }
+    entries.push_back(
+        {it->path(), status.getSize(), status.getLastModificationTime()});
+    totalSize += status.getSize();
+  }
+  if (totalSize <= maxSize_) {
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) {
+              return a.lastUse < b.lastUse;
+            });
+  for (const auto &E : entries) {
+    if (totalSize <= maxSize_) {
+      break;
+    }
+    // Another process may have removed the entry already.
+    llvm::sys::fs::remove(E.path);
+    totalSize -= E.size;
+  }
+}
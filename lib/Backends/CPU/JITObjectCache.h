@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_BACKENDS_CPU_JITOBJECTCACHE_H
+#define GLOW_BACKENDS_CPU_JITOBJECTCACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace glow {
+
+/// A cache of the object files of the functions compiled by the CPU backend,
+/// which is kept in a directory shared between processes. A process that
+/// compiles a function which an earlier process already compiled loads its
+/// object files instead of generating and optimizing its LLVM IR.
+///
+/// The cache does not know what the object files contain. The CPU backend
+/// keys them by a digest of everything their code depends on (see
+/// LLVMIRGen::getCodeDigest), and only caches code that does not have any
+/// address of the process baked into it.
+///
+/// The size of the directory is bounded. Once it is exceeded, the least
+/// recently used entries are removed.
+class JITObjectCache {
+  /// The directory that holds the entries.
+  std::string dir_;
+  /// The maximal size of the entries in the directory in bytes.
+  uint64_t maxSize_;
+  /// The number of lookups that found their entry.
+  std::atomic<size_t> numHits_{0};
+  /// The number of lookups that did not find their entry.
+  std::atomic<size_t> numMisses_{0};
+
+  /// \returns the path of the entry with the key \p key.
+  std::string getPath(llvm::StringRef key) const;
+
+  /// Remove the least recently used entries until the directory holds at
+  /// most maxSize_ bytes.
+  void evict();
+
+public:
+  /// Ctor. Creates the directory \p dir if it does not exist. The entries in
+  /// it take up at most \p maxSize bytes.
+  JITObjectCache(llvm::StringRef dir, uint64_t maxSize);
+
+  /// \returns the object files stored with the key \p key, or an empty list
+  /// if they are not in the cache.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> lookup(llvm::StringRef key);
+
+  /// Store the object files \p objects with the key \p key. Failing to write
+  /// them only means that they are not cached.
+  void store(llvm::StringRef key,
+             llvm::ArrayRef<std::unique_ptr<llvm::MemoryBuffer>> objects);
+
+  /// \returns the directory of the cache.
+  llvm::StringRef getDir() const { return dir_; }
+
+  /// \returns the number of lookups of this cache that found their entry.
+  size_t getNumHits() const { return numHits_; }
+
+  /// \returns the number of lookups of this cache that did not find their
+  /// entry.
+  size_t getNumMisses() const { return numMisses_; }
+};
+
+} // namespace glow
+
+#endif // GLOW_BACKENDS_CPU_JITOBJECTCACHE_H
@@ -23,16 +23,26 @@
 #include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
 #include "glow/Quantization/Base/Base.h"
-
+#include "glow/Support/ThreadPool.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 using namespace glow;
 using llvm::cast;
@@ -64,6 +74,14 @@ llvm::cl::opt<llvm::Reloc::Model> relocModel(
         clEnumValN(llvm::Reloc::PIC_, "pic", "Position independent code")),
     llvm::cl::init(llvm::Reloc::Static), llvm::cl::cat(CPUBackendCat));
 
+llvm::cl::opt<bool> fuseLoopNests(
+    "fuse-loop-nests",
+    llvm::cl::desc("Fuse broadcasts, reductions and int8 conversions into the "
+                   "loop nests of the data-parallel kernels"),
+    llvm::cl::init(true), llvm::cl::cat(CPUBackendCat));
+
+extern llvm::cl::opt<bool> jitSpecializeDims;
+
 /// Generate the LLVM MAttr list of attributes.
 static llvm::SmallVector<std::string, 0> getMachineAttributes() {
   llvm::SmallVector<std::string, 0> result;
@@ -138,24 +156,21 @@ void LLVMIRGen::loadBaseAddresses(llvm::IRBuilder<> &builder) {
   offsetsArray_ = F->args().begin() + 3;
 }
 
-// Search for the standard library bitcode file on disk and load it into an
-// LLVM module. We search for the standard library around the current executable
-// and also in the current directory.
-static std::unique_ptr<llvm::Module>
-loadStandardLibrary(llvm::LLVMContext *ctx, llvm::StringRef filename) {
+// Search for the standard library bitcode file on disk. We search for the
+// standard library around the current executable and also in the current
+// directory. \returns the path of the file.
+static std::string findStandardLibrary(llvm::StringRef filename) {
   using llvm::sys::path::append;
   using llvm::sys::path::parent_path;
 
-  llvm::SMDiagnostic error;
-
   auto *envPath = getenv("GLOW_LIBJIT_PATH");
   if (envPath != nullptr) {
-    return llvm::parseIRFile(envPath, error, *ctx);
+    return envPath;
   }
 
   // Figure out the location of the current executable.
   auto mainExec =
-      llvm::sys::fs::getMainExecutable(nullptr, (void *)&loadStandardLibrary);
+      llvm::sys::fs::getMainExecutable(nullptr, (void *)&findStandardLibrary);
   llvm::StringRef basePath = parent_path(mainExec);
 
   // Search for the standard library starting at the location of the executable.
@@ -164,20 +179,39 @@ loadStandardLibrary(llvm::LLVMContext *ctx, llvm::StringRef filename) {
     llvm::SmallString<256> libPath(basePath);
     append(libPath, filename);
     if (llvm::sys::fs::exists(libPath)) {
-      auto res = llvm::parseIRFile(libPath, error, *ctx);
-
-      // If we could not parse the bitcode file then print an error.
-      if (!res.get()) {
-        error.print(mainExec.c_str(), llvm::errs());
-      }
-      return res;
+      return libPath.str().str();
     }
 
     // Go up the filesystem tree.
     basePath = parent_path(basePath);
   }
 
-  return llvm::parseIRFile(filename, error, *ctx);
+  return filename.str();
+}
+
+// Load the standard library bitcode file \p filename into an LLVM module.
+static std::unique_ptr<llvm::Module>
+loadStandardLibrary(llvm::LLVMContext *ctx, llvm::StringRef filename) {
+  llvm::SMDiagnostic error;
+  auto res = llvm::parseIRFile(findStandardLibrary(filename), error, *ctx);
+
+  // If we could not parse the bitcode file then print an error.
+  if (!res.get()) {
+    error.print(nullptr, llvm::errs());
+  }
+  return res;
+}
+
+/// \returns a digest of the contents of the standard library bitcode file
+/// \p filename, or an empty string if the file cannot be read.
+static std::string getStandardLibraryDigest(llvm::StringRef filename) {
+  auto buffer = llvm::MemoryBuffer::getFile(findStandardLibrary(filename));
+  if (!buffer) {
+    return "";
+  }
+  llvm::SHA1 hasher;
+  hasher.update((*buffer)->getBuffer());
+  return hasher.final().str();
 }
 
 /// Register a diagnostics handler that prevents the compiler from printing to
@@ -246,6 +280,8 @@ llvm::Type *LLVMIRGen::getElementType(llvm::IRBuilder<> &builder,
     return builder.getInt16Ty();
   case ElemKind::Int32QTy:
     return builder.getInt32Ty();
+  case ElemKind::UInt8FusedQTy:
+    return builder.getInt8Ty();
   }
   return nullptr;
 }
@@ -312,6 +348,7 @@ llvm::Value *LLVMIRGen::emitValueAddress(llvm::IRBuilder<> &builder,
     T = llvm::Type::getFloatPtrTy(ctx_);
     break;
   case ElemKind::Int8QTy:
+  case ElemKind::UInt8FusedQTy:
     T = llvm::Type::getInt8PtrTy(ctx_);
     break;
   case ElemKind::Int64ITy:
@@ -353,12 +390,9 @@ llvm::Value *
 LLVMIRGen::emitConstOffsetsArray(llvm::IRBuilder<> &builder,
                                  const AllocationsInfo &allocationsInfo) {
   auto sizeTType = builder.getIntNTy(sizeof(size_t) * 8);
-  std::vector<llvm::Constant *> elems(allocationsInfo.valueNumbers_.size());
-  for (auto &I : allocationsInfo.valueNumbers_) {
-    auto *V = I.first;
-    auto offset = I.second.second;
-    elems[offset] = llvm::ConstantInt::get(
-        sizeTType, allocationsInfo.allocatedAddressed_.lookup(V));
+  std::vector<llvm::Constant *> elems;
+  for (auto offset : allocationsInfo.getOffsets()) {
+    elems.push_back(llvm::ConstantInt::get(sizeTType, offset));
   }
   auto *arr = llvm::ConstantArray::get(
       llvm::ArrayType::get(sizeTType, elems.size()), elems);
@@ -458,6 +492,8 @@ llvm::Value *LLVMIRGen::emitConst(llvm::IRBuilder<> &builder, float val,
     return builder.getInt16(static_cast<int16_t>(val));
   case ElemKind::Int32QTy:
     return builder.getInt32(static_cast<int32_t>(val));
+  case ElemKind::UInt8FusedQTy:
+    return builder.getInt8(static_cast<uint8_t>(val));
   }
   llvm_unreachable("Unknown element type");
 }
@@ -514,15 +550,16 @@ llvm::Function *LLVMIRGen::getFunction(const std::string &name,
   }
 }
 
-/// Create LLVM IR for the for loop with a loop count specified by the only
-/// parameter of the enclosing function.
+/// Create LLVM IR for the for loop iterating from \p begin to \p end. The
+/// loop body is executed at least once, i.e. \p begin should be less than
+/// \p end.
 /// \returns a pair of basic blocks. The first BB is the BB of the loop body,
 /// the second BB is the loop exit BB.
 static std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
 createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
-           llvm::Value *numElements) {
+           llvm::Value *begin, llvm::Value *end) {
   auto sizeTTy = builder.getIntNTy(sizeof(size_t) * 8);
-  auto *initVal = llvm::ConstantInt::get(sizeTTy, 0);
+  auto *initVal = begin;
 
   // Make the new basic block for the loop header. Insert it after current
   // block.
@@ -545,7 +582,7 @@ createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
   auto *nextVal = builder.CreateAdd(var, stepVal, "nextvar", /* HasNUW */ true,
                                     /* HasNSW */ true);
   // Compute the end condition.
-  auto *endCond = builder.CreateICmpULT(nextVal, numElements, "loopcond");
+  auto *endCond = builder.CreateICmpULT(nextVal, end, "loopcond");
 
   // Create the "after loop" block and insert it.
   auto *afterBB = llvm::BasicBlock::Create(ctx, "afterloop", func);
@@ -590,6 +627,227 @@ emitBufferAddress(llvm::IRBuilder<> &builder, Value *val,
   return kernel->args().begin() + bufferToArgNum[val];
 }
 
+/// \returns true if \p I is an instruction that reads or writes its operands
+/// in a single pass over them, which can be fused into the loop nest of a
+/// data-parallel kernel, but is not data-parallel itself.
+static bool isNestKind(const Instruction *I) {
+  return isa<BatchedAddInst>(I) || isa<BatchedReduceAddInst>(I) ||
+         isa<QuantizeInst>(I) || isa<DequantizeInst>(I) ||
+         isa<RescaleQuantizedInst>(I);
+}
+
+/// \returns true if the instruction \p I can be stacked into a data-parallel
+/// kernel. Broadcasts are iterated by the inner loop of the nest, reductions
+/// over the outermost dimension accumulate the rows of the nest, and the int8
+/// conversions are computed element-wise.
+static bool isStackable(const Instruction *I) {
+  if (I->isDataParallel()) {
+    return true;
+  }
+  if (!fuseLoopNests) {
+    return false;
+  }
+  if (auto *BA = dyn_cast<BatchedAddInst>(I)) {
+    auto kind = BA->getDest()->getElementType();
+    return (kind == ElemKind::FloatTy || kind == ElemKind::Int8QTy) &&
+           BA->getBatch()->getElementType() == kind &&
+           BA->getSlice()->getElementType() == kind;
+  }
+  if (auto *BR = dyn_cast<BatchedReduceAddInst>(I)) {
+    return BR->getAxis() == 0 &&
+           BR->getDest()->getElementType() == ElemKind::FloatTy;
+  }
+  if (auto *QI = dyn_cast<QuantizeInst>(I)) {
+    return QI->getDest()->getElementType() == ElemKind::Int8QTy;
+  }
+  if (auto *DQI = dyn_cast<DequantizeInst>(I)) {
+    return DQI->getSrc()->getElementType() == ElemKind::Int8QTy;
+  }
+  if (auto *RQI = dyn_cast<RescaleQuantizedInst>(I)) {
+    return RQI->getDest()->getElementType() == ElemKind::Int8QTy &&
+           RQI->getSrc()->getElementType() == ElemKind::Int8QTy;
+  }
+  return false;
+}
+
+/// \returns the number of iterations of the stackable instruction \p I.
+static size_t getIterationSize(const Instruction *I) {
+  if (auto *BR = dyn_cast<BatchedReduceAddInst>(I)) {
+    return BR->getBatch()->size();
+  }
+  return I->getOperand(0).first->size();
+}
+
+/// \returns the size of the slice that the stackable instruction \p I
+/// broadcasts or reduces to, i.e. the number of iterations of the inner loop
+/// of its nest. \returns 0 if \p I is computed element-wise.
+static size_t getSliceSize(const Instruction *I) {
+  if (auto *BA = dyn_cast<BatchedAddInst>(I)) {
+    return BA->getSlice()->size();
+  }
+  if (auto *BR = dyn_cast<BatchedReduceAddInst>(I)) {
+    return BR->getDest()->size();
+  }
+  return 0;
+}
+
+/// \returns the operand of \p I that is not indexed by the iteration, i.e.
+/// the broadcast slice or the reduced result, or nullptr if there is none.
+static Value *getSliceOperand(const Instruction *I) {
+  if (auto *BA = dyn_cast<BatchedAddInst>(I)) {
+    return BA->getSlice();
+  }
+  if (auto *BR = dyn_cast<BatchedReduceAddInst>(I)) {
+    return BR->getDest();
+  }
+  return nullptr;
+}
+
+/// \returns true if the memory regions of the buffers \p a and \p b overlap,
+/// including the case when they are the same.
+static bool isOverlapping(AllocationsInfo &allocationsInfo, Value *a,
+                          Value *b) {
+  auto addrA = allocationsInfo.allocatedAddressed_[a];
+  auto addrB = allocationsInfo.allocatedAddressed_[b];
+  return addrA < addrB + b->getSizeInBytes() &&
+         addrB < addrA + a->getSizeInBytes();
+}
+
+/// \returns true if the loop nest of the instruction \p I reads a slice it
+/// writes, or writes a result it reads, in other iterations than the current
+/// one. Such an instruction is not data-parallel.
+static bool isSelfConflicting(AllocationsInfo &allocationsInfo,
+                              const Instruction *I) {
+  if (auto *BA = dyn_cast<BatchedAddInst>(I)) {
+    return isOverlapping(allocationsInfo, BA->getDest(), BA->getSlice());
+  }
+  if (auto *BR = dyn_cast<BatchedReduceAddInst>(I)) {
+    return isOverlapping(allocationsInfo, BR->getDest(), BR->getBatch());
+  }
+  return false;
+}
+
+/// \returns true if the instructions \p I and \p J cannot share a loop nest,
+/// because one of them accesses the slice of the other one in other iterations
+/// than the current one. A broadcast slice must not be written by the nest,
+/// and a reduced result is complete only after the nest.
+static bool isConflictingInNest(AllocationsInfo &allocationsInfo,
+                                const Instruction *I, const Instruction *J) {
+  for (auto *X : {I, J}) {
+    auto *Y = X == I ? J : I;
+    auto *slice = getSliceOperand(X);
+    if (!slice) {
+      continue;
+    }
+    bool isReduction = isa<BatchedReduceAddInst>(X);
+    for (const auto &op : Y->getOperands()) {
+      if (!isReduction && op.second == OperandKind::In) {
+        continue;
+      }
+      if (isOverlapping(allocationsInfo, slice, op.first)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// The minimal number of elements processed by a single task of a parallel
+/// data-parallel kernel.
+static constexpr size_t minElementsPerTask = 16384;
+
+/// The number of elements the chunks of parallel data-parallel kernels are
+/// aligned to. This keeps the vectorized loops in the chunks aligned and avoids
+/// false sharing between the threads.
+static constexpr size_t parallelChunkAlignment = 64;
+
+void LLVMIRGen::emitParallelKernelCall(llvm::IRBuilder<> &builder,
+                                       llvm::Function *kernel,
+                                       llvm::ArrayRef<llvm::Value *> buffers,
+                                       size_t numElements, size_t numTasks,
+                                       size_t chunkAlignment) {
+  auto *sizeTTy = builder.getIntNTy(sizeof(size_t) * 8);
+  auto *int8PtrTy = builder.getInt8PtrTy();
+  auto *parallelFor = getFunction("parallel_for");
+  auto *taskRange = getFunction("task_range");
+  auto *taskFuncTy = llvm::cast<llvm::FunctionType>(
+      llvm::cast<llvm::PointerType>(
+          parallelFor->getFunctionType()->getParamType(0))
+          ->getElementType());
+
+  // Create the task function. It receives the array of buffers as its context,
+  // computes its range of iterations and invokes the kernel on it.
+  auto *taskFunc =
+      llvm::Function::Create(taskFuncTy, llvm::Function::InternalLinkage,
+                             "libjit_stacked_task", llmodule_.get());
+  auto *entryBB = llvm::BasicBlock::Create(ctx_, "entry", taskFunc);
+  auto *runBB = llvm::BasicBlock::Create(ctx_, "run", taskFunc);
+  auto *exitBB = llvm::BasicBlock::Create(ctx_, "exit", taskFunc);
+  llvm::IRBuilder<> taskBuilder(entryBB);
+  auto taskArgs = taskFunc->arg_begin();
+  llvm::Value *ctxArg = &*taskArgs++;
+  llvm::Value *taskId = &*taskArgs++;
+  llvm::Value *numTasksArg = &*taskArgs++;
+
+  // Compute the range of iterations in the units of aligned chunks.
+  auto *beginPtr = taskBuilder.CreateAlloca(sizeTTy);
+  auto *endPtr = taskBuilder.CreateAlloca(sizeTTy);
+  size_t numChunks = (numElements + chunkAlignment - 1) / chunkAlignment;
+  createCall(taskBuilder, taskRange,
+             {emitConstSizeT(taskBuilder, numChunks), taskId, numTasksArg,
+              beginPtr, endPtr});
+  auto *chunkSize = emitConstSizeT(taskBuilder, chunkAlignment);
+  auto *numElementsVal = emitConstSizeT(taskBuilder, numElements);
+  auto *begin = taskBuilder.CreateMul(
+      taskBuilder.CreateLoad(sizeTTy, beginPtr), chunkSize);
+  auto *end =
+      taskBuilder.CreateMul(taskBuilder.CreateLoad(sizeTTy, endPtr), chunkSize);
+  end = taskBuilder.CreateSelect(
+      taskBuilder.CreateICmpULT(end, numElementsVal), end, numElementsVal);
+  // Skip empty ranges, because the kernel loop is executed at least once.
+  taskBuilder.CreateCondBr(taskBuilder.CreateICmpULT(begin, end), runBB,
+                           exitBB);
+
+  // Unpack the buffers and invoke the kernel.
+  taskBuilder.SetInsertPoint(runBB);
+  auto *buffersArray =
+      taskBuilder.CreateBitCast(ctxArg, int8PtrTy->getPointerTo());
+  llvm::SmallVector<llvm::Value *, 32> kernelArgs;
+  for (size_t idx = 0, e = buffers.size(); idx < e; idx++) {
+    auto *addrPtr = taskBuilder.CreateGEP(int8PtrTy, buffersArray,
+                                          emitConstSizeT(taskBuilder, idx));
+    auto *addr = taskBuilder.CreateLoad(int8PtrTy, addrPtr);
+    kernelArgs.push_back(
+        taskBuilder.CreateBitCast(addr, buffers[idx]->getType()));
+  }
+  kernelArgs.push_back(begin);
+  kernelArgs.push_back(end);
+  createCall(taskBuilder, kernel, kernelArgs);
+  taskBuilder.CreateBr(exitBB);
+  taskBuilder.SetInsertPoint(exitBB);
+  taskBuilder.CreateRetVoid();
+
+  // Pass the buffers to the tasks using an array allocated on the stack of the
+  // calling function.
+  auto *callerF = builder.GetInsertBlock()->getParent();
+  llvm::IRBuilder<> allocaBuilder(&callerF->getEntryBlock(),
+                                  callerF->getEntryBlock().begin());
+  auto *buffersArrayTy = llvm::ArrayType::get(int8PtrTy, buffers.size());
+  auto *buffersArrayAlloca = allocaBuilder.CreateAlloca(buffersArrayTy);
+  for (size_t idx = 0, e = buffers.size(); idx < e; idx++) {
+    auto *elemPtr = builder.CreateConstInBoundsGEP2_32(
+        buffersArrayTy, buffersArrayAlloca, 0, idx);
+    builder.CreateStore(builder.CreateBitCast(buffers[idx], int8PtrTy),
+                        elemPtr);
+  }
+  createCall(
+      builder, parallelFor,
+      {builder.CreateBitCast(taskFunc,
+                             parallelFor->getFunctionType()->getParamType(0)),
+       builder.CreateBitCast(buffersArrayAlloca, int8PtrTy),
+       emitConstSizeT(builder, numTasks)});
+}
+
 /// Emit the function that implements a data-parallel kernel and calls it.
 ///
 /// The generated kernel functions get buffers as their parameters. The buffers
@@ -597,10 +855,21 @@ emitBufferAddress(llvm::IRBuilder<> &builder, Value *val,
 /// only once. This allows us to mark all parameters of the generated kernel as
 /// noalias. As a result, the LLVM optimizer makes use of the noalias attributes
 /// and produces nicely vectorized code for the generated data-parallel kernels.
+///
+/// The last two parameters of the kernel are the range of iterations it
+/// should process. This allows for splitting large kernels among threads.
+///
+/// If the bundle broadcasts or reduces slices, the kernel iterates over a loop
+/// nest. The outer loop iterates over the rows of the iteration space, which
+/// is the range passed to the kernel, and the inner loop over the elements of
+/// the slices. The element-wise instructions of the bundle are computed in the
+/// same nest, so that all of them make a single pass over memory.
 void LLVMIRGen::emitDataParallelKernel(
     llvm::IRBuilder<> &builder, llvm::ArrayRef<const Instruction *> bundle) {
   if (bundle.empty())
     return;
+  dataParallelStats_.passes++;
+  dataParallelStats_.instrs += bundle.size();
   llvm::Type *voidTy = llvm::Type::getVoidTy(ctx_);
   // Types of arguments for the kernel function being generated.
   llvm::SmallVector<llvm::Type *, 32> argTypes;
@@ -622,6 +891,11 @@ void LLVMIRGen::emitDataParallelKernel(
     }
   }
 
+  // The range of iterations to be processed by the kernel.
+  auto *sizeTTy = builder.getIntNTy(sizeof(size_t) * 8);
+  argTypes.push_back(sizeTTy);
+  argTypes.push_back(sizeTTy);
+
   // Create stacked kernel function type.
   llvm::FunctionType *kernelFuncTy =
       llvm::FunctionType::get(voidTy, argTypes, false);
@@ -638,31 +912,116 @@ void LLVMIRGen::emitDataParallelKernel(
   llvm::BasicBlock *entryBB =
       llvm::BasicBlock::Create(ctx_, "entry", kernelFunc);
   llvm::IRBuilder<> kernelBuilder(entryBB);
+  // The range of iterations is passed as the last two arguments.
+  auto *loopBegin = kernelFunc->args().begin() + buffers.size();
+  auto *loopEnd = loopBegin + 1;
+
   // Number of tensor elements.
-  auto *numElements =
-      emitValueSize(kernelBuilder, bundle[0]->getOperand(0).first);
-  // Create a loop inside the stacked kernel function being generated.
-  auto loopBBs = createLoop(kernelBuilder, ctx_, numElements);
-
-  // Get the index parameter of the loop.
-  // This is the PHI node of the BB.
-  auto *kernelLoopIdx = dyn_cast<llvm::PHINode>(loopBBs.first->begin());
-  assert(kernelLoopIdx && "Could not find the loop index");
-  // Insert the body of the loop right after the PHI node.
-  kernelBuilder.SetInsertPoint(loopBBs.first->getFirstNonPHIOrDbg());
-  // Iterate over stacked instructions and create a kernel invocations per
-  // instruction.
+  size_t numElements = getIterationSize(bundle[0]);
+  // The number of elements of the slices that are broadcast or reduced to,
+  // which is the number of iterations of the inner loop of the nest.
+  size_t sliceSize = 0;
+  bool hasReductions = false;
   for (auto &BI : bundle) {
-    // Name of the stacked operation to be invoked.
-    assert(BI->isDataParallel() && "Data parallel operation is expected");
-    generateLLVMIRForDataParallelInstr(kernelBuilder, BI, kernelFunc,
-                                       bufferToArgNum, kernelLoopIdx);
+    sliceSize = std::max(sliceSize, getSliceSize(BI));
+    hasReductions |= isa<BatchedReduceAddInst>(BI);
+  }
+
+  if (!sliceSize) {
+    // Create a loop inside the stacked kernel function being generated.
+    auto loopBBs = createLoop(kernelBuilder, ctx_, loopBegin, loopEnd);
+
+    // Get the index parameter of the loop.
+    // This is the PHI node of the BB.
+    auto *kernelLoopIdx = dyn_cast<llvm::PHINode>(loopBBs.first->begin());
+    assert(kernelLoopIdx && "Could not find the loop index");
+    // Insert the body of the loop right after the PHI node.
+    kernelBuilder.SetInsertPoint(loopBBs.first->getFirstNonPHIOrDbg());
+    // Iterate over stacked instructions and create a kernel invocations per
+    // instruction.
+    for (auto &BI : bundle) {
+      // Name of the stacked operation to be invoked.
+      assert(isStackable(BI) && "Data parallel operation is expected");
+      generateLLVMIRForDataParallelInstr(kernelBuilder, BI, kernelFunc,
+                                         bufferToArgNum, kernelLoopIdx,
+                                         kernelLoopIdx);
+    }
+    kernelBuilder.SetInsertPoint(loopBBs.second);
+  } else {
+    auto *zero = emitConstSizeT(kernelBuilder, 0);
+    auto *sliceEnd = emitConstSizeT(kernelBuilder, sliceSize);
+
+    // Clear the results of the reductions, which are accumulated by the nest.
+    if (hasReductions) {
+      auto initBBs = createLoop(kernelBuilder, ctx_, zero, sliceEnd);
+      auto *initIdx = cast<llvm::PHINode>(initBBs.first->begin());
+      llvm::IRBuilder<> initBuilder(initBBs.first->getFirstNonPHIOrDbg());
+      for (auto &BI : bundle) {
+        if (!isa<BatchedReduceAddInst>(BI)) {
+          continue;
+        }
+        auto *dest = BI->getOperand(0).first;
+        auto *destPtr =
+            emitBufferAddress(initBuilder, dest, kernelFunc, bufferToArgNum);
+        auto *destAddr =
+            initBuilder.CreateGEP(getElementType(initBuilder, dest), destPtr,
+                                  initIdx, "buffer.element.addr");
+        initBuilder.CreateStore(emitConstF32(initBuilder, 0), destAddr);
+      }
+    }
+
+    // Create the outer loop over the rows. Its block is split right after the
+    // PHI node, so that the inner loop is emitted between the PHI node and the
+    // latch of the outer loop.
+    auto outerBBs = createLoop(kernelBuilder, ctx_, loopBegin, loopEnd);
+    auto *rowIdx = dyn_cast<llvm::PHINode>(outerBBs.first->begin());
+    assert(rowIdx && "Could not find the loop index");
+    auto *latchBB = outerBBs.first->splitBasicBlock(
+        outerBBs.first->getFirstNonPHIOrDbg(), "outer.latch");
+    outerBBs.first->getTerminator()->eraseFromParent();
+    kernelBuilder.SetInsertPoint(outerBBs.first);
+    auto *rowBase = kernelBuilder.CreateMul(rowIdx, sliceEnd, "row.base",
+                                            /* HasNUW */ true,
+                                            /* HasNSW */ true);
+
+    // Create the inner loop over the elements of the slices.
+    auto innerBBs = createLoop(kernelBuilder, ctx_, zero, sliceEnd);
+    kernelBuilder.CreateBr(latchBB);
+    auto *sliceIdx = dyn_cast<llvm::PHINode>(innerBBs.first->begin());
+    assert(sliceIdx && "Could not find the loop index");
+    kernelBuilder.SetInsertPoint(innerBBs.first->getFirstNonPHIOrDbg());
+    auto *elementIdx = kernelBuilder.CreateAdd(rowBase, sliceIdx, "element",
+                                               /* HasNUW */ true,
+                                               /* HasNSW */ true);
+    for (auto &BI : bundle) {
+      assert(isStackable(BI) && "Data parallel operation is expected");
+      generateLLVMIRForDataParallelInstr(kernelBuilder, BI, kernelFunc,
+                                         bufferToArgNum, elementIdx, sliceIdx);
+    }
+    kernelBuilder.SetInsertPoint(outerBBs.second);
   }
-  kernelBuilder.SetInsertPoint(loopBBs.second);
   // Add a return.
   kernelBuilder.CreateRetVoid();
 
+  // The kernel iterates over the rows of the nest, if it has one.
+  size_t numIterations = sliceSize ? numElements / sliceSize : numElements;
+  size_t chunkAlignment =
+      sliceSize ? (parallelChunkAlignment + sliceSize - 1) / sliceSize
+                : parallelChunkAlignment;
+  // Split large kernels among the threads. The reductions accumulate all rows
+  // and are not split.
+  size_t numTasks =
+      std::min<size_t>(numThreads_, numElements / minElementsPerTask);
+  numTasks = std::min(numTasks, numIterations);
+  if (numTasks > 1 && !hasReductions) {
+    emitParallelKernelCall(builder, kernelFunc, buffers, numIterations,
+                           numTasks, chunkAlignment);
+    return;
+  }
+
   // Emit a call of the kernel.
+  buffers.push_back(emitConstSizeT(builder, 0));
+  buffers.push_back(emitConstSizeT(builder, numIterations));
   createCall(builder, kernelFunc, buffers);
 }
 
@@ -703,19 +1062,49 @@ void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
   // Go over the instructions and try to group them into bundles.
   auto &instrs = F_->getInstrs();
 
+  // Memory management instructions are handled by the MemoryManager and are
+  // NOPs for a JIT.
+  auto isMemoryManagement = [](const Instruction &I) {
+    return isa<AllocActivationInst>(&I) || isa<DeallocActivationInst>(&I) ||
+           isa<TensorViewInst>(&I);
+  };
+
+  // Split the code into parts with about the same number of instructions. The
+  // debug information and the dumps describe a single entry function, so the
+  // code is not split if they are requested.
+  size_t partSize = 0;
+  if (numCodeGenParts_ > 1 && !emitDebugInfo && !dumpIR && !dumpJitAsm) {
+    size_t numInstrs = std::count_if(instrs.begin(), instrs.end(),
+                                     [&](const Instruction &I) {
+                                       return !isMemoryManagement(I);
+                                     });
+    partSize = (numInstrs + numCodeGenParts_ - 1) / numCodeGenParts_;
+  }
+  auto *entryF = builder.GetInsertBlock()->getParent();
+  llvm::BasicBlock *callBB = nullptr;
+  size_t instrIdx = 0;
+
   // Group instructions into bundles of shape compatible data parallel
   // instructions and emit them.
   llvm::SmallVector<const Instruction *, 32> bundle;
   for (auto &I : instrs) {
-    if (!I.isDataParallel()) {
-      // Ignore memory management instructions as they are handled by the
-      // MemoryManager and are NOPs for a JIT.
-      if (isa<AllocActivationInst>(&I) || isa<DeallocActivationInst>(&I) ||
-          isa<TensorViewInst>(&I))
-        continue;
+    if (isMemoryManagement(I))
+      continue;
+    // Start a new part. A bundle does not cross the boundary of a part.
+    if (partSize && instrIdx++ % partSize == 0) {
+      emitDataParallelKernel(builder, bundle);
+      bundle.clear();
+      startCodeGenPart(builder, entryF, callBB);
+    }
+
+    if (!isStackable(&I) || isSelfConflicting(allocationsInfo_, &I)) {
       emitDataParallelKernel(builder, bundle);
       bundle.clear();
       generateLLVMIRForInstr(builder, &I);
+      if (isNestKind(&I)) {
+        dataParallelStats_.passes++;
+        dataParallelStats_.instrs++;
+      }
       continue;
     }
 
@@ -724,10 +1113,21 @@ void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
     // Check if the current instruction is shape compatible with the bundle.
     bool isBundleCompatible = true;
     if (!bundle.empty()) {
-      auto val = I.getOperand(0).first;
-      auto bundleVal = bundle.back()->getOperand(0).first;
       // Check if shapes have the same amount of elements.
-      isBundleCompatible = val->size() == bundleVal->size();
+      isBundleCompatible =
+          getIterationSize(&I) == getIterationSize(bundle.back());
+      // The instructions of a loop nest must share its inner loop, and must
+      // not access the slices of each other.
+      size_t sliceSize = getSliceSize(&I);
+      for (auto *BI : bundle) {
+        if (!isBundleCompatible) {
+          break;
+        }
+        size_t bundleSliceSize = getSliceSize(BI);
+        isBundleCompatible =
+            (!sliceSize || !bundleSliceSize || sliceSize == bundleSliceSize) &&
+            !isConflictingInNest(allocationsInfo_, &I, BI);
+      }
     }
 
     // Check all mutated operands of the current instruction. Their memory
@@ -759,14 +1159,254 @@ void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
   }
 
   emitDataParallelKernel(builder, bundle);
+
+  // Terminate the last part and continue in the entry function after the
+  // calls of the parts.
+  if (callBB) {
+    builder.CreateRetVoid();
+    builder.SetInsertPoint(callBB);
+  }
+}
+
+void LLVMIRGen::startCodeGenPart(llvm::IRBuilder<> &builder,
+                                 llvm::Function *entryF,
+                                 llvm::BasicBlock *&callBB) {
+  if (callBB) {
+    // Terminate the previous part.
+    builder.CreateRetVoid();
+  } else {
+    callBB = builder.GetInsertBlock();
+  }
+
+  // The part takes the same arguments as the entry function, which calls it.
+  auto *partF = llvm::Function::Create(
+      entryF->getFunctionType(), llvm::Function::ExternalLinkage,
+      entryF->getName() + "_part" + std::to_string(codeGenParts_.size()),
+      llmodule_.get());
+  codeGenParts_.push_back(partF);
+  llvm::SmallVector<llvm::Value *, 4> args;
+  for (auto &arg : entryF->args()) {
+    args.push_back(&arg);
+  }
+  llvm::IRBuilder<> callBuilder(callBB);
+  createCall(callBuilder, partF, args);
+
+  builder.SetInsertPoint(llvm::BasicBlock::Create(ctx_, "entry", partF));
+  loadBaseAddresses(builder);
+}
+
+/// Add the global value \p root and the definitions it refers to, directly or
+/// transitively, to \p deps. The walk does not enter the functions in
+/// \p parts other than \p root, nor the mutable global variables that are
+/// visible outside of the module, which must not be duplicated.
+static void
+collectDependencies(const llvm::GlobalValue *root,
+                    llvm::ArrayRef<llvm::Function *> parts,
+                    llvm::SmallPtrSetImpl<const llvm::GlobalValue *> &deps) {
+  llvm::SmallVector<const llvm::Constant *, 32> worklist{root};
+  llvm::SmallPtrSet<const llvm::Constant *, 32> visited;
+  while (!worklist.empty()) {
+    auto *C = worklist.pop_back_val();
+    if (!visited.insert(C).second) {
+      continue;
+    }
+    auto *GV = dyn_cast<llvm::GlobalValue>(C);
+    if (!GV) {
+      // Look through constant expressions and aggregates.
+      for (auto &op : C->operands()) {
+        if (auto *opC = dyn_cast<llvm::Constant>(op)) {
+          worklist.push_back(opC);
+        }
+      }
+      continue;
+    }
+    if (GV->isDeclaration() || (GV != root && llvm::is_contained(parts, GV))) {
+      continue;
+    }
+    auto *var = dyn_cast<llvm::GlobalVariable>(GV);
+    if (var && !var->hasLocalLinkage() && !var->isConstant()) {
+      continue;
+    }
+    deps.insert(GV);
+    if (var) {
+      worklist.push_back(var->getInitializer());
+      continue;
+    }
+    if (auto *F = dyn_cast<llvm::Function>(GV)) {
+      for (auto &BB : *F) {
+        for (auto &I : BB) {
+          for (auto &op : I.operands()) {
+            if (auto *opC = dyn_cast<llvm::Constant>(op)) {
+              worklist.push_back(opC);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void LLVMIRGen::splitCodeGenParts() {
+  for (auto *partF : codeGenParts_) {
+    partF->removeFnAttr(llvm::Attribute::AttrKind::AlwaysInline);
+    partF->addFnAttr(llvm::Attribute::AttrKind::NoInline);
+  }
+
+  // Every part gets a copy of the definitions it uses, so that they can be
+  // inlined into it. Only the part itself is visible outside of its module.
+  for (auto *partF : codeGenParts_) {
+    llvm::SmallPtrSet<const llvm::GlobalValue *, 32> deps;
+    collectDependencies(partF, codeGenParts_, deps);
+    llvm::ValueToValueMapTy VMap;
+    auto partM =
+#if LLVM_VERSION_MAJOR > 6
+        llvm::CloneModule(*llmodule_, VMap,
+#else
+        llvm::CloneModule(llmodule_.get(), VMap,
+#endif
+                          [&](const llvm::GlobalValue *GV) {
+                            return deps.count(GV) != 0;
+                          });
+    for (auto &GV : partM->global_values()) {
+      if (GV.isDeclaration() || GV.getName() == partF->getName()) {
+        continue;
+      }
+      GV.setLinkage(llvm::GlobalValue::InternalLinkage);
+      if (auto *GO = dyn_cast<llvm::GlobalObject>(&GV)) {
+        GO->setComdat(nullptr);
+      }
+    }
+
+    codeGenPartsBitcode_.emplace_back();
+    llvm::raw_svector_ostream os(codeGenPartsBitcode_.back());
+#if LLVM_VERSION_MAJOR > 6
+    llvm::WriteBitcodeToFile(*partM, os);
+#else
+    llvm::WriteBitcodeToFile(partM.get(), os);
+#endif
+  }
+
+  // The module only calls the parts.
+  for (auto *partF : codeGenParts_) {
+    partF->deleteBody();
+  }
+  codeGenParts_.clear();
+}
+
+/// Compile the module \p M, which is optimized for the target machine \p TM,
+/// to machine code. \returns the object file.
+static std::unique_ptr<llvm::MemoryBuffer>
+emitObjectFile(llvm::Module &M, llvm::TargetMachine &TM) {
+  llvm::SmallVector<char, 0> object;
+  llvm::raw_svector_ostream os(object);
+  llvm::legacy::PassManager PM;
+  TM.addPassesToEmitFile(PM, os,
+                         llvm::TargetMachine::CodeGenFileType::CGFT_ObjectFile);
+  PM.run(M);
+  return llvm::MemoryBuffer::getMemBufferCopy(
+      llvm::StringRef(object.data(), object.size()), M.getName());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> LLVMIRGen::compileModule() {
+  return emitObjectFile(*llmodule_, getTargetMachine());
+}
+
+std::string LLVMIRGen::getCodeDigest() const {
+  // The debug information and the dumps are only produced when the code is
+  // generated.
+  if (emitDebugInfo || dumpIR || dumpJitAsm) {
+    return "";
+  }
+  static const std::string libjitDigest =
+      getStandardLibraryDigest("libjit.bc");
+  if (libjitDigest.empty()) {
+    return "";
+  }
+
+  llvm::SHA1 hasher;
+  hasher.update(libjitDigest);
+  // The configuration of the code generator and of the target machine.
+  hasher.update(LLVM_VERSION_STRING);
+  hasher.update(TM_->getTargetTriple().str());
+  hasher.update(TM_->getTargetCPU());
+  hasher.update(TM_->getTargetFeatureString());
+  std::string options = std::to_string(TM_->getOptLevel()) + "," +
+                        std::to_string(TM_->getRelocationModel()) + "," +
+                        std::to_string(TM_->getCodeModel()) + "," +
+                        std::to_string(numThreads_) + "," +
+                        std::to_string(fuseLoopNests) + "," +
+                        std::to_string(jitSpecializeDims);
+  hasher.update(options);
+
+  // The Glow IR, which also describes the types of all of the values.
+  std::string IR;
+  llvm::raw_string_ostream os(IR);
+  F_->dump(os);
+  hasher.update(os.str());
+
+  // The kinds of the values in the order of their numbers. The offsets of the
+  // activations and of the mutable weights decide which instructions share a
+  // loop nest, so they are part of the digest. The constant weights are only
+  // addressed through the offsets that are passed to the code, so their
+  // addresses are not.
+  std::vector<std::pair<AllocationsInfo::ValueKind, uint64_t>> numbered(
+      allocationsInfo_.valueNumbers_.size());
+  for (auto &I : allocationsInfo_.valueNumbers_) {
+    auto kind = I.second.first;
+    uint64_t offset = 0;
+    if (kind != AllocationsInfo::ValueKind::ConstantWeight) {
+      offset = allocationsInfo_.allocatedAddressed_.lookup(I.first);
+    }
+    numbered[I.second.second] = {kind, offset};
+  }
+  for (auto &N : numbered) {
+    hasher.update(std::to_string(static_cast<int>(N.first)) + ":" +
+                  std::to_string(N.second) + ",");
+  }
+  return llvm::toHex(hasher.final());
+}
+
+std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+LLVMIRGen::compileCodeGenParts(ThreadPool *pool) {
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects(
+      codeGenPartsBitcode_.size());
+  auto compilePart = [&](size_t idx) {
+    // Each part is processed in a context of its own, so that the parts can be
+    // processed concurrently.
+    llvm::LLVMContext ctx;
+    registerEmptyDiagHandler(ctx);
+    auto &bitcode = codeGenPartsBitcode_[idx];
+    auto M = llvm::cantFail(llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()),
+                              "part"),
+        ctx));
+    std::unique_ptr<llvm::TargetMachine> TM(
+        TM_->getTarget().createTargetMachine(
+            TM_->getTargetTriple().str(), TM_->getTargetCPU(),
+            TM_->getTargetFeatureString(), TM_->Options,
+            TM_->getRelocationModel(), TM_->getCodeModel(),
+            TM_->getOptLevel()));
+    runOptimizationPipeline(*M, *TM);
+    objects[idx] = emitObjectFile(*M, *TM);
+  };
+
+  if (pool) {
+    pool->parallelFor(objects.size(), compilePart);
+  } else {
+    for (size_t idx = 0, e = objects.size(); idx < e; idx++) {
+      compilePart(idx);
+    }
+  }
+  codeGenPartsBitcode_.clear();
+  return objects;
 }
 
 void LLVMIRGen::generateLLVMIRForDataParallelInstr(
     llvm::IRBuilder<> &builder, const glow::Instruction *I,
     llvm::Function *kernel, llvm::DenseMap<Value *, int> &bufferToArgNum,
-    llvm::Value *loopCount) {
+    llvm::Value *loopCount, llvm::Value *sliceCount) {
   setCurrentDebugLocation(builder, I);
-  assert(I->isDataParallel() && "Expected a data parallel instruction");
+  assert(isStackable(I) && "Expected a data parallel instruction");
   switch (I->getKind()) {
 
 #define ARITHMETIC_UNARY_OP_WITH_IMM_CASE(INST_NAME_, FUN_NAME_, VALUE_)       \
@@ -959,6 +1599,135 @@ void LLVMIRGen::generateLLVMIRForDataParallelInstr(
     break;
   }
 
+  case Kinded::Kind::BatchedAddInstKind: {
+    auto *BA = cast<BatchedAddInst>(I);
+    auto *dest = BA->getDest();
+    auto *batch = BA->getBatch();
+    auto *slice = BA->getSlice();
+    auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+    auto *batchPtr = emitBufferAddress(builder, batch, kernel, bufferToArgNum);
+    auto *slicePtr = emitBufferAddress(builder, slice, kernel, bufferToArgNum);
+    auto *F = getFunction("batchedadd_kernel", dest->getElementType());
+
+    llvm::Value *stackedOpCall;
+    if (batch->getType()->isQuantizedType()) {
+      auto *destTy = dest->getType();
+      auto *batchTy = batch->getType();
+      auto *sliceTy = slice->getType();
+
+      auto *destOffset = emitConstI32(builder, destTy->getOffset());
+      auto *batchOffset = emitConstI32(builder, batchTy->getOffset());
+      auto *sliceOffset = emitConstI32(builder, sliceTy->getOffset());
+
+      float destScale = destTy->getScale();
+      auto batchScaleParams = quantization::quantizeScaleOffset32To8(
+          batchTy->getScale() / destScale, batchTy->getOffset());
+      auto sliceScaleParams = quantization::quantizeScaleOffset32To8(
+          sliceTy->getScale() / destScale, sliceTy->getOffset());
+
+      auto *batchPre = emitConstI32(builder, batchScaleParams.pre);
+      auto *batchPost = emitConstI32(builder, batchScaleParams.post);
+      auto *batchScale = emitConstI32(builder, batchScaleParams.scale);
+      auto *slicePre = emitConstI32(builder, sliceScaleParams.pre);
+      auto *slicePost = emitConstI32(builder, sliceScaleParams.post);
+      auto *sliceScale = emitConstI32(builder, sliceScaleParams.scale);
+
+      stackedOpCall = createCall(
+          builder, F,
+          {loopCount, sliceCount, batchPtr, slicePtr, destOffset, batchOffset,
+           sliceOffset, batchPre, batchPost, batchScale, slicePre, slicePost,
+           sliceScale});
+    } else {
+      stackedOpCall =
+          createCall(builder, F, {loopCount, sliceCount, batchPtr, slicePtr});
+    }
+    auto *destAddr = builder.CreateGEP(getElementType(builder, dest), destPtr,
+                                       loopCount, "buffer.element.addr");
+    builder.CreateStore(stackedOpCall, destAddr);
+    break;
+  }
+
+  case Kinded::Kind::BatchedReduceAddInstKind: {
+    auto *BR = cast<BatchedReduceAddInst>(I);
+    auto *dest = BR->getDest();
+    auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+    auto *batchPtr =
+        emitBufferAddress(builder, BR->getBatch(), kernel, bufferToArgNum);
+    auto *F = getFunction("batchedreduceadd_kernel", dest->getElementType());
+    // The result is accumulated in the destination, which the kernel clears
+    // before the loop nest.
+    auto *stackedOpCall =
+        createCall(builder, F, {loopCount, sliceCount, batchPtr, destPtr});
+    auto *destAddr = builder.CreateGEP(getElementType(builder, dest), destPtr,
+                                       sliceCount, "buffer.element.addr");
+    builder.CreateStore(stackedOpCall, destAddr);
+    break;
+  }
+
+  case Kinded::Kind::QuantizeInstKind: {
+    auto *QI = cast<QuantizeInst>(I);
+    auto *dest = QI->getDest();
+    auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+    auto *srcPtr =
+        emitBufferAddress(builder, QI->getSrc(), kernel, bufferToArgNum);
+    auto *destType = dest->getType();
+    auto *scale = emitConstF32(builder, destType->getScale());
+    auto *offset = emitConstI32(builder, destType->getOffset());
+    auto *F = getFunction("quantize_kernel", dest->getElementType());
+    auto *stackedOpCall =
+        createCall(builder, F, {loopCount, srcPtr, scale, offset});
+    auto *destAddr = builder.CreateGEP(builder.getInt8Ty(), destPtr, loopCount,
+                                       "buffer.element.addr");
+    builder.CreateStore(stackedOpCall, destAddr);
+    break;
+  }
+
+  case Kinded::Kind::DequantizeInstKind: {
+    auto *DQI = cast<DequantizeInst>(I);
+    auto *dest = DQI->getDest();
+    auto *src = DQI->getSrc();
+    auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+    auto *srcPtr = emitBufferAddress(builder, src, kernel, bufferToArgNum);
+    auto *srcType = src->getType();
+    auto *scale = emitConstF32(builder, srcType->getScale());
+    auto *offset = emitConstI32(builder, srcType->getOffset());
+    auto *F = getFunction("dequantize_kernel", dest->getElementType());
+    auto *stackedOpCall =
+        createCall(builder, F, {loopCount, srcPtr, scale, offset});
+    auto *destAddr = builder.CreateGEP(builder.getFloatTy(), destPtr,
+                                       loopCount, "buffer.element.addr");
+    builder.CreateStore(stackedOpCall, destAddr);
+    break;
+  }
+
+  case Kinded::Kind::RescaleQuantizedInstKind: {
+    auto *RQI = cast<RescaleQuantizedInst>(I);
+    auto *dest = RQI->getDest();
+    auto *src = RQI->getSrc();
+    auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+    auto *srcPtr = emitBufferAddress(builder, src, kernel, bufferToArgNum);
+
+    auto *destType = dest->getType();
+    auto *srcType = src->getType();
+    auto rescaleParams = quantization::quantizeScaleOffset32To8(
+        srcType->getScale() / destType->getScale(), srcType->getOffset());
+
+    auto *destOffset = emitConstI32(builder, destType->getOffset());
+    auto *srcOffset = emitConstI32(builder, srcType->getOffset());
+    auto *preShift = emitConstI32(builder, rescaleParams.pre);
+    auto *postShift = emitConstI32(builder, rescaleParams.post);
+    auto *scale = emitConstI32(builder, rescaleParams.scale);
+
+    auto *F = getFunction("rescale_kernel", dest->getElementType());
+    auto *stackedOpCall = createCall(builder, F,
+                                     {loopCount, srcPtr, destOffset, srcOffset,
+                                      preShift, postShift, scale});
+    auto *destAddr = builder.CreateGEP(builder.getInt8Ty(), destPtr, loopCount,
+                                       "buffer.element.addr");
+    builder.CreateStore(stackedOpCall, destAddr);
+    break;
+  }
+
 #undef ARITHMETIC_UNARY_OP_CASE
 
 #define ARITHMETIC_BINARY_OP_CASE(INST_NAME_, FUN_NAME_)                       \
@@ -1210,6 +1979,57 @@ void LLVMIRGen::generateLLVMIRForDataParallelInstr(
   }
 }
 
+namespace {
+/// The parameters that select how the DKKC8 convolution kernels iterate over
+/// the image and the filter.
+struct DKKC8Params {
+  bool pixelScanFirst;
+  unsigned numDepthRegs;
+  unsigned sizeGroupY;
+  unsigned depthStrips;
+};
+} // namespace
+
+/// \returns the DKKC8 kernel parameters for a convolution with \p inChannels
+/// input channels, \p outChannels output channels and \p group groups.
+static DKKC8Params getDKKC8Params(size_t inChannels, size_t outChannels,
+                                  size_t group) {
+  DKKC8Params params;
+  // Select a method for iterating on the image in the pixel (filter-first, or
+  // input-first). Perform convolutions with a high channel count by scanning
+  // the input image multiple times, once for each filter entry. Scan images
+  // with a low channel count by scanning the image once because the filter
+  // scan will fall in the cache.
+  params.pixelScanFirst = (inChannels < 16);
+
+  // The number of float8 registers that we use to process the depth channel.
+  params.numDepthRegs = (params.pixelScanFirst ? 8 : 2);
+  // The number of y pixels to process at once.
+  params.sizeGroupY = (params.pixelScanFirst ? 1 : 5);
+
+  // When producing output pixels process this many times of depth-strips,
+  // where each chunk is float8 * numDepthRegs. This is a form of tiling. It's
+  // profitable to scan multiple depth-strips of the filter if the scanned
+  // memory fits in the cahce and does not get evicted before the next
+  // iteration. By increasing the number strips (and using more cache memory)
+  // we reduce the number of times that we iterate over the input. However, we
+  // also increase the pressure on the cache that has to store the filter so
+  // we can't process too many strips at once.
+  unsigned depthStrips = 1;
+  unsigned numDepthRegs = params.numDepthRegs;
+  unsigned stripSize = 8 * numDepthRegs * inChannels;
+  unsigned tileSize = 16384;
+  // Increase the number of strips until we reach the output-tensor depth size
+  // or until we exceed some threashold.
+  while (2 * depthStrips * stripSize <= tileSize &&
+         2 * depthStrips * numDepthRegs * 8 <= outChannels / group &&
+         depthStrips < 8) {
+    depthStrips *= 2;
+  }
+  params.depthStrips = depthStrips;
+  return params;
+}
+
 void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
                                        const glow::Instruction *I) {
   setCurrentDebugLocation(builder, I);
@@ -1257,6 +2077,30 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::CPUFusedMatMulInstKind: {
+    auto *MM = cast<CPUFusedMatMulInst>(I);
+    auto *dest = MM->getDest();
+    auto *lhs = MM->getLHS();
+    auto *rhs = MM->getRHS();
+    auto *bias = MM->getBias();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *lhsPtr = emitValueAddress(builder, lhs);
+    auto *rhsPtr = emitValueAddress(builder, rhs);
+    auto *biasPtr = emitValueAddress(builder, bias);
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *lhsDims = emitValueDims(builder, lhs);
+    auto *rhsDims = emitValueDims(builder, rhs);
+    auto *clampMin = emitConstF32(builder, MM->getClampMin());
+    auto *clampMax = emitConstF32(builder, MM->getClampMax());
+
+    auto *F = getFunction("matmul_fused", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, lhsPtr, rhsPtr, biasPtr, destDims, lhsDims, rhsDims,
+                clampMin, clampMax});
+    break;
+  }
+
   case Kinded::Kind::BatchedAddInstKind: {
     auto *BA = cast<BatchedAddInst>(I);
     auto *dest = BA->getDest();
@@ -1433,7 +2277,7 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
                   srcDims,    filterDims, biasDims,   kernels,   strides,
                   pads,       group,      destOffset, srcOffset, filterOffset,
                   biasOffset, biasPre,    biasPost,   biasScale, outPre,
-                  outPost,    outScale,   unrollD});
+                  outPost,    outScale});
     } else {
       createCall(builder, F,
                  {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
@@ -1464,44 +2308,12 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *pads = emitConstSizeTArray(builder, CI->getPads());
     auto *group = emitConstSizeT(builder, CI->getGroup());
 
-    size_t inChannels = src->dims()[3];
-    size_t outChannels = dest->dims()[3];
-
-    // Select a method for iterating on the image in the pixel (filter-first, or
-    // input-first). Perform convolutions with a high channel count by scanning
-    // the input image multiple times, once for each filter entry. Scan images
-    // with a low channel count by scanning the image once because the filter
-    // scan will fall in the cache.
-    bool pixelScanFirst = (inChannels < 16);
-
-    // The number of float8 registers that we use to process the depth channel.
-    unsigned numDepthRegs = (pixelScanFirst ? 8 : 2);
-    // The number of y pixels to process at once.
-    unsigned sizeGroupY = (pixelScanFirst ? 1 : 5);
-
-    // When producing output pixels process this many times of depth-strips,
-    // where each chunk is float8 * numDepthRegs. This is a form of tiling. It's
-    // profitable to scan multiple depth-strips of the filter if the scanned
-    // memory fits in the cahce and does not get evicted before the next
-    // iteration. By increasing the number strips (and using more cache memory)
-    // we reduce the number of times that we iterate over the input. However, we
-    // also increase the pressure on the cache that has to store the filter so
-    // we can't process too many strips at once.
-    unsigned depthStrips = 1;
-    unsigned stripSize = 8 * numDepthRegs * inChannels;
-    unsigned tileSize = 16384;
-    // Increase the number of strips until we reach the output-tensor depth size
-    // or until we exceed some threashold.
-    while (2 * depthStrips * stripSize <= tileSize &&
-           2 * depthStrips * numDepthRegs * 8 <= outChannels / CI->getGroup() &&
-           depthStrips < 8) {
-      depthStrips *= 2;
-    }
-
-    auto *pixelScanFirstVal = emitConstI32(builder, pixelScanFirst);
-    auto *numDepthRegsVal = emitConstI32(builder, numDepthRegs);
-    auto *sizeGroupYVal = emitConstI32(builder, sizeGroupY);
-    auto *depthStripsVal = emitConstI32(builder, depthStrips);
+    auto params =
+        getDKKC8Params(src->dims()[3], dest->dims()[3], CI->getGroup());
+    auto *pixelScanFirstVal = emitConstI32(builder, params.pixelScanFirst);
+    auto *numDepthRegsVal = emitConstI32(builder, params.numDepthRegs);
+    auto *sizeGroupYVal = emitConstI32(builder, params.sizeGroupY);
+    auto *depthStripsVal = emitConstI32(builder, params.depthStrips);
 
     const char *kernelName = "convDKKC8";
     auto *F = getFunction(kernelName, dest->getElementType());
@@ -1514,6 +2326,227 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::CPUFusedConvInstKind:
+  case Kinded::Kind::CPUFusedConvAddInstKind: {
+    Value *dest, *src, *filter, *bias;
+    Value *residual = nullptr;
+    llvm::ArrayRef<unsigned_t> kernelsRef, stridesRef, padsRef;
+    unsigned_t groupVal;
+    float clampMin, clampMax;
+    if (auto *CI = dyn_cast<CPUFusedConvAddInst>(I)) {
+      dest = CI->getDest();
+      src = CI->getSrc();
+      filter = CI->getFilter();
+      bias = CI->getBias();
+      residual = CI->getResidual();
+      kernelsRef = CI->getKernels();
+      stridesRef = CI->getStrides();
+      padsRef = CI->getPads();
+      groupVal = CI->getGroup();
+      clampMin = CI->getClampMin();
+      clampMax = CI->getClampMax();
+    } else {
+      auto *FI = cast<CPUFusedConvInst>(I);
+      dest = FI->getDest();
+      src = FI->getSrc();
+      filter = FI->getFilter();
+      bias = FI->getBias();
+      kernelsRef = FI->getKernels();
+      stridesRef = FI->getStrides();
+      padsRef = FI->getPads();
+      groupVal = FI->getGroup();
+      clampMin = FI->getClampMin();
+      clampMax = FI->getClampMax();
+    }
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, bias);
+    llvm::Value *residualPtr =
+        residual ? emitValueAddress(builder, residual)
+                 : llvm::ConstantPointerNull::get(
+                       getElementType(builder, dest)->getPointerTo());
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *filterDims = emitValueDims(builder, filter);
+    auto *biasDims = emitValueDims(builder, bias);
+
+    auto *kernels = emitConstSizeTArray(builder, kernelsRef);
+    auto *strides = emitConstSizeTArray(builder, stridesRef);
+    auto *pads = emitConstSizeTArray(builder, padsRef);
+    auto *group = emitConstSizeT(builder, groupVal);
+    auto *clampMinVal = emitConstF32(builder, clampMin);
+    auto *clampMaxVal = emitConstF32(builder, clampMax);
+
+    // The filter was transposed to the DKKC8 layout if it has 5 dimensions.
+    if (filter->dims().size() == 5) {
+      auto params = getDKKC8Params(src->dims()[3], dest->dims()[3], groupVal);
+      auto *pixelScanFirstVal = emitConstI32(builder, params.pixelScanFirst);
+      auto *numDepthRegsVal = emitConstI32(builder, params.numDepthRegs);
+      auto *sizeGroupYVal = emitConstI32(builder, params.sizeGroupY);
+      auto *depthStripsVal = emitConstI32(builder, params.depthStrips);
+      auto *F = getFunction("convDKKC8_fused", dest->getElementType());
+      createCall(builder, F,
+                 {destPtr, srcPtr, filterPtr, biasPtr, residualPtr, destDims,
+                  srcDims, filterDims, biasDims, kernels, strides, pads, group,
+                  pixelScanFirstVal, numDepthRegsVal, sizeGroupYVal,
+                  depthStripsVal, clampMinVal, clampMaxVal});
+      break;
+    }
+
+    // As for the regular convolution, process 8 output channels at once if
+    // the channels of each group allow it.
+    bool groupDividedBy8 = ((dest->dims()[3] / groupVal) % 8) == 0;
+    auto *unrollD = emitConstI32(builder, groupDividedBy8 ? 8 : 1);
+    auto *F = getFunction("convolution_fused", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, srcPtr, filterPtr, biasPtr, residualPtr, destDims,
+                srcDims, filterDims, biasDims, kernels, strides, pads, group,
+                unrollD, clampMinVal, clampMaxVal});
+    break;
+  }
+
+  case Kinded::Kind::CPUConvDKKC16InstKind: {
+    auto *CI = cast<CPUConvDKKC16Inst>(I);
+    auto *dest = CI->getDest();
+    auto *src = CI->getSrc();
+    auto *filter = CI->getFilter();
+    auto *bias = CI->getBias();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, bias);
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *filterDims = emitValueDims(builder, filter);
+    auto *biasDims = emitValueDims(builder, bias);
+
+    auto *kernels = emitConstSizeTArray(builder, CI->getKernels());
+    auto *strides = emitConstSizeTArray(builder, CI->getStrides());
+    auto *pads = emitConstSizeTArray(builder, CI->getPads());
+    auto *group = emitConstSizeT(builder, CI->getGroup());
+
+    auto *destTy = dest->getType();
+    auto *srcTy = src->getType();
+    auto *filterTy = filter->getType();
+    auto *biasTy = bias->getType();
+
+    auto *destOffset = emitConstI32(builder, destTy->getOffset());
+    auto *srcOffset = emitConstI32(builder, srcTy->getOffset());
+    auto *filterOffset = emitConstI32(builder, filterTy->getOffset());
+    auto *biasOffset = emitConstI32(builder, biasTy->getOffset());
+
+    // The scaling parameters are the same as the ones of the quantized
+    // Convolution.
+    float matMulScale = srcTy->getScale() * filterTy->getScale();
+    auto biasScaleParam = quantization::quantizeScaleOffset32To8(
+        biasTy->getScale() / matMulScale, biasTy->getOffset());
+    auto outScaleParam = quantization::quantizeScaleOffset32To8(
+        matMulScale / destTy->getScale(), 0);
+
+    auto *biasPre = emitConstI32(builder, biasScaleParam.pre);
+    auto *biasPost = emitConstI32(builder, biasScaleParam.post);
+    auto *biasScale = emitConstI32(builder, biasScaleParam.scale);
+    auto *outPre = emitConstI32(builder, outScaleParam.pre);
+    auto *outPost = emitConstI32(builder, outScaleParam.post);
+    auto *outScale = emitConstI32(builder, outScaleParam.scale);
+
+    auto *F = getFunction("convDKKC16", dest->getElementType());
+    createCall(builder, F,
+               {destPtr,    srcPtr,     filterPtr,  biasPtr,   destDims,
+                srcDims,    filterDims, biasDims,   kernels,   strides,
+                pads,       group,      destOffset, srcOffset, filterOffset,
+                biasOffset, biasPre,    biasPost,   biasScale, outPre,
+                outPost,    outScale});
+    break;
+  }
+
+  case Kinded::Kind::CPUDepthwiseConvInstKind: {
+    auto *CI = cast<CPUDepthwiseConvInst>(I);
+    auto *dest = CI->getDest();
+    auto *src = CI->getSrc();
+    auto *filter = CI->getFilter();
+    auto *bias = CI->getBias();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, bias);
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+
+    auto *kernels = emitConstSizeTArray(builder, CI->getKernels());
+    auto *strides = emitConstSizeTArray(builder, CI->getStrides());
+    auto *pads = emitConstSizeTArray(builder, CI->getPads());
+
+    auto *F = getFunction("depthwise_conv", dest->getElementType());
+
+    if (src->getType()->isQuantizedType()) {
+      auto *destTy = dest->getType();
+      auto *srcTy = src->getType();
+      auto *filterTy = filter->getType();
+      auto *biasTy = bias->getType();
+
+      auto *destOffset = emitConstI32(builder, destTy->getOffset());
+      auto *srcOffset = emitConstI32(builder, srcTy->getOffset());
+      auto *filterOffset = emitConstI32(builder, filterTy->getOffset());
+      auto *biasOffset = emitConstI32(builder, biasTy->getOffset());
+
+      // The scaling parameters are the same as the ones of the quantized
+      // Convolution.
+      float matMulScale = srcTy->getScale() * filterTy->getScale();
+      auto biasScaleParam = quantization::quantizeScaleOffset32To8(
+          biasTy->getScale() / matMulScale, biasTy->getOffset());
+      auto outScaleParam = quantization::quantizeScaleOffset32To8(
+          matMulScale / destTy->getScale(), 0);
+
+      auto *biasPre = emitConstI32(builder, biasScaleParam.pre);
+      auto *biasPost = emitConstI32(builder, biasScaleParam.post);
+      auto *biasScale = emitConstI32(builder, biasScaleParam.scale);
+      auto *outPre = emitConstI32(builder, outScaleParam.pre);
+      auto *outPost = emitConstI32(builder, outScaleParam.post);
+      auto *outScale = emitConstI32(builder, outScaleParam.scale);
+
+      createCall(builder, F,
+                 {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
+                  kernels, strides, pads, destOffset, srcOffset, filterOffset,
+                  biasOffset, biasPre, biasPost, biasScale, outPre, outPost,
+                  outScale});
+    } else {
+      createCall(builder, F,
+                 {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
+                  kernels, strides, pads});
+    }
+    break;
+  }
+
+  case Kinded::Kind::CPUWinogradConvInstKind: {
+    auto *CI = cast<CPUWinogradConvInst>(I);
+    auto *dest = CI->getDest();
+    auto *src = CI->getSrc();
+    auto *filter = CI->getFilter();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, CI->getBias());
+
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *filterDims = emitValueDims(builder, filter);
+
+    auto *pads = emitConstSizeTArray(builder, CI->getPads());
+    auto *clampMin = emitConstF32(builder, CI->getClampMin());
+    auto *clampMax = emitConstF32(builder, CI->getClampMax());
+
+    auto *F = getFunction("winograd_conv", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
+                filterDims, pads, clampMin, clampMax});
+    break;
+  }
+
   case Kinded::Kind::ConvolutionGradInstKind: {
     auto *CG = cast<ConvolutionGradInst>(I);
     auto *srcGrad = CG->getSrcGrad();
@@ -1962,6 +2995,74 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::SparseLengthsWeightedSumInstKind: {
+    auto *SI = cast<SparseLengthsWeightedSumInst>(I);
+    auto *dest = SI->getDest();
+    auto *data = SI->getData();
+    auto *indices = SI->getIndices();
+    auto *lengths = SI->getLengths();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *dataPtr = emitValueAddress(builder, data);
+    auto *weightsPtr = emitValueAddress(builder, SI->getWeights());
+    auto *indicesPtr = emitValueAddress(builder, indices);
+    auto *lengthsPtr = emitValueAddress(builder, lengths);
+    auto *segments = emitConstSizeT(builder, lengths->dims()[0]);
+    auto *lineSize = emitConstSizeT(builder, data->size() / data->dims()[0]);
+    auto *numIndices = emitConstSizeT(builder, indices->dims()[0]);
+    auto *F =
+        getFunction("sparse_lengths_weighted_sum", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, dataPtr, weightsPtr, indicesPtr, lengthsPtr, segments,
+                lineSize, numIndices});
+    break;
+  }
+
+  case Kinded::Kind::RowwiseQuantizedSparseLengthsWeightedSumInstKind: {
+    auto *SI = cast<RowwiseQuantizedSparseLengthsWeightedSumInst>(I);
+    auto *dest = SI->getDest();
+    auto *data = SI->getData();
+    auto *indices = SI->getIndices();
+    auto *lengths = SI->getLengths();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *dataPtr = emitValueAddress(builder, data);
+    auto *scalesPtr = emitValueAddress(builder, SI->getScales());
+    auto *offsetsPtr = emitValueAddress(builder, SI->getOffsets());
+    auto *weightsPtr = emitValueAddress(builder, SI->getWeights());
+    auto *indicesPtr = emitValueAddress(builder, indices);
+    auto *lengthsPtr = emitValueAddress(builder, lengths);
+    auto *segments = emitConstSizeT(builder, lengths->dims()[0]);
+    auto *lineSize = emitConstSizeT(builder, data->size() / data->dims()[0]);
+    auto *numIndices = emitConstSizeT(builder, indices->dims()[0]);
+    auto *F = getFunction("rowwise_quantized_sparse_lengths_weighted_sum",
+                          dest->getElementType());
+    createCall(builder, F,
+               {destPtr, dataPtr, scalesPtr, offsetsPtr, weightsPtr, indicesPtr,
+                lengthsPtr, segments, lineSize, numIndices});
+    break;
+  }
+
+  case Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumInstKind: {
+    auto *SI = cast<FusedRowwiseQuantizedSparseLengthsWeightedSumInst>(I);
+    auto *dest = SI->getDest();
+    auto *indices = SI->getIndices();
+    auto *lengths = SI->getLengths();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *dataPtr = emitValueAddress(builder, SI->getData());
+    auto *weightsPtr = emitValueAddress(builder, SI->getWeights());
+    auto *indicesPtr = emitValueAddress(builder, indices);
+    auto *lengthsPtr = emitValueAddress(builder, lengths);
+    auto *segments = emitConstSizeT(builder, lengths->dims()[0]);
+    // The line size of the result, which excludes the scale and the offset.
+    auto *lineSize = emitConstSizeT(builder, dest->dims()[1]);
+    auto *numIndices = emitConstSizeT(builder, indices->dims()[0]);
+    auto *F = getFunction("fused_rowwise_quantized_sparse_lengths_weighted_sum",
+                          dest->getElementType());
+    createCall(builder, F,
+               {destPtr, dataPtr, weightsPtr, indicesPtr, lengthsPtr, segments,
+                lineSize, numIndices});
+    break;
+  }
+
   case Kinded::Kind::ScatterAssignInstKind: {
     auto *SAI = llvm::cast<ScatterAssignInst>(I);
     auto *data = SAI->getData();
@@ -26,12 +26,16 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Target/TargetMachine.h"
 
+#include <vector>
+
 namespace glow {
 
 class Context;
 class IRFunction;
+class ThreadPool;
 class Value;
 class Tensor;
 class Variable;
@@ -80,6 +84,17 @@ struct DebugInfo {
 /// This is a class containing a common logic for the generation of the LLVM IR
 /// from an IRFunction. The primary clients of this class are JITs and bundlers.
 class LLVMIRGen {
+public:
+  /// The statistics of the passes over memory that the element-wise code
+  /// generated by an LLVMIRGen makes.
+  struct DataParallelStats {
+    /// The number of passes, i.e. of the loop nests of the data-parallel
+    /// kernels and of the element-wise instructions emitted on their own.
+    size_t passes;
+    /// The number of instructions computed by these passes.
+    size_t instrs;
+  };
+
 protected:
   /// The IR to generate code for.
   const IRFunction *F_;
@@ -119,6 +134,21 @@ protected:
   /// A set that contains all of the argument that we request from the
   /// specializer not to specialize.
   llvm::DenseSet<llvm::Value *> dontSpecializeArgsSet_;
+  /// The maximal number of threads the generated code may use. Data-parallel
+  /// kernels are split among the threads if this number is greater than 1.
+  unsigned numThreads_{1};
+  /// The number of parts the code of the entry function is split into. The
+  /// parts are optimized and compiled separately, and can be compiled in
+  /// parallel.
+  unsigned numCodeGenParts_{1};
+  /// The statistics of the element-wise code generated so far.
+  DataParallelStats dataParallelStats_{};
+  /// The functions holding the parts of the code of the entry function, which
+  /// calls them in order.
+  std::vector<llvm::Function *> codeGenParts_;
+  /// The bitcode of the modules of the parts once they were split off the
+  /// module.
+  std::vector<llvm::SmallVector<char, 0>> codeGenPartsBitcode_;
 
   /// Generates LLVM IR that computes the address of \p val using \p builder.
   /// The address type is specified by \p ptrTy.
@@ -159,19 +189,39 @@ protected:
   /// weightvars, mutable weight vars) so that they can be reused inside the
   /// body of the function.
   void loadBaseAddresses(llvm::IRBuilder<> &builder);
+  /// Start a new part of the code of the entry function \p entryF, and
+  /// continue the code generation with \p builder at its beginning. The
+  /// calls of the parts are emitted at the end of \p callBB, which is set
+  /// to the current block of \p builder when the first part starts.
+  void startCodeGenPart(llvm::IRBuilder<> &builder, llvm::Function *entryF,
+                        llvm::BasicBlock *&callBB);
+  /// Move the parts of the code of the entry function into modules of their
+  /// own, which are kept as bitcode until compileCodeGenParts is called. Only
+  /// declarations of the parts stay in the module.
+  void splitCodeGenParts();
   /// Create a function representing a stacked kernel for instructions provided
   /// in \p stackedInstrs.
   void
   emitDataParallelKernel(llvm::IRBuilder<> &builder,
                          llvm::ArrayRef<const Instruction *> stackedInstrs);
+  /// Emit a call of the stacked \p kernel, which splits the \p numElements
+  /// iterations of the kernel into \p numTasks parallel tasks. The ranges of
+  /// the tasks are aligned to \p chunkAlignment iterations. The \p buffers
+  /// are the buffer arguments of the kernel.
+  void emitParallelKernelCall(llvm::IRBuilder<> &builder,
+                              llvm::Function *kernel,
+                              llvm::ArrayRef<llvm::Value *> buffers,
+                              size_t numElements, size_t numTasks,
+                              size_t chunkAlignment);
   /// Emit IR for the data parallel instruction \p I which is invoked inside the
-  /// stacked \p kernel. The current loop count is described by \p loopCount.
-  /// The \p bufferToArgNum map can be used to find the required buffers, which
-  /// are provided as arguments to the stacked \p kernel.
+  /// stacked \p kernel. The current loop count is described by \p loopCount,
+  /// and the index in the slices that are broadcast or reduced to by
+  /// \p sliceCount. The \p bufferToArgNum map can be used to find the required
+  /// buffers, which are provided as arguments to the stacked \p kernel.
   void generateLLVMIRForDataParallelInstr(
       llvm::IRBuilder<> &builder, const glow::Instruction *I,
       llvm::Function *kernel, llvm::DenseMap<Value *, int> &bufferToArgNum,
-      llvm::Value *loopCount);
+      llvm::Value *loopCount, llvm::Value *sliceCount);
   /// \returns the llvm type of the glow vale \p val.
   llvm::Type *getElementType(llvm::IRBuilder<> &builder, const Value *val);
   /// Create a debug information for a given LLVM type \p ty.
@@ -226,6 +276,10 @@ public:
   /// Optimize the function \p F and the module that owns it. Use the target
   /// information from the \p TM target machine.
   void optimizeLLVMModule(llvm::Function *F, llvm::TargetMachine &TM);
+  /// Run the optimization pipeline on the module \p M, which is prepared for
+  /// the target machine \p TM.
+  static void runOptimizationPipeline(llvm::Module &M,
+                                      llvm::TargetMachine &TM);
   /// Performs specialization of operations based on constant parameters.
   void performSpecialization();
   /// \returns allocations info.
@@ -253,6 +307,33 @@ public:
   llvm::Module &getModule() { return *llmodule_; }
   /// \returns the IR function.
   const IRFunction *getIRFunction() { return F_; }
+  /// Set the maximal number of threads the generated code may use.
+  void setNumThreads(unsigned numThreads) { numThreads_ = numThreads; }
+  /// \returns the maximal number of threads the generated code may use.
+  unsigned getNumThreads() const { return numThreads_; }
+  /// Set the number of parts the code of the entry function is split into.
+  void setNumCodeGenParts(unsigned numParts) { numCodeGenParts_ = numParts; }
+  /// \returns the number of parts the code of the entry function is split
+  /// into.
+  unsigned getNumCodeGenParts() const { return numCodeGenParts_; }
+  /// Optimize the parts of the code that performCodeGen split off the module
+  /// and compile them into object files, using the threads of \p pool if it
+  /// is not null. \returns the object files, which define the parts that the
+  /// module declares. The list is empty if the code was not split.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+  compileCodeGenParts(ThreadPool *pool);
+  /// Compile the module, once performCodeGen optimized it, into an object
+  /// file. \returns the object file.
+  std::unique_ptr<llvm::MemoryBuffer> compileModule();
+  /// \returns a digest of everything the generated code depends on: the IR,
+  /// the allocations, the options of the code generator, the target machine
+  /// and the libjit library. It is computed without generating any code, and
+  /// is the same in every process as long as the IR has the same names. The
+  /// digest only describes the code that takes the offsets of the values as
+  /// an argument (see CPUBackend), which does not depend on the addresses of
+  /// the constant weights. \returns an empty string if the code should not be
+  /// reused, e.g. because debug information is requested.
+  std::string getCodeDigest() const;
   /// Set output directory for bundles, debug info files, etc.
   void setOutputDir(llvm::StringRef outputDir) { outputDir_ = outputDir; }
   /// Get output directory for bundles, debug info files, etc.
@@ -266,6 +347,11 @@ public:
   llvm::Value *emitStringConst(llvm::IRBuilder<> &builder, llvm::StringRef str);
   /// Register \p val as an argument that should not be specialized.
   void markArgAsUnspecialized(llvm::Value *val);
+  /// \returns the statistics of the element-wise code generated by this
+  /// LLVMIRGen.
+  const DataParallelStats &getDataParallelStats() const {
+    return dataParallelStats_;
+  }
 };
 
 } // namespace glow
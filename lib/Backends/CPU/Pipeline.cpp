@@ -86,16 +86,6 @@ void LLVMIRGen::optimizeLLVMModule(llvm::Function *F, llvm::TargetMachine &TM) {
   // else.
   performSpecialization();
 
-  llvm::PassManagerBuilder PMB;
-  PMB.OptLevel = 2;
-  PMB.SizeLevel = 0;
-  PMB.LoopVectorize = true;
-  PMB.SLPVectorize = false;
-  PMB.Inliner = llvm::createFunctionInliningPass();
-
-  M->setTargetTriple(TM.getTargetTriple().normalize());
-  M->setDataLayout(TM.createDataLayout());
-
   // Replace the target-specific machine code attributes that were attached by
   // the frontend.
   llvm::AttributeList AL;
@@ -125,7 +115,27 @@ void LLVMIRGen::optimizeLLVMModule(llvm::Function *F, llvm::TargetMachine &TM) {
   // inlined.
   M->getFunction("main")->addFnAttr(llvm::Attribute::AttrKind::AlwaysInline);
 
-  llvm::legacy::FunctionPassManager FPM(M);
+  // The parts of the code, if any, are optimized separately from the module.
+  if (!codeGenParts_.empty()) {
+    splitCodeGenParts();
+  }
+
+  runOptimizationPipeline(*M, TM);
+}
+
+void LLVMIRGen::runOptimizationPipeline(llvm::Module &M,
+                                        llvm::TargetMachine &TM) {
+  llvm::PassManagerBuilder PMB;
+  PMB.OptLevel = 2;
+  PMB.SizeLevel = 0;
+  PMB.LoopVectorize = true;
+  PMB.SLPVectorize = false;
+  PMB.Inliner = llvm::createFunctionInliningPass();
+
+  M.setTargetTriple(TM.getTargetTriple().normalize());
+  M.setDataLayout(TM.createDataLayout());
+
+  llvm::legacy::FunctionPassManager FPM(&M);
   llvm::legacy::PassManager PM;
 
   // Add internal analysis passes from the target machine.
@@ -135,10 +145,10 @@ void LLVMIRGen::optimizeLLVMModule(llvm::Function *F, llvm::TargetMachine &TM) {
   PMB.populateFunctionPassManager(FPM);
   PMB.populateModulePassManager(PM);
   FPM.doInitialization();
-  PM.run(*M);
-  for (auto &FF : *M) {
+  PM.run(M);
+  for (auto &FF : M) {
     FPM.run(FF);
   }
   FPM.doFinalization();
-  PM.run(*M);
+  PM.run(M);
 }
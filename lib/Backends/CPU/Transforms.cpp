@@ -19,8 +19,12 @@
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Nodes.h"
 
+#include <cmath>
+
 using namespace glow;
+using llvm::cast;
 using llvm::dyn_cast;
+using llvm::dyn_cast_or_null;
 using llvm::isa;
 
 /// Try to optimize the regular Convolution into a target-specific convolution
@@ -79,6 +83,208 @@ static Node *optimizeCPUConv(ConvolutionNode *CN, Function *F) {
       CN->getBias(), CN->getKernels(), CN->getStrides(), CN->getPads(), group));
 }
 
+/// The filter transform G of the Winograd algorithm F(2 x 2, 3 x 3).
+static const float winogradG2[4][3] = {
+    {1, 0, 0}, {0.5, 0.5, 0.5}, {0.5, -0.5, 0.5}, {0, 0, 1}};
+
+/// The filter transform G of the Winograd algorithm F(4 x 4, 3 x 3).
+static const float winogradG4[6][3] = {{1.0 / 4, 0, 0},
+                                       {-1.0 / 6, -1.0 / 6, -1.0 / 6},
+                                       {-1.0 / 6, 1.0 / 6, -1.0 / 6},
+                                       {1.0 / 24, 1.0 / 12, 1.0 / 6},
+                                       {1.0 / 24, -1.0 / 12, 1.0 / 6},
+                                       {0, 0, 1}};
+
+/// Try to optimize a 3x3 stride-1 Convolution into a Winograd convolution
+/// F(m x m, 3 x 3), which computes each m x m tile of the output with
+/// (m + 2)^2 multiplications per pair of channels instead of 9 * m^2. The
+/// filter g of each pair of channels is transformed at compile time to
+/// G g G^T and stored in the layout [(m + 2)^2, C, D], so that the
+/// element-wise stage of the algorithm is a batch of matrix multiplications.
+static Node *optimizeCPUWinogradConv(ConvolutionNode *CN, Function *F) {
+  auto *M = F->getParent();
+  auto kernels = CN->getKernels();
+  auto strides = CN->getStrides();
+  if (CN->getGroup() != 1 || kernels[0] != 3 || kernels[1] != 3 ||
+      strides[0] != 1 || strides[1] != 1) {
+    return nullptr;
+  }
+
+  Variable *filter = dyn_cast<Variable>(CN->getFilter());
+  if (!filter || filter->getNumUsers() != 1 || !filter->isPrivate()) {
+    // Can't mutate the filter.
+    return nullptr;
+  }
+
+  if (filter->getElementType() != ElemKind::FloatTy ||
+      CN->getInput().getElementType() != ElemKind::FloatTy ||
+      CN->getBias().getElementType() != ElemKind::FloatTy ||
+      CN->getResult().getElementType() != ElemKind::FloatTy) {
+    return nullptr;
+  }
+
+  // The transforms of the input and output tiles only pay off if there are
+  // enough of them, so small images are left to the direct convolution.
+  // F(4 x 4, 3 x 3) saves more multiplications than F(2 x 2, 3 x 3), but
+  // wastes more work on the partial tiles at the borders of the image.
+  ShapeNHWC odim(CN->getResult().dims());
+  if (odim.h < 8 || odim.w < 8) {
+    return nullptr;
+  }
+  bool largeImage = odim.h >= 16 && odim.w >= 16;
+  bool wholeTiles = odim.h % 4 == 0 && odim.w % 4 == 0;
+  size_t m = (largeImage || wholeTiles) ? 4 : 2;
+  size_t alpha = m + 2;
+  const float *G = m == 2 ? &winogradG2[0][0] : &winogradG4[0][0];
+
+  auto dims = filter->dims();
+  assert(dims.size() == 4 && "Invalid filter size");
+  size_t depth = dims[0];
+  size_t channels = dims[3];
+  auto *filterU = M->createVariable(ElemKind::FloatTy,
+                                    {alpha * alpha, channels, depth},
+                                    filter->getName(), VisibilityKind::Private,
+                                    false);
+
+  auto UH = filterU->getHandle();
+  auto FH = filter->getHandle();
+  for (size_t d = 0; d < depth; d++) {
+    for (size_t c = 0; c < channels; c++) {
+      // Compute G g, and then (G g) G^T.
+      float Gg[6][3];
+      for (size_t i = 0; i < alpha; i++) {
+        for (size_t j = 0; j < 3; j++) {
+          float sum = 0;
+          for (size_t k = 0; k < 3; k++) {
+            sum += G[i * 3 + k] * FH.at({d, k, j, c});
+          }
+          Gg[i][j] = sum;
+        }
+      }
+      for (size_t i = 0; i < alpha; i++) {
+        for (size_t j = 0; j < alpha; j++) {
+          float sum = 0;
+          for (size_t k = 0; k < 3; k++) {
+            sum += Gg[i][k] * G[j * 3 + k];
+          }
+          UH.at({i * alpha + j, c, d}) = sum;
+        }
+      }
+    }
+  }
+
+  return F->addNode(new CPUWinogradConvNode(
+      CN->getName(), CN->getResult().getType(), CN->getInput(), filterU,
+      CN->getBias(), CN->getPads(), -INFINITY, INFINITY));
+}
+
+/// Try to optimize a quantized Convolution into a target-specific convolution
+/// that operates on a packed filter. The CPU backend computes quantized
+/// convolutions as the product of the im2col patches of the input with panels
+/// of 16 output channels of the filter. This optimization packs the panels at
+/// compile time: the filter of each group is transposed to the layout
+/// [ceil(D/G/16), K, K, C/G, 16], where the last panel is padded with zeros,
+/// and the groups are stored one after another.
+static Node *optimizeCPUConvI8(ConvolutionNode *CN, Function *F) {
+  auto *M = F->getParent();
+  auto group = CN->getGroup();
+
+  Variable *filter = dyn_cast<Variable>(CN->getFilter());
+  if (!filter || filter->getNumUsers() != 1 || !filter->isPrivate()) {
+    // Can't mutate the filter.
+    return nullptr;
+  }
+
+  if (filter->getElementType() != ElemKind::Int8QTy ||
+      CN->getInput().getElementType() != ElemKind::Int8QTy ||
+      CN->getBias().getElementType() != ElemKind::Int8QTy ||
+      CN->getResult().getElementType() != ElemKind::Int8QTy) {
+    return nullptr;
+  }
+
+  TypeRef filterTy = filter->getType();
+  auto dims = filterTy->dims();
+  assert(dims.size() == 4 && "Invalid filter size");
+  size_t depthPerGroup = dims[0] / group;
+  size_t panelsPerGroup = (depthPerGroup + 15) / 16;
+  auto *filter16 = M->createVariable(
+      ElemKind::Int8QTy,
+      {group * panelsPerGroup, dims[1], dims[2], dims[3], 16},
+      filterTy->getScale(), filterTy->getOffset(), filter->getName(),
+      VisibilityKind::Private, false);
+
+  auto F16H = filter16->getHandle<int8_t>();
+  auto FH = filter->getHandle<int8_t>();
+  F16H.clear(0);
+
+  // Transpose the weights of each group into panels of 16 output channels.
+  for (size_t c0 = 0; c0 < dims[0]; c0++) {
+    size_t panel = (c0 / depthPerGroup) * panelsPerGroup +
+                   (c0 % depthPerGroup) / 16;
+    for (size_t c1 = 0; c1 < dims[1]; c1++)
+      for (size_t c2 = 0; c2 < dims[2]; c2++)
+        for (size_t c3 = 0; c3 < dims[3]; c3++) {
+          F16H.at({panel, c1, c2, c3, (c0 % depthPerGroup) % 16}) =
+              FH.at({c0, c1, c2, c3});
+        }
+  }
+
+  return F->addNode(new CPUConvDKKC16Node(
+      CN->getName(), CN->getResult().getType(), CN->getInput(), filter16,
+      CN->getBias(), CN->getKernels(), CN->getStrides(), CN->getPads(), group));
+}
+
+/// Try to optimize a depthwise Convolution, where each input channel is
+/// convolved with its own single-channel filter, into a target-specific
+/// depthwise convolution. The filter is transposed from [C, K, K, 1] to
+/// [K, K, C], so that the kernel can vectorize across the channels of the
+/// NHWC input. Constant filters are transposed at compile time.
+static Node *optimizeCPUDepthwiseConv(ConvolutionNode *CN, Function *F) {
+  auto *M = F->getParent();
+  auto group = CN->getGroup();
+  auto filterDims = CN->getFilter().dims();
+  size_t channels = CN->getInput().dims()[3];
+
+  // Only handle the case where the number of output channels is the same as
+  // the number of input channels (a depth multiplier of 1).
+  if (group == 1 || group != channels || filterDims[0] != channels) {
+    return nullptr;
+  }
+
+  ElemKind elemTy = CN->getResult().getElementType();
+  if (elemTy != ElemKind::FloatTy && elemTy != ElemKind::Int8QTy) {
+    return nullptr;
+  }
+  if (CN->getInput().getElementType() != elemTy ||
+      CN->getFilter().getElementType() != elemTy ||
+      CN->getBias().getElementType() != elemTy) {
+    return nullptr;
+  }
+
+  auto filterTy = M->uniqueTypeWithNewShape(
+      CN->getFilter().getType(), {filterDims[1], filterDims[2], channels});
+  NodeValue filterKKC;
+  Variable *filter = dyn_cast<Variable>(CN->getFilter());
+  if (filter && filter->getNumUsers() == 1 && filter->isPrivate()) {
+    // The last dimension of the filter is 1, so transposing it to
+    // [K, K, 1, C] gives the data of [K, K, C].
+    Tensor transposed;
+    filter->getPayload().transpose(&transposed, {1, 2, 3, 0});
+    Tensor reshaped = transposed.getUnowned(filterTy->dims());
+    auto *filterVar = M->createVariable(filterTy, filter->getName(),
+                                        VisibilityKind::Private, false);
+    filterVar->assign(&reshaped);
+    filterKKC = filterVar;
+  } else {
+    auto *TN = F->createTranspose(CN->getName(), CN->getFilter(), {1, 2, 3, 0});
+    filterKKC = F->createReshape(CN->getName(), TN, filterTy->dims());
+  }
+
+  return F->addNode(new CPUDepthwiseConvNode(
+      CN->getName(), CN->getResult().getType(), CN->getInput(), filterKKC,
+      CN->getBias(), CN->getKernels(), CN->getStrides(), CN->getPads()));
+}
+
 /// Merge Max and Splat nodes into target-specific CPUMaxSplat node.
 /// For quantized network, sinkRescaleQuantizedNode transformation might have
 /// merged Rescale into Max node. In this case we need to pull it out, since
@@ -113,13 +319,193 @@ static Node *optimizeCPUMaxSplat(MaxNode *MN, Function *F) {
       new CPUMaxSplatNode(MN->getName(), input, splat->getValue()));
 }
 
+/// \returns the only user of the single-result node \p N that is live, or
+/// null if \p N has no live users or more than one use by live nodes. The
+/// nodes that were replaced earlier by this transformation are still users of
+/// their inputs until the next DCE, but they are dead, as they have no users
+/// and no side effects.
+static Node *getSingleLiveUser(Node *N) {
+  Node *user = nullptr;
+  for (auto &U : N->getUsers()) {
+    Node *candidate = U.getUser();
+    if (!candidate->hasUsers() && !candidate->hasSideEffects()) {
+      continue;
+    }
+    if (user) {
+      return nullptr;
+    }
+    user = candidate;
+  }
+  return user;
+}
+
+/// \returns true if all of the inputs and the results of \p N are float.
+static bool isFloatNode(const Node *N) {
+  for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+    if (N->getNthInput(i).getElementType() != ElemKind::FloatTy) {
+      return false;
+    }
+  }
+  for (unsigned i = 0, e = N->getNumResults(); i < e; i++) {
+    if (N->getNthResult(i).getElementType() != ElemKind::FloatTy) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Try to fuse the element-wise nodes that follow the float convolution or
+/// matrix multiplication \p N into the epilogue of a single target-specific
+/// node, which applies them to the output while it is still in the cache. The
+/// fused chain is: the bias of a lowered FullyConnected (a BatchedAdd of a
+/// vector, for matrix multiplications only), a residual Add (for convolutions
+/// only), and any number of Max or Min nodes with splats (e.g. Relu and
+/// clipping), which are folded into a single clamp. A Winograd convolution
+/// already adds its bias in its output transform, which also applies the
+/// clamp, but it does not fuse a residual Add. \returns the node that
+/// replaces the last node of the chain, or null if nothing was fused.
+static Node *fuseCPUEpilogue(Node *N, Function *F) {
+  auto *WCN = dyn_cast<CPUWinogradConvNode>(N);
+  bool isConv = isa<ConvolutionNode>(N) || isa<CPUConvDKKC8Node>(N);
+  if ((!isConv && !WCN && !isa<MatMulNode>(N)) || N->hasPredicate() ||
+      !isFloatNode(N)) {
+    return nullptr;
+  }
+
+  // The number of nodes absorbed so far.
+  unsigned numAbsorbed = 0;
+  NodeValue cur = N->getNthResult(0);
+  Node *user = getSingleLiveUser(N);
+  auto absorb = [&](Node *next) {
+    numAbsorbed++;
+    cur = next->getNthResult(0);
+    user = getSingleLiveUser(next);
+  };
+  auto isFusible = [&](Node *next) {
+    return next && !next->hasPredicate() && isFloatNode(next) &&
+           next->getNthResult(0).dims() == cur.dims();
+  };
+
+  // The FullyConnected bias.
+  NodeValue bias;
+  if (isa<MatMulNode>(N)) {
+    auto *BA = dyn_cast_or_null<BatchedAddNode>(user);
+    if (!isFusible(BA) || BA->getBatch() != cur ||
+        BA->getSlice().dims().size() != 1) {
+      return nullptr;
+    }
+    bias = BA->getSlice();
+    absorb(BA);
+  }
+
+  // The residual connection.
+  NodeValue residual;
+  if (auto *AN = dyn_cast_or_null<AddNode>(user)) {
+    NodeValue other = AN->getLHS() == cur ? AN->getRHS() : AN->getLHS();
+    if (isConv && isFusible(AN) && other != cur &&
+        other.getType() == AN->getResult().getType()) {
+      residual = other;
+      absorb(AN);
+    }
+  }
+
+  // Fold the Max and Min nodes with splats into the clamp [lo, hi]. The clamp
+  // of a Winograd convolution that was fused before is extended.
+  float lo = WCN ? WCN->getClampMin() : -INFINITY;
+  float hi = WCN ? WCN->getClampMax() : INFINITY;
+  while (isFusible(user)) {
+    if (auto *MS = dyn_cast<CPUMaxSplatNode>(user)) {
+      lo = std::max(lo, MS->getSplatValue());
+      hi = std::max(hi, MS->getSplatValue());
+      absorb(MS);
+      continue;
+    }
+    if (auto *MN = dyn_cast<MinNode>(user)) {
+      auto *splat = dyn_cast<SplatNode>(MN->getRHS());
+      NodeValue input = MN->getLHS();
+      if (!splat) {
+        splat = dyn_cast<SplatNode>(MN->getLHS());
+        input = MN->getRHS();
+      }
+      if (!splat || input != cur) {
+        break;
+      }
+      lo = std::min(lo, splat->getValue());
+      hi = std::min(hi, splat->getValue());
+      absorb(MN);
+      continue;
+    }
+    break;
+  }
+
+  if (numAbsorbed == 0) {
+    return nullptr;
+  }
+
+  auto resTy = cur.getType();
+  Node *fused;
+  if (WCN) {
+    fused = F->addNode(new CPUWinogradConvNode(
+        N->getName(), resTy, WCN->getInput(), WCN->getFilter(),
+        WCN->getBias(), WCN->getPads(), lo, hi));
+  } else if (auto *MM = dyn_cast<MatMulNode>(N)) {
+    fused = F->addNode(new CPUFusedMatMulNode(N->getName(), resTy,
+                                              MM->getLHS(), MM->getRHS(),
+                                              bias, lo, hi));
+  } else {
+    NodeValue input, filter, convBias;
+    llvm::ArrayRef<unsigned_t> kernels, strides, pads;
+    unsigned_t group;
+    if (auto *CN = dyn_cast<ConvolutionNode>(N)) {
+      input = CN->getInput();
+      filter = CN->getFilter();
+      convBias = CN->getBias();
+      kernels = CN->getKernels();
+      strides = CN->getStrides();
+      pads = CN->getPads();
+      group = CN->getGroup();
+    } else {
+      auto *DN = cast<CPUConvDKKC8Node>(N);
+      input = DN->getInput();
+      filter = DN->getFilter();
+      convBias = DN->getBias();
+      kernels = DN->getKernels();
+      strides = DN->getStrides();
+      pads = DN->getPads();
+      group = DN->getGroup();
+    }
+    if (residual.getNode()) {
+      fused = F->addNode(new CPUFusedConvAddNode(
+          N->getName(), resTy, input, filter, convBias, residual, kernels,
+          strides, pads, group, lo, hi));
+    } else {
+      fused = F->addNode(new CPUFusedConvNode(N->getName(), resTy, input,
+                                              filter, convBias, kernels,
+                                              strides, pads, group, lo, hi));
+    }
+  }
+
+  cur.replaceAllUsesOfWith(fused);
+  return fused;
+}
+
 bool CPUBackend::transformPostLowering(Function *F,
                                        CompilationMode mode) const {
   bool changed = false;
   for (auto &node : F->getNodes()) {
     // Try to replace generic convolution with cpu-optimized version.
     if (auto *CN = dyn_cast<ConvolutionNode>(&node)) {
-      if (Node *NCN = optimizeCPUConv(CN, F)) {
+      Node *NCN = optimizeCPUDepthwiseConv(CN, F);
+      if (!NCN) {
+        NCN = optimizeCPUWinogradConv(CN, F);
+      }
+      if (!NCN) {
+        NCN = optimizeCPUConv(CN, F);
+      }
+      if (!NCN) {
+        NCN = optimizeCPUConvI8(CN, F);
+      }
+      if (NCN) {
         NodeValue(&node, 0).replaceAllUsesOfWith(NCN);
         changed = true;
         continue;
@@ -136,5 +522,16 @@ bool CPUBackend::transformPostLowering(Function *F,
     }
   }
 
+  // Fuse the epilogues of the convolutions and matrix multiplications into
+  // them. This runs after the loop above, so that the Max nodes have been
+  // merged into CPUMaxSplat and the convolutions have their final layout.
+  if (mode == CompilationMode::Infer) {
+    for (auto &node : F->getNodes()) {
+      if (fuseCPUEpilogue(&node, F)) {
+        changed = true;
+      }
+    }
+  }
+
   return changed;
 }
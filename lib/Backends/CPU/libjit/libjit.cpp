@@ -587,6 +587,145 @@ void libjit_max_pool_xy_generic(const T *inW, T *outW, size_t *inXY,
   }       // N
 }
 
+/// The number of lookups ahead of the current one whose rows are prefetched by
+/// the SparseLengthsSum kernels. The rows of large embedding tables are rarely
+/// in the cache, and the addresses of the next rows are known in advance.
+constexpr size_t slsPrefetchDistance = 8;
+
+/// Prefetch the \p size bytes that start at \p p into the cache.
+inline void libjit_prefetch(const void *p, size_t size) {
+  for (size_t i = 0; i < size; i += 64) {
+    __builtin_prefetch((const char *)p + i);
+  }
+}
+
+/// The context of the SparseLengthsWeightedSum kernels. The rows of \p data
+/// have \p lineSize elements of the type T. Quantized rows are dequantized
+/// with their own scale and offset. The uint8 rows are fused, i.e. each of
+/// them is followed by its float scale and offset instead.
+template <typename T> struct SparseLengthsSumTaskCtx {
+  float *dest;
+  const T *data;
+  const float *scales;
+  const float *offsets;
+  const float *weights;
+  const size_t *indices;
+  const size_t *lengths;
+  size_t segments;
+  size_t lineSize;
+  size_t numIndices;
+};
+
+/// Add the row \p row of the float data of \p ctx times \p weight to \p out.
+inline void libjit_sls_add_row(const SparseLengthsSumTaskCtx<float> &ctx,
+                               float *out, size_t row, float weight) {
+  const float *in = &ctx.data[row * ctx.lineSize];
+  float8 w = BroadcastFloat8(weight);
+  size_t k = 0;
+  for (; k + 8 <= ctx.lineSize; k += 8) {
+    AdduFloat8(&out[k], LoaduFloat8(&in[k]) * w);
+  }
+  for (; k < ctx.lineSize; k++) {
+    out[k] += in[k] * weight;
+  }
+}
+
+/// Add the dequantized row \p row of the int8 data of \p ctx times \p weight
+/// to \p out.
+inline void libjit_sls_add_row(const SparseLengthsSumTaskCtx<int8_t> &ctx,
+                               float *out, size_t row, float weight) {
+  const int8_t *in = &ctx.data[row * ctx.lineSize];
+  // (in * scale + offset) * weight = in * (scale * weight) + offset * weight.
+  float scale = ctx.scales[row] * weight;
+  float offset = ctx.offsets[row] * weight;
+  float8 s = BroadcastFloat8(scale);
+  float8 o = BroadcastFloat8(offset);
+  size_t k = 0;
+  for (; k + 8 <= ctx.lineSize; k += 8) {
+    int8x8 q;
+    memcpy(&q, &in[k], sizeof(q));
+    AdduFloat8(&out[k], __builtin_convertvector(q, float8) * s + o);
+  }
+  for (; k < ctx.lineSize; k++) {
+    out[k] += in[k] * scale + offset;
+  }
+}
+
+/// Add the dequantized row \p row of the fused uint8 data of \p ctx times
+/// \p weight to \p out.
+inline void libjit_sls_add_row(const SparseLengthsSumTaskCtx<uint8_t> &ctx,
+                               float *out, size_t row, float weight) {
+  const uint8_t *in = &ctx.data[row * (ctx.lineSize + 2 * sizeof(float))];
+  float scale, offset;
+  memcpy(&scale, &in[ctx.lineSize], sizeof(float));
+  memcpy(&offset, &in[ctx.lineSize + sizeof(float)], sizeof(float));
+  scale *= weight;
+  offset *= weight;
+  float8 s = BroadcastFloat8(scale);
+  float8 o = BroadcastFloat8(offset);
+  size_t k = 0;
+  for (; k + 8 <= ctx.lineSize; k += 8) {
+    uint8x8 q;
+    memcpy(&q, &in[k], sizeof(q));
+    AdduFloat8(&out[k], __builtin_convertvector(q, float8) * s + o);
+  }
+  for (; k < ctx.lineSize; k++) {
+    out[k] += in[k] * scale + offset;
+  }
+}
+
+/// \returns the number of elements of type T per row of the data of \p ctx.
+template <typename T>
+size_t libjit_sls_data_line_size(const SparseLengthsSumTaskCtx<T> &ctx) {
+  return ctx.lineSize;
+}
+
+/// \returns the number of bytes per row of the fused data of \p ctx.
+inline size_t
+libjit_sls_data_line_size(const SparseLengthsSumTaskCtx<uint8_t> &ctx) {
+  return ctx.lineSize + 2 * sizeof(float);
+}
+
+/// Compute a range of the segments of a SparseLengthsWeightedSum. Every
+/// segment is written by a single task.
+template <typename T>
+void libjit_sparse_lengths_sum_task(void *ctxPtr, size_t taskId,
+                                    size_t numTasks) {
+  const SparseLengthsSumTaskCtx<T> &ctx =
+      *(const SparseLengthsSumTaskCtx<T> *)ctxPtr;
+  size_t begin, end;
+  libjit_task_range(ctx.segments, taskId, numTasks, &begin, &end);
+
+  // Find the first lookup of the first segment of the range.
+  size_t curIdx = 0;
+  for (size_t i = 0; i < begin; i++) {
+    curIdx += ctx.lengths[i];
+  }
+
+  size_t dataLineSize = libjit_sls_data_line_size(ctx);
+  size_t rowSize = dataLineSize * sizeof(T);
+  for (size_t i = begin; i < end; i++) {
+    float *out = &ctx.dest[i * ctx.lineSize];
+    memset(out, 0, ctx.lineSize * sizeof(float));
+    for (size_t j = 0, e = ctx.lengths[i]; j < e; j++, curIdx++) {
+      if (curIdx + slsPrefetchDistance < ctx.numIndices) {
+        size_t next = ctx.indices[curIdx + slsPrefetchDistance];
+        libjit_prefetch(&ctx.data[next * dataLineSize], rowSize);
+      }
+      libjit_sls_add_row(ctx, out, ctx.indices[curIdx], ctx.weights[curIdx]);
+    }
+  }
+}
+
+/// Run the SparseLengthsWeightedSum described by \p ctx in parallel.
+template <typename T>
+void libjit_sparse_lengths_sum(SparseLengthsSumTaskCtx<T> &ctx) {
+  // The average number of elements that are accumulated per segment.
+  size_t segmentCost = ctx.numIndices * ctx.lineSize / MAX(ctx.segments, 1);
+  libjit_parallel_for(libjit_sparse_lengths_sum_task<T>, &ctx,
+                      libjit_num_tasks(ctx.segments, segmentCost));
+}
+
 } // namespace
 
 extern "C" {
@@ -737,6 +876,52 @@ DEFINE_DATA_PARALLEL_KERNEL_WITH_IMM_OPERAND(libjit_splat_kernel_u, size_t, val)
 DEFINE_DATA_PARALLEL_KERNEL_WITH_IMM_OPERAND(libjit_splat_kernel_i8, int8_t,
                                              val)
 
+/// Mini-kernels for the instructions that are fused into the loop nests of the
+/// generated kernels. \p idx is the index in the iteration space and
+/// \p sliceIdx is the index in the innermost loop of the nest, which indexes
+/// the broadcast slices and the reduced results.
+float libjit_batchedadd_kernel_f(size_t idx, size_t sliceIdx,
+                                 const float *batch, const float *slice) {
+  return batch[idx] + slice[sliceIdx];
+}
+
+int8_t libjit_batchedadd_kernel_i8(size_t idx, size_t sliceIdx,
+                                   const int8_t *batch, const int8_t *slice,
+                                   int32_t destOffset, int32_t batchOffset,
+                                   int32_t sliceOffset, int32_t batchPre,
+                                   int32_t batchPost, int32_t batchScale,
+                                   int32_t slicePre, int32_t slicePost,
+                                   int32_t sliceScale) {
+  int32_t b = batch[idx] - batchOffset;
+  int32_t s = slice[sliceIdx] - sliceOffset;
+  int32_t x = libjit_scale_i32i8(b, batchPre, batchPost, batchScale, 0);
+  int32_t y = libjit_scale_i32i8(s, slicePre, slicePost, sliceScale, 0);
+  return libjit_clip(x + y + destOffset);
+}
+
+float libjit_batchedreduceadd_kernel_f(size_t idx, size_t sliceIdx,
+                                       const float *batch, const float *dest) {
+  return dest[sliceIdx] + batch[idx];
+}
+
+int8_t libjit_quantize_kernel_i8(size_t idx, const float *src, float scale,
+                                 int32_t offset) {
+  int32_t result = (int32_t)nearbyintf(src[idx] / scale + offset);
+  return MAX(INT8_MIN, MIN(INT8_MAX, result));
+}
+
+float libjit_dequantize_kernel_f(size_t idx, const int8_t *src, float scale,
+                                 int32_t offset) {
+  return scale * (src[idx] - offset);
+}
+
+int8_t libjit_rescale_kernel_i8(size_t idx, const int8_t *src,
+                                int32_t outOffset, int32_t inOffset,
+                                int32_t pre, int32_t post, int32_t scale) {
+  return libjit_clip(
+      libjit_scale_i32i8(src[idx] - inOffset, pre, post, scale, outOffset));
+}
+
 #undef DEFINE_DATA_PARALLEL_KERNEL
 #undef DEFINE_DATA_PARALLEL_KERNEL_FUNC
 #undef DEFINE_DATA_PARALLEL_KERNEL_FUNC
@@ -870,6 +1055,59 @@ void libjit_gather_u(size_t *dest, const size_t *data, const size_t *indices,
                 sampleSize);
 }
 
+void libjit_sparse_lengths_weighted_sum_f(float *dest, const float *data,
+                                          const float *weights,
+                                          const size_t *indices,
+                                          const size_t *lengths,
+                                          size_t segments, size_t lineSize,
+                                          size_t numIndices) {
+  SparseLengthsSumTaskCtx<float> ctx = {dest,
+                                        data,
+                                        nullptr,
+                                        nullptr,
+                                        weights,
+                                        indices,
+                                        lengths,
+                                        segments,
+                                        lineSize,
+                                        numIndices};
+  libjit_sparse_lengths_sum(ctx);
+}
+
+void libjit_rowwise_quantized_sparse_lengths_weighted_sum_f(
+    float *dest, const int8_t *data, const float *scales, const float *offsets,
+    const float *weights, const size_t *indices, const size_t *lengths,
+    size_t segments, size_t lineSize, size_t numIndices) {
+  SparseLengthsSumTaskCtx<int8_t> ctx = {dest,
+                                         data,
+                                         scales,
+                                         offsets,
+                                         weights,
+                                         indices,
+                                         lengths,
+                                         segments,
+                                         lineSize,
+                                         numIndices};
+  libjit_sparse_lengths_sum(ctx);
+}
+
+void libjit_fused_rowwise_quantized_sparse_lengths_weighted_sum_f(
+    float *dest, const uint8_t *data, const float *weights,
+    const size_t *indices, const size_t *lengths, size_t segments,
+    size_t lineSize, size_t numIndices) {
+  SparseLengthsSumTaskCtx<uint8_t> ctx = {dest,
+                                          data,
+                                          nullptr,
+                                          nullptr,
+                                          weights,
+                                          indices,
+                                          lengths,
+                                          segments,
+                                          lineSize,
+                                          numIndices};
+  libjit_sparse_lengths_sum(ctx);
+}
+
 void libjit_scatterassign_f(float *data, const size_t *indices,
                             const float *slices, size_t numIndices,
                             size_t sliceSize) {
@@ -25,17 +25,17 @@
 #include "libjit_defs.h"
 
 namespace {
-// Initialize the convolution output frame for slice \p N with the bias \p
-// biasW.
-void libjit_conv_init_output_with_bias(size_t N, float *outW,
-                                       const float *biasW,
+// Initialize the output channels [\p dBegin, \p dEnd) of the convolution
+// output frame for slice \p N with the bias \p biasW.
+void libjit_conv_init_output_with_bias(size_t N, size_t dBegin, size_t dEnd,
+                                       float *outW, const float *biasW,
                                        const size_t *outWdims,
                                        const size_t *biasWdims) {
   // For each (x,y) step in the output tensor:
   for (size_t ax = 0; ax < outWdims[1]; ax++) {
     for (size_t ay = 0; ay < outWdims[2]; ay++) {
       // For each output channel:
-      for (size_t d = 0; d < outWdims[3]; d++) {
+      for (size_t d = dBegin; d < dEnd; d++) {
         // Store the results to the output buffer.
         float bias = biasW[d];
         auto outIdx = libjit_getXYZW(outWdims, N, ax, ay, d);
@@ -45,6 +45,109 @@ void libjit_conv_init_output_with_bias(size_t N, float *outW,
   }     // For each X in the output.
 }
 
+struct ConvTaskCtx;
+
+/// Computes the output channels [dBegin, dEnd) of the sample n of a
+/// convolution. All of the channels belong to the group g.
+typedef void (*libjit_conv_slice_fn)(const ConvTaskCtx &ctx, size_t n,
+                                     size_t g, size_t dBegin, size_t dEnd);
+
+/// The context of a parallel float convolution. The output of the convolution
+/// is split into work items, each of which is a block of \p blockSize output
+/// channels of a single sample. Blocks never cross the group boundaries.
+struct ConvTaskCtx {
+  float *outW;
+  const float *inW;
+  const float *filterW;
+  const float *biasW;
+  const size_t *outWdims;
+  const size_t *inWdims;
+  const size_t *filterWdims;
+  const size_t *biasWdims;
+  const size_t *kernelSizes;
+  const size_t *strides;
+  const size_t *pads;
+  size_t group;
+  /// Parameters of libjit_convDKKC8_f.
+  unsigned pixelScanFirst;
+  unsigned numDepthRegs;
+  unsigned sizeGroupY;
+  unsigned depthStrips;
+  /// Parameters of libjit_convolution_f.
+  unsigned depthUnroll;
+  /// The number of output channels in a work item.
+  size_t blockSize;
+  /// The function that computes a run of work items.
+  libjit_conv_slice_fn slice;
+  /// The epilogue of a fused convolution: the tensor that is added to the
+  /// output, or null, and the range that the output is clamped to.
+  const float *residualW;
+  float clampMin;
+  float clampMax;
+};
+
+/// Apply the epilogue of the fused convolution \p ctx to the output channels
+/// [\p dBegin, \p dEnd) of the sample \p n. The kernels accumulate the
+/// contributions of the filter pixels in the output, so the epilogue runs
+/// right after the work item is complete, while it is still in the cache.
+void libjit_conv_epilogue(const ConvTaskCtx &ctx, size_t n, size_t dBegin,
+                          size_t dEnd) {
+  if (!ctx.residualW && ctx.clampMin == -INFINITY &&
+      ctx.clampMax == INFINITY) {
+    return;
+  }
+  for (size_t ax = 0; ax < ctx.outWdims[1]; ax++) {
+    for (size_t ay = 0; ay < ctx.outWdims[2]; ay++) {
+      size_t outIdx = libjit_getXYZW(ctx.outWdims, n, ax, ay, dBegin);
+      libjit_fused_epilogue_f(&ctx.outW[outIdx],
+                              ctx.residualW ? &ctx.residualW[outIdx] : nullptr,
+                              dEnd - dBegin, ctx.clampMin, ctx.clampMax);
+    }
+  }
+}
+
+/// \returns the number of work items in a single group of \p ctx.
+size_t libjit_conv_blocks_per_group(const ConvTaskCtx &ctx) {
+  size_t outCperG = ctx.outWdims[3] / ctx.group;
+  return (outCperG + ctx.blockSize - 1) / ctx.blockSize;
+}
+
+/// Process the work items of the task \p taskId out of \p numTasks. Adjacent
+/// items of the same sample and group are processed by a single call of the
+/// slice function, which keeps the blocking of the serial kernel.
+void libjit_conv_task(void *ctxPtr, size_t taskId, size_t numTasks) {
+  const ConvTaskCtx &ctx = *(const ConvTaskCtx *)ctxPtr;
+  size_t outCperG = ctx.outWdims[3] / ctx.group;
+  size_t blocksPerGroup = libjit_conv_blocks_per_group(ctx);
+  size_t blocksPerSample = blocksPerGroup * ctx.group;
+  size_t begin, end;
+  libjit_task_range(ctx.outWdims[0] * blocksPerSample, taskId, numTasks,
+                    &begin, &end);
+  for (size_t item = begin; item < end;) {
+    size_t n = item / blocksPerSample;
+    size_t g = (item % blocksPerSample) / blocksPerGroup;
+    size_t blk = item % blocksPerGroup;
+    size_t blkEnd = MIN(blocksPerGroup, blk + (end - item));
+    size_t dBegin = g * outCperG + blk * ctx.blockSize;
+    size_t dEnd = g * outCperG + MIN(blkEnd * ctx.blockSize, outCperG);
+    ctx.slice(ctx, n, g, dBegin, dEnd);
+    libjit_conv_epilogue(ctx, n, dBegin, dEnd);
+    item += blkEnd - blk;
+  }
+}
+
+/// Run the convolution described by \p ctx, possibly in parallel.
+void libjit_conv_run(ConvTaskCtx &ctx) {
+  size_t numItems =
+      ctx.outWdims[0] * ctx.group * libjit_conv_blocks_per_group(ctx);
+  // The number of multiply-adds in a work item.
+  size_t itemCost = ctx.outWdims[1] * ctx.outWdims[2] * ctx.blockSize *
+                    ctx.kernelSizes[0] * ctx.kernelSizes[1] *
+                    (ctx.inWdims[3] / ctx.group);
+  libjit_parallel_for(libjit_conv_task, &ctx,
+                      libjit_num_tasks(numItems, itemCost));
+}
+
 /// Perform the heart of the convolution. Load \p ywidth scalars in a specific
 /// channel, broadcast them, and multiply them with
 /// [ywidth * float8 * numDepthRegs] depth values and accumulate them to create
@@ -251,73 +354,57 @@ void libjit_convDKKC8_foreach_xy_pixels_filter(
   }       // For each X in the output.
 }
 
-} // namespace
-
-extern "C" {
-void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
-                        const float *biasW, const size_t *outWdims,
-                        const size_t *inWdims, const size_t *filterWdims,
-                        const size_t *biasWdims, const size_t *kernelSizes,
-                        const size_t *strides, const size_t *pads, size_t group,
-                        unsigned pixelScanFirst, unsigned numDepthRegs,
-                        unsigned sizeGroupY, unsigned depthStrips) {
-  size_t inChannels = inWdims[3];
-  size_t outChannels = outWdims[3];
-  size_t inCperG = inChannels / group;
-  size_t outCperG = outChannels / group;
+/// Compute the output channels [\p dBegin, \p dEnd) of the sample \p n of the
+/// DKKC8 convolution \p ctx.
+void libjit_convDKKC8_slice(const ConvTaskCtx &ctx, size_t n, size_t g,
+                            size_t dBegin, size_t dEnd) {
+  size_t inCperG = ctx.inWdims[3] / ctx.group;
+  size_t endChannelIndex = (g + 1) * (ctx.outWdims[3] / ctx.group);
 
   // Select the order in which we iterate over the pixels in the picture.
   auto eachPixelConv =
-      (pixelScanFirst ? &libjit_convDKKC8_foreach_xy_pixels_filter
-                      : &libjit_convDKKC8_foreach_xy_filter_pixels);
+      (ctx.pixelScanFirst ? &libjit_convDKKC8_foreach_xy_pixels_filter
+                          : &libjit_convDKKC8_foreach_xy_filter_pixels);
 
-  // For each input in the batch:
-  for (size_t n = 0; n < inWdims[0]; n++) {
-
-    // Initialize the output frame for the N'th slice with the bias.
-    // Later we will accumulate values into this slice.
-    libjit_conv_init_output_with_bias(n, outW, biasW, outWdims, biasWdims);
+  // Initialize the output channels of the N'th slice with the bias.
+  // Later we will accumulate values into this slice.
+  libjit_conv_init_output_with_bias(n, dBegin, dEnd, ctx.outW, ctx.biasW,
+                                    ctx.outWdims, ctx.biasWdims);
 
-    // For each group of input channels:
-    for (size_t g = 0; g < group; g++) {
+  // For each output channel, process [numDepthRegs x float8] elements.
+  for (size_t d = dBegin; d < dEnd; d += ctx.blockSize) {
 
-      // For each output channel, process [numDepthRegs x float8] elements.
-      size_t startChannelIndex = g * outCperG;
-      size_t endChannelIndex = (g + 1) * outCperG;
-      for (size_t d = startChannelIndex; d < endChannelIndex;
-           d += 8 * numDepthRegs * depthStrips) {
+    // Perform the convolution for each pixel.
+    eachPixelConv(n, d, ctx.numDepthRegs, ctx.depthStrips, ctx.sizeGroupY,
+                  inCperG, ctx.outW, ctx.inW, ctx.filterW, ctx.biasW,
+                  ctx.outWdims, ctx.inWdims, ctx.filterWdims, ctx.biasWdims,
+                  ctx.kernelSizes, ctx.strides, ctx.pads, g, endChannelIndex);
 
-        // Perform the convolution for each pixel.
-        eachPixelConv(n, d, numDepthRegs, depthStrips, sizeGroupY, inCperG,
-                      outW, inW, filterW, biasW, outWdims, inWdims, filterWdims,
-                      biasWdims, kernelSizes, strides, pads, g,
-                      endChannelIndex);
-
-      } // For each D (the depth, or the output channel).
-    }   // for each G, the group
-  }     // For each N, the sample in the batch.
+  } // For each D (the depth, or the output channel).
 }
 
-void libjit_convolution_f(float *outW, const float *inW, const float *filterW,
-                          const float *biasW, const size_t *outWdims,
-                          const size_t *inWdims, const size_t *filterWdims,
-                          const size_t *biasWdims, const size_t *kernelSizes,
-                          const size_t *strides, const size_t *pads,
-                          size_t group, unsigned depthUnroll) {
-  size_t inChannels = inWdims[3];
-  size_t outChannels = outWdims[3];
-  size_t inCperG = inChannels / group;
-  size_t outCperG = outChannels / group;
+/// Compute the output channels [\p dBegin, \p dEnd) of the sample \p n of the
+/// generic float convolution \p ctx.
+void libjit_convolution_slice(const ConvTaskCtx &ctx, size_t n, size_t g,
+                              size_t dBegin, size_t dEnd) {
+  float *outW = ctx.outW;
+  const float *inW = ctx.inW;
+  const float *filterW = ctx.filterW;
+  const size_t *outWdims = ctx.outWdims;
+  const size_t *inWdims = ctx.inWdims;
+  const size_t *filterWdims = ctx.filterWdims;
+  unsigned depthUnroll = ctx.depthUnroll;
+  size_t inCperG = inWdims[3] / ctx.group;
 
   // The output dims are calculated already from all of the pads,
   // therefore we only need the top and left pads here to control the starting
   // position.
-  size_t pad_t = pads[0];
-  size_t pad_l = pads[1];
-  size_t stride_h = strides[0];
-  size_t stride_w = strides[1];
-  size_t kernel_h = kernelSizes[0];
-  size_t kernel_w = kernelSizes[1];
+  size_t pad_t = ctx.pads[0];
+  size_t pad_l = ctx.pads[1];
+  size_t stride_h = ctx.strides[0];
+  size_t stride_w = ctx.strides[1];
+  size_t kernel_h = ctx.kernelSizes[0];
+  size_t kernel_w = ctx.kernelSizes[1];
   // The size of the input-channel tile. High channel count allow for SIMD
   // parallelism but create register pressure. Low channel count reduces the
   // memory pressure and allows things to fit in cache, but require additional
@@ -325,192 +412,1003 @@ void libjit_convolution_f(float *outW, const float *inW, const float *filterW,
   // compromise between the two.
   constexpr unsigned cbSize = 512;
 
-  // For each input in the batch:
-  for (size_t n = 0; n < inWdims[0]; n++) {
+  // Initialize the output channels of the N'th slice with the bias.
+  // Later we will accumulate values into this slice.
+  libjit_conv_init_output_with_bias(n, dBegin, dEnd, outW, ctx.biasW, outWdims,
+                                    ctx.biasWdims);
 
-    // Initialize the output frame for the N'th slice with the bias.
-    // Later we will accumulate values into this slice.
-    libjit_conv_init_output_with_bias(n, outW, biasW, outWdims, biasWdims);
+  // Process the body of the loop in tiles of "channel-block".
+  for (size_t cb = 0; cb < inCperG; cb += cbSize) {
 
-    // For each group of input channels:
-    for (size_t g = 0; g < group; g++) {
-      // Process the body of the loop in tiles of "channel-block".
-      for (size_t cb = 0; cb < inCperG; cb += cbSize) {
-
-        // For each output channel in the group. Process 'depthUnroll' output
-        // layers together.
-        for (size_t d = g * outCperG; d < (g + 1) * outCperG;
-             d += depthUnroll) {
-
-          // For each element in the convolution-filter:
-          for (size_t fx = 0; fx < kernel_h; fx++) {
-            for (size_t fy = 0; fy < kernel_w; fy++) {
-
-              // For each convolution 'jump' in the input tensor:
-              for (size_t outx = 0; outx < outWdims[1]; outx++) {
-                for (size_t outy = 0; outy < outWdims[2]; outy++) {
-
-                  // Process 'depthUnroll' output pixels at once. Each scalar
-                  // here represents the convolution sum for one (x,y) point in
-                  // the output. We process the same pixel for different output
-                  // channel (D) values. The compiler should perform scalar
-                  // replacement of aggregates and split this tiny array to
-                  // registers.
-                  float sum[depthUnroll];
-                  for (unsigned i = 0; i < depthUnroll; i++) {
-                    sum[i] = 0;
-                  }
+    // For each output channel in the slice. Process 'depthUnroll' output
+    // layers together.
+    for (size_t d = dBegin; d < dEnd; d += depthUnroll) {
 
-                  // Calculate the specific input x,y that we process in this
-                  // iteration.
-                  ssize_t inx = (ssize_t)outx * stride_h - pad_t + fx;
-                  ssize_t iny = (ssize_t)outy * stride_w - pad_l + fy;
+      // For each element in the convolution-filter:
+      for (size_t fx = 0; fx < kernel_h; fx++) {
+        for (size_t fy = 0; fy < kernel_w; fy++) {
 
-                  // Ignore index access below zero (this is due to padding).
-                  if (inx < 0 || iny < 0 || inx >= (ssize_t)inWdims[1] ||
-                      iny >= (ssize_t)inWdims[2]) {
-                    continue;
-                  }
+          // For each convolution 'jump' in the input tensor:
+          for (size_t outx = 0; outx < outWdims[1]; outx++) {
+            for (size_t outy = 0; outy < outWdims[2]; outy++) {
+
+              // Process 'depthUnroll' output pixels at once. Each scalar
+              // here represents the convolution sum for one (x,y) point in
+              // the output. We process the same pixel for different output
+              // channel (D) values. The compiler should perform scalar
+              // replacement of aggregates and split this tiny array to
+              // registers.
+              float sum[depthUnroll];
+              for (unsigned i = 0; i < depthUnroll; i++) {
+                sum[i] = 0;
+              }
 
-                  // Calculate the indices into the Filter and Input buffers.
-                  size_t inIdx = libjit_getXYZW(inWdims, n, (size_t)inx,
-                                                (size_t)iny, g * inCperG);
-                  size_t filterIdx = libjit_getXYZW(filterWdims, d, fx, fy, 0);
-                  size_t sliceSize =
-                      filterWdims[1] * filterWdims[2] * filterWdims[3];
-
-                  // Perform the heart of the convolution, 4 elements at a time
-                  // to reduce register pressure.
-                  for (size_t fd = cb, e = MIN(cb + cbSize, inCperG); fd < e;
-                       fd++) {
-                    float in = inW[inIdx + fd];
-                    for (unsigned i = 0; i < MIN(4, depthUnroll); i++) {
-                      sum[i] += filterW[filterIdx + (sliceSize * i) + fd] * in;
-                    }
-                  }
+              // Calculate the specific input x,y that we process in this
+              // iteration.
+              ssize_t inx = (ssize_t)outx * stride_h - pad_t + fx;
+              ssize_t iny = (ssize_t)outy * stride_w - pad_l + fy;
 
-                  // And run the innermost loop again for the second group of
-                  // depth slices:
-                  if (depthUnroll > 4) {
-                    for (size_t fd = cb, e = MIN(cb + cbSize, inCperG); fd < e;
-                         fd++) {
-                      float in = inW[inIdx + fd];
-                      for (unsigned i = 4; i < MIN(8, depthUnroll); i++) {
-                        sum[i] +=
-                            filterW[filterIdx + (sliceSize * i) + fd] * in;
-                      }
-                    }
-                  }
+              // Ignore index access below zero (this is due to padding).
+              if (inx < 0 || iny < 0 || inx >= (ssize_t)inWdims[1] ||
+                  iny >= (ssize_t)inWdims[2]) {
+                continue;
+              }
 
-                  // Store the results to the output buffer.
-                  for (unsigned i = 0; i < depthUnroll; i++) {
-                    outW[libjit_getXYZW(outWdims, n, outx, outy, d + i)] +=
-                        sum[i];
+              // Calculate the indices into the Filter and Input buffers.
+              size_t inIdx = libjit_getXYZW(inWdims, n, (size_t)inx,
+                                            (size_t)iny, g * inCperG);
+              size_t filterIdx = libjit_getXYZW(filterWdims, d, fx, fy, 0);
+              size_t sliceSize =
+                  filterWdims[1] * filterWdims[2] * filterWdims[3];
+
+              // Perform the heart of the convolution, 4 elements at a time
+              // to reduce register pressure.
+              for (size_t fd = cb, e = MIN(cb + cbSize, inCperG); fd < e;
+                   fd++) {
+                float in = inW[inIdx + fd];
+                for (unsigned i = 0; i < MIN(4, depthUnroll); i++) {
+                  sum[i] += filterW[filterIdx + (sliceSize * i) + fd] * in;
+                }
+              }
+
+              // And run the innermost loop again for the second group of
+              // depth slices:
+              if (depthUnroll > 4) {
+                for (size_t fd = cb, e = MIN(cb + cbSize, inCperG); fd < e;
+                     fd++) {
+                  float in = inW[inIdx + fd];
+                  for (unsigned i = 4; i < MIN(8, depthUnroll); i++) {
+                    sum[i] += filterW[filterIdx + (sliceSize * i) + fd] * in;
                   }
                 }
               }
-            } // For each Y in the filter.
-          }   // For each X in the filter.
-        }     // For each D (the depth, or the output channel).
-      }       // For each block in the input channel.
-    }         // For each group in the input channel.
-  }           // For each N, the sample in the batch.
+
+              // Store the results to the output buffer.
+              for (unsigned i = 0; i < depthUnroll; i++) {
+                outW[libjit_getXYZW(outWdims, n, outx, outy, d + i)] += sum[i];
+              }
+            }
+          }
+        } // For each Y in the filter.
+      }   // For each X in the filter.
+    }     // For each D (the depth, or the output channel).
+  }       // For each block in the input channel.
 }
 
-void libjit_convolution_i8(
-    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
-    const size_t *outWdims, const size_t *inWdims, const size_t *filterWdims,
-    const size_t *biasWdims, const size_t *kernelSizes, const size_t *strides,
-    const size_t *pads, size_t group, int32_t outOffset, int32_t inOffset,
-    int32_t filterOffset, int32_t biasOffset, int32_t biasPre, int32_t biasPost,
-    int32_t biasScale, int32_t outPre, int32_t outPost, int32_t outScale,
-    unsigned depthUnroll) {
-  size_t inChannels = inWdims[3];
+/// The number of output pixels whose im2col patches are multiplied with the
+/// filter at once by the quantized convolution.
+constexpr size_t convTileI8 = 8 * mrI8;
+
+/// The context of a quantized convolution, which is computed as the product
+/// of the im2col patches of the input and the filter.
+struct ConvI8TaskCtx {
+  int8_t *outW;
+  const int8_t *inW;
+  /// The filter, either in the DKKC layout or packed into panels of nrI8
+  /// output channels with the layout [G * ceil(D/G/nrI8), K, K, C/G, nrI8].
+  const int8_t *filterW;
+  bool packedFilter;
+  const size_t *outWdims;
+  const size_t *inWdims;
+  const size_t *kernelSizes;
+  const size_t *strides;
+  const size_t *pads;
+  size_t group;
+  /// The terms that are added to the result of each output channel: the
+  /// scaled bias and the parts of the offset correction that don't depend on
+  /// the input.
+  const int32_t *channelTerms;
+  int32_t inOffset;
+  int32_t filterOffset;
+  int32_t outOffset;
+  int32_t outPre;
+  int32_t outPost;
+  int32_t outScale;
+};
+
+/// Copy the input pixels that the output pixels [\p pixBegin, \p pixEnd) of
+/// the group \p g of the sample \p n are computed from into consecutive rows
+/// of \p patches. Pixels that fall in the padding are filled with the input
+/// offset, which is the quantized zero, so that the product of the patches
+/// and the filter does not need any bounds checks. The part of the offset
+/// correction that depends on the patch is written to \p rowTerms.
+void libjit_conv_i8_im2col(const ConvI8TaskCtx &ctx, size_t n, size_t g,
+                           size_t pixBegin, size_t pixEnd, int8_t *patches,
+                           int32_t *rowTerms) {
+  size_t inCperG = ctx.inWdims[3] / ctx.group;
+  size_t kernel_h = ctx.kernelSizes[0];
+  size_t kernel_w = ctx.kernelSizes[1];
+  size_t patchSize = kernel_h * kernel_w * inCperG;
+  int8_t padValue = libjit_clip(ctx.inOffset);
+
+  for (size_t pix = pixBegin; pix < pixEnd; pix++) {
+    ssize_t x = (ssize_t)((pix / ctx.outWdims[2]) * ctx.strides[0]) -
+                (ssize_t)ctx.pads[0];
+    ssize_t y = (ssize_t)((pix % ctx.outWdims[2]) * ctx.strides[1]) -
+                (ssize_t)ctx.pads[1];
+    int8_t *patch = patches;
+    for (size_t fx = 0; fx < kernel_h; fx++) {
+      for (size_t fy = 0; fy < kernel_w; fy++) {
+        ssize_t ox = x + fx;
+        ssize_t oy = y + fy;
+        if (ox < 0 || oy < 0 || ox >= (ssize_t)ctx.inWdims[1] ||
+            oy >= (ssize_t)ctx.inWdims[2]) {
+          memset(patch, padValue, inCperG);
+        } else {
+          memcpy(patch,
+                 &ctx.inW[libjit_getXYZW(ctx.inWdims, n, (size_t)ox,
+                                         (size_t)oy, g * inCperG)],
+                 inCperG);
+        }
+        patch += inCperG;
+      }
+    }
+
+    int32_t sum = 0;
+    for (size_t i = 0; i < patchSize; i++) {
+      sum += patches[i];
+    }
+    *rowTerms++ = -ctx.filterOffset * sum;
+    patches += patchSize;
+  }
+}
+
+/// Pack the output channels [\p d, \p d + nrI8) of the DKKC filter \p filterW,
+/// whose channels have \p patchSize values each, into the panel \p panel.
+/// Channels at or past \p dEnd are padded with zeros.
+void libjit_conv_i8_pack_panel(const int8_t *filterW, size_t patchSize,
+                               size_t d, size_t dEnd, int8_t *panel) {
+  for (size_t jj = 0; jj < nrI8; jj++) {
+    for (size_t p = 0; p < patchSize; p++) {
+      panel[p * nrI8 + jj] =
+          d + jj < dEnd ? filterW[(d + jj) * patchSize + p] : 0;
+    }
+  }
+}
+
+/// \returns the number of values in an im2col patch of the quantized
+/// convolution \p ctx.
+size_t libjit_conv_i8_patch_size(const ConvI8TaskCtx &ctx) {
+  return ctx.kernelSizes[0] * ctx.kernelSizes[1] *
+         (ctx.inWdims[3] / ctx.group);
+}
+
+/// Compute the output pixels [\p pixBegin, \p pixEnd) of the group \p g of the
+/// sample \p n of the quantized convolution \p ctx. The pixels are at most
+/// convTileI8, and their patches are multiplied with every panel of the
+/// group's filter. \p patches holds convTileI8 patches, and \p panelBuffer
+/// one panel, into which the filter is packed if it was not packed at compile
+/// time.
+void libjit_conv_i8_tile(const ConvI8TaskCtx &ctx, size_t n, size_t g,
+                         size_t pixBegin, size_t pixEnd, int8_t *patches,
+                         int8_t *panelBuffer) {
+  size_t outChannels = ctx.outWdims[3];
+  size_t outCperG = outChannels / ctx.group;
+  size_t patchSize = libjit_conv_i8_patch_size(ctx);
+  size_t numPanels = (outCperG + nrI8 - 1) / nrI8;
+  size_t rows = pixEnd - pixBegin;
+
+  int32_t rowTerms[convTileI8];
+  libjit_conv_i8_im2col(ctx, n, g, pixBegin, pixEnd, patches, rowTerms);
+
+  int8_t *out =
+      &ctx.outW[(n * ctx.outWdims[1] * ctx.outWdims[2] + pixBegin) *
+                outChannels];
+  for (size_t p = 0; p < numPanels; p++) {
+    size_t d = g * outCperG + p * nrI8;
+    size_t cols = MIN(nrI8, outCperG - p * nrI8);
+    const int8_t *panel;
+    if (ctx.packedFilter) {
+      panel = &ctx.filterW[(g * numPanels + p) * patchSize * nrI8];
+    } else {
+      libjit_conv_i8_pack_panel(ctx.filterW, patchSize, d,
+                                (g + 1) * outCperG, panelBuffer);
+      panel = panelBuffer;
+    }
+
+    size_t r = 0;
+    for (; r + mrI8 <= rows; r += mrI8) {
+      libjit_matmul_i8_block<mrI8>(
+          patchSize, &patches[r * patchSize], patchSize, panel, &rowTerms[r],
+          &ctx.channelTerms[d], &out[r * outChannels + d], outChannels, cols,
+          ctx.outPre, ctx.outPost, ctx.outScale, ctx.outOffset);
+    }
+    // Handle the remaining pixels one at a time.
+    for (; r < rows; r++) {
+      libjit_matmul_i8_block<1>(
+          patchSize, &patches[r * patchSize], patchSize, panel, &rowTerms[r],
+          &ctx.channelTerms[d], &out[r * outChannels + d], outChannels, cols,
+          ctx.outPre, ctx.outPost, ctx.outScale, ctx.outOffset);
+    }
+  }
+}
+
+/// \returns the number of tiles of convTileI8 output pixels per image.
+size_t libjit_conv_i8_tiles_per_image(const ConvI8TaskCtx &ctx) {
+  return (ctx.outWdims[1] * ctx.outWdims[2] + convTileI8 - 1) / convTileI8;
+}
+
+/// Compute a range of the tiles of the quantized convolution. The tiles of
+/// all the samples and groups are independent.
+void libjit_conv_i8_task(void *ctxPtr, size_t taskId, size_t numTasks) {
+  const ConvI8TaskCtx &ctx = *(const ConvI8TaskCtx *)ctxPtr;
+  size_t numPixels = ctx.outWdims[1] * ctx.outWdims[2];
+  size_t numTiles = libjit_conv_i8_tiles_per_image(ctx);
+  size_t begin, end;
+  libjit_task_range(ctx.outWdims[0] * ctx.group * numTiles, taskId, numTasks,
+                    &begin, &end);
+  if (begin == end) {
+    return;
+  }
+
+  // The patches and the panel grow with the filter, so they are kept off the
+  // stack. All the tiles of the task reuse them.
+  size_t patchSize = libjit_conv_i8_patch_size(ctx);
+  size_t patchesSize = convTileI8 * patchSize;
+  int8_t *patches = (int8_t *)libjit_alloc_scratch(
+      patchesSize + (ctx.packedFilter ? 0 : patchSize * nrI8));
+  for (size_t i = begin; i < end; i++) {
+    size_t n = i / (ctx.group * numTiles);
+    size_t g = (i / numTiles) % ctx.group;
+    size_t pixBegin = (i % numTiles) * convTileI8;
+    libjit_conv_i8_tile(ctx, n, g, pixBegin,
+                        MIN(pixBegin + convTileI8, numPixels), patches,
+                        patches + patchesSize);
+  }
+  libjit_free_scratch(patches);
+}
+
+/// Compute the quantized convolution with the filter \p filterW, which is in
+/// the DKKC layout or packed (see ConvI8TaskCtx) if \p packedFilter is true.
+/// sum((in - io) * (f - fo)) = sum(in * f) - fo * sum(in) - io * sum(f) +
+/// K * io * fo, where K is the size of a patch. The terms that depend on the
+/// output channel only are computed once, together with the scaled bias.
+void libjit_conv_i8(int8_t *outW, const int8_t *inW, const int8_t *filterW,
+                    const int8_t *biasW, const size_t *outWdims,
+                    const size_t *inWdims, const size_t *kernelSizes,
+                    const size_t *strides, const size_t *pads, size_t group,
+                    bool packedFilter, int32_t outOffset, int32_t inOffset,
+                    int32_t filterOffset, int32_t biasOffset, int32_t biasPre,
+                    int32_t biasPost, int32_t biasScale, int32_t outPre,
+                    int32_t outPost, int32_t outScale) {
   size_t outChannels = outWdims[3];
-  size_t inCperG = inChannels / group;
   size_t outCperG = outChannels / group;
-  size_t pad_t = pads[0];
-  size_t pad_l = pads[1];
-  size_t stride_h = strides[0];
-  size_t stride_w = strides[1];
-  size_t kernel_h = kernelSizes[0];
-  size_t kernel_w = kernelSizes[1];
-  // For each input in the batch:
-  for (size_t n = 0; n < inWdims[0]; n++) {
-    // For each group of input channels:
+  size_t patchSize = kernelSizes[0] * kernelSizes[1] * (inWdims[3] / group);
+  size_t numPanels = (outCperG + nrI8 - 1) / nrI8;
+
+  // The kernel reads the terms of whole panels, so pad them to a multiple of
+  // nrI8 past the last channel. The sums of the filter are turned into the
+  // terms of the channels in place.
+  int32_t *channelTerms =
+      (int32_t *)libjit_alloc_scratch((outChannels + nrI8) * sizeof(int32_t));
+  int32_t *filterSums = channelTerms;
+  memset(filterSums, 0, (outChannels + nrI8) * sizeof(int32_t));
+  if (packedFilter) {
     for (size_t g = 0; g < group; g++) {
+      for (size_t p = 0; p < numPanels; p++) {
+        const int8_t *panel = &filterW[(g * numPanels + p) * patchSize * nrI8];
+        size_t cols = MIN(nrI8, outCperG - p * nrI8);
+        int32_t *sums = &filterSums[g * outCperG + p * nrI8];
+        for (size_t i = 0; i < patchSize; i++) {
+          for (size_t jj = 0; jj < cols; jj++) {
+            sums[jj] += panel[i * nrI8 + jj];
+          }
+        }
+      }
+    }
+  } else {
+    for (size_t d = 0; d < outChannels; d++) {
+      for (size_t i = 0; i < patchSize; i++) {
+        filterSums[d] += filterW[d * patchSize + i];
+      }
+    }
+  }
 
-      // For each output channel in the group. Process 'depthUnroll' output
-      // layers together.
-      for (size_t d = g * outCperG; d < (g + 1) * outCperG; d += depthUnroll) {
-        // For each convolution 'jump' in the input tensor:
-        ssize_t x = -(ssize_t)pad_t;
-        for (size_t ax = 0; ax < outWdims[1]; x += stride_h, ax++) {
-          ssize_t y = -(ssize_t)pad_l;
-          for (size_t ay = 0; ay < outWdims[2]; y += stride_w, ay++) {
-            int32_t sum[depthUnroll];
+  int32_t offsetsProduct = int32_t(patchSize) * inOffset * filterOffset;
+  for (size_t d = 0; d < outChannels + nrI8; d++) {
+    // Scale the bias to match the scale of the matrix multiplication.
+    int32_t bias = d < outChannels
+                       ? libjit_scale_i32i8((int32_t)biasW[d] - biasOffset,
+                                            biasPre, biasPost, biasScale, 0)
+                       : 0;
+    channelTerms[d] = bias - inOffset * filterSums[d] + offsetsProduct;
+  }
 
-            for (unsigned i = 0; i < depthUnroll; i++) {
-              // Scale the bias to match the scale of the matrix multiplication.
-              sum[i] = libjit_scale_i32i8((int32_t)biasW[d + i] - biasOffset,
-                                          biasPre, biasPost, biasScale, 0);
-            }
+  ConvI8TaskCtx ctx = {outW,
+                       inW,
+                       filterW,
+                       packedFilter,
+                       outWdims,
+                       inWdims,
+                       kernelSizes,
+                       strides,
+                       pads,
+                       group,
+                       channelTerms,
+                       inOffset,
+                       filterOffset,
+                       outOffset,
+                       outPre,
+                       outPost,
+                       outScale};
+  size_t numItems = outWdims[0] * group * libjit_conv_i8_tiles_per_image(ctx);
+  // The number of multiply-adds in a work item.
+  size_t itemCost = convTileI8 * outCperG * patchSize;
+  libjit_parallel_for(libjit_conv_i8_task, &ctx,
+                      libjit_num_tasks(numItems, itemCost));
+  libjit_free_scratch(channelTerms);
+}
 
-            // For each element in the convolution-filter:
-            for (size_t fx = 0; fx < kernel_h; fx++) {
-              for (size_t fy = 0; fy < kernel_w; fy++) {
-                ssize_t ox = x + fx;
-                ssize_t oy = y + fy;
+/// The context of a float depthwise convolution. The filter has the layout
+/// [K, K, C], and the work items are the rows of the output.
+struct DepthwiseConvTaskCtx {
+  float *outW;
+  const float *inW;
+  const float *filterW;
+  const float *biasW;
+  const size_t *outWdims;
+  const size_t *inWdims;
+  const size_t *kernelSizes;
+  const size_t *strides;
+  const size_t *pads;
+};
+
+/// Compute the channels [\p d, \p d + 8 * \p regs) of the output pixel \p out
+/// of the sample \p n, whose filter window starts at the input pixel
+/// (\p x, \p y). The channels are accumulated in vector registers over all
+/// of the filter taps, and taps that fall in the padding are skipped.
+template <size_t regs>
+void libjit_depthwise_conv_block_f(const DepthwiseConvTaskCtx &ctx, size_t n,
+                                   ssize_t x, ssize_t y, size_t d,
+                                   float *out) {
+  size_t channels = ctx.inWdims[3];
+  float8 sum[regs];
+  for (size_t r = 0; r < regs; r++) {
+    sum[r] = LoaduFloat8(&ctx.biasW[d + 8 * r]);
+  }
+  for (size_t fx = 0; fx < ctx.kernelSizes[0]; fx++) {
+    ssize_t ox = x + fx;
+    if (ox < 0 || ox >= (ssize_t)ctx.inWdims[1]) {
+      continue;
+    }
+    for (size_t fy = 0; fy < ctx.kernelSizes[1]; fy++) {
+      ssize_t oy = y + fy;
+      if (oy < 0 || oy >= (ssize_t)ctx.inWdims[2]) {
+        continue;
+      }
+      const float *in =
+          &ctx.inW[libjit_getXYZW(ctx.inWdims, n, (size_t)ox, (size_t)oy, d)];
+      const float *w =
+          &ctx.filterW[(fx * ctx.kernelSizes[1] + fy) * channels + d];
+      for (size_t r = 0; r < regs; r++) {
+        sum[r] += LoaduFloat8(in + 8 * r) * LoaduFloat8(w + 8 * r);
+      }
+    }
+  }
+  for (size_t r = 0; r < regs; r++) {
+    StoreuFloat8(&out[d + 8 * r], sum[r]);
+  }
+}
 
-                // Ignore index access below zero (this is due to padding).
-                if (ox < 0 || oy < 0 || ox >= (ssize_t)inWdims[1] ||
-                    oy >= (ssize_t)inWdims[2]) {
-                  continue;
-                }
+/// Compute a range of the output rows of the float depthwise convolution.
+void libjit_depthwise_conv_f_task(void *ctxPtr, size_t taskId,
+                                  size_t numTasks) {
+  const DepthwiseConvTaskCtx &ctx = *(const DepthwiseConvTaskCtx *)ctxPtr;
+  size_t channels = ctx.inWdims[3];
+  size_t begin, end;
+  libjit_task_range(ctx.outWdims[0] * ctx.outWdims[1], taskId, numTasks,
+                    &begin, &end);
+  for (size_t row = begin; row < end; row++) {
+    size_t n = row / ctx.outWdims[1];
+    size_t ax = row % ctx.outWdims[1];
+    ssize_t x = (ssize_t)(ax * ctx.strides[0]) - (ssize_t)ctx.pads[0];
+    for (size_t ay = 0; ay < ctx.outWdims[2]; ay++) {
+      ssize_t y = (ssize_t)(ay * ctx.strides[1]) - (ssize_t)ctx.pads[1];
+      float *out = &ctx.outW[libjit_getXYZW(ctx.outWdims, n, ax, ay, 0)];
+      size_t d = 0;
+      for (; d + 32 <= channels; d += 32) {
+        libjit_depthwise_conv_block_f<4>(ctx, n, x, y, d, out);
+      }
+      for (; d + 8 <= channels; d += 8) {
+        libjit_depthwise_conv_block_f<1>(ctx, n, x, y, d, out);
+      }
+      // Handle the remaining channels one at a time.
+      for (; d < channels; d++) {
+        float sum = ctx.biasW[d];
+        for (size_t fx = 0; fx < ctx.kernelSizes[0]; fx++) {
+          for (size_t fy = 0; fy < ctx.kernelSizes[1]; fy++) {
+            ssize_t ox = x + fx;
+            ssize_t oy = y + fy;
+            if (ox < 0 || oy < 0 || ox >= (ssize_t)ctx.inWdims[1] ||
+                oy >= (ssize_t)ctx.inWdims[2]) {
+              continue;
+            }
+            sum += ctx.inW[libjit_getXYZW(ctx.inWdims, n, (size_t)ox,
+                                          (size_t)oy, d)] *
+                   ctx.filterW[(fx * ctx.kernelSizes[1] + fy) * channels + d];
+          }
+        }
+        out[d] = sum;
+      }
+    }
+  }
+}
 
-                // Calculate the indices into the Filter and Input buffers.
-                size_t inIdx = libjit_getXYZW(inWdims, n, (size_t)ox,
-                                              (size_t)oy, g * inCperG);
-                size_t filterIdx = libjit_getXYZW(filterWdims, d, fx, fy, 0);
-                size_t sliceSize =
-                    filterWdims[1] * filterWdims[2] * filterWdims[3];
-
-                // Perform the innermost loop of the convolution using 4 vector
-                // registers.
-                for (size_t fd = 0; fd < inCperG; fd++) {
-                  int32_t in = inW[inIdx + fd] - inOffset;
-                  for (unsigned i = 0; i < MIN(4, depthUnroll); i++) {
-                    sum[i] += (filterW[filterIdx + (sliceSize * i) + fd] -
-                               filterOffset) *
-                              in;
-                  }
-                }
+/// The context of a quantized depthwise convolution. The filter has the
+/// layout [K, K, C], and the work items are the rows of the output.
+struct DepthwiseConvI8TaskCtx {
+  int8_t *outW;
+  const int8_t *inW;
+  const int8_t *filterW;
+  /// The bias of each channel, scaled to the scale of the products.
+  const int32_t *biasTerms;
+  const size_t *outWdims;
+  const size_t *inWdims;
+  const size_t *kernelSizes;
+  const size_t *strides;
+  const size_t *pads;
+  int32_t inOffset;
+  int32_t filterOffset;
+  int32_t outOffset;
+  int32_t outPre;
+  int32_t outPost;
+  int32_t outScale;
+};
+
+/// The quantized version of libjit_depthwise_conv_block_f. The products are
+/// accumulated in int32x8 registers and requantized at the end.
+template <size_t regs>
+void libjit_depthwise_conv_block_i8(const DepthwiseConvI8TaskCtx &ctx,
+                                    size_t n, ssize_t x, ssize_t y, size_t d,
+                                    int8_t *out) {
+  size_t channels = ctx.inWdims[3];
+  int32x8 sum[regs];
+  for (size_t r = 0; r < regs; r++) {
+    sum[r] = LoaduInt32x8(&ctx.biasTerms[d + 8 * r]);
+  }
+  for (size_t fx = 0; fx < ctx.kernelSizes[0]; fx++) {
+    ssize_t ox = x + fx;
+    if (ox < 0 || ox >= (ssize_t)ctx.inWdims[1]) {
+      continue;
+    }
+    for (size_t fy = 0; fy < ctx.kernelSizes[1]; fy++) {
+      ssize_t oy = y + fy;
+      if (oy < 0 || oy >= (ssize_t)ctx.inWdims[2]) {
+        continue;
+      }
+      const int8_t *in =
+          &ctx.inW[libjit_getXYZW(ctx.inWdims, n, (size_t)ox, (size_t)oy, d)];
+      const int8_t *w =
+          &ctx.filterW[(fx * ctx.kernelSizes[1] + fy) * channels + d];
+      for (size_t r = 0; r < regs; r++) {
+        sum[r] += (LoaduInt8x8AsInt32x8(in + 8 * r) - ctx.inOffset) *
+                  (LoaduInt8x8AsInt32x8(w + 8 * r) - ctx.filterOffset);
+      }
+    }
+  }
+  for (size_t r = 0; r < regs; r++) {
+    int8x8 res = libjit_scale_clip_i32x8(sum[r], ctx.outPre, ctx.outPost,
+                                         ctx.outScale, ctx.outOffset);
+    memcpy(&out[d + 8 * r], &res, sizeof(res));
+  }
+}
 
-                // And perform the innermost loop again with 4 more registers.
-                if (depthUnroll > 4)
-                  for (size_t fd = 0; fd < inCperG; fd++) {
-                    int32_t in = inW[inIdx + fd] - inOffset;
-                    for (unsigned i = 4; i < MIN(8, depthUnroll); i++) {
-                      sum[i] += (filterW[filterIdx + (sliceSize * i) + fd] -
-                                 filterOffset) *
-                                in;
-                    }
-                  }
-              }
+/// Compute a range of the output rows of the quantized depthwise convolution.
+void libjit_depthwise_conv_i8_task(void *ctxPtr, size_t taskId,
+                                   size_t numTasks) {
+  const DepthwiseConvI8TaskCtx &ctx = *(const DepthwiseConvI8TaskCtx *)ctxPtr;
+  size_t channels = ctx.inWdims[3];
+  size_t begin, end;
+  libjit_task_range(ctx.outWdims[0] * ctx.outWdims[1], taskId, numTasks,
+                    &begin, &end);
+  for (size_t row = begin; row < end; row++) {
+    size_t n = row / ctx.outWdims[1];
+    size_t ax = row % ctx.outWdims[1];
+    ssize_t x = (ssize_t)(ax * ctx.strides[0]) - (ssize_t)ctx.pads[0];
+    for (size_t ay = 0; ay < ctx.outWdims[2]; ay++) {
+      ssize_t y = (ssize_t)(ay * ctx.strides[1]) - (ssize_t)ctx.pads[1];
+      int8_t *out = &ctx.outW[libjit_getXYZW(ctx.outWdims, n, ax, ay, 0)];
+      size_t d = 0;
+      for (; d + 32 <= channels; d += 32) {
+        libjit_depthwise_conv_block_i8<4>(ctx, n, x, y, d, out);
+      }
+      for (; d + 8 <= channels; d += 8) {
+        libjit_depthwise_conv_block_i8<1>(ctx, n, x, y, d, out);
+      }
+      // Handle the remaining channels one at a time.
+      for (; d < channels; d++) {
+        int32_t sum = ctx.biasTerms[d];
+        for (size_t fx = 0; fx < ctx.kernelSizes[0]; fx++) {
+          for (size_t fy = 0; fy < ctx.kernelSizes[1]; fy++) {
+            ssize_t ox = x + fx;
+            ssize_t oy = y + fy;
+            if (ox < 0 || oy < 0 || ox >= (ssize_t)ctx.inWdims[1] ||
+                oy >= (ssize_t)ctx.inWdims[2]) {
+              continue;
             }
+            int32_t in = ctx.inW[libjit_getXYZW(ctx.inWdims, n, (size_t)ox,
+                                                (size_t)oy, d)];
+            int32_t w =
+                ctx.filterW[(fx * ctx.kernelSizes[1] + fy) * channels + d];
+            sum += (in - ctx.inOffset) * (w - ctx.filterOffset);
+          }
+        }
+        out[d] = libjit_clip(libjit_scale_i32i8(
+            sum, ctx.outPre, ctx.outPost, ctx.outScale, ctx.outOffset));
+      }
+    }
+  }
+}
 
-            for (unsigned i = 0; i < depthUnroll; i++) {
-              // Scale the result back to the expected destination scale.
-              int32_t scaledSum = libjit_scale_i32i8(sum[i], outPre, outPost,
-                                                     outScale, outOffset);
-              outW[libjit_getXYZW(outWdims, n, ax, ay, d + i)] =
-                  libjit_clip(scaledSum);
-            }
-          } // W
-        }   // H
-      }     // C
-    }       // G
-  }         // N
+/// The 1D input transform B^T of the Winograd algorithm F(m, 3), which is
+/// applied to the m + 2 vectors \p d[0], \p d[s], ... and written to \p v[0],
+/// \p v[s], ...
+template <size_t m>
+void libjit_winograd_input_1d(const float8 *d, size_t s, float8 *v);
+
+template <>
+void libjit_winograd_input_1d<2>(const float8 *d, size_t s, float8 *v) {
+  float8 d0 = d[0], d1 = d[s], d2 = d[2 * s], d3 = d[3 * s];
+  v[0] = d0 - d2;
+  v[s] = d1 + d2;
+  v[2 * s] = d2 - d1;
+  v[3 * s] = d1 - d3;
+}
+
+template <>
+void libjit_winograd_input_1d<4>(const float8 *d, size_t s, float8 *v) {
+  float8 d0 = d[0], d1 = d[s], d2 = d[2 * s], d3 = d[3 * s], d4 = d[4 * s],
+         d5 = d[5 * s];
+  v[0] = 4.0f * d0 - 5.0f * d2 + d4;
+  v[s] = d3 + d4 - 4.0f * (d1 + d2);
+  v[2 * s] = d4 - d3 + 4.0f * (d1 - d2);
+  v[3 * s] = d4 - d2 + 2.0f * (d3 - d1);
+  v[4 * s] = d4 - d2 + 2.0f * (d1 - d3);
+  v[5 * s] = 4.0f * d1 - 5.0f * d3 + d5;
+}
+
+/// The 1D output transform A^T of the Winograd algorithm F(m, 3), which maps
+/// the m + 2 vectors \p t[0], \p t[s], ... to the m vectors \p y[0], \p y[ys],
+/// ...
+template <size_t m>
+void libjit_winograd_output_1d(const float8 *t, size_t s, float8 *y,
+                               size_t ys);
+
+template <>
+void libjit_winograd_output_1d<2>(const float8 *t, size_t s, float8 *y,
+                                  size_t ys) {
+  y[0] = t[0] + t[s] + t[2 * s];
+  y[ys] = t[s] - t[2 * s] - t[3 * s];
+}
+
+template <>
+void libjit_winograd_output_1d<4>(const float8 *t, size_t s, float8 *y,
+                                  size_t ys) {
+  float8 a = t[s] + t[2 * s];
+  float8 b = t[s] - t[2 * s];
+  float8 c = t[3 * s] + t[4 * s];
+  float8 e = t[3 * s] - t[4 * s];
+  y[0] = t[0] + a + c;
+  y[ys] = b + 2.0f * e;
+  y[2 * ys] = a + 4.0f * c;
+  y[3 * ys] = b + 8.0f * e + t[5 * s];
+}
+
+/// Loads the first \p lanes floats of \p p into a vector, whose remaining
+/// elements are zero.
+inline float8 libjit_load_lanes(const float *p, size_t lanes) {
+  if (lanes == 8) {
+    return LoaduFloat8(p);
+  }
+  float8 res = BroadcastFloat8(0);
+  memcpy(&res, p, lanes * sizeof(float));
+  return res;
+}
+
+/// Stores the first \p lanes elements of the vector \p v to \p p.
+inline void libjit_store_lanes(float *p, float8 v, size_t lanes) {
+  if (lanes == 8) {
+    StoreuFloat8(p, v);
+  } else {
+    memcpy(p, &v, lanes * sizeof(float));
+  }
+}
+
+/// The number of floats of scratch memory that a task of the Winograd
+/// convolution may use for the transformed input and the products of a block
+/// of tiles. The scratch memory is on the heap, so this only bounds the
+/// working set of a block.
+constexpr size_t winogradScratchSize = 1 << 18;
+/// The maximal number of tiles of the Winograd convolution in a block.
+constexpr size_t winogradMaxTileBlock = 64;
+
+/// The context of the Winograd convolution F(m x m, 3 x 3). The filter is
+/// transformed at compile time to the shape [(m + 2)^2, C, D]. The output is
+/// split into tiles of m x m pixels, which are processed in blocks of
+/// tileBlock tiles.
+struct WinogradConvTaskCtx {
+  float *outW;
+  const float *inW;
+  const float *filterW;
+  const float *biasW;
+  const size_t *outWdims;
+  const size_t *inWdims;
+  const size_t *pads;
+  size_t tilesH;
+  size_t tilesW;
+  size_t tileBlock;
+  /// The range that the output is clamped to.
+  float clampMin;
+  float clampMax;
+};
+
+/// Compute the tiles [\p tileBegin, \p tileEnd) of the Winograd convolution
+/// \p ctx. The transformed input of the tiles is stored in \p V, with the
+/// shape [(m + 2)^2, tiles, C], and multiplied with the transformed filter one
+/// of the (m + 2)^2 elements at a time, which gives \p M with the shape
+/// [(m + 2)^2, tiles, D]. The output transform then reduces M to the tiles of
+/// the output, adds the bias and clamps the result.
+template <size_t m>
+void libjit_winograd_conv_block(const WinogradConvTaskCtx &ctx,
+                                size_t tileBegin, size_t tileEnd, float *V,
+                                float *M) {
+  constexpr size_t alpha = m + 2;
+  size_t inC = ctx.inWdims[3];
+  size_t outC = ctx.outWdims[3];
+  size_t tiles = tileEnd - tileBegin;
+  size_t tilesPerImage = ctx.tilesH * ctx.tilesW;
+  bool clamp = ctx.clampMin != -INFINITY || ctx.clampMax != INFINITY;
+
+  for (size_t t = 0; t < tiles; t++) {
+    size_t tile = tileBegin + t;
+    size_t n = tile / tilesPerImage;
+    ssize_t x0 = (ssize_t)((tile % tilesPerImage) / ctx.tilesW * m) -
+                 (ssize_t)ctx.pads[0];
+    ssize_t y0 = (ssize_t)((tile % ctx.tilesW) * m) - (ssize_t)ctx.pads[1];
+    for (size_t c = 0; c < inC; c += 8) {
+      size_t lanes = MIN(inC - c, (size_t)8);
+      float8 d[alpha * alpha];
+      for (size_t i = 0; i < alpha; i++) {
+        for (size_t j = 0; j < alpha; j++) {
+          ssize_t x = x0 + (ssize_t)i;
+          ssize_t y = y0 + (ssize_t)j;
+          if (x < 0 || y < 0 || x >= (ssize_t)ctx.inWdims[1] ||
+              y >= (ssize_t)ctx.inWdims[2]) {
+            d[i * alpha + j] = BroadcastFloat8(0);
+            continue;
+          }
+          d[i * alpha + j] = libjit_load_lanes(
+              &ctx.inW[libjit_getXYZW(ctx.inWdims, n, (size_t)x, (size_t)y, c)],
+              lanes);
+        }
+      }
+      // Compute B^T d B by transforming the columns and then the rows.
+      float8 tmp[alpha * alpha];
+      float8 v[alpha * alpha];
+      for (size_t j = 0; j < alpha; j++) {
+        libjit_winograd_input_1d<m>(&d[j], alpha, &tmp[j]);
+      }
+      for (size_t i = 0; i < alpha; i++) {
+        libjit_winograd_input_1d<m>(&tmp[i * alpha], 1, &v[i * alpha]);
+      }
+      for (size_t xi = 0; xi < alpha * alpha; xi++) {
+        libjit_store_lanes(&V[(xi * tiles + t) * inC + c], v[xi], lanes);
+      }
+    }
+  }
+
+  // The element-wise products of the transformed tiles and filters are
+  // (m + 2)^2 independent matrix multiplications over the input channels.
+  for (size_t xi = 0; xi < alpha * alpha; xi++) {
+    libjit_matmul_serial_f(tiles, outC, inC, &V[xi * tiles * inC], inC,
+                           &ctx.filterW[xi * inC * outC], outC,
+                           &M[xi * tiles * outC], outC);
+  }
+
+  for (size_t t = 0; t < tiles; t++) {
+    size_t tile = tileBegin + t;
+    size_t n = tile / tilesPerImage;
+    size_t x0 = (tile % tilesPerImage) / ctx.tilesW * m;
+    size_t y0 = (tile % ctx.tilesW) * m;
+    size_t rows = MIN(ctx.outWdims[1] - x0, m);
+    size_t cols = MIN(ctx.outWdims[2] - y0, m);
+    for (size_t d = 0; d < outC; d += 8) {
+      size_t lanes = MIN(outC - d, (size_t)8);
+      float8 mm[alpha * alpha];
+      for (size_t xi = 0; xi < alpha * alpha; xi++) {
+        mm[xi] = libjit_load_lanes(&M[(xi * tiles + t) * outC + d], lanes);
+      }
+      // Compute A^T mm A by transforming the columns and then the rows.
+      float8 tmp[m * alpha];
+      float8 y[m * m];
+      for (size_t j = 0; j < alpha; j++) {
+        libjit_winograd_output_1d<m>(&mm[j], alpha, &tmp[j], alpha);
+      }
+      for (size_t i = 0; i < m; i++) {
+        libjit_winograd_output_1d<m>(&tmp[i * alpha], 1, &y[i * m], 1);
+      }
+      float8 bias = libjit_load_lanes(&ctx.biasW[d], lanes);
+      for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+          float *out =
+              &ctx.outW[libjit_getXYZW(ctx.outWdims, n, x0 + i, y0 + j, d)];
+          libjit_store_lanes(out, y[i * m + j] + bias, lanes);
+          if (clamp) {
+            libjit_fused_epilogue_f(out, nullptr, lanes, ctx.clampMin,
+                                    ctx.clampMax);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Compute a range of the tile blocks of the Winograd convolution.
+template <size_t m>
+void libjit_winograd_conv_task(void *ctxPtr, size_t taskId, size_t numTasks) {
+  const WinogradConvTaskCtx &ctx = *(const WinogradConvTaskCtx *)ctxPtr;
+  constexpr size_t alpha = m + 2;
+  size_t numTiles = ctx.outWdims[0] * ctx.tilesH * ctx.tilesW;
+  size_t numBlocks = (numTiles + ctx.tileBlock - 1) / ctx.tileBlock;
+  size_t begin, end;
+  libjit_task_range(numBlocks, taskId, numTasks, &begin, &end);
+  if (begin == end) {
+    return;
+  }
+  // The transformed tiles take up to winogradScratchSize floats, and more if
+  // a single tile has more channels, so they are kept off the stack.
+  size_t sizeV = alpha * alpha * ctx.tileBlock * ctx.inWdims[3];
+  size_t sizeM = alpha * alpha * ctx.tileBlock * ctx.outWdims[3];
+  float *V = (float *)libjit_alloc_scratch((sizeV + sizeM) * sizeof(float));
+  float *M = V + sizeV;
+  for (size_t b = begin; b < end; b++) {
+    size_t tileBegin = b * ctx.tileBlock;
+    libjit_winograd_conv_block<m>(ctx, tileBegin,
+                                  MIN(tileBegin + ctx.tileBlock, numTiles), V,
+                                  M);
+  }
+  libjit_free_scratch(V);
+}
+
+} // namespace
+
+extern "C" {
+void libjit_convDKKC8_fused_f(
+    float *outW, const float *inW, const float *filterW, const float *biasW,
+    const float *residualW, const size_t *outWdims, const size_t *inWdims,
+    const size_t *filterWdims, const size_t *biasWdims,
+    const size_t *kernelSizes, const size_t *strides, const size_t *pads,
+    size_t group, unsigned pixelScanFirst, unsigned numDepthRegs,
+    unsigned sizeGroupY, unsigned depthStrips, float clampMin,
+    float clampMax) {
+  // The samples and the blocks of output channels are independent and are
+  // processed in parallel.
+  ConvTaskCtx ctx = {outW,
+                     inW,
+                     filterW,
+                     biasW,
+                     outWdims,
+                     inWdims,
+                     filterWdims,
+                     biasWdims,
+                     kernelSizes,
+                     strides,
+                     pads,
+                     group,
+                     pixelScanFirst,
+                     numDepthRegs,
+                     sizeGroupY,
+                     depthStrips,
+                     /* depthUnroll */ 1,
+                     8 * numDepthRegs * depthStrips,
+                     libjit_convDKKC8_slice,
+                     residualW,
+                     clampMin,
+                     clampMax};
+  libjit_conv_run(ctx);
+}
+
+void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
+                        const float *biasW, const size_t *outWdims,
+                        const size_t *inWdims, const size_t *filterWdims,
+                        const size_t *biasWdims, const size_t *kernelSizes,
+                        const size_t *strides, const size_t *pads, size_t group,
+                        unsigned pixelScanFirst, unsigned numDepthRegs,
+                        unsigned sizeGroupY, unsigned depthStrips) {
+  libjit_convDKKC8_fused_f(outW, inW, filterW, biasW, nullptr, outWdims,
+                           inWdims, filterWdims, biasWdims, kernelSizes,
+                           strides, pads, group, pixelScanFirst, numDepthRegs,
+                           sizeGroupY, depthStrips, -INFINITY, INFINITY);
+}
+
+void libjit_convolution_fused_f(
+    float *outW, const float *inW, const float *filterW, const float *biasW,
+    const float *residualW, const size_t *outWdims, const size_t *inWdims,
+    const size_t *filterWdims, const size_t *biasWdims,
+    const size_t *kernelSizes, const size_t *strides, const size_t *pads,
+    size_t group, unsigned depthUnroll, float clampMin, float clampMax) {
+  // The samples and the blocks of output channels are independent and are
+  // processed in parallel.
+  ConvTaskCtx ctx = {outW,
+                     inW,
+                     filterW,
+                     biasW,
+                     outWdims,
+                     inWdims,
+                     filterWdims,
+                     biasWdims,
+                     kernelSizes,
+                     strides,
+                     pads,
+                     group,
+                     /* pixelScanFirst */ 0,
+                     /* numDepthRegs */ 0,
+                     /* sizeGroupY */ 0,
+                     /* depthStrips */ 0,
+                     depthUnroll,
+                     depthUnroll,
+                     libjit_convolution_slice,
+                     residualW,
+                     clampMin,
+                     clampMax};
+  libjit_conv_run(ctx);
+}
+
+void libjit_convolution_f(float *outW, const float *inW, const float *filterW,
+                          const float *biasW, const size_t *outWdims,
+                          const size_t *inWdims, const size_t *filterWdims,
+                          const size_t *biasWdims, const size_t *kernelSizes,
+                          const size_t *strides, const size_t *pads,
+                          size_t group, unsigned depthUnroll) {
+  libjit_convolution_fused_f(outW, inW, filterW, biasW, nullptr, outWdims,
+                             inWdims, filterWdims, biasWdims, kernelSizes,
+                             strides, pads, group, depthUnroll, -INFINITY,
+                             INFINITY);
+}
+
+void libjit_convolution_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const size_t *outWdims, const size_t *inWdims, const size_t *filterWdims,
+    const size_t *biasWdims, const size_t *kernelSizes, const size_t *strides,
+    const size_t *pads, size_t group, int32_t outOffset, int32_t inOffset,
+    int32_t filterOffset, int32_t biasOffset, int32_t biasPre, int32_t biasPost,
+    int32_t biasScale, int32_t outPre, int32_t outPost, int32_t outScale) {
+  libjit_conv_i8(outW, inW, filterW, biasW, outWdims, inWdims, kernelSizes,
+                 strides, pads, group, /* packedFilter */ false, outOffset,
+                 inOffset, filterOffset, biasOffset, biasPre, biasPost,
+                 biasScale, outPre, outPost, outScale);
+}
+
+void libjit_convDKKC16_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const size_t *outWdims, const size_t *inWdims, const size_t *filterWdims,
+    const size_t *biasWdims, const size_t *kernelSizes, const size_t *strides,
+    const size_t *pads, size_t group, int32_t outOffset, int32_t inOffset,
+    int32_t filterOffset, int32_t biasOffset, int32_t biasPre, int32_t biasPost,
+    int32_t biasScale, int32_t outPre, int32_t outPost, int32_t outScale) {
+  libjit_conv_i8(outW, inW, filterW, biasW, outWdims, inWdims, kernelSizes,
+                 strides, pads, group, /* packedFilter */ true, outOffset,
+                 inOffset, filterOffset, biasOffset, biasPre, biasPost,
+                 biasScale, outPre, outPost, outScale);
+}
+
+void libjit_depthwise_conv_f(float *outW, const float *inW,
+                             const float *filterW, const float *biasW,
+                             const size_t *outWdims, const size_t *inWdims,
+                             const size_t *kernelSizes, const size_t *strides,
+                             const size_t *pads) {
+  DepthwiseConvTaskCtx ctx = {outW,
+                              inW,
+                              filterW,
+                              biasW,
+                              outWdims,
+                              inWdims,
+                              kernelSizes,
+                              strides,
+                              pads};
+  // The number of multiply-adds in an output row.
+  size_t rowCost = outWdims[2] * outWdims[3] * kernelSizes[0] * kernelSizes[1];
+  libjit_parallel_for(libjit_depthwise_conv_f_task, &ctx,
+                      libjit_num_tasks(outWdims[0] * outWdims[1], rowCost));
+}
+
+void libjit_depthwise_conv_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const size_t *outWdims, const size_t *inWdims, const size_t *kernelSizes,
+    const size_t *strides, const size_t *pads, int32_t outOffset,
+    int32_t inOffset, int32_t filterOffset, int32_t biasOffset, int32_t biasPre,
+    int32_t biasPost, int32_t biasScale, int32_t outPre, int32_t outPost,
+    int32_t outScale) {
+  size_t channels = outWdims[3];
+  // The number of channels is not bounded, so the terms are kept off the
+  // stack.
+  int32_t *biasTerms =
+      (int32_t *)libjit_alloc_scratch(channels * sizeof(int32_t));
+  for (size_t d = 0; d < channels; d++) {
+    // Scale the bias to match the scale of the products.
+    biasTerms[d] = libjit_scale_i32i8((int32_t)biasW[d] - biasOffset, biasPre,
+                                      biasPost, biasScale, 0);
+  }
+  DepthwiseConvI8TaskCtx ctx = {outW,
+                                inW,
+                                filterW,
+                                biasTerms,
+                                outWdims,
+                                inWdims,
+                                kernelSizes,
+                                strides,
+                                pads,
+                                inOffset,
+                                filterOffset,
+                                outOffset,
+                                outPre,
+                                outPost,
+                                outScale};
+  // The number of multiply-adds in an output row.
+  size_t rowCost = outWdims[2] * outWdims[3] * kernelSizes[0] * kernelSizes[1];
+  libjit_parallel_for(libjit_depthwise_conv_i8_task, &ctx,
+                      libjit_num_tasks(outWdims[0] * outWdims[1], rowCost));
+  libjit_free_scratch(biasTerms);
+}
+
+void libjit_winograd_conv_f(float *outW, const float *inW,
+                            const float *filterW, const float *biasW,
+                            const size_t *outWdims, const size_t *inWdims,
+                            const size_t *filterWdims, const size_t *pads,
+                            float clampMin, float clampMax) {
+  size_t m = filterWdims[0] == 4 * 4 ? 2 : 4;
+  size_t alpha = m + 2;
+  size_t tilesH = (outWdims[1] + m - 1) / m;
+  size_t tilesW = (outWdims[2] + m - 1) / m;
+  size_t numTiles = outWdims[0] * tilesH * tilesW;
+
+  // Bound the scratch memory of a block of tiles, but make sure that there
+  // are enough blocks to keep all the threads busy.
+  size_t tileScratch = alpha * alpha * (inWdims[3] + outWdims[3]);
+  size_t numThreads = libjit_get_num_threads();
+  size_t tileBlock =
+      MIN(winogradScratchSize / tileScratch, winogradMaxTileBlock);
+  tileBlock = MIN(tileBlock, (numTiles + numThreads - 1) / numThreads);
+  tileBlock = MAX(tileBlock, (size_t)1);
+
+  WinogradConvTaskCtx ctx = {outW,
+                             inW,
+                             filterW,
+                             biasW,
+                             outWdims,
+                             inWdims,
+                             pads,
+                             tilesH,
+                             tilesW,
+                             tileBlock,
+                             clampMin,
+                             clampMax};
+  // The number of multiply-adds of the element-wise stage of a block.
+  size_t blockCost = tileBlock * alpha * alpha * inWdims[3] * outWdims[3];
+  size_t numBlocks = (numTiles + tileBlock - 1) / tileBlock;
+  libjit_parallel_for(m == 2 ? libjit_winograd_conv_task<2>
+                             : libjit_winograd_conv_task<4>,
+                      &ctx, libjit_num_tasks(numBlocks, blockCost));
 }
 
 void libjit_convolution_grad_f(float *inG, const float *outG, const float *inW,
@@ -17,15 +17,20 @@
 #define GLOW_BACKENDS_CPU_LIBJIT_LIBJIT_DEFS_H
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #if defined(_MSC_VER)
 #include <BaseTsd.h>
+#include <malloc.h>
 typedef SSIZE_T ssize_t;
 #endif
 
 typedef float float4 __attribute__((ext_vector_type(4)));
 typedef float float8 __attribute__((ext_vector_type(8)));
+typedef int8_t int8x8 __attribute__((ext_vector_type(8)));
+typedef uint8_t uint8x8 __attribute__((ext_vector_type(8)));
+typedef int32_t int32x8 __attribute__((ext_vector_type(8)));
 
 /// Loads a simd float8 value from \p ptr.
 #define LoadFloat8(PTR) *((const float8 *)(PTR))
@@ -59,6 +64,21 @@ inline void AdduFloat8(float *p, float8 v) {
   StoreuFloat8(p, LoaduFloat8(p) + v);
 }
 
+/// Perform an unaligned load of eight int8 values from \p p and sign-extend
+/// them to 32 bits.
+inline int32x8 LoaduInt8x8AsInt32x8(const int8_t *p) {
+  int8x8 res;
+  memcpy(&res, p, sizeof(int8x8));
+  return __builtin_convertvector(res, int32x8);
+}
+
+/// Perform an unaligned load of an int32x8 from an int32_t pointer.
+inline int32x8 LoaduInt32x8(const int32_t *p) {
+  int32x8 res;
+  memcpy(&res, p, sizeof(int32x8));
+  return res;
+}
+
 /// \returns the index of the element at x,y,z,w,q,r.
 inline size_t libjit_getXYZWQR(const size_t *dims, size_t x, size_t y, size_t z,
                                size_t w, size_t q, size_t r) {
@@ -93,6 +113,28 @@ inline size_t libjit_getXY(const size_t *dims, size_t x, size_t y) {
   return (x * dims[1]) + y;
 }
 
+/// \returns \p size bytes of memory aligned to 64 bytes, which is released
+/// with libjit_free_scratch. The kernels keep the buffers whose size depends
+/// on the operands there, because the stacks of the threads that run the
+/// kernels are small.
+inline void *libjit_alloc_scratch(size_t size) {
+#if defined(_MSC_VER)
+  return _aligned_malloc(size, 64);
+#else
+  void *ptr = nullptr;
+  return posix_memalign(&ptr, 64, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+/// Release the memory \p ptr returned by libjit_alloc_scratch.
+inline void libjit_free_scratch(void *ptr) {
+#if defined(_MSC_VER)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
 inline int8_t libjit_clip(int32_t val) {
   return (int8_t)MIN(MAX(val, -128), 127);
 }
@@ -114,4 +156,135 @@ inline int32_t libjit_scale_i32i8(int32_t input, int32_t pre, int32_t post,
   return ((((input >> pre) * scale) + rtn) >> post) + offset;
 }
 
+/// Vector version of libjit_scale_i32i8 followed by libjit_clip: scales the
+/// eight 32-bit integers in \p input and \returns them clipped to int8.
+inline int8x8 libjit_scale_clip_i32x8(int32x8 input, int32_t pre, int32_t post,
+                                      int32_t scale, int32_t offset) {
+  int rtn = (post > 0) ? (1 << (post - 1)) : 0;
+  int32x8 res = ((((input >> pre) * scale) + rtn) >> post) + offset;
+  // Clip to the int8 range with masks, which maps to vector min/max.
+  const int32x8 lo = (int32x8)(-128);
+  const int32x8 hi = (int32x8)(127);
+  int32x8 isLow = res < lo;
+  res = (res & ~isLow) | (lo & isLow);
+  int32x8 isHigh = res > hi;
+  res = (res & ~isHigh) | (hi & isHigh);
+  return __builtin_convertvector(res, int8x8);
+}
+
+/// Number of int32x8 registers that hold one row of the int8 kernel's block.
+constexpr size_t regsNI8 = 2;
+/// Number of columns of the output that the int8 kernel computes at once.
+constexpr size_t nrI8 = regsNI8 * 8;
+/// Number of rows of the output that the int8 kernel computes at once.
+constexpr size_t mrI8 = 4;
+
+/// Compute a \p rows x nrI8 block of an int8 matrix product. \p a points to
+/// the first of \p rows rows of the row-major matrix A (with leading dimension
+/// \p lda), and \p packedB to a panel of nrI8 columns of B, which stores its
+/// \p k rows consecutively. The offsets of the operands are not subtracted in
+/// the inner loop; instead the terms \p rowTerms of each row and \p colTerms
+/// of each column of the block are added to the 32-bit results, which are
+/// then requantized with \p pre, \p post, \p scale and \p offset. The first
+/// \p cols columns of the result are written to \p rows rows of \p out (with
+/// leading dimension \p ldo).
+template <size_t rows>
+inline void libjit_matmul_i8_block(size_t k, const int8_t *a, size_t lda,
+                                   const int8_t *packedB,
+                                   const int32_t *rowTerms,
+                                   const int32_t *colTerms, int8_t *out,
+                                   size_t ldo, size_t cols, int32_t pre,
+                                   int32_t post, int32_t scale,
+                                   int32_t offset) {
+  int32x8 acc[rows][regsNI8];
+  for (size_t r = 0; r < rows; r++) {
+    for (size_t v = 0; v < regsNI8; v++) {
+      acc[r][v] = (int32x8)(0);
+    }
+  }
+
+  for (size_t p = 0; p < k; p++) {
+    int32x8 bb[regsNI8];
+    for (size_t v = 0; v < regsNI8; v++) {
+      bb[v] = LoaduInt8x8AsInt32x8(packedB + v * 8);
+    }
+    for (size_t r = 0; r < rows; r++) {
+      int32x8 aa = (int32x8)((int32_t)a[r * lda + p]);
+      for (size_t v = 0; v < regsNI8; v++) {
+        acc[r][v] += aa * bb[v];
+      }
+    }
+    packedB += nrI8;
+  }
+
+  for (size_t r = 0; r < rows; r++) {
+    int32x8 rowTerm = (int32x8)(rowTerms[r]);
+    int8_t res[nrI8];
+    for (size_t v = 0; v < regsNI8; v++) {
+      int32x8 sum = acc[r][v] + rowTerm + LoaduInt32x8(colTerms + v * 8);
+      int8x8 scaled = libjit_scale_clip_i32x8(sum, pre, post, scale, offset);
+      memcpy(&res[v * 8], &scaled, sizeof(scaled));
+    }
+    memcpy(&out[r * ldo], res, cols);
+  }
+}
+
+/// Apply the epilogue of a fused kernel to the \p n consecutive elements at
+/// \p out: add the elements of \p addend, unless it is null, and clamp the
+/// results to [\p clampMin, \p clampMax].
+inline void libjit_fused_epilogue_f(float *out, const float *addend, size_t n,
+                                    float clampMin, float clampMax) {
+  if (addend) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = MIN(MAX(out[i] + addend[i], clampMin), clampMax);
+    }
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = MIN(MAX(out[i], clampMin), clampMax);
+    }
+  }
+}
+
+/// Compute c = a * b on the calling thread, where c is a row-major \p m x \p n
+/// matrix, a is a row-major \p m x \p k matrix and b is a row-major \p k x
+/// \p n matrix, with the leading dimensions \p ldc, \p lda and \p ldb. The
+/// function does not start parallel tasks, so it can be called by the tasks
+/// of other kernels.
+void libjit_matmul_serial_f(size_t m, size_t n, size_t k, const float *a,
+                            size_t lda, const float *b, size_t ldb, float *c,
+                            size_t ldc);
+
+/// A single task of a parallel loop. The task processes the part \p taskId out
+/// of \p numTasks parts of the work described by the kernel-specific context
+/// \p ctx.
+typedef void (*libjit_task_fn)(void *ctx, size_t taskId, size_t numTasks);
+
+extern "C" {
+/// Run \p numTasks tasks \p fn with the context \p ctx and return when all
+/// of them are complete. The tasks are executed in parallel if the host runtime
+/// provided a thread pool and serially otherwise.
+void libjit_parallel_for(libjit_task_fn fn, void *ctx, size_t numTasks);
+
+/// \returns the maximal number of threads the kernels may use.
+size_t libjit_get_num_threads();
+
+/// Compute the range [\p begin, \p end) of \p numItems work items that should
+/// be processed by the task \p taskId out of \p numTasks tasks.
+void libjit_task_range(size_t numItems, size_t taskId, size_t numTasks,
+                       size_t *begin, size_t *end);
+}
+
+/// The minimal amount of work (in multiply-adds or similar operations) that
+/// justifies waking up another thread.
+#define LIBJIT_MIN_TASK_WORK (1 << 16)
+
+/// \returns the number of tasks that \p numItems work items of the cost
+/// \p itemCost should be split into.
+inline size_t libjit_num_tasks(size_t numItems, size_t itemCost) {
+  size_t numTasks = libjit_get_num_threads();
+  numTasks = MIN(numTasks, numItems * itemCost / LIBJIT_MIN_TASK_WORK);
+  numTasks = MIN(numTasks, numItems);
+  return MAX(numTasks, (size_t)1);
+}
+
 #endif // GLOW_BACKENDS_CPU_LIBJIT_LIBJIT_DEFS_H
@@ -58,12 +58,44 @@ constexpr int nc = 4096;
 /// can be fairly large.
 constexpr size_t pack_threshold = 1024;
 
+/// The epilogue of a fused matrix multiplication. It is applied to each block
+/// of C once the last panel of K has been accumulated into it.
+struct MatMulEpilogue {
+  /// The vector that is added to every column of C, or null.
+  const float *bias;
+  /// The range that the elements of C are clamped to.
+  float clampMin;
+  float clampMax;
+};
+
+/// Accumulate the RAxRB block \p csum into C and apply the epilogue \p ep to
+/// it while it is still in registers. \p bias points to the bias of the first
+/// row of the block, or is null.
+template <size_t regsA, size_t regsB>
+void libjit_matmul_store_fused(float8 csum[regsA][regsB], float *c, size_t ldc,
+                               const MatMulEpilogue *ep, const float *bias) {
+  for (size_t bi = 0; bi < regsB; bi++) {
+    for (size_t ai = 0; ai < regsA; ai++) {
+      float8 res = LoaduFloat8(&C(ai * 8, bi)) + csum[ai][bi];
+      if (bias) {
+        res += LoaduFloat8(&bias[ai * 8]);
+      }
+      for (unsigned l = 0; l < 8; l++) {
+        res[l] = MIN(MAX(res[l], ep->clampMin), ep->clampMax);
+      }
+      StoreuFloat8(&C(ai * 8, bi), res);
+    }
+  }
+}
+
 /// Compute a RAxRB block of C using a vectorized dot product, where RA is the
 /// number of registers to load from matrix A, and RB is the number of registers
-/// to load from matrix B.
+/// to load from matrix B. The epilogue \p ep, with the bias \p bias of the
+/// first row of the block, is applied to the block unless it is null.
 template <size_t regsA, size_t regsB>
 void libjit_matmul_dot(size_t k, const float *a, size_t lda, const float *b,
-                       size_t ldb, float *c, size_t ldc) {
+                       size_t ldb, float *c, size_t ldc,
+                       const MatMulEpilogue *ep, const float *bias) {
   float8 csum[regsA][regsB] = {{0.0}};
   for (size_t p = 0; p < k; p++) {
     // Perform the DOT product.
@@ -76,6 +108,11 @@ void libjit_matmul_dot(size_t k, const float *a, size_t lda, const float *b,
     }
   }
 
+  if (ep) {
+    libjit_matmul_store_fused<regsA, regsB>(csum, c, ldc, ep, bias);
+    return;
+  }
+
   // Accumulate the results into C.
   for (size_t bi = 0; bi < regsB; bi++) {
     for (size_t ai = 0; ai < regsA; ai++) {
@@ -88,7 +125,8 @@ void libjit_matmul_dot(size_t k, const float *a, size_t lda, const float *b,
 /// packed using z-ordering.
 template <size_t regsA, size_t regsB>
 void libjit_matmul_zdot(size_t k, const float *a, size_t lda, const float *b,
-                        size_t ldb, float *c, size_t ldc) {
+                        size_t ldb, float *c, size_t ldc,
+                        const MatMulEpilogue *ep, const float *bias) {
   float8 csum[regsA][regsB] = {{0.0}};
 
   for (size_t p = 0; p < k; p++) {
@@ -104,6 +142,11 @@ void libjit_matmul_zdot(size_t k, const float *a, size_t lda, const float *b,
     b += regsB;
   }
 
+  if (ep) {
+    libjit_matmul_store_fused<regsA, regsB>(csum, c, ldc, ep, bias);
+    return;
+  }
+
   // Accumulate the results into C.
   for (size_t bi = 0; bi < regsB; bi++) {
     for (size_t ai = 0; ai < regsA; ai++) {
@@ -148,11 +191,13 @@ void pack_matrix_b(size_t n, size_t k, const float *b, size_t ldb,
 /// and N strides over the B matrix, which is very large and will blow out the
 /// cache.
 void libjit_matmul_inner_packed(int m, int n, int k, const float *packedA,
-                                const float *packedB, float *c, int ldc) {
+                                const float *packedB, float *c, int ldc,
+                                const MatMulEpilogue *ep, const float *bias) {
   for (int j = 0; j < n - nr + 1; j += nr) {
     for (int i = 0; i < m - mr + 1; i += mr) {
       libjit_matmul_zdot<regsA, regsB>(k, &packedA[i * k], mr, &packedB[j * k],
-                                       k, &C(i, j), ldc);
+                                       k, &C(i, j), ldc, ep,
+                                       bias ? &bias[i] : nullptr);
     }
   }
 }
@@ -160,21 +205,24 @@ void libjit_matmul_inner_packed(int m, int n, int k, const float *packedA,
 /// Inner kernel for non-packed matrices.  In these cases N is small, so it
 /// tends to be beneficial to retain locality in the A matrix.
 void libjit_matmul_inner_unpacked(int m, int n, int k, const float *a, int lda,
-                                  const float *b, int ldb, float *c, int ldc) {
+                                  const float *b, int ldb, float *c, int ldc,
+                                  const MatMulEpilogue *ep, const float *bias) {
   for (int i = 0; i < m - mr + 1; i += mr) {
     for (int j = 0; j < n - nr + 1; j += nr) {
       libjit_matmul_dot<regsA, regsB>(k, &A(i, 0), lda, &B(0, j), ldb, &C(i, j),
-                                      ldc);
+                                      ldc, ep, bias ? &bias[i] : nullptr);
     }
   }
 }
 
 /// Compute a portion of C one block at a time.  Handle ragged edges with calls
-/// to a slow but general helper.
+/// to a slow but general helper. If \p ep is not null, this is the last panel
+/// of K and the epilogue is applied to the portion of C, whose bias is \p bias.
 template <bool pack>
 void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
                          const float *b, int ldb, float *c, int ldc,
-                         float *packedB) {
+                         float *packedB, const MatMulEpilogue *ep,
+                         const float *bias) {
   // The tiling scheme naturally divides the input matrices into 2 parts each;
   // one tiled section, and three "ragged" edges.
   //
@@ -194,9 +242,9 @@ void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
   }
 
   if (pack) {
-    libjit_matmul_inner_packed(m, n, k, packedA, packedB, c, ldc);
+    libjit_matmul_inner_packed(m, n, k, packedA, packedB, c, ldc, ep, bias);
   } else {
-    libjit_matmul_inner_unpacked(m, n, k, a, lda, b, ldb, c, ldc);
+    libjit_matmul_inner_unpacked(m, n, k, a, lda, b, ldb, c, ldc, ep, bias);
   }
 
   size_t i = (m / mr) * mr;
@@ -211,6 +259,15 @@ void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
     libjit_matmul_odd(m - i, n - j, k, &A(i, 0), lda, &B(0, j), ldb, &C(i, j),
                       ldc);
   }
+
+  // The tiled part was finished by the kernels, finish the ragged edges.
+  if (ep) {
+    for (size_t jj = 0; jj < n; jj++) {
+      size_t ii = jj < j ? i : 0;
+      libjit_fused_epilogue_f(&C(ii, jj), bias ? &bias[ii] : nullptr, m - ii,
+                              ep->clampMin, ep->clampMax);
+    }
+  }
 }
 
 /// Tile A into mc * kc blocks, where mc and kc are chosen to approximately fit
@@ -221,14 +278,22 @@ void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
 /// \p c is a \p m x \p n column-major matrix.
 /// \p lda, \p ldb, and \p ldc are the leading dimensions of A, B, and C,
 /// respectively.
+/// \p ep is the epilogue of a fused multiplication, or null, and \p bias is
+/// its bias of the first row of C.
 template <bool pack>
 void __attribute__((noinline))
 libjit_matmul_outer(size_t m, size_t n, size_t k, const float *a, size_t lda,
-                    const float *b, size_t ldb, float *c, size_t ldc) {
-  float packedB[kc * nc] __attribute__((aligned(64)));
+                    const float *b, size_t ldb, float *c, size_t ldc,
+                    const MatMulEpilogue *ep, const float *bias) {
+  // The panel of B takes 2 MB, which is too much for the stacks of the
+  // threads that run the tasks of a multiplication.
+  float *packedB =
+      pack ? (float *)libjit_alloc_scratch(kc * nc * sizeof(float)) : nullptr;
 
   for (size_t p = 0; p < k; p += kc) {
     size_t pb = MIN(k - p, kc);
+    // The epilogue is applied with the last panel of K.
+    const MatMulEpilogue *panelEp = p + kc >= k ? ep : nullptr;
     for (size_t j = 0; j < n; j += nc) {
       size_t jb = MIN(n - j, nc);
       if (pack) {
@@ -237,28 +302,229 @@ libjit_matmul_outer(size_t m, size_t n, size_t k, const float *a, size_t lda,
       for (size_t i = 0; i < m; i += mc) {
         size_t ib = MIN(m - i, mc);
         libjit_matmul_inner<pack>(ib, jb, pb, &A(i, p), lda, &B(p, j), ldb,
-                                  &C(i, j), ldc, packedB);
+                                  &C(i, j), ldc, packedB, panelEp,
+                                  bias ? &bias[i] : nullptr);
       }
     }
   }
+  if (pack) {
+    libjit_free_scratch(packedB);
+  }
+}
+
+/// The context of a parallel matrix multiplication. The arguments have the
+/// same meaning as the arguments of libjit_matmul_outer.
+struct MatMulTaskCtx {
+  size_t m;
+  size_t n;
+  size_t k;
+  const float *a;
+  size_t lda;
+  const float *b;
+  size_t ldb;
+  float *c;
+  size_t ldc;
+  bool pack;
+  /// Split the work along the M dimension if true and along N otherwise.
+  bool splitM;
+  /// The epilogue of a fused multiplication, or null.
+  const MatMulEpilogue *ep;
+};
+
+/// Compute a single slice of the matrix multiplication described by \p ctx.
+/// The slices are disjoint parts of C, so that no synchronization is needed.
+void libjit_matmul_task(void *ctx, size_t taskId, size_t numTasks) {
+  const MatMulTaskCtx &mm = *(const MatMulTaskCtx *)ctx;
+  const float *a = mm.a;
+  const float *b = mm.b;
+  float *c = mm.c;
+  size_t lda = mm.lda;
+  size_t ldb = mm.ldb;
+  size_t ldc = mm.ldc;
+  size_t m = mm.m;
+  size_t n = mm.n;
+  size_t i = 0;
+  size_t j = 0;
+  if (mm.splitM) {
+    // Split M into slices of whole kernel blocks.
+    size_t begin, end;
+    libjit_task_range((mm.m + mr - 1) / mr, taskId, numTasks, &begin, &end);
+    i = MIN(begin * mr, mm.m);
+    m = MIN(end * mr, mm.m) - i;
+  } else {
+    size_t end;
+    libjit_task_range(mm.n, taskId, numTasks, &j, &end);
+    n = end - j;
+  }
+  if (m == 0 || n == 0) {
+    return;
+  }
+  const float *bias = mm.ep && mm.ep->bias ? &mm.ep->bias[i] : nullptr;
+  if (mm.pack) {
+    libjit_matmul_outer<true>(m, n, mm.k, &A(i, 0), lda, &B(0, j), ldb,
+                              &C(i, j), ldc, mm.ep, bias);
+  } else {
+    libjit_matmul_outer<false>(m, n, mm.k, &A(i, 0), lda, &B(0, j), ldb,
+                               &C(i, j), ldc, mm.ep, bias);
+  }
 }
 
 #undef C
 #undef B
 #undef A
 
-} // namespace
+/// The packed panels of B that are multiplied with a block of rows of A are
+/// sized to fit in (about half of) the L2 cache.
+constexpr size_t packedBytesI8 = 128 * 1024;
+/// The number of rows of A that are multiplied with the packed panels of B
+/// before the panels are packed again. It bounds the row terms kept on the
+/// stack.
+constexpr size_t mcI8 = 256;
 
-extern "C" {
+/// The quantization parameters of an int8 matrix multiplication.
+struct MatMulI8Params {
+  int32_t outOffset;
+  int32_t lhsOffset;
+  int32_t rhsOffset;
+  int32_t outPre;
+  int32_t outPost;
+  int32_t outScale;
+};
+
+/// Pack the \p k x \p n block of the row-major matrix \p b (with leading
+/// dimension \p ldb) into panels of nrI8 columns. Each panel stores its
+/// \p k rows consecutively, so that the kernel streams through memory. The
+/// last panel is padded with zeros. The sum of each column multiplied by
+/// -\p lhsOffset, which is the part of the offset correction that depends on
+/// the column only, is stored in \p colTerms.
+void pack_matrix_b_i8(size_t k, size_t n, const int8_t *b, size_t ldb,
+                      int8_t *b_to, int32_t lhsOffset, int32_t *colTerms) {
+  for (size_t j = 0; j < n; j += nrI8) {
+    size_t jb = MIN(nrI8, n - j);
+    int32_t sums[nrI8] = {0};
+    for (size_t p = 0; p < k; p++) {
+      const int8_t *row = &b[p * ldb + j];
+      for (size_t jj = 0; jj < nrI8; jj++) {
+        int8_t val = jj < jb ? row[jj] : 0;
+        sums[jj] += val;
+        *b_to++ = val;
+      }
+    }
+    for (size_t jj = 0; jj < nrI8; jj++) {
+      colTerms[j + jj] = -lhsOffset * sums[jj];
+    }
+  }
+}
+
+/// The context of an int8 matrix multiplication out = lhs * rhs, where all of
+/// the matrices are row-major; out is m x n, lhs is m x k and rhs is k x n.
+struct MatMulI8TaskCtx {
+  size_t m;
+  size_t n;
+  size_t k;
+  int8_t *out;
+  const int8_t *lhs;
+  const int8_t *rhs;
+  MatMulI8Params q;
+  /// Split the work along the M dimension if true and along N otherwise.
+  bool splitM;
+};
+
+/// Compute rows [\p i0, \p i1) and columns [\p j0, \p j1) of the int8 matrix
+/// multiplication described by \p mm. The rows are processed in blocks of
+/// mcI8 rows. Blocks of columns of rhs are packed into panels that fit in the
+/// L2 cache, and every block of mrI8 rows of lhs is multiplied with all of the
+/// panels before moving to the next block of rows.
+void libjit_matmul_i8_range(const MatMulI8TaskCtx &mm, size_t i0, size_t i1,
+                            size_t j0, size_t j1) {
+  size_t k = mm.k;
+  size_t n = mm.n;
+
+  size_t nc = MAX(nrI8, packedBytesI8 / MAX(k, (size_t)1) / nrI8 * nrI8);
+  nc = MIN(nc, (j1 - j0 + nrI8 - 1) / nrI8 * nrI8);
+  // The panels hold at least nrI8 whole columns of rhs, so their size grows
+  // with k. They are kept off the stack together with the column terms.
+  int32_t *colTerms = (int32_t *)libjit_alloc_scratch(nc * sizeof(int32_t) +
+                                                      k * nc);
+  int8_t *packedB = (int8_t *)(colTerms + nc);
+
+  // sum((a - lo) * (b - ro)) = sum(a * b) - ro * sum(a) - lo * sum(b) +
+  // k * lo * ro. The terms that depend on the row of lhs are computed once
+  // per block of rows.
+  int32_t offsetsProduct = int32_t(k) * mm.q.lhsOffset * mm.q.rhsOffset;
+  int32_t rowTerms[mcI8];
+
+  for (size_t ib = i0; ib < i1; ib += mcI8) {
+    size_t ie = MIN(ib + mcI8, i1);
+    for (size_t i = ib; i < ie; i++) {
+      int32_t sum = 0;
+      for (size_t p = 0; p < k; p++) {
+        sum += mm.lhs[i * k + p];
+      }
+      rowTerms[i - ib] = offsetsProduct - mm.q.rhsOffset * sum;
+    }
+
+    for (size_t j = j0; j < j1; j += nc) {
+      size_t jb = MIN(nc, j1 - j);
+      pack_matrix_b_i8(k, jb, &mm.rhs[j], n, packedB, mm.q.lhsOffset,
+                       colTerms);
+      size_t i = ib;
+      for (; i + mrI8 <= ie; i += mrI8) {
+        for (size_t jj = 0; jj < jb; jj += nrI8) {
+          libjit_matmul_i8_block<mrI8>(
+              k, &mm.lhs[i * k], k, &packedB[jj * k], &rowTerms[i - ib],
+              &colTerms[jj], &mm.out[i * n + j + jj], n, MIN(nrI8, jb - jj),
+              mm.q.outPre, mm.q.outPost, mm.q.outScale, mm.q.outOffset);
+        }
+      }
+      // Handle the remaining rows one at a time.
+      for (; i < ie; i++) {
+        for (size_t jj = 0; jj < jb; jj += nrI8) {
+          libjit_matmul_i8_block<1>(
+              k, &mm.lhs[i * k], k, &packedB[jj * k], &rowTerms[i - ib],
+              &colTerms[jj], &mm.out[i * n + j + jj], n, MIN(nrI8, jb - jj),
+              mm.q.outPre, mm.q.outPost, mm.q.outScale, mm.q.outOffset);
+        }
+      }
+    }
+  }
+  libjit_free_scratch(colTerms);
+}
+
+/// Compute a single slice of the int8 matrix multiplication described by
+/// \p ctx. The slices are disjoint parts of the output.
+void libjit_matmul_i8_task(void *ctx, size_t taskId, size_t numTasks) {
+  const MatMulI8TaskCtx &mm = *(const MatMulI8TaskCtx *)ctx;
+  size_t begin, end;
+  if (mm.splitM) {
+    // Split M into slices of whole row blocks.
+    libjit_task_range((mm.m + mrI8 - 1) / mrI8, taskId, numTasks, &begin,
+                      &end);
+    begin = MIN(begin * mrI8, mm.m);
+    end = MIN(end * mrI8, mm.m);
+    if (begin < end) {
+      libjit_matmul_i8_range(mm, begin, end, 0, mm.n);
+    }
+  } else {
+    // Split N into slices of whole panels.
+    libjit_task_range((mm.n + nrI8 - 1) / nrI8, taskId, numTasks, &begin,
+                      &end);
+    begin = MIN(begin * nrI8, mm.n);
+    end = MIN(end * nrI8, mm.n);
+    if (begin < end) {
+      libjit_matmul_i8_range(mm, 0, mm.m, begin, end);
+    }
+  }
+}
 
 /// Performs the matrix multiplication c = a * b, where c, a, and b are
-/// row-major matrices.
+/// row-major matrices, and applies the epilogue \p ep to c unless it is null.
 /// \p c is a m x n matrix, so \p cDims = {m, n}
 /// \p a is a m x k matrix, so \p aDims = {m, k}
 /// \p b is a k x n matrix, so \p bDims = {k, n}
-void libjit_matmul_f(float *c, const float *a, const float *b,
-                     const size_t *cDims, const size_t *aDims,
-                     const size_t *bDims) {
+void libjit_matmul_run(float *c, const float *a, const float *b,
+                       const size_t *cDims, const size_t *aDims,
+                       const size_t *bDims, const MatMulEpilogue *ep) {
   memset(c, 0, cDims[0] * cDims[1] * sizeof(float));
   // Call the matrix multiplication routine with appropriate dimensions and
   // leading dimensions. The "leading dimension" for a row-major matrix is equal
@@ -275,29 +541,102 @@ void libjit_matmul_f(float *c, const float *a, const float *b,
   int n = cDims[0];
   int k = aDims[1];
   bool pack = m >= pack_threshold;
+  // Large multiplications are split into disjoint slices of C, which are
+  // computed in parallel. Slice along N if there are enough rows in the
+  // row-major C (e.g. large batches), and along M otherwise.
+  bool splitM = n < m / mr;
+  size_t numTasks =
+      splitM ? libjit_num_tasks((m + mr - 1) / mr, size_t(mr) * n * k)
+             : libjit_num_tasks(n, size_t(m) * k);
+  if (numTasks > 1) {
+    MatMulTaskCtx ctx = {size_t(m), size_t(n), size_t(k), b, bDims[1], a,
+                         aDims[1], c, cDims[1], pack, splitM, ep};
+    libjit_parallel_for(libjit_matmul_task, &ctx, numTasks);
+    return;
+  }
+  const float *bias = ep ? ep->bias : nullptr;
   if (pack) {
-    libjit_matmul_outer<true>(m, n, k, b, bDims[1], a, aDims[1], c, cDims[1]);
+    libjit_matmul_outer<true>(m, n, k, b, bDims[1], a, aDims[1], c, cDims[1],
+                              ep, bias);
+  } else {
+    libjit_matmul_outer<false>(m, n, k, b, bDims[1], a, aDims[1], c, cDims[1],
+                               ep, bias);
+  }
+}
+
+} // namespace
+
+void libjit_matmul_serial_f(size_t m, size_t n, size_t k, const float *a,
+                            size_t lda, const float *b, size_t ldb, float *c,
+                            size_t ldc) {
+  for (size_t i = 0; i < m; i++) {
+    memset(&c[i * ldc], 0, n * sizeof(float));
+  }
+  // As in libjit_matmul_f, compute the column-major C' += B' * A'.
+  if (n >= pack_threshold) {
+    libjit_matmul_outer<true>(n, m, k, b, ldb, a, lda, c, ldc, nullptr,
+                              nullptr);
   } else {
-    libjit_matmul_outer<false>(m, n, k, b, bDims[1], a, aDims[1], c, cDims[1]);
+    libjit_matmul_outer<false>(n, m, k, b, ldb, a, lda, c, ldc, nullptr,
+                               nullptr);
   }
 }
 
+extern "C" {
+
+/// Performs the matrix multiplication c = a * b, where c, a, and b are
+/// row-major matrices.
+/// \p c is a m x n matrix, so \p cDims = {m, n}
+/// \p a is a m x k matrix, so \p aDims = {m, k}
+/// \p b is a k x n matrix, so \p bDims = {k, n}
+void libjit_matmul_f(float *c, const float *a, const float *b,
+                     const size_t *cDims, const size_t *aDims,
+                     const size_t *bDims) {
+  libjit_matmul_run(c, a, b, cDims, aDims, bDims, nullptr);
+}
+
+/// Performs the fused matrix multiplication c = clamp(a * b + bias), where
+/// the vector \p bias is added to every row of c and the elements of c are
+/// clamped to [\p clampMin, \p clampMax]. The epilogue is applied to the
+/// blocks of c while they are computed.
+void libjit_matmul_fused_f(float *c, const float *a, const float *b,
+                           const float *bias, const size_t *cDims,
+                           const size_t *aDims, const size_t *bDims,
+                           float clampMin, float clampMax) {
+  MatMulEpilogue ep = {bias, clampMin, clampMax};
+  libjit_matmul_run(c, a, b, cDims, aDims, bDims, &ep);
+}
+
 void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW, const int8_t *rhsW,
                       const size_t *outWdims, const size_t *lhsWdims,
                       const size_t *rhsWdims, int32_t outOffset,
                       int32_t lhsOffset, int32_t rhsOffset, int32_t outPre,
                       int32_t outPost, int32_t outScale) {
-  for (size_t x = 0; x < outWdims[0]; x++) {
-    for (size_t y = 0; y < outWdims[1]; y++) {
-      int32_t sum = 0;
-      for (size_t i = 0; i < lhsWdims[1]; i++) {
-        int32_t lhs = lhsW[libjit_getXY(lhsWdims, x, i)] - lhsOffset;
-        int32_t rhs = rhsW[libjit_getXY(rhsWdims, i, y)] - rhsOffset;
-        sum += lhs * rhs;
-      }
-      int32_t s = libjit_scale_i32i8(sum, outPre, outPost, outScale, outOffset);
-      outW[libjit_getXY(outWdims, x, y)] = libjit_clip(s);
-    }
+  size_t m = outWdims[0];
+  size_t n = outWdims[1];
+  size_t k = lhsWdims[1];
+  // Large multiplications are split into disjoint slices of the output. Slices
+  // along N let each task pack only its own columns of rhs, so slice along M
+  // only if there are more rows than columns.
+  bool splitM = m > n;
+  MatMulI8TaskCtx ctx = {m,
+                         n,
+                         k,
+                         outW,
+                         lhsW,
+                         rhsW,
+                         {outOffset, lhsOffset, rhsOffset, outPre, outPost,
+                          outScale},
+                         splitM};
+  size_t numTasks =
+      splitM ? libjit_num_tasks((m + mrI8 - 1) / mrI8, mrI8 * n * k)
+             : libjit_num_tasks((n + nrI8 - 1) / nrI8, nrI8 * m * k);
+  if (numTasks > 1) {
+    libjit_parallel_for(libjit_matmul_i8_task, &ctx, numTasks);
+    return;
+  }
+  if (m && n) {
+    libjit_matmul_i8_range(ctx, 0, m, 0, n);
   }
 }
 }
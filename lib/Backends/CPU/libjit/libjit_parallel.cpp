@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "libjit_defs.h"
+
+/// The signature of the parallel-for dispatcher provided by the host runtime.
+typedef void (*libjit_dispatch_fn)(void *pool, libjit_task_fn fn, void *ctx,
+                                   size_t numTasks);
+
+extern "C" {
+
+/// The parallel runtime state. The JIT replaces the initializers of these
+/// variables by the host dispatcher, its thread pool and the number of threads
+/// selected for the compiled function. Bundles keep the defaults and run all
+/// tasks serially.
+libjit_dispatch_fn libjit_parallel_dispatcher = nullptr;
+void *libjit_parallel_pool = nullptr;
+size_t libjit_num_threads = 1;
+
+size_t libjit_get_num_threads() { return libjit_num_threads; }
+
+void libjit_task_range(size_t numItems, size_t taskId, size_t numTasks,
+                       size_t *begin, size_t *end) {
+  *begin = numItems * taskId / numTasks;
+  *end = numItems * (taskId + 1) / numTasks;
+}
+
+void libjit_parallel_for(libjit_task_fn fn, void *ctx, size_t numTasks) {
+  if (numTasks > 1 && libjit_parallel_dispatcher) {
+    libjit_parallel_dispatcher(libjit_parallel_pool, fn, ctx, numTasks);
+    return;
+  }
+  for (size_t taskId = 0; taskId < numTasks; taskId++) {
+    fn(ctx, taskId, numTasks);
+  }
+}
+}
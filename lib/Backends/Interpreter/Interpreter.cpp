@@ -36,6 +36,12 @@ Interpreter::compileIR(std::unique_ptr<IRFunction> IR,
 }
 
 bool Interpreter::isOpSupported(Kinded::Kind opKind, ElemKind elementTy) const {
+  // Fused row-wise quantized data is only read by the embedding lookups.
+  if (elementTy == ElemKind::UInt8FusedQTy) {
+    return opKind ==
+           Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind;
+  }
+
   // Check quantization support.
   if (elementTy == ElemKind::Int8QTy) {
     switch (opKind) {
@@ -59,6 +65,7 @@ bool Interpreter::isOpSupported(Kinded::Kind opKind, ElemKind elementTy) const {
     case Kinded::Kind::ReluNodeKind:
     case Kinded::Kind::RescaleQuantizedNodeKind:
     case Kinded::Kind::ReshapeNodeKind:
+    case Kinded::Kind::RowwiseQuantizedSparseLengthsWeightedSumNodeKind:
     case Kinded::Kind::SelectNodeKind:
     case Kinded::Kind::SigmoidNodeKind:
     case Kinded::Kind::SliceNodeKind:
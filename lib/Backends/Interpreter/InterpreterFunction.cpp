@@ -16,113 +16,127 @@
 
 #include "InterpreterFunction.h"
 
+#include "glow/CodeGen/MemoryPlanner.h"
 #include "glow/IR/IR.h"
 #include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
+#include "glow/Support/Memory.h"
 
 #include "llvm/Support/Casting.h"
 
+#include <unordered_map>
+
 using namespace glow;
 
 InterpreterFunction::InterpreterFunction(std::unique_ptr<IRFunction> F,
                                          const Context &ctx)
     : F_(std::move(F)) {
+  // The tensors that back the values of the function. This is only used while
+  // the plan is built.
+  std::unordered_map<const Value *, Tensor *> tensors;
 
   // Register the concrete tensors that back the placeholder tensors.
   for (auto &ph : ctx.pairs()) {
     auto *w = F_->getWeightForNode(ph.first);
-    assert(!externalTensors_.count(w) && "The tensor is already registered");
-    externalTensors_[w] = ph.second;
+    assert(!tensors.count(w) && "The tensor is already registered");
+    tensors[w] = ph.second;
   }
 
   for (auto &v : F_->getGraph()->getParent()->getVars()) {
     auto *w = F_->getWeightForNode(v);
-    assert(!externalTensors_.count(w) && "The tensor is already registered");
-    externalTensors_[w] = &v->getPayload();
-  }
-}
-
-InterpreterFunction::~InterpreterFunction() {
-  // Delete the tensors that are owned by this backend.
-  for (auto p : tensors_) {
-    delete p.second;
+    assert(!tensors.count(w) && "The tensor is already registered");
+    tensors[w] = &v->getPayload();
   }
-  tensors_.clear();
-  externalTensors_.clear();
-}
 
-Tensor *InterpreterFunction::getTensor(const Value *v) const {
-  auto it = tensors_.find(v);
-  if (it != tensors_.end()) {
-    return it->second;
+  // Place all of the activations in a single memory block. An activation is
+  // live from its allocation up to its deallocation.
+  MemoryPlanner planner("Activations");
+  std::unordered_map<const Value *, size_t> allocIdx;
+  size_t idx = 0;
+  for (const auto &I : F_->getInstrs()) {
+    idx++;
+    if (auto *A = llvm::dyn_cast<AllocActivationInst>(&I)) {
+      allocIdx[A] = idx;
+      continue;
+    }
+    if (auto *D = llvm::dyn_cast<DeallocActivationInst>(&I)) {
+      auto *A = D->getAlloc();
+      assert(allocIdx.count(A) && "Invalid deallocation");
+      planner.addBuffer(A, A->getSizeInBytes(), allocIdx[A], idx);
+    }
   }
-
-  auto ie = externalTensors_.find(v);
-  assert(ie != externalTensors_.end() && "Unknown key Value.");
-  return ie->second;
-}
-
-Tensor *InterpreterFunction::getOrCreateTensor(const Value *v) {
-  auto ie = externalTensors_.find(v);
-  if (ie != externalTensors_.end()) {
-    return ie->second;
+  for (const auto &I : F_->getInstrs()) {
+    auto *A = llvm::dyn_cast<AllocActivationInst>(&I);
+    if (A && !planner.hasAddress(A)) {
+      planner.addBuffer(A, A->getSizeInBytes(), allocIdx[A], idx);
+    }
   }
-
-  // Pick the tensor.
-  auto it = tensors_.find(v);
-  if (it == tensors_.end()) {
-    auto *T = new Tensor(v->getType());
-    tensors_[v] = T;
-    return T;
+  if (planner.plan() != 0) {
+    activations_ = static_cast<char *>(
+        alignedAlloc(planner.getMemorySize(), TensorAlignment));
   }
-  return it->second;
-}
 
-Tensor *
-InterpreterFunction::getOrCreateUnownedTensor(const Value *v, const Value *src,
-                                              llvm::ArrayRef<size_t> offsets) {
-  assert(llvm::isa<TensorViewInst>(v) && "Expected a tensor view");
+  // Build the plan. The activations and the tensor views get their tensors
+  // when they are defined, so every operand is backed by a tensor by the time
+  // it is used.
+  for (const auto &I : F_->getInstrs()) {
+    Step step;
+    step.I = &I;
+    switch (I.getKind()) {
+#define DEF_VALUE(CLASS, NAME)
+#define DEF_INSTR(CLASS, NAME)                                                 \
+  case Kinded::Kind::CLASS##Kind:                                              \
+    step.execute = [](InterpreterFunction *F, const Instruction *I) {          \
+      F->fwd##CLASS(llvm::cast<CLASS>(I));                                     \
+    };                                                                         \
+    break;
+#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME)
+#include "glow/AutoGenInstr.def"
 
-  // Pick the tensor.
-  auto it = tensors_.find(v);
+    default:
+      llvm_unreachable("Invalid instruction.");
+    }
 
-  // Release unowned tensors before re-creating them.
-  if (it != tensors_.end()) {
-    deleteTensor(v);
+    step.operandsBegin = operands_.size();
+    if (auto *A = llvm::dyn_cast<AllocActivationInst>(&I)) {
+      tensors_.emplace_back(new Tensor(activations_ + planner.getAddress(A),
+                                       A->getType()));
+      tensors[A] = tensors_.back().get();
+      operands_.emplace_back(A, tensors_.back().get());
+    } else if (auto *TV = llvm::dyn_cast<TensorViewInst>(&I)) {
+      assert(tensors.count(TV->getSrc()) && "The source is not defined");
+      tensors_.emplace_back(new Tensor());
+      *tensors_.back() =
+          tensors[TV->getSrc()]->getUnowned(TV->dims(), TV->getOffsets());
+      tensors[TV] = tensors_.back().get();
+    }
+    for (const auto &op : I.getOperands()) {
+      assert(tensors.count(op.first) && "Unknown operand");
+      operands_.emplace_back(op.first, tensors[op.first]);
+    }
+    step.operandsEnd = operands_.size();
+    plan_.push_back(step);
   }
-
-  auto *T = new Tensor();
-  *T = getTensor(src)->getUnowned(v->dims(), offsets);
-  tensors_[v] = T;
-  return T;
 }
 
-void InterpreterFunction::deleteTensor(const Value *v) {
-  auto it = tensors_.find(v);
-  if (it == tensors_.end()) {
-    return;
-  }
+InterpreterFunction::~InterpreterFunction() { alignedFree(activations_); }
 
-  delete it->second;
-  tensors_.erase(it);
+Tensor *InterpreterFunction::getTensor(const Value *v) const {
+  // Instructions have few operands, so a linear search is the fastest.
+  for (const auto &op : curOperands_) {
+    if (op.first == v) {
+      return op.second;
+    }
+  }
+  llvm_unreachable("The value is not an operand of the instruction.");
 }
 
 void InterpreterFunction::execute() {
-// Do the forward pass.
-#define DEF_VALUE(CLASS, NAME)
-#define DEF_INSTR(CLASS, NAME)                                                 \
-  case Kinded::Kind::CLASS##Kind: {                                            \
-    fwd##CLASS(llvm::cast<CLASS>(&I));                                         \
-    break;                                                                     \
-  }
-#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME)
-  // Dispatch the interpreter on each instruction in the program:
-  for (const auto &I : F_->getInstrs()) {
-    switch (I.getKind()) {
-#include "glow/AutoGenInstr.def"
-
-    default:
-      llvm_unreachable("Invalid instruction.");
-    }
+  // Dispatch the interpreter on each step of the plan.
+  for (const auto &step : plan_) {
+    curOperands_ = llvm::makeArrayRef(operands_.data() + step.operandsBegin,
+                                      operands_.data() + step.operandsEnd);
+    step.execute(this, step.I);
   }
+  curOperands_ = llvm::None;
 }
@@ -23,11 +23,13 @@
 #include "llvm/ADT/ArrayRef.h"
 
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace glow {
 
 class Context;
+class Instruction;
 class IRFunction;
 class Value;
 class Tensor;
@@ -40,13 +42,44 @@ class Variable;
 #include "glow/AutoGenInstr.def"
 
 /// Function "compiled" for execution by the interpreter.
+///
+/// The function is turned into an execution plan when it is created. Every
+/// step of the plan dispatches one instruction, and the tensors of its
+/// operands are resolved ahead of time. The activations are placed in a single
+/// memory block and the tensor views are created up front, so that executing
+/// the plan needs no lookups and no allocations. The tensors that the context
+/// binds and the payloads of the variables must not be reallocated while the
+/// function is in use.
 class InterpreterFunction final : public CompiledFunction {
+  /// Executes the instruction \p I on the function \p F.
+  using ExecuteFn = void (*)(InterpreterFunction *F, const Instruction *I);
+
+  /// An operand of an instruction and the tensor that backs it.
+  using Operand = std::pair<const Value *, Tensor *>;
+
+  /// A step of the execution plan.
+  struct Step {
+    /// Dispatches the instruction.
+    ExecuteFn execute;
+    /// The instruction to execute.
+    const Instruction *I;
+    /// The range of the operands of the instruction in operands_.
+    size_t operandsBegin;
+    size_t operandsEnd;
+  };
+
   /// The IR to be executed.
   std::unique_ptr<IRFunction> F_;
-  /// Maps values to Tensors, that are owned by this class.
-  std::unordered_map<const Value *, Tensor *> tensors_;
-  /// Maps values to Tensors, that are *not* owned by this class.
-  std::unordered_map<const Value *, Tensor *> externalTensors_;
+  /// The memory block that holds the payloads of all activations.
+  char *activations_{nullptr};
+  /// The unowned tensors that back the activations and the tensor views.
+  std::vector<std::unique_ptr<Tensor>> tensors_;
+  /// The operands of all steps of the plan.
+  std::vector<Operand> operands_;
+  /// The steps of the plan, in the order of the instructions.
+  std::vector<Step> plan_;
+  /// The operands of the step that is being executed.
+  llvm::ArrayRef<Operand> curOperands_;
 
 public:
   InterpreterFunction(std::unique_ptr<IRFunction> F, const Context &ctx);
@@ -59,29 +92,25 @@ public:
   ///@}
 
 private:
-  /// \returns a pointer to the tensor that is saved under \p v.
+  /// \returns a pointer to the tensor that backs \p v, which must be an
+  /// operand of the instruction that is being executed.
   Tensor *getTensor(const Value *v) const;
 
-  /// Allocate a tensor to back the value \p v. Do not allocate anything if a
-  /// tensor is already allocated for \p v.
-  /// \returns a tensor for \p v.
-  Tensor *getOrCreateTensor(const Value *v);
-
-  /// Allocate an unowned tensor to back the value \p v. The source tensor of
-  /// the unowned tensor is provided by \p src.
-  /// \returns a tensor for \p v.
-  Tensor *getOrCreateUnownedTensor(const Value *v, const Value *src,
-                                   llvm::ArrayRef<size_t> offsets);
-
-  /// If a tensor is allocated for \p v then delete it.
-  void deleteTensor(const Value *v);
-
   /// \returns a typed handle to the tensor that is stored at \p v.
   template <class ElemTy = float>
   Handle<ElemTy> getWeightHandle(Value *v) const {
     return getTensor(v)->getHandle<ElemTy>();
   }
 
+  /// \returns a typed pointer to the payload of the tensor that is stored at
+  /// \p v. The kernels use it to index the payload without going through a
+  /// handle.
+  template <class ElemTy = float> ElemTy *getWeightPtr(Value *v) const {
+    Tensor *T = getTensor(v);
+    assert(T->getType().isType<ElemTy>() && "Asking for the wrong ptr type.");
+    return reinterpret_cast<ElemTy *>(T->getUnsafePtr());
+  }
+
   /// @name Interpreter methods. This is a list of method declerations that are
   /// used by the interpreter to dispatch different instructions.
   ///@{
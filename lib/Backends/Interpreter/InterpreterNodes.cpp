@@ -24,8 +24,30 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace glow;
 
+#ifdef GLOW_INTERPRETER_USE_LIBJIT
+extern "C" {
+// The float convolution and matrix multiplication kernels of libjit. The
+// CPURuntimeNative library compiles them natively, so the interpreter may
+// share the blocked and vectorized kernels of the CPU backend. This is opt-in,
+// because by default the interpreter is an independent reference for the
+// results of the CPU backend.
+void libjit_convolution_f(float *outW, const float *inW, const float *filterW,
+                          const float *biasW, const size_t *outWdims,
+                          const size_t *inWdims, const size_t *filterWdims,
+                          const size_t *biasWdims, const size_t *kernelSizes,
+                          const size_t *strides, const size_t *pads,
+                          size_t group, unsigned depthUnroll);
+void libjit_matmul_f(float *c, const float *a, const float *b,
+                     const size_t *cDims, const size_t *aDims,
+                     const size_t *bDims);
+}
+#endif // GLOW_INTERPRETER_USE_LIBJIT
+
 //===----------------------------------------------------------------------===//
 //                       Convolution
 //===----------------------------------------------------------------------===//
@@ -36,37 +58,50 @@ void InterpreterFunction::fwdConvolutionInst_FloatImpl(
     llvm::ArrayRef<unsigned_t> kernelSizes, llvm::ArrayRef<unsigned_t> strides,
     llvm::ArrayRef<unsigned_t> pads, size_t group) {
 
-  auto inW = getWeightHandle(inV);
-  auto outW = getWeightHandle(outV);
-  auto filterW = getWeightHandle(filterV);
-  auto biasW = getWeightHandle(biasV);
+  auto *inW = getWeightPtr(inV);
+  auto *outW = getWeightPtr(outV);
+  auto *filterW = getWeightPtr(filterV);
+  auto *biasW = getWeightPtr(biasV);
 
-  ShapeNHWC odim(outW.dims());
-  ShapeNHWC idim(inW.dims());
+  ShapeNHWC odim(outV->dims());
+  ShapeNHWC idim(inV->dims());
   ShapeHW kdim(kernelSizes);
   ShapeHW sdim(strides);
 
   assert(idim.c % group == 0 && "Input channels must be divisible by group.");
   assert(odim.c % group == 0 && "Output channels must be divisible by group.");
-  size_t inCperG = idim.c / group;
   size_t outCperG = odim.c / group;
 
+#ifdef GLOW_INTERPRETER_USE_LIBJIT
+  // The libjit kernel processes 8 output channels at once if the number of
+  // output channels in each group allows it, like the CPU backend does.
+  size_t kernelsArr[] = {kdim.height, kdim.width};
+  size_t stridesArr[] = {sdim.height, sdim.width};
+  size_t padsArr[] = {pads[0], pads[1], pads[2], pads[3]};
+  unsigned depthUnroll = (outCperG % 8 == 0) ? 8 : 1;
+  libjit_convolution_f(outW, inW, filterW, biasW, outV->dims().data(),
+                       inV->dims().data(), filterV->dims().data(),
+                       biasV->dims().data(), kernelsArr, stridesArr, padsArr,
+                       group, depthUnroll);
+#else
+  size_t inCperG = idim.c / group;
   PaddingTLBR pdim(pads);
 
   // For each input in the batch:
   for (size_t n = 0; n < idim.n; n++) {
 
-    // For each group of input channels:
-    for (size_t g = 0; g < group; g++) {
+    // For each convolution 'jump' in the input tensor:
+    ssize_t x = -ssize_t(pdim.top);
+    for (size_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
+      ssize_t y = -ssize_t(pdim.left);
+      for (size_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+        float *outPx = outW + ((n * odim.h + ax) * odim.w + ay) * odim.c;
 
-      // For each output channel in the group:
-      for (size_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
+        // For each group of input channels:
+        for (size_t g = 0; g < group; g++) {
 
-        // For each convolution 'jump' in the input tensor:
-        ssize_t x = -ssize_t(pdim.top);
-        for (size_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
-          ssize_t y = -ssize_t(pdim.left);
-          for (size_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+          // For each output channel in the group:
+          for (size_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
 
             // For each element in the convolution-filter:
             float sum = 0;
@@ -80,34 +115,44 @@ void InterpreterFunction::fwdConvolutionInst_FloatImpl(
                     oy >= ssize_t(idim.w)) {
                   continue;
                 }
+
+                // The channels of a pixel are consecutive in both the input
+                // and the filter.
+                const float *inPx =
+                    inW + ((n * idim.h + ox) * idim.w + oy) * idim.c +
+                    g * inCperG;
+                const float *filterPx =
+                    filterW + ((d * kdim.height + fx) * kdim.width + fy) *
+                                  inCperG;
                 for (size_t fd = 0; fd < inCperG; fd++) {
-                  sum += filterW.at({d, fx, fy, fd}) *
-                         inW.at({n, (size_t)ox, (size_t)oy, g * inCperG + fd});
+                  sum += filterPx[fd] * inPx[fd];
                 }
               }
             }
 
-            sum += biasW.at({d});
-            outW.at({n, ax, ay, d}) = sum;
-          } // W
-        }   // H
-      }     // C
-    }       // G
+            outPx[d] = sum + biasW[d];
+          } // C
+        }   // G
+      }     // W
+    }       // H
   }         // N
+#endif // GLOW_INTERPRETER_USE_LIBJIT
 }
 
-// This is the quantized i8 implementation of Convolution.
+// This is the quantized i8 implementation of Convolution. The libjit kernel
+// requantizes with integer arithmetic, so the interpreter keeps its own kernel
+// that rounds in floating point.
 void InterpreterFunction::fwdConvolutionInst_I8Impl(
     Value *inV, Value *outV, Value *filterV, Value *biasV,
     llvm::ArrayRef<unsigned_t> kernelSizes, llvm::ArrayRef<unsigned_t> strides,
     llvm::ArrayRef<unsigned_t> pads, size_t group) {
-  auto inW = getWeightHandle<int8_t>(inV);
-  auto outW = getWeightHandle<int8_t>(outV);
-  auto filterW = getWeightHandle<int8_t>(filterV);
-  auto biasW = getWeightHandle<int8_t>(biasV);
+  auto *inW = getWeightPtr<int8_t>(inV);
+  auto *outW = getWeightPtr<int8_t>(outV);
+  auto *filterW = getWeightPtr<int8_t>(filterV);
+  auto *biasW = getWeightPtr<int8_t>(biasV);
 
-  ShapeNHWC odim(outW.dims());
-  ShapeNHWC idim(inW.dims());
+  ShapeNHWC odim(outV->dims());
+  ShapeNHWC idim(inV->dims());
   ShapeHW kdim(kernelSizes);
   ShapeHW sdim(strides);
 
@@ -138,17 +183,19 @@ void InterpreterFunction::fwdConvolutionInst_I8Impl(
 
   // For each input in the batch:
   for (size_t n = 0; n < idim.n; n++) {
-    // For each group of input channels:
-    for (size_t g = 0; g < group; g++) {
 
-      // For each output channel in the group:
-      for (size_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
+    // For each convolution 'jump' in the input tensor:
+    ssize_t x = -ssize_t(pdim.top);
+    for (size_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
+      ssize_t y = -ssize_t(pdim.left);
+      for (size_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+        int8_t *outPx = outW + ((n * odim.h + ax) * odim.w + ay) * odim.c;
 
-        // For each convolution 'jump' in the input tensor:
-        ssize_t x = -ssize_t(pdim.top);
-        for (size_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
-          ssize_t y = -ssize_t(pdim.left);
-          for (size_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+        // For each group of input channels:
+        for (size_t g = 0; g < group; g++) {
+
+          // For each output channel in the group:
+          for (size_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
 
             // For each element in the convolution-filter:
             int32_t sum = 0;
@@ -162,32 +209,38 @@ void InterpreterFunction::fwdConvolutionInst_I8Impl(
                     oy >= ssize_t(idim.w)) {
                   continue;
                 }
-                for (size_t fd = 0; fd < inCperG; fd++) {
 
-                  int32_t F = filterW.at({d, fx, fy, fd});
-                  int32_t I =
-                      inW.at({n, (size_t)ox, (size_t)oy, g * inCperG + fd});
+                // The channels of a pixel are consecutive in both the input
+                // and the filter.
+                const int8_t *inPx =
+                    inW + ((n * idim.h + ox) * idim.w + oy) * idim.c +
+                    g * inCperG;
+                const int8_t *filterPx =
+                    filterW + ((d * kdim.height + fx) * kdim.width + fy) *
+                                  inCperG;
+                for (size_t fd = 0; fd < inCperG; fd++) {
                   // We represent the element multiplication with offset as
                   // (value - offset).
-                  sum += (F - filterOffset) * (I - inOffset);
+                  sum += (int32_t(filterPx[fd]) - filterOffset) *
+                         (int32_t(inPx[fd]) - inOffset);
                 }
               }
             }
 
             // Scale the bias to match the scale of the matrix multiplication.
-            int32_t B = std::round(float(biasW.at({d}) - biasOffset) *
+            int32_t B = std::round(float(biasW[d] - biasOffset) *
                                    (biasScale / matMulScale));
 
             // Add the bias:
             sum += B;
 
             // Scale the result back to the expected destination scale.
-            outW.at({n, ax, ay, d}) = quantization::clip<int32_t, int8_t>(
+            outPx[d] = quantization::clip<int32_t, int8_t>(
                 std::round(float(sum) * (matMulScale / outScale) + outOffset));
-          } // W
-        }   // H
-      }     // C
-    }       // G
+          } // C
+        }   // G
+      }     // W
+    }       // H
   }         // N
 }
 
@@ -290,8 +343,8 @@ static void fwdMaxPool(Tensor *inW, Tensor *outW, Handle<int64_t> *SXY,
                        llvm::ArrayRef<unsigned_t> pads) {
   ShapeNHWC odim(outW->dims());
   ShapeNHWC idim(inW->dims());
-  Handle<T> inHandle = inW->getHandle<T>();
-  Handle<T> outHandle = outW->getHandle<T>();
+  const T *inPtr = reinterpret_cast<const T *>(inW->getUnsafePtr());
+  T *outPtr = reinterpret_cast<T *>(outW->getUnsafePtr());
   PaddingTLBR pdim(pads);
   ShapeHW kdim(kernelSizes);
   ShapeHW sdim(strides);
@@ -323,7 +376,7 @@ static void fwdMaxPool(Tensor *inW, Tensor *outW, Handle<int64_t> *SXY,
                 continue;
               }
 
-              T val = inHandle.at({n, (size_t)ox, (size_t)oy, z});
+              T val = inPtr[((n * idim.h + ox) * idim.w + oy) * idim.c + z];
               if (first || (val >= max_value)) {
                 first = false;
                 max_value = val;
@@ -333,7 +386,7 @@ static void fwdMaxPool(Tensor *inW, Tensor *outW, Handle<int64_t> *SXY,
             }
           }
 
-          outHandle.at({n, ax, ay, z}) = max_value;
+          outPtr[((n * odim.h + ax) * odim.w + ay) * odim.c + z] = max_value;
 
           if (SXY) {
             SXY->at({n, ax, ay, z, 0}) = maxX;
@@ -384,8 +437,8 @@ void InterpreterFunction::fwdAvgPoolInst(const AvgPoolInst *I) {
   float filterArea = kdim.height * kdim.width;
 
   if (I->getSrc()->getType()->isQuantizedType()) {
-    auto inW = getWeightHandle<int8_t>(I->getSrc());
-    auto outW = getWeightHandle<int8_t>(I->getDest());
+    auto *inW = getWeightPtr<int8_t>(I->getSrc());
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
     TensorQuantizationParams inQP{I->getSrc()->getType()->getScale(),
                                   I->getSrc()->getType()->getOffset()};
     TensorQuantizationParams outQP{I->getDest()->getType()->getScale(),
@@ -413,11 +466,12 @@ void InterpreterFunction::fwdAvgPoolInst(const AvgPoolInst *I) {
                   continue;
                 }
 
-                sum += inW.at({n, (size_t)ox, (size_t)oy, z}) - inQP.offset;
+                sum += inW[((n * idim.h + ox) * idim.w + oy) * idim.c + z] -
+                       inQP.offset;
               }
             }
             // Instead of dividing by filterArea, just change scale.
-            outW.at({n, ax, ay, z}) =
+            outW[((n * odim.h + ax) * odim.w + ay) * odim.c + z] =
                 quantization::clip<int32_t, int8_t>(std::round(
                     float(sum) * (inQP.scale / outQP.scale / filterArea) +
                     outQP.offset));
@@ -429,8 +483,8 @@ void InterpreterFunction::fwdAvgPoolInst(const AvgPoolInst *I) {
     return;
   }
 
-  auto inW = getWeightHandle(I->getSrc());
-  auto outW = getWeightHandle(I->getDest());
+  auto *inW = getWeightPtr(I->getSrc());
+  auto *outW = getWeightPtr(I->getDest());
 
   // For each input in the batch:
   for (size_t n = 0; n < odim.n; n++) {
@@ -454,10 +508,11 @@ void InterpreterFunction::fwdAvgPoolInst(const AvgPoolInst *I) {
                 continue;
               }
 
-              sum += inW.at({n, (size_t)ox, (size_t)oy, z});
+              sum += inW[((n * idim.h + ox) * idim.w + oy) * idim.c + z];
             }
           }
-          outW.at({n, ax, ay, z}) = sum / filterArea;
+          outW[((n * odim.h + ax) * odim.w + ay) * odim.c + z] =
+              sum / filterArea;
         } // W
       }   // H
     }     // C
@@ -551,22 +606,22 @@ void InterpreterFunction::fwdAvgPoolGradInst(const AvgPoolGradInst *I) {
 //===----------------------------------------------------------------------===//
 
 void InterpreterFunction::fwdSigmoidInst(const SigmoidInst *I) {
-  auto inW = getWeightHandle(I->getSrc());
-  auto outW = getWeightHandle(I->getDest());
+  auto *inW = getWeightPtr(I->getSrc());
+  auto *outW = getWeightPtr(I->getDest());
 
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    float val = inW.raw(i);
-    outW.raw(i) = 1 / (1 + std::exp(-val));
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    float val = inW[i];
+    outW[i] = 1 / (1 + std::exp(-val));
   }
 }
 
 void InterpreterFunction::fwdTanhInst(const TanhInst *I) {
-  auto inW = getWeightHandle(I->getSrc());
-  auto outW = getWeightHandle(I->getDest());
+  auto *inW = getWeightPtr(I->getSrc());
+  auto *outW = getWeightPtr(I->getDest());
 
-  for (size_t i = 0, e = inW.size(); i < e; i++) {
-    float val = inW.raw(i);
-    outW.raw(i) = std::tanh(val);
+  for (size_t i = 0, e = I->getSrc()->size(); i < e; i++) {
+    float val = inW[i];
+    outW[i] = std::tanh(val);
   }
 }
 
@@ -575,28 +630,31 @@ void InterpreterFunction::fwdTanhInst(const TanhInst *I) {
 //===----------------------------------------------------------------------===//
 
 void InterpreterFunction::fwdSoftMaxInst(const SoftMaxInst *I) {
-  auto inW = getWeightHandle(I->getSrc());
-  auto outW = getWeightHandle(I->getDest());
-  auto idim = inW.dims();
+  auto *inW = getWeightPtr(I->getSrc());
+  auto *outW = getWeightPtr(I->getDest());
+  auto idim = I->getSrc()->dims();
 
   for (size_t n = 0; n < idim[0]; n++) {
+    const float *inRow = inW + n * idim[1];
+    float *outRow = outW + n * idim[1];
+
     // Find Max.
-    float max = inW.at({n, 0});
+    float max = inRow[0];
     for (size_t i = 1; i < idim[1]; i++) {
-      max = std::max(max, inW.at({n, i}));
+      max = std::max(max, inRow[i]);
     }
 
     // Compute exp.
     float sum = 0;
     for (size_t i = 0; i < idim[1]; i++) {
-      float e = std::exp(inW.at({n, i}) - max);
+      float e = std::exp(inRow[i] - max);
       sum += e;
-      outW.at({n, i}) = e;
+      outRow[i] = e;
     }
 
     // Normalize the output.
     for (size_t i = 0; i < idim[1]; i++) {
-      outW.at({n, i}) = outW.at({n, i}) / sum;
+      outRow[i] = outRow[i] / sum;
     }
   } // N
 }
@@ -672,7 +730,7 @@ void InterpreterFunction::fwdTransposeInst(const TransposeInst *I) {
 }
 
 void InterpreterFunction::fwdTensorViewInst(const TensorViewInst *I) {
-  getOrCreateUnownedTensor(I, I->getSrc(), I->getOffsets());
+  // The tensor of the view is created with the execution plan.
 }
 
 void InterpreterFunction::fwdSplatInst(const glow::SplatInst *I) {
@@ -942,12 +1000,12 @@ void InterpreterFunction::fwdElementAddInst(const ElementAddInst *I) {
     int32_t rhsOffset = rhsTy->getOffset();
     int32_t destOffset = destTy->getOffset();
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      int32_t L = lhsW.raw(i);
-      int32_t R = rhsW.raw(i);
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+      int32_t L = lhsW[i];
+      int32_t R = rhsW[i];
 
       // We increase the size of the integer up to 16 bits to prevent overflow.
       const float largeScale = float(1) / (1 << 15);
@@ -956,16 +1014,16 @@ void InterpreterFunction::fwdElementAddInst(const ElementAddInst *I) {
       int32_t R32 = std::round(float(R - rhsOffset) * (rhsScale / largeScale));
       int32_t sum32 = L32 + R32;
       sum32 = std::round(float(sum32) * (largeScale / destScale) + destOffset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(sum32);
+      outW[i] = quantization::clip<int32_t, int8_t>(sum32);
     }
     return;
   }
 
-  auto outW = getWeightHandle(I->getDest());
-  auto lhsW = getWeightHandle(I->getLHS());
-  auto rhsW = getWeightHandle(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) + rhsW.raw(i);
+  auto *outW = getWeightPtr(I->getDest());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = lhsW[i] + rhsW[i];
   }
 }
 
@@ -983,25 +1041,25 @@ void InterpreterFunction::fwdElementSubInst(const ElementSubInst *I) {
     int32_t lhsOffset = lhsTy->getOffset();
     int32_t rhsOffset = rhsTy->getOffset();
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
       //    s_d * (i_d - o_d) = s_l * (i_l - o_l) - s_r * (i_r - o_r)
       // => i_d = (s_l / s_d) * (i_l - o_l) - (s_r / s_d) * (i_r - o_r) + o_d
-      float l = (lhsScale / destScale) * float(lhsW.raw(i) - lhsOffset);
-      float r = (rhsScale / destScale) * float(rhsW.raw(i) - rhsOffset);
+      float l = (lhsScale / destScale) * float(lhsW[i] - lhsOffset);
+      float r = (rhsScale / destScale) * float(rhsW[i] - rhsOffset);
       int32_t q = std::round(l - r + destOffset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
+      outW[i] = quantization::clip<int32_t, int8_t>(q);
     }
     return;
   }
 
-  auto outW = getWeightHandle(I->getDest());
-  auto lhsW = getWeightHandle(I->getLHS());
-  auto rhsW = getWeightHandle(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) - rhsW.raw(i);
+  auto *outW = getWeightPtr(I->getDest());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = lhsW[i] - rhsW[i];
   }
 }
 
@@ -1015,23 +1073,23 @@ void InterpreterFunction::fwdElementMulInst(const ElementMulInst *I) {
     TensorQuantizationParams rhsQ{rhsTy->getScale(), rhsTy->getOffset()};
     TensorQuantizationParams destQ{destTy->getScale(), destTy->getOffset()};
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
     float scale = lhsQ.scale * rhsQ.scale / destQ.scale;
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      int32_t mul = (lhsW.raw(i) - lhsQ.offset) * (rhsW.raw(i) - rhsQ.offset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+      int32_t mul = (lhsW[i] - lhsQ.offset) * (rhsW[i] - rhsQ.offset);
+      outW[i] = quantization::clip<int32_t, int8_t>(
           std::round(mul * scale) + destQ.offset);
     }
     return;
   }
 
-  auto outW = getWeightHandle(I->getDest());
-  auto lhsW = getWeightHandle(I->getLHS());
-  auto rhsW = getWeightHandle(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) * rhsW.raw(i);
+  auto *outW = getWeightPtr(I->getDest());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = lhsW[i] * rhsW[i];
   }
 }
 
@@ -1049,26 +1107,26 @@ void InterpreterFunction::fwdElementDivInst(const ElementDivInst *I) {
     int32_t lhsOffset = lhsTy->getOffset();
     int32_t rhsOffset = rhsTy->getOffset();
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
       //    s_d * (i_d - o_d) = (s_l * (i_l - o_l)) / (s_r * (i_r - o_r))
       // => i_d = (s_l * (i_l - o_l)) / (s_d * s_r * (i_r - o_r)) + o_d
-      float l = lhsScale * float(lhsW.raw(i) - lhsOffset);
-      float r = rhsScale * destScale * float(rhsW.raw(i) - rhsOffset);
+      float l = lhsScale * float(lhsW[i] - lhsOffset);
+      float r = rhsScale * destScale * float(rhsW[i] - rhsOffset);
       int32_t q = std::round(l / r + destOffset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
+      outW[i] = quantization::clip<int32_t, int8_t>(q);
     }
     return;
   }
 
 #define DIV_LOOP(TYPE_)                                                        \
-  auto outW = getWeightHandle<TYPE_>(I->getDest());                            \
-  auto lhsW = getWeightHandle<TYPE_>(I->getLHS());                             \
-  auto rhsW = getWeightHandle<TYPE_>(I->getRHS());                             \
-  for (size_t i = 0, e = outW.size(); i < e; i++) {                            \
-    outW.raw(i) = lhsW.raw(i) / rhsW.raw(i);                                   \
+  auto *outW = getWeightPtr<TYPE_>(I->getDest());                              \
+  auto *lhsW = getWeightPtr<TYPE_>(I->getLHS());                               \
+  auto *rhsW = getWeightPtr<TYPE_>(I->getRHS());                               \
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {                   \
+    outW[i] = lhsW[i] / rhsW[i];                                               \
   }
 
   auto *T = getTensor(I->getDest());
@@ -1096,29 +1154,26 @@ void InterpreterFunction::fwdElementMaxInst(const ElementMaxInst *I) {
     TensorQuantizationParams rhsQ{rhsTy->getScale(), rhsTy->getOffset()};
     TensorQuantizationParams destQ{destTy->getScale(), destTy->getOffset()};
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
       // Convert both sides to the destination scale and perform a regular
       // comparison.
       int8_t L = quantization::quantize(
-          quantization::dequantize(lhsW.raw(i), lhsQ), destQ);
+          quantization::dequantize(lhsW[i], lhsQ), destQ);
       int8_t R = quantization::quantize(
-          quantization::dequantize(rhsW.raw(i), rhsQ), destQ);
-      outW.raw(i) = std::max(L, R);
+          quantization::dequantize(rhsW[i], rhsQ), destQ);
+      outW[i] = std::max(L, R);
     }
     return;
   }
 
-  auto *lhs = getTensor(I->getLHS());
-  auto *rhs = getTensor(I->getRHS());
-  auto *out = getTensor(I->getDest());
-  auto outW = out->getHandle();
-  auto lhsW = lhs->getHandle();
-  auto rhsW = rhs->getHandle();
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = std::max(lhsW.raw(i), rhsW.raw(i));
+  auto *outW = getWeightPtr(I->getDest());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = std::max(lhsW[i], rhsW[i]);
   }
 }
 
@@ -1132,26 +1187,26 @@ void InterpreterFunction::fwdElementMinInst(const ElementMinInst *I) {
     TensorQuantizationParams rhsQ{rhsTy->getScale(), rhsTy->getOffset()};
     TensorQuantizationParams destQ{destTy->getScale(), destTy->getOffset()};
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
       // Convert both sides to the destination scale and perform a regular
       // comparison.
       int8_t L = quantization::quantize(
-          quantization::dequantize(lhsW.raw(i), lhsQ), destQ);
+          quantization::dequantize(lhsW[i], lhsQ), destQ);
       int8_t R = quantization::quantize(
-          quantization::dequantize(rhsW.raw(i), rhsQ), destQ);
-      outW.raw(i) = std::min(L, R);
+          quantization::dequantize(rhsW[i], rhsQ), destQ);
+      outW[i] = std::min(L, R);
     }
     return;
   }
 
-  auto outW = getWeightHandle(I->getDest());
-  auto lhsW = getWeightHandle(I->getLHS());
-  auto rhsW = getWeightHandle(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = std::min(lhsW.raw(i), rhsW.raw(i));
+  auto *outW = getWeightPtr(I->getDest());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = std::min(lhsW[i], rhsW[i]);
   }
 }
 
@@ -1168,50 +1223,50 @@ void InterpreterFunction::fwdElementCmpLTEInst(const ElementCmpLTEInst *I) {
     int32_t lhsOffset = lhsTy->getOffset();
     int32_t rhsOffset = rhsTy->getOffset();
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      outW.raw(i) = lhsScale * (lhsW.raw(i) - lhsOffset) <=
-                            rhsScale * (rhsW.raw(i) - rhsOffset)
-                        ? 1.0
-                        : 0.0;
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+      outW[i] = lhsScale * (lhsW[i] - lhsOffset) <=
+                        rhsScale * (rhsW[i] - rhsOffset)
+                    ? 1.0
+                    : 0.0;
     }
     return;
   }
 
-  auto outW = getWeightHandle(I->getDest());
-  auto lhsW = getWeightHandle(I->getLHS());
-  auto rhsW = getWeightHandle(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) <= rhsW.raw(i) ? 1.0 : 0.0;
+  auto *outW = getWeightPtr(I->getDest());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = lhsW[i] <= rhsW[i] ? 1.0 : 0.0;
   }
 }
 
 void InterpreterFunction::fwdElementCmpEQInst(const ElementCmpEQInst *I) {
-  auto outW = getWeightHandle<int64_t>(I->getDest());
-  auto lhsW = getWeightHandle<int64_t>(I->getLHS());
-  auto rhsW = getWeightHandle<int64_t>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) == rhsW.raw(i) ? 1 : 0;
+  auto *outW = getWeightPtr<int64_t>(I->getDest());
+  auto *lhsW = getWeightPtr<int64_t>(I->getLHS());
+  auto *rhsW = getWeightPtr<int64_t>(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = lhsW[i] == rhsW[i] ? 1 : 0;
   }
 }
 
 void InterpreterFunction::fwdElementPowInst(const glow::ElementPowInst *I) {
-  auto baseW = getWeightHandle(I->getLHS());
-  auto expW = getWeightHandle(I->getRHS());
-  auto outW = getWeightHandle(I->getDest());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = pow(baseW.raw(i), expW.raw(i));
+  auto *baseW = getWeightPtr(I->getLHS());
+  auto *expW = getWeightPtr(I->getRHS());
+  auto *outW = getWeightPtr(I->getDest());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = pow(baseW[i], expW[i]);
   }
 }
 
 void InterpreterFunction::fwdElementLogInst(const ElementLogInst *I) {
-  auto inW = getWeightHandle(I->getSrc());
-  auto outW = getWeightHandle(I->getDest());
-  for (size_t i = 0, e = inW.size(); i < e; i++) {
-    float val = inW.raw(i);
-    outW.raw(i) = log(val);
+  auto *inW = getWeightPtr(I->getSrc());
+  auto *outW = getWeightPtr(I->getDest());
+  for (size_t i = 0, e = I->getSrc()->size(); i < e; i++) {
+    float val = inW[i];
+    outW[i] = log(val);
   }
 }
 
@@ -1230,25 +1285,25 @@ void InterpreterFunction::fwdElementSelectInst(
     int32_t lhsOffset = lhsTy->getOffset();
     int32_t rhsOffset = rhsTy->getOffset();
 
-    auto outW = getWeightHandle<int8_t>(I->getDest());
-    auto condW = getWeightHandle<int8_t>(I->getCond());
-    auto lhsW = getWeightHandle<int8_t>(I->getLHS());
-    auto rhsW = getWeightHandle<int8_t>(I->getRHS());
-    for (size_t i = 0, e = outW.size(); i < e; i++) {
-      float val = (condW.raw(i) != 0) ? lhsScale * (lhsW.raw(i) - lhsOffset)
-                                      : rhsScale * (rhsW.raw(i) - rhsOffset);
+    auto *outW = getWeightPtr<int8_t>(I->getDest());
+    auto *condW = getWeightPtr<int8_t>(I->getCond());
+    auto *lhsW = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhsW = getWeightPtr<int8_t>(I->getRHS());
+    for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+      float val = (condW[i] != 0) ? lhsScale * (lhsW[i] - lhsOffset)
+                                  : rhsScale * (rhsW[i] - rhsOffset);
       int32_t q = std::round(val / destScale + destOffset);
-      outW.raw(i) = quantization::clip<int32_t, int8_t>(q);
+      outW[i] = quantization::clip<int32_t, int8_t>(q);
     }
     return;
   }
 
-  auto outW = getWeightHandle(I->getDest());
-  auto condW = getWeightHandle(I->getCond());
-  auto lhsW = getWeightHandle(I->getLHS());
-  auto rhsW = getWeightHandle(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = (condW.raw(i) != 0.0) ? lhsW.raw(i) : rhsW.raw(i);
+  auto *outW = getWeightPtr(I->getDest());
+  auto *condW = getWeightPtr(I->getCond());
+  auto *lhsW = getWeightPtr(I->getLHS());
+  auto *rhsW = getWeightPtr(I->getRHS());
+  for (size_t i = 0, e = I->getDest()->size(); i < e; i++) {
+    outW[i] = (condW[i] != 0.0) ? lhsW[i] : rhsW[i];
   }
 }
 
@@ -1257,21 +1312,18 @@ void InterpreterFunction::fwdElementSelectInst(
 //===----------------------------------------------------------------------===//
 
 void InterpreterFunction::fwdMatMulInst(const glow::MatMulInst *I) {
-  if (getTensor(I->getLHS())->getType().isQuantizedType()) {
-    auto lhs = getWeightHandle<int8_t>(I->getLHS());
-    auto rhs = getWeightHandle<int8_t>(I->getRHS());
+  auto destDim = I->getDest()->dims();
+  auto lhsDim = I->getLHS()->dims();
 
-    auto dest = getWeightHandle<int8_t>(I->getDest());
-
-    auto destDim = dest.dims();
-    auto lhsDim = lhs.dims();
+  if (getTensor(I->getLHS())->getType().isQuantizedType()) {
+    auto *lhs = getWeightPtr<int8_t>(I->getLHS());
+    auto *rhs = getWeightPtr<int8_t>(I->getRHS());
+    auto *dest = getWeightPtr<int8_t>(I->getDest());
 
     auto destTy = I->getDest()->getType();
     auto lhsTy = I->getLHS()->getType();
     auto rhsTy = I->getRHS()->getType();
 
-    dest.clear(0);
-
     // For matrix multiplication, if the offset is equal to zero the scale
     // is defined as the formula (L.scale * R.scale / D.scale).
     // In here we assume that the offset for all buffers is zero.
@@ -1280,48 +1332,58 @@ void InterpreterFunction::fwdMatMulInst(const glow::MatMulInst *I) {
     int32_t rhsOffset = rhsTy->getOffset();
     int32_t destOffset = destTy->getOffset();
 
-    // For each (x,y) in the destination matrix:
+    // Compute the rows of the destination matrix in blocks of columns. The
+    // 32-bit sums of a block are accumulated on the stack, one row of the
+    // right-hand side at a time, so the inner loop runs over consecutive
+    // elements.
+    constexpr size_t blockSize = 64;
+    int32_t sum[blockSize];
     for (size_t x = 0; x < destDim[0]; x++) {
-      for (size_t y = 0; y < destDim[1]; y++) {
-
-        // Perform DOT on the row an column.
-        int32_t sum = 0;
+      for (size_t y0 = 0; y0 < destDim[1]; y0 += blockSize) {
+        size_t cols = std::min(blockSize, destDim[1] - y0);
+        std::fill(sum, sum + cols, 0);
         for (size_t i = 0; i < lhsDim[1]; i++) {
-          int32_t L = lhs.at({x, i});
-          int32_t R = rhs.at({i, y});
           // We represent the element multiplication with offset as
           // (value - offset).
-          sum += (L - lhsOffset) * (R - rhsOffset);
+          int32_t L = int32_t(lhs[x * lhsDim[1] + i]) - lhsOffset;
+          const int8_t *rhsRow = rhs + i * destDim[1] + y0;
+          for (size_t y = 0; y < cols; y++) {
+            sum[y] += L * (int32_t(rhsRow[y]) - rhsOffset);
+          }
         }
 
-        dest.at({x, y}) = quantization::clip<int32_t, int8_t>(
-            std::round(scale * sum + destOffset));
+        int8_t *destRow = dest + x * destDim[1] + y0;
+        for (size_t y = 0; y < cols; y++) {
+          destRow[y] = quantization::clip<int32_t, int8_t>(
+              std::round(scale * sum[y] + destOffset));
+        }
       }
     }
     return;
   }
 
-  auto lhs = getWeightHandle(I->getLHS());
-  auto rhs = getWeightHandle(I->getRHS());
-  auto dest = getWeightHandle(I->getDest());
-
-  auto destDim = dest.dims();
-  auto lhsDim = lhs.dims();
-
-  dest.clear(0);
+  auto *lhs = getWeightPtr(I->getLHS());
+  auto *rhs = getWeightPtr(I->getRHS());
+  auto *dest = getWeightPtr(I->getDest());
 
-  // For each (x,y) in the destination matrix:
+#ifdef GLOW_INTERPRETER_USE_LIBJIT
+  libjit_matmul_f(dest, lhs, rhs, destDim.data(), lhsDim.data(),
+                  I->getRHS()->dims().data());
+#else
+  // Accumulate one row of the right-hand side at a time into each row of the
+  // destination, so the inner loop runs over consecutive elements.
   for (size_t x = 0; x < destDim[0]; x++) {
-    for (size_t y = 0; y < destDim[1]; y++) {
-
-      // Perform DOT on the row an column.
-      float sum = 0;
-      for (size_t i = 0; i < lhsDim[1]; i++) {
-        sum += lhs.at({x, i}) * rhs.at({i, y});
+    float *destRow = dest + x * destDim[1];
+    std::fill(destRow, destRow + destDim[1], 0);
+    for (size_t i = 0; i < lhsDim[1]; i++) {
+      float L = lhs[x * lhsDim[1] + i];
+      const float *rhsRow = rhs + i * destDim[1];
+      for (size_t y = 0; y < destDim[1]; y++) {
+        destRow[y] += L * rhsRow[y];
       }
-      dest.at({x, y}) = sum;
     }
   }
+#endif // GLOW_INTERPRETER_USE_LIBJIT
 }
 
 //===----------------------------------------------------------------------===//
@@ -1329,10 +1391,15 @@ void InterpreterFunction::fwdMatMulInst(const glow::MatMulInst *I) {
 //===----------------------------------------------------------------------===//
 
 void InterpreterFunction::fwdBatchedAddInst(const glow::BatchedAddInst *I) {
+  auto bdim = flattenCdr(I->getBatch()->dims());
+  assert(I->getSlice()->size() == bdim.second && "Invalid slice size");
+  assert(I->getBatch()->dims().drop_front() == I->getSlice()->dims() &&
+         "Invalid batch size");
+
   if (getTensor(I->getBatch())->getType().isQuantizedType()) {
-    auto batch = getWeightHandle<int8_t>(I->getBatch());
-    auto slice = getWeightHandle<int8_t>(I->getSlice());
-    auto dest = getWeightHandle<int8_t>(I->getDest());
+    auto *batch = getWeightPtr<int8_t>(I->getBatch());
+    auto *slice = getWeightPtr<int8_t>(I->getSlice());
+    auto *dest = getWeightPtr<int8_t>(I->getDest());
 
     auto batchTy = I->getBatch()->getType();
     auto sliceTy = I->getSlice()->getType();
@@ -1346,18 +1413,14 @@ void InterpreterFunction::fwdBatchedAddInst(const glow::BatchedAddInst *I) {
     int32_t batchOffset = batchTy->getOffset();
     int32_t destOffset = destTy->getOffset();
 
-    auto bdim = flattenCdr(batch.dims());
-    assert(slice.size() == bdim.second && "Invalid slice size");
-    assert(batch.dims().drop_front() == slice.dims() && "Invalid batch size");
-
     // For each layer in the batch:
     for (size_t n = 0; n < bdim.first; n++) {
-      size_t base = batch.getElementPtr({n});
+      size_t base = n * bdim.second;
 
       // For each element in the slice.
       for (size_t i = 0; i < bdim.second; i++) {
-        int32_t batchVal = batch.raw(base + i);
-        int32_t sliceVal = slice.raw(i);
+        int32_t batchVal = batch[base + i];
+        int32_t sliceVal = slice[i];
         // We increase the size of the integer up to 16 bits for more accurate
         // arithmetic.
         const float largeScale = float(1) / (1 << 15);
@@ -1367,28 +1430,24 @@ void InterpreterFunction::fwdBatchedAddInst(const glow::BatchedAddInst *I) {
         int32_t S = std::round(float(sliceVal - sliceOffset) *
                                (sliceScale / largeScale));
         int32_t R = B + S;
-        dest.raw(base + i) = quantization::clip<int32_t, int8_t>(
+        dest[base + i] = quantization::clip<int32_t, int8_t>(
             std::round(float(R) * (largeScale / destScale) + destOffset));
       }
     }
     return;
   }
 
-  auto batch = getWeightHandle(I->getBatch());
-  auto slice = getWeightHandle(I->getSlice());
-  auto dest = getWeightHandle(I->getDest());
-
-  auto bdim = flattenCdr(batch.dims());
-  assert(slice.size() == bdim.second && "Invalid slice size");
-  assert(batch.dims().drop_front() == slice.dims() && "Invalid batch size");
+  auto *batch = getWeightPtr(I->getBatch());
+  auto *slice = getWeightPtr(I->getSlice());
+  auto *dest = getWeightPtr(I->getDest());
 
   // For each layer in the batch:
   for (size_t n = 0; n < bdim.first; n++) {
-    size_t base = batch.getElementPtr({n});
+    size_t base = n * bdim.second;
 
     // For each element in the slice.
     for (size_t i = 0; i < bdim.second; i++) {
-      dest.raw(base + i) = batch.raw(base + i) + slice.raw(i);
+      dest[base + i] = batch[base + i] + slice[i];
     }
   }
 }
@@ -1534,6 +1593,88 @@ void InterpreterFunction::fwdSparseLengthsWeightedSumInst(
   }
 }
 
+void InterpreterFunction::fwdRowwiseQuantizedSparseLengthsWeightedSumInst(
+    const RowwiseQuantizedSparseLengthsWeightedSumInst *I) {
+  auto out = getTensor(I->getDest());
+  auto data = getTensor(I->getData());
+  auto scales = getTensor(I->getScales());
+  auto offsets = getTensor(I->getOffsets());
+  auto weights = getTensor(I->getWeights());
+  auto indices = getTensor(I->getIndices());
+  auto lengths = getTensor(I->getLengths());
+
+  out->zero();
+
+  auto IH = indices->getHandle<int64_t>();
+  auto LH = lengths->getHandle<int64_t>();
+
+  size_t segments = lengths->dims()[0];
+  size_t lineSize = data->size() / data->dims()[0];
+
+  auto DH = data->getHandle<int8_t>();
+  auto SH = scales->getHandle<float>();
+  auto OFH = offsets->getHandle<float>();
+  auto WH = weights->getHandle<float>();
+  auto OH = out->getHandle<float>();
+
+  size_t curIdx = 0;
+  for (size_t i = 0; i < segments; i++) {
+    for (size_t j = 0, e = LH.raw(i); j < e; j++) {
+      float weight = WH.raw(curIdx);
+      size_t row = IH.raw(curIdx++);
+      float scale = SH.raw(row);
+      float offset = OFH.raw(row);
+      size_t offsetIn = row * lineSize;
+      size_t offsetOut = i * lineSize;
+      for (size_t k = 0; k < lineSize; k++) {
+        float value = DH.raw(offsetIn++) * scale + offset;
+        OH.raw(offsetOut++) += value * weight;
+      }
+    }
+  }
+}
+
+void InterpreterFunction::fwdFusedRowwiseQuantizedSparseLengthsWeightedSumInst(
+    const FusedRowwiseQuantizedSparseLengthsWeightedSumInst *I) {
+  auto out = getTensor(I->getDest());
+  auto data = getTensor(I->getData());
+  auto weights = getTensor(I->getWeights());
+  auto indices = getTensor(I->getIndices());
+  auto lengths = getTensor(I->getLengths());
+
+  out->zero();
+
+  auto IH = indices->getHandle<int64_t>();
+  auto LH = lengths->getHandle<int64_t>();
+
+  size_t segments = lengths->dims()[0];
+  size_t inLineSize = data->dims()[1];
+  size_t outLineSize = out->dims()[1];
+
+  auto DH = data->getHandle<uint8_t>();
+  auto WH = weights->getHandle<float>();
+  auto OH = out->getHandle<float>();
+
+  size_t curIdx = 0;
+  for (size_t i = 0; i < segments; i++) {
+    for (size_t j = 0, e = LH.raw(i); j < e; j++) {
+      float weight = WH.raw(curIdx);
+      size_t row = IH.raw(curIdx++);
+      // The scale and the offset follow the quantized elements of the row.
+      const uint8_t *rowEnd = &DH.raw(row * inLineSize + outLineSize);
+      float scale, offset;
+      memcpy(&scale, rowEnd, sizeof(float));
+      memcpy(&offset, rowEnd + sizeof(float), sizeof(float));
+      size_t offsetIn = row * inLineSize;
+      size_t offsetOut = i * outLineSize;
+      for (size_t k = 0; k < outLineSize; k++) {
+        float value = DH.raw(offsetIn++) * scale + offset;
+        OH.raw(offsetOut++) += value * weight;
+      }
+    }
+  }
+}
+
 //===----------------------------------------------------------------------===//
 //                Instructions used by RNN
 //===----------------------------------------------------------------------===//
@@ -1590,12 +1731,15 @@ void InterpreterFunction::fwdTopKInst(const TopKInst *I) {
 //===----------------------------------------------------------------------===//
 
 void InterpreterFunction::fwdAllocActivationInst(const AllocActivationInst *I) {
-  getOrCreateTensor(I);
+  // The activation is placed in the memory block of the activations when the
+  // execution plan is created. It starts out as zero, like a new tensor.
+  getTensor(I)->zero();
 }
 
 void InterpreterFunction::fwdDeallocActivationInst(
     const DeallocActivationInst *I) {
-  deleteTensor(I->getSrc());
+  // The memory of the activation may be reused by the activations that are
+  // allocated later.
 }
 
 //===----------------------------------------------------------------------===//
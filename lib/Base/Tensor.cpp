@@ -277,6 +277,8 @@ void glow::dumpAsciiImpl(Tensor *T, llvm::raw_ostream &os) {
     return dumpAsciiGenericImpl(T->getHandle<int32_t>(), os);
   case ElemKind::Int64ITy:
     return dumpAsciiGenericImpl(T->getHandle<int64_t>(), os);
+  case ElemKind::UInt8FusedQTy:
+    return dumpAsciiGenericImpl(T->getHandle<uint8_t>(), os);
   }
 }
 
@@ -294,6 +296,8 @@ void glow::dumpImpl(Tensor *T, llvm::raw_ostream &os) {
     return dumpGenericImpl(T->getHandle<int32_t>(), os);
   case ElemKind::Int64ITy:
     return dumpGenericImpl(T->getHandle<int64_t>(), os);
+  case ElemKind::UInt8FusedQTy:
+    return dumpGenericImpl(T->getHandle<uint8_t>(), os);
   }
 }
 
@@ -346,6 +350,12 @@ void glow::genericTranspose(Tensor *src, Tensor *dest,
     transposeSelectImpl(srcH, destH, shuffle);
     return;
   }
+  case ElemKind::UInt8FusedQTy: {
+    auto srcH = src->getHandle<uint8_t>();
+    auto destH = dest->getHandle<uint8_t>();
+    transposeSelectImpl(srcH, destH, shuffle);
+    return;
+  }
   }
 }
 
@@ -385,6 +395,10 @@ void Tensor::init(InitKind init, float val, PseudoRNG &PRNG) {
       getHandle<int64_t>().clear(val);
       break;
     }
+    case ElemKind::UInt8FusedQTy: {
+      getHandle<uint8_t>().clear(val);
+      break;
+    }
     }
     break;
   }
@@ -411,6 +425,10 @@ void Tensor::init(InitKind init, float val, PseudoRNG &PRNG) {
       getHandle<int64_t>().initXavier(val, PRNG);
       break;
     }
+    case ElemKind::UInt8FusedQTy: {
+      getHandle<uint8_t>().initXavier(val, PRNG);
+      break;
+    }
     }
     break;
   }
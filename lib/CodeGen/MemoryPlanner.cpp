@@ -0,0 +1,242 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define DEBUG_TYPE "memory-planner"
+
+#include "glow/CodeGen/MemoryPlanner.h"
+#include "glow/Support/Debug.h"
+#include "glow/Support/Memory.h"
+
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace glow;
+
+void MemoryPlanner::addBuffer(Handle handle, uint64_t size, size_t begin,
+                              size_t end) {
+  assert(begin <= end && "The buffer ends before it begins");
+  assert(!handleToIdx_.count(handle) && "The handle already has a buffer");
+  handleToIdx_[handle] = buffers_.size();
+  // Always place buffers properly aligned to hold values of any type.
+  buffers_.push_back({handle, alignedSize(size, TensorAlignment), begin, end});
+}
+
+uint64_t MemoryPlanner::getAddress(Handle handle) const {
+  auto it = handleToIdx_.find(handle);
+  assert(it != handleToIdx_.end() && "Unknown handle");
+  assert(offsets_.size() == buffers_.size() && "The buffers were not placed");
+  return offsets_[it->second];
+}
+
+uint64_t MemoryPlanner::getLowerBound() const {
+  // Sweep over the points in time at which buffers become live or dead. A
+  // buffer is dead after its last time step.
+  std::vector<std::pair<size_t, int64_t>> events;
+  events.reserve(buffers_.size() * 2);
+  for (const auto &B : buffers_) {
+    events.emplace_back(B.begin, B.size);
+    events.emplace_back(B.end + 1, -int64_t(B.size));
+  }
+  // The buffers that die at some point in time are released before the ones
+  // that become live at the same point are added.
+  std::sort(events.begin(), events.end());
+  uint64_t live = 0;
+  uint64_t maxLive = 0;
+  for (const auto &E : events) {
+    live += E.second;
+    maxLive = std::max(maxLive, live);
+  }
+  return maxLive;
+}
+
+double MemoryPlanner::getFragmentation() const {
+  if (memorySize_ == 0) {
+    return 0;
+  }
+  return 1.0 - double(getLowerBound()) / double(memorySize_);
+}
+
+const char *MemoryPlanner::getStrategyName(Strategy strategy) {
+  switch (strategy) {
+  case Strategy::FirstFit:
+    return "first-fit";
+  case Strategy::GreedyBySize:
+    return "greedy-by-size";
+  case Strategy::GreedyByBreadth:
+    return "greedy-by-breadth";
+  }
+  llvm_unreachable("Unknown strategy");
+}
+
+void MemoryPlanner::dump(llvm::raw_ostream &os) const {
+  os << "Memory plan of '" << name_ << "': " << buffers_.size()
+     << " buffers, strategy: " << getStrategyName(strategy_)
+     << ", size: " << memorySize_ << ", lower bound: " << getLowerBound()
+     << ", fragmentation: "
+     << llvm::format("%.1f%%", getFragmentation() * 100) << "\n";
+}
+
+std::vector<size_t> MemoryPlanner::getPlacementOrder(Strategy strategy) const {
+  std::vector<size_t> order(buffers_.size());
+  for (size_t i = 0, e = order.size(); i < e; i++) {
+    order[i] = i;
+  }
+
+  // Larger buffers go first. Buffers of the same size are placed in the order
+  // in which they become live.
+  auto isLarger = [&](size_t a, size_t b) {
+    const auto &A = buffers_[a];
+    const auto &B = buffers_[b];
+    if (A.size != B.size) {
+      return A.size > B.size;
+    }
+    return A.begin < B.begin;
+  };
+
+  switch (strategy) {
+  case Strategy::FirstFit:
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return buffers_[a].begin < buffers_[b].begin;
+    });
+    return order;
+
+  case Strategy::GreedyBySize:
+    std::stable_sort(order.begin(), order.end(), isLarger);
+    return order;
+
+  case Strategy::GreedyByBreadth: {
+    // The total size of the live buffers can only reach a maximum at a point
+    // in time at which a buffer becomes live.
+    std::vector<std::pair<uint64_t, size_t>> breadths;
+    for (const auto &B : buffers_) {
+      uint64_t breadth = 0;
+      for (const auto &other : buffers_) {
+        if (other.begin <= B.begin && B.begin <= other.end) {
+          breadth += other.size;
+        }
+      }
+      breadths.emplace_back(breadth, B.begin);
+    }
+    std::sort(breadths.begin(), breadths.end(),
+              [](const std::pair<uint64_t, size_t> &a,
+                 const std::pair<uint64_t, size_t> &b) {
+                if (a.first != b.first) {
+                  return a.first > b.first;
+                }
+                return a.second < b.second;
+              });
+
+    std::vector<size_t> result;
+    result.reserve(buffers_.size());
+    std::vector<bool> added(buffers_.size(), false);
+    for (const auto &step : breadths) {
+      size_t first = result.size();
+      for (size_t i = 0, e = buffers_.size(); i < e; i++) {
+        if (!added[i] && buffers_[i].begin <= step.second &&
+            step.second <= buffers_[i].end) {
+          added[i] = true;
+          result.push_back(i);
+        }
+      }
+      std::stable_sort(result.begin() + first, result.end(), isLarger);
+    }
+    return result;
+  }
+  }
+  llvm_unreachable("Unknown strategy");
+}
+
+uint64_t MemoryPlanner::place(const std::vector<size_t> &order, bool bestFit,
+                              std::vector<uint64_t> &offsets) const {
+  offsets.assign(buffers_.size(), 0);
+  std::vector<size_t> placed;
+  placed.reserve(buffers_.size());
+  uint64_t memorySize = 0;
+  // The ranges of memory taken by the placed buffers that are live at the same
+  // time as the current one.
+  std::vector<std::pair<uint64_t, uint64_t>> taken;
+  for (size_t idx : order) {
+    const auto &B = buffers_[idx];
+    taken.clear();
+    for (size_t p : placed) {
+      const auto &P = buffers_[p];
+      if (P.begin <= B.end && B.begin <= P.end) {
+        taken.emplace_back(offsets[p], offsets[p] + P.size);
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+
+    // Find a gap between the taken ranges, or place the buffer above all of
+    // them.
+    uint64_t offset = 0;
+    uint64_t bestGap = 0;
+    bool found = false;
+    uint64_t prev = 0;
+    for (const auto &range : taken) {
+      if (range.first >= prev + B.size) {
+        uint64_t gap = range.first - prev;
+        if (!found || gap < bestGap) {
+          offset = prev;
+          bestGap = gap;
+          found = true;
+        }
+        if (!bestFit) {
+          break;
+        }
+      }
+      prev = std::max(prev, range.second);
+    }
+    if (!found) {
+      offset = prev;
+    }
+
+    offsets[idx] = offset;
+    placed.push_back(idx);
+    memorySize = std::max(memorySize, offset + B.size);
+  }
+  return memorySize;
+}
+
+uint64_t MemoryPlanner::plan(Strategy strategy) {
+  strategy_ = strategy;
+  memorySize_ = place(getPlacementOrder(strategy),
+                      /* bestFit */ strategy != Strategy::FirstFit, offsets_);
+  DEBUG_GLOW(dump(llvm::dbgs()));
+  return memorySize_;
+}
+
+uint64_t MemoryPlanner::plan() {
+  std::vector<uint64_t> offsets;
+  bool hasPlan = false;
+  for (auto strategy : {Strategy::FirstFit, Strategy::GreedyBySize,
+                        Strategy::GreedyByBreadth}) {
+    uint64_t memorySize =
+        place(getPlacementOrder(strategy),
+              /* bestFit */ strategy != Strategy::FirstFit, offsets);
+    if (!hasPlan || memorySize < memorySize_) {
+      hasPlan = true;
+      strategy_ = strategy;
+      memorySize_ = memorySize;
+      offsets_.swap(offsets);
+    }
+  }
+  DEBUG_GLOW(dump(llvm::dbgs()));
+  return memorySize_;
+}
@@ -0,0 +1,236 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/ExecutionEngine/BucketedExecutor.h"
+#include "glow/Graph/Nodes.h"
+#include "glow/Support/Compiler.h"
+
+#include "llvm/ADT/STLExtras.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+using namespace glow;
+
+/// \returns the product of \p sizes.
+static size_t getVolume(llvm::ArrayRef<size_t> sizes) {
+  return std::accumulate(sizes.begin(), sizes.end(), size_t(1),
+                         std::multiplies<size_t>());
+}
+
+/// Copy the elements of \p src whose coordinates are below \p dims into the
+/// same coordinates of \p dest. The tensors have the same element type and
+/// are at least as large as \p dims in every dimension.
+static void copyBlock(const Tensor &src, Tensor &dest,
+                      llvm::ArrayRef<size_t> dims) {
+  assert(src.getElementType() == dest.getElementType() &&
+         "Mismatch on the element type");
+  size_t elemSize = src.getType().getElementSize();
+  size_t numDims = dims.size();
+  if (numDims == 0) {
+    std::memcpy(dest.getUnsafePtr(), src.getUnsafePtr(), elemSize);
+    return;
+  }
+
+  // Compute the strides, in elements, of both tensors.
+  std::vector<size_t> srcStrides(numDims), destStrides(numDims);
+  size_t srcStride = 1, destStride = 1;
+  for (size_t i = numDims; i-- > 0;) {
+    assert(dims[i] <= src.dims()[i] && dims[i] <= dest.dims()[i] &&
+           "The block does not fit the tensors");
+    srcStrides[i] = srcStride;
+    destStrides[i] = destStride;
+    srcStride *= src.dims()[i];
+    destStride *= dest.dims()[i];
+  }
+
+  // Copy the block one innermost row at a time.
+  size_t rowSize = dims.back() * elemSize;
+  size_t numRows = getVolume(dims.drop_back());
+  std::vector<size_t> coords(numDims, 0);
+  for (size_t r = 0; r < numRows; r++) {
+    size_t srcOffset = 0, destOffset = 0;
+    for (size_t i = 0; i + 1 < numDims; i++) {
+      srcOffset += coords[i] * srcStrides[i];
+      destOffset += coords[i] * destStrides[i];
+    }
+    std::memcpy(dest.getUnsafePtr() + destOffset * elemSize,
+                src.getUnsafePtr() + srcOffset * elemSize, rowSize);
+
+    // Advance to the next row.
+    for (size_t i = numDims - 1; i-- > 0;) {
+      if (++coords[i] < dims[i]) {
+        break;
+      }
+      coords[i] = 0;
+    }
+  }
+}
+
+/// Check that the placeholders \p placeholders of the bucket with the sizes
+/// \p sizes have the shapes that the dimensions \p dims declare: a dynamic
+/// dimension has the size of the bucket, and a static dimension the size that
+/// it has in \p first, the placeholders of the first bucket.
+static void verifyDynamicDims(llvm::ArrayRef<Placeholder *> placeholders,
+                              llvm::ArrayRef<Placeholder *> first,
+                              llvm::ArrayRef<std::vector<int>> dims,
+                              llvm::ArrayRef<size_t> sizes) {
+  assert(placeholders.size() == dims.size() &&
+         "Every placeholder declares its dynamic dimensions");
+  for (size_t i = 0, e = placeholders.size(); i < e; i++) {
+    auto phDims = placeholders[i]->dims();
+    (void)phDims;
+    assert(phDims.size() == dims[i].size() && "Mismatch on the rank");
+    for (size_t d = 0, n = dims[i].size(); d < n; d++) {
+      assert(dims[i][d] < int(sizes.size()) && "No such dynamic dimension");
+      assert((dims[i][d] < 0 ? phDims[d] == first[i]->dims()[d]
+                             : phDims[d] == sizes[dims[i][d]]) &&
+             "The shape does not match the declared dynamic dimensions");
+    }
+  }
+}
+
+BucketedExecutor::BucketedExecutor(BackendKind backendKind)
+    : backendKind_(backendKind) {}
+
+BucketedExecutor::~BucketedExecutor() = default;
+
+void BucketedExecutor::compile(CompilationMode mode,
+                               llvm::ArrayRef<std::vector<size_t>> buckets,
+                               const Builder &build) {
+  assert(!buckets.empty() && "No buckets");
+  buckets_.clear();
+
+  // Create all of the specializations before any of them is optimized. The
+  // optimizer may erase the weights that have no users, which includes the
+  // weights of the specializations that were not created yet.
+  std::vector<std::vector<size_t>> sorted(buckets.begin(), buckets.end());
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const std::vector<size_t> &a,
+                      const std::vector<size_t> &b) {
+                     return getVolume(a) < getVolume(b);
+                   });
+  for (auto &sizes : sorted) {
+    assert(sizes.size() == sorted[0].size() &&
+           "All buckets have the same number of dynamic dimensions");
+    Bucket B;
+    B.sizes = sizes;
+    B.spec = build(M_, sizes);
+    assert(B.spec.F && B.spec.F->getParent() == &M_ &&
+           "The specialization is not a function of the module");
+    assert((buckets_.empty() ||
+            (B.spec.inputs.size() == buckets_[0].spec.inputs.size() &&
+             B.spec.outputs.size() == buckets_[0].spec.outputs.size())) &&
+           "Mismatch on the number of inputs or outputs");
+    assert((buckets_.empty() ||
+            (B.spec.inputDims == buckets_[0].spec.inputDims &&
+             B.spec.outputDims == buckets_[0].spec.outputDims)) &&
+           "The buckets declare different dynamic dimensions");
+    const auto &first = buckets_.empty() ? B.spec : buckets_[0].spec;
+    verifyDynamicDims(B.spec.inputs, first.inputs, B.spec.inputDims, sizes);
+    verifyDynamicDims(B.spec.outputs, first.outputs, B.spec.outputDims,
+                      sizes);
+    buckets_.push_back(std::move(B));
+  }
+
+  inputDims_ = buckets_[0].spec.inputDims;
+  outputDims_ = buckets_[0].spec.outputDims;
+
+  for (auto &B : buckets_) {
+    B.ctx = llvm::make_unique<Context>();
+    for (auto *P : B.spec.inputs) {
+      B.ctx->allocate(P);
+    }
+    for (auto *P : B.spec.outputs) {
+      B.ctx->allocate(P);
+    }
+    B.EE = llvm::make_unique<ExecutionEngine>(backendKind_);
+    B.EE->compile(mode, B.spec.F, *B.ctx);
+  }
+}
+
+std::vector<size_t> BucketedExecutor::getRequestSizes(
+    llvm::ArrayRef<const Tensor *> inputs) const {
+  assert(inputs.size() == inputDims_.size() &&
+         "The number of inputs does not match the number of placeholders");
+  std::vector<size_t> request(buckets_[0].sizes.size(), 0);
+  for (size_t i = 0, e = inputs.size(); i < e; i++) {
+    auto dims = inputs[i]->dims();
+    assert(dims.size() == inputDims_[i].size() && "Mismatch on the rank");
+    for (size_t d = 0, n = dims.size(); d < n; d++) {
+      int v = inputDims_[i][d];
+      if (v < 0) {
+        assert(dims[d] == buckets_[0].spec.inputs[i]->dims()[d] &&
+               "Mismatch on a static dimension");
+        continue;
+      }
+      request[v] = std::max(request[v], dims[d]);
+    }
+  }
+  return request;
+}
+
+size_t
+BucketedExecutor::selectBucket(llvm::ArrayRef<const Tensor *> inputs) const {
+  auto request = getRequestSizes(inputs);
+
+  // The buckets are sorted by size, so the first one that fits is the
+  // smallest.
+  for (size_t b = 0, e = buckets_.size(); b < e; b++) {
+    bool fits = true;
+    for (size_t v = 0, n = request.size(); v < n && fits; v++) {
+      fits = request[v] <= buckets_[b].sizes[v];
+    }
+    if (fits) {
+      return b;
+    }
+  }
+  GLOW_UNREACHABLE("No bucket fits the request");
+}
+
+void BucketedExecutor::run(llvm::ArrayRef<const Tensor *> inputs,
+                           llvm::ArrayRef<Tensor *> outputs) {
+  assert(outputs.size() == outputDims_.size() &&
+         "The number of outputs does not match the number of placeholders");
+  auto request = getRequestSizes(inputs);
+  auto &B = buckets_[selectBucket(inputs)];
+
+  // Pad the inputs with zeros up to the sizes of the bucket.
+  for (size_t i = 0, e = inputs.size(); i < e; i++) {
+    Tensor *T = B.ctx->get(B.spec.inputs[i]);
+    if (inputs[i]->dims() != T->dims()) {
+      T->zero();
+    }
+    copyBlock(*inputs[i], *T, inputs[i]->dims());
+  }
+
+  B.EE->run();
+
+  // Cut the outputs back to the sizes of the request.
+  for (size_t i = 0, e = outputs.size(); i < e; i++) {
+    Tensor *T = B.ctx->get(B.spec.outputs[i]);
+    std::vector<size_t> dims(T->dims().begin(), T->dims().end());
+    for (size_t d = 0, n = dims.size(); d < n; d++) {
+      if (outputDims_[i][d] >= 0) {
+        dims[d] = request[outputDims_[i][d]];
+      }
+    }
+    outputs[i]->reset(Type::newShape(T->getType(), dims));
+    copyBlock(*T, *outputs[i], dims);
+  }
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/ExecutionEngine/DAGExecutor.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Graph/Nodes.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/Casting.h"
+
+using namespace glow;
+
+DAGExecutor::DAGExecutor(BackendKind backendKind, unsigned numThreads)
+    : backendKind_(backendKind), pool_(numThreads) {}
+
+DAGExecutor::~DAGExecutor() = default;
+
+void DAGExecutor::compile(CompilationMode mode, const FunctionDAG &G,
+                          const Context &ctx) {
+  assert(G.verify() && "The partitions are not topologically sorted");
+  partitions_.clear();
+  ctx_.clear();
+
+  // Bind all of the placeholders that the partitions read or write. The
+  // placeholders bound by the caller refer to the caller's tensors; the rest
+  // connect the partitions and are backed by tensors owned by the executor.
+  for (auto *F : G.getFunctions()) {
+    for (auto &N : F->getNodes()) {
+      for (unsigned i = 0, e = N.getNumInputs(); i < e; i++) {
+        auto *P = llvm::dyn_cast<Placeholder>(N.getNthInput(i).getNode());
+        if (!P || ctx_.count(P)) {
+          continue;
+        }
+        if (auto *T = ctx.get(P)) {
+          ctx_.insert(P, T->getUnowned(T->dims()));
+        } else {
+          ctx_.allocate(P);
+        }
+      }
+    }
+  }
+
+  // Compile the partitions and record the edges of the DAG. The dependency
+  // lists may name the same partition more than once.
+  llvm::DenseMap<Function *, size_t> indices;
+  for (auto *F : G.getFunctions()) {
+    size_t idx = partitions_.size();
+    indices[F] = idx;
+    partitions_.emplace_back();
+    partitions_[idx].F = F;
+    partitions_[idx].EE = llvm::make_unique<ExecutionEngine>(backendKind_);
+    partitions_[idx].EE->compile(mode, F, ctx_);
+
+    const auto &deps = G.getDependencies(F);
+    llvm::SmallPtrSet<Function *, 4> uniqueDeps(deps.begin(), deps.end());
+    partitions_[idx].numDependencies = uniqueDeps.size();
+    for (auto *dep : uniqueDeps) {
+      partitions_[indices[dep]].users.push_back(idx);
+    }
+  }
+
+  pending_ = std::vector<std::atomic<unsigned>>(partitions_.size());
+}
+
+void DAGExecutor::runPartition(size_t idx) {
+  const size_t numPartitions = partitions_.size();
+  for (;;) {
+    auto &P = partitions_[idx];
+    P.EE->run();
+
+    // Release the users of this partition. The counters are updated with
+    // sequentially-consistent atomics, which makes the results of all of the
+    // dependencies visible to the thread that runs a user.
+    size_t next = numPartitions;
+    for (auto user : P.users) {
+      if (--pending_[user] != 0) {
+        continue;
+      }
+      if (next == numPartitions) {
+        next = user;
+        continue;
+      }
+      pool_.submit([this, user] { runPartition(user); });
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(finishedMtx_);
+      if (++numFinished_ == numPartitions) {
+        allFinished_.notify_all();
+      }
+    }
+
+    // The executor may be destroyed as soon as the last partition finished, so
+    // don't touch any members after that point.
+    if (next == numPartitions) {
+      return;
+    }
+    idx = next;
+  }
+}
+
+void DAGExecutor::run() {
+  assert(!partitions_.empty() && "No partitions have been compiled");
+  for (size_t i = 0, e = partitions_.size(); i < e; i++) {
+    pending_[i] = partitions_[i].numDependencies;
+  }
+  {
+    std::lock_guard<std::mutex> lock(finishedMtx_);
+    numFinished_ = 0;
+  }
+
+  // Start all of the partitions that have no dependencies.
+  for (size_t i = 0, e = partitions_.size(); i < e; i++) {
+    if (partitions_[i].numDependencies == 0) {
+      pool_.submit([this, i] { runPartition(i); });
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(finishedMtx_);
+  allFinished_.wait(lock,
+                    [this] { return numFinished_ == partitions_.size(); });
+}
@@ -19,11 +19,88 @@
 #include "glow/Graph/Context.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Optimizer/Optimizer.h"
+#include "glow/Support/Memory.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cstring>
 
 using namespace glow;
 
+namespace {
+/// Identifies the files written by saveConstantWeights.
+const char weightsFileMagic[8] = {'G', 'L', 'O', 'W', 'W', 'T', 'S', '\0'};
+/// The version of the layout of the weights files.
+constexpr uint64_t weightsFileVersion = 1;
+
+/// Describes the payload of a constant in a weights file. The file starts with
+/// the magic, the version and the number of records, followed by the records
+/// and by the payloads. The payloads are aligned to TensorAlignment.
+struct WeightsRecord {
+  std::string name;
+  ElemKind elemKind;
+  float scale;
+  int32_t offset;
+  std::vector<size_t> dims;
+  /// The offset of the payload from the beginning of the file.
+  uint64_t dataOffset;
+  /// The size of the payload in bytes.
+  uint64_t dataSize;
+};
+
+/// Appends plain values to a buffer.
+class WeightsWriter {
+  std::string &buf_;
+
+public:
+  explicit WeightsWriter(std::string &buf) : buf_(buf) {}
+
+  template <typename T> void write(T value) {
+    buf_.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void writeString(llvm::StringRef str) {
+    write<uint64_t>(str.size());
+    buf_.append(str.data(), str.size());
+  }
+};
+
+/// Reads plain values from a memory region, checking its bounds.
+class WeightsReader {
+  const char *cur_;
+  const char *end_;
+
+public:
+  WeightsReader(const char *begin, const char *end) : cur_(begin), end_(end) {}
+
+  template <typename T> T read() {
+    GLOW_ASSERT(size_t(end_ - cur_) >= sizeof(T) && "Truncated weights file");
+    T value;
+    memcpy(&value, cur_, sizeof(T));
+    cur_ += sizeof(T);
+    return value;
+  }
+
+  std::string readString() {
+    auto size = read<uint64_t>();
+    GLOW_ASSERT(uint64_t(end_ - cur_) >= size && "Truncated weights file");
+    std::string str(cur_, size);
+    cur_ += size;
+    return str;
+  }
+};
+
+/// \returns true if the payload of \p V is saved to weights files.
+bool isConstantWeight(const Variable *V) {
+  return V->getVisibilityKind() == VisibilityKind::Private &&
+         !V->isTraining();
+}
+} // namespace
+
 ExecutionEngine::ExecutionEngine(BackendKind backendKind)
     : backend_(createBackend(backendKind)) {}
 
@@ -31,12 +108,14 @@ ExecutionEngine::ExecutionEngine(BackendKind backendKind)
 void ExecutionEngine::setBackend(BackendKind backendKind) {
   backend_.reset(createBackend(backendKind));
   function_.reset();
+  cache_.clear();
 }
 
 /// Set the code generator kind to \p backend.
 void ExecutionEngine::setBackend(Backend *backend) {
   backend_.reset(backend);
   function_.reset();
+  cache_.clear();
 }
 
 ExecutionEngine::~ExecutionEngine() = default;
@@ -165,33 +244,267 @@ void ExecutionEngine::optimizeFunction(CompilationMode mode, Function *F) {
   F->verify();
 
   // Optimize the graph.
-  ::glow::optimize(F, mode);
+  ::glow::optimize(F, mode, backend_.get());
 
   // Allow the backend to transform the graph prior to lowering.
   if (backend_->transformPreLowering(F, mode)) {
     // Optimize the graph again after the backend transformation.
     // In particular, DCE is very likely to be useful.
-    ::glow::optimize(F, mode);
+    ::glow::optimize(F, mode, backend_.get());
   }
 
   // Lower the graph into a sequence of low-level linear algebra operations.
   ::glow::lower(F, *backend_);
 
   // Optimize the graph again.
-  ::glow::optimize(F, mode);
+  ::glow::optimize(F, mode, backend_.get());
 
   // Allow the backend to transform the graph after lowering.
   if (backend_->transformPostLowering(F, mode)) {
     // Optimize the graph again after the backend transformation.
     // In particular, DCE is very likely to be useful.
-    ::glow::optimize(F, mode);
+    ::glow::optimize(F, mode, backend_.get());
+  }
+}
+
+ExecutionEngine::PayloadList
+ExecutionEngine::getPayloads(const Module *M, const Context &ctx) {
+  PayloadList payloads;
+  for (auto *V : M->getVars()) {
+    auto &payload = V->getPayload();
+    payloads.emplace_back(payload.getUnsafePtr(), payload.getType().getSizeInBytes());
+  }
+  // The order of the bindings does not matter, because they are compared as
+  // a map as well.
+  for (auto &binding : ctx.pairs()) {
+    Tensor *T = binding.second;
+    payloads.emplace_back(T->getUnsafePtr(), T->getType().getSizeInBytes());
+  }
+  std::sort(payloads.begin(), payloads.end());
+  return payloads;
+}
+
+std::shared_ptr<CompiledFunction>
+ExecutionEngine::lookupCache(llvm::StringRef hash,
+                             llvm::ArrayRef<const Storage *> storage,
+                             CompilationMode mode, const Module *M,
+                             const Context &ctx) {
+  PayloadList payloads;
+  for (auto it = cache_.begin(), e = cache_.end(); it != e; ++it) {
+    // The compiled code references the variables and the tensors of the
+    // context, and may reference their payloads by their addresses, so they
+    // have to match as well. A payload that was reallocated, or a tensor that
+    // was rebound to other memory, needs a new compilation.
+    if (it->hash != hash || it->mode != mode || it->module != M ||
+        llvm::ArrayRef<const Storage *>(it->storage) != storage ||
+        it->bindings != ctx.pairs()) {
+      continue;
+    }
+    if (payloads.empty()) {
+      payloads = getPayloads(M, ctx);
+    }
+    if (it->payloads != payloads) {
+      continue;
+    }
+    // Move the function to the most recently used position.
+    cache_.splice(cache_.end(), cache_, it);
+    return cache_.back().function;
+  }
+  return nullptr;
+}
+
+void ExecutionEngine::addToCache(llvm::StringRef hash,
+                                 llvm::ArrayRef<const Storage *> storage,
+                                 CompilationMode mode, const Module *M,
+                                 const Context &ctx,
+                                 std::shared_ptr<CompiledFunction> function) {
+  cache_.push_back({hash.str(), storage.vec(), mode, M, ctx.pairs(),
+                    getPayloads(M, ctx), std::move(function)});
+  if (cache_.size() > maxCachedFunctions) {
+    cache_.pop_front();
   }
 }
 
 void ExecutionEngine::compile(CompilationMode mode, Function *F,
                               const Context &ctx) {
+  std::vector<const Storage *> storage;
+  auto hash = F->getStructuralHash(&storage);
+  if (auto function = lookupCache(hash, storage, mode, F->getParent(), ctx)) {
+    function_ = std::move(function);
+    numCacheHits_++;
+    return;
+  }
+
   optimizeFunction(mode, F);
   function_ = backend_->compile(F, ctx);
+  addToCache(hash, storage, mode, F->getParent(), ctx, function_);
+
+  // Compiling the optimized Function produces the same code, so remember the
+  // code under its hash as well. This serves the callers that compile the
+  // same Function again, such as a training loop that alternates between
+  // training and inference.
+  std::vector<const Storage *> optimizedStorage;
+  auto optimizedHash = F->getStructuralHash(&optimizedStorage);
+  if (optimizedHash != hash || optimizedStorage != storage) {
+    addToCache(optimizedHash, optimizedStorage, mode, F->getParent(), ctx,
+               function_);
+  }
+}
+
+void ExecutionEngine::saveConstantWeights(llvm::StringRef filename) {
+  // Describe the constants first, because the size of the records determines
+  // where the payloads start.
+  std::vector<WeightsRecord> records;
+  std::vector<const Tensor *> payloads;
+  for (auto *V : M_.getVars()) {
+    if (!isConstantWeight(V)) {
+      continue;
+    }
+    auto ty = V->getType();
+    WeightsRecord R;
+    R.name = V->getName();
+    R.elemKind = ty->getElementType();
+    R.scale = ty->isQuantizedType() ? ty->getScale() : 0;
+    R.offset = ty->isQuantizedType() ? ty->getOffset() : 0;
+    R.dims.assign(ty->dims().begin(), ty->dims().end());
+    R.dataOffset = 0;
+    R.dataSize = ty->getSizeInBytes();
+    records.push_back(std::move(R));
+    payloads.push_back(&V->getPayload());
+  }
+
+  auto writeHeader = [&](std::string &buf) {
+    WeightsWriter W(buf);
+    buf.append(weightsFileMagic, sizeof(weightsFileMagic));
+    W.write<uint64_t>(weightsFileVersion);
+    W.write<uint64_t>(records.size());
+    for (const auto &R : records) {
+      W.writeString(R.name);
+      W.write<uint64_t>(static_cast<uint64_t>(R.elemKind));
+      W.write<float>(R.scale);
+      W.write<int32_t>(R.offset);
+      W.write<uint64_t>(R.dims.size());
+      for (auto d : R.dims) {
+        W.write<uint64_t>(d);
+      }
+      W.write<uint64_t>(R.dataOffset);
+      W.write<uint64_t>(R.dataSize);
+    }
+  };
+
+  // The size of the header does not depend on the offsets of the payloads.
+  std::string header;
+  writeHeader(header);
+  uint64_t pos = alignedSize(header.size(), TensorAlignment);
+  for (auto &R : records) {
+    R.dataOffset = pos;
+    pos += alignedSize(R.dataSize, TensorAlignment);
+  }
+  header.clear();
+  writeHeader(header);
+
+  std::error_code EC;
+  llvm::raw_fd_ostream os(filename, EC, llvm::sys::fs::F_None);
+  GLOW_ASSERT(!EC && "Could not open the output file for saving the weights");
+  os << header;
+  pos = header.size();
+  for (size_t i = 0, e = records.size(); i < e; i++) {
+    for (; pos < records[i].dataOffset; pos++) {
+      os.write(0);
+    }
+    os.write(payloads[i]->getUnsafePtr(), records[i].dataSize);
+    pos += records[i].dataSize;
+  }
+  os.close();
+  GLOW_ASSERT(!os.has_error() && "Could not write the weights file");
+}
+
+size_t ExecutionEngine::mapConstantWeights(llvm::StringRef filename) {
+  int fd;
+  auto EC = llvm::sys::fs::openFileForRead(filename, fd);
+  GLOW_ASSERT(!EC && "Could not open the weights file");
+  uint64_t fileSize;
+  EC = llvm::sys::fs::file_size(filename, fileSize);
+  GLOW_ASSERT(!EC && "Could not get the size of the weights file");
+  // Map the file copy-on-write. The pages are shared with the page cache and
+  // with the other processes that map the file, but the optimizer may still
+  // update the payloads in place without changing the file.
+  auto region = llvm::make_unique<llvm::sys::fs::mapped_file_region>(
+      fd, llvm::sys::fs::mapped_file_region::priv, fileSize, 0, EC);
+  llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  GLOW_ASSERT(!EC && "Could not map the weights file");
+  char *base = region->data();
+  assert(reinterpret_cast<uintptr_t>(base) % TensorAlignment == 0 &&
+         "The mapping is not aligned");
+
+  WeightsReader R(base, base + fileSize);
+  char magic[sizeof(weightsFileMagic)];
+  for (auto &c : magic) {
+    c = R.read<char>();
+  }
+  GLOW_ASSERT(!memcmp(magic, weightsFileMagic, sizeof(magic)) &&
+              "Not a weights file");
+  GLOW_ASSERT(R.read<uint64_t>() == weightsFileVersion &&
+              "Unsupported version of the weights file");
+
+  size_t numMapped = 0;
+  for (uint64_t i = 0, e = R.read<uint64_t>(); i < e; i++) {
+    auto name = R.readString();
+    auto elemKind = static_cast<ElemKind>(R.read<uint64_t>());
+    auto scale = R.read<float>();
+    auto offset = R.read<int32_t>();
+    std::vector<size_t> dims(R.read<uint64_t>());
+    for (auto &d : dims) {
+      d = R.read<uint64_t>();
+    }
+    auto dataOffset = R.read<uint64_t>();
+    auto dataSize = R.read<uint64_t>();
+    GLOW_ASSERT(dataOffset <= fileSize && dataSize <= fileSize - dataOffset &&
+                "Truncated weights file");
+
+    // The constants that the module does not have any more, for example
+    // because the optimizer removed them, are skipped.
+    auto *V = M_.getVariableByName(name);
+    if (!V || !isConstantWeight(V)) {
+      continue;
+    }
+    auto ty = V->getType();
+    GLOW_ASSERT(elemKind == ty->getElementType() &&
+                llvm::ArrayRef<size_t>(dims) == ty->dims() &&
+                (!ty->isQuantizedType() ||
+                 (scale == ty->getScale() && offset == ty->getOffset())) &&
+                dataSize == ty->getSizeInBytes() &&
+                "Mismatch on the type of a mapped constant");
+    V->getPayload() = Tensor(base + dataOffset, V->getType());
+    numMapped++;
+  }
+  mappedWeights_.push_back(std::move(region));
+
+  // Unmap the files that earlier calls mapped and that no payload uses any
+  // more, because this call mapped all of their constants again.
+  auto isUnused = [&](const llvm::sys::fs::mapped_file_region &MR) {
+    const char *begin = MR.const_data();
+    const char *end = begin + MR.size();
+    for (auto *V : M_.getVars()) {
+      const char *ptr = V->getPayload().getUnsafePtr();
+      if (ptr >= begin && ptr < end) {
+        return false;
+      }
+    }
+    return true;
+  };
+  mappedWeights_.erase(
+      std::remove_if(mappedWeights_.begin(), mappedWeights_.end(),
+                     [&](const std::unique_ptr<
+                         llvm::sys::fs::mapped_file_region> &MR) {
+                       return isUnused(*MR);
+                     }),
+      mappedWeights_.end());
+
+  // The compiled code may reference the old payloads.
+  function_.reset();
+  cache_.clear();
+  return numMapped;
 }
 
 void ExecutionEngine::save(CompilationMode mode, Function *F,
@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/ExecutionEngine/RequestBatcher.h"
+#include "glow/Graph/Nodes.h"
+
+#include <cstring>
+
+using namespace glow;
+
+RequestBatcher::RequestBatcher(ExecutionEngine &EE, Context &ctx,
+                               llvm::ArrayRef<Placeholder *> inputs,
+                               llvm::ArrayRef<Placeholder *> outputs,
+                               size_t maxBatchSize,
+                               std::chrono::microseconds maxDelay)
+    : EE_(EE), ctx_(ctx), inputs_(inputs.begin(), inputs.end()),
+      outputs_(outputs.begin(), outputs.end()), maxBatchSize_(maxBatchSize),
+      maxDelay_(maxDelay) {
+  assert(!inputs_.empty() && !outputs_.empty() && "No inputs or outputs");
+  size_t batchDim = inputs_[0]->dims()[0];
+  for (auto *P : inputs_) {
+    (void)P;
+    assert(ctx_.get(P) && "The input is not bound by the context");
+    assert(P->dims()[0] == batchDim && "Mismatch on the batch dimension");
+  }
+  for (auto *P : outputs_) {
+    (void)P;
+    assert(ctx_.get(P) && "The output is not bound by the context");
+    assert(P->dims()[0] == batchDim && "Mismatch on the batch dimension");
+  }
+  if (maxBatchSize_ == 0) {
+    maxBatchSize_ = batchDim;
+  }
+  assert(maxBatchSize_ <= batchDim && "The batch does not fit the inputs");
+
+  worker_ = std::thread([this] { loop(); });
+}
+
+RequestBatcher::~RequestBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  worker_.join();
+}
+
+std::future<RequestBatcher::Result>
+RequestBatcher::submit(std::vector<Tensor> &&inputs) {
+  assert(inputs.size() == inputs_.size() &&
+         "The number of inputs does not match the number of placeholders");
+  Request request;
+  request.inputs = std::move(inputs);
+  request.arrival = std::chrono::steady_clock::now();
+  auto result = request.result.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(!stop_ && "Submitting a request to a stopped batcher");
+    queue_.push_back(std::move(request));
+  }
+  cond_.notify_one();
+  return result;
+}
+
+void RequestBatcher::loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      // The batcher stopped and all requests were run.
+      return;
+    }
+
+    // Wait for the batch to fill up, but not longer than the oldest request
+    // may wait. Once the batcher stops the pending requests run right away.
+    auto deadline = queue_.front().arrival + maxDelay_;
+    cond_.wait_until(lock, deadline, [this] {
+      return stop_ || queue_.size() >= maxBatchSize_;
+    });
+
+    size_t batchSize = std::min(queue_.size(), maxBatchSize_);
+    std::vector<Request> batch;
+    batch.reserve(batchSize);
+    for (size_t i = 0; i < batchSize; i++) {
+      batch.push_back(std::move(queue_.front()));
+      queue_.pop_front();
+    }
+
+    // New requests may be queued while the batch runs.
+    lock.unlock();
+    runBatch(batch);
+    lock.lock();
+  }
+}
+
+void RequestBatcher::runBatch(std::vector<Request> &batch) {
+  // Copy the requests into consecutive slices of the inputs. The slices past
+  // the last request keep their old content, and their results are dropped.
+  for (size_t i = 0, e = inputs_.size(); i < e; i++) {
+    Tensor *T = ctx_.get(inputs_[i]);
+    size_t sliceSize = T->getType().getSizeInBytes() / T->dims()[0];
+    for (size_t j = 0, n = batch.size(); j < n; j++) {
+      const Tensor &in = batch[j].inputs[i];
+      assert(in.dims()[0] == 1 && in.dims().slice(1) == T->dims().slice(1) &&
+             in.getElementType() == T->getElementType() &&
+             "Mismatch on the shape of the request");
+      std::memcpy(T->getUnsafePtr() + j * sliceSize, in.getUnsafePtr(),
+                  sliceSize);
+    }
+  }
+
+  EE_.run();
+  numBatches_++;
+  numRequests_ += batch.size();
+
+  // Hand the slices of the outputs back to the requests.
+  for (size_t j = 0, n = batch.size(); j < n; j++) {
+    Result result;
+    result.reserve(outputs_.size());
+    for (auto *P : outputs_) {
+      Tensor *T = ctx_.get(P);
+      std::vector<size_t> sliceDims(T->dims().begin(), T->dims().end());
+      std::vector<size_t> offsets(sliceDims.size(), 0);
+      sliceDims[0] = 1;
+      offsets[0] = j;
+      result.push_back(T->getUnowned(sliceDims, offsets).clone());
+    }
+    batch[j].result.set_value(std::move(result));
+  }
+}
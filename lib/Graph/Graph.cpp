@@ -22,11 +22,16 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace glow;
@@ -381,6 +386,13 @@ Variable *Module::createVariable(llvm::StringRef name, const Tensor &tensor,
   return V;
 }
 
+Variable *Module::createVariable(llvm::StringRef name, Tensor &&tensor,
+                                 VisibilityKind visibility, bool trainable) {
+  auto FT = uniqueType(tensor.getType());
+  return addVar(
+      new Variable(name, FT, visibility, trainable, std::move(tensor)));
+}
+
 llvm::StringRef Module::uniqueName(llvm::StringRef name,
                                    llvm::StringSet<> &stringTable) {
   std::string legalName;
@@ -1323,6 +1335,155 @@ Function::createSparseLengthsWeightedSum(llvm::StringRef name, NodeValue data,
                                                   indices, lengths));
 }
 
+RowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createRowwiseQuantizedSparseLengthsWeightedSum(
+    llvm::StringRef name, NodeValue data, NodeValue scales, NodeValue offsets,
+    NodeValue weights, NodeValue indices, NodeValue lengths) {
+  auto inDims = data.dims();
+  ShapeVector outDims(inDims.begin(), inDims.end());
+  outDims[0] = lengths.dims()[0];
+  auto outTy = getParent()->uniqueType(ElemKind::FloatTy, outDims);
+  return addNode(new RowwiseQuantizedSparseLengthsWeightedSumNode(
+      name, outTy, data, scales, offsets, weights, indices, lengths));
+}
+
+RowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createRowwiseQuantizedSparseLengthsWeightedSum(llvm::StringRef name,
+                                                         Tensor &data,
+                                                         NodeValue weights,
+                                                         NodeValue indices,
+                                                         NodeValue lengths) {
+  assert(data.getElementType() == ElemKind::FloatTy && "Data must be float");
+  auto *M = getParent();
+  size_t rows = data.dims()[0];
+  size_t lineSize = data.size() / rows;
+  auto *dataQ = M->createVariable(ElemKind::Int8QTy, data.dims(), 1.0, 0,
+                                  name.str() + ".data",
+                                  VisibilityKind::Private, false);
+  auto *scales = M->createVariable(ElemKind::FloatTy, {rows},
+                                   name.str() + ".scales",
+                                   VisibilityKind::Private, false);
+  auto *offsets = M->createVariable(ElemKind::FloatTy, {rows},
+                                    name.str() + ".offsets",
+                                    VisibilityKind::Private, false);
+
+  auto DH = data.getHandle<float>();
+  auto QH = dataQ->getHandle<int8_t>();
+  auto SH = scales->getHandle<float>();
+  auto OH = offsets->getHandle<float>();
+  for (size_t i = 0; i < rows; i++) {
+    // Map the range [min, max] of the row to the int8 range [-128, 127].
+    float min = DH.raw(i * lineSize);
+    float max = min;
+    for (size_t j = 0; j < lineSize; j++) {
+      min = std::min(min, DH.raw(i * lineSize + j));
+      max = std::max(max, DH.raw(i * lineSize + j));
+    }
+    float scale = (max - min) / 255;
+    if (scale == 0) {
+      // All the elements of the row are the same.
+      scale = 1;
+    }
+    float offset = min + 128 * scale;
+    SH.raw(i) = scale;
+    OH.raw(i) = offset;
+    for (size_t j = 0; j < lineSize; j++) {
+      float q = std::round((DH.raw(i * lineSize + j) - offset) / scale);
+      QH.raw(i * lineSize + j) = std::max(-128.0f, std::min(q, 127.0f));
+    }
+  }
+
+  return createRowwiseQuantizedSparseLengthsWeightedSum(
+      name, dataQ, scales, offsets, weights, indices, lengths);
+}
+
+RowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createRowwiseQuantizedSparseLengthsSum(llvm::StringRef name,
+                                                 Tensor &data,
+                                                 NodeValue indices,
+                                                 NodeValue lengths) {
+  auto ty = getParent()->uniqueType(ElemKind::FloatTy, {indices.dims()[0]});
+  auto ones = createSplat(name.str() + ".ones", ty, 1.0);
+  return createRowwiseQuantizedSparseLengthsWeightedSum(name, data, ones,
+                                                        indices, lengths);
+}
+
+FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+    llvm::StringRef name, NodeValue data, NodeValue weights, NodeValue indices,
+    NodeValue lengths) {
+  // The scale and the offset at the end of each row are not part of the
+  // result.
+  auto outTy = getParent()->uniqueType(
+      ElemKind::FloatTy,
+      {lengths.dims()[0], data.dims()[1] - 2 * sizeof(float)});
+  return addNode(new FusedRowwiseQuantizedSparseLengthsWeightedSumNode(
+      name, outTy, data, weights, indices, lengths));
+}
+
+FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+    llvm::StringRef name, Tensor &data, NodeValue weights, NodeValue indices,
+    NodeValue lengths) {
+  assert(data.getElementType() == ElemKind::FloatTy && "Data must be float");
+  assert(data.dims().size() == 2 && "Data must be 2D");
+  size_t rows = data.dims()[0];
+  size_t lineSize = data.dims()[1];
+  size_t fusedLineSize = lineSize + 2 * sizeof(float);
+  auto *dataQ = getParent()->createVariable(
+      ElemKind::UInt8FusedQTy, {rows, fusedLineSize}, name.str() + ".data",
+      VisibilityKind::Private, false);
+
+  auto DH = data.getHandle<float>();
+  auto QH = dataQ->getHandle<uint8_t>();
+  for (size_t i = 0; i < rows; i++) {
+    // Map the range [min, max] of the row to the uint8 range [0, 255].
+    float min = DH.at({i, 0});
+    float max = min;
+    for (size_t j = 0; j < lineSize; j++) {
+      min = std::min(min, DH.at({i, j}));
+      max = std::max(max, DH.at({i, j}));
+    }
+    float scale = (max - min) / 255;
+    if (scale == 0) {
+      // All the elements of the row are the same.
+      scale = 1;
+    }
+    for (size_t j = 0; j < lineSize; j++) {
+      float q = std::round((DH.at({i, j}) - min) / scale);
+      QH.at({i, j}) = std::max(0.0f, std::min(q, 255.0f));
+    }
+    uint8_t *rowEnd = &QH.at({i, lineSize});
+    memcpy(rowEnd, &scale, sizeof(float));
+    memcpy(rowEnd + sizeof(float), &min, sizeof(float));
+  }
+
+  return createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      name, dataQ, weights, indices, lengths);
+}
+
+FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createFusedRowwiseQuantizedSparseLengthsSum(llvm::StringRef name,
+                                                      NodeValue data,
+                                                      NodeValue indices,
+                                                      NodeValue lengths) {
+  auto ty = getParent()->uniqueType(ElemKind::FloatTy, {indices.dims()[0]});
+  auto ones = createSplat(name.str() + ".ones", ty, 1.0);
+  return createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      name, data, ones, indices, lengths);
+}
+
+FusedRowwiseQuantizedSparseLengthsWeightedSumNode *
+Function::createFusedRowwiseQuantizedSparseLengthsSum(llvm::StringRef name,
+                                                      Tensor &data,
+                                                      NodeValue indices,
+                                                      NodeValue lengths) {
+  auto ty = getParent()->uniqueType(ElemKind::FloatTy, {indices.dims()[0]});
+  auto ones = createSplat(name.str() + ".ones", ty, 1.0);
+  return createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      name, data, ones, indices, lengths);
+}
+
 SaveNode *Function::createSave(llvm::StringRef name, NodeValue input) {
   auto *dest = getParent()->createVariable(input.getType(), name,
                                            VisibilityKind::Public, false);
@@ -2413,6 +2574,67 @@ void Function::createLSTM(Context &ctx, llvm::StringRef namePrefix,
     outputs.push_back(O);
   }
 };
+
+std::string
+Function::getStructuralHash(std::vector<const Storage *> *storage) const {
+  // Identify the nodes by their position in the list of nodes and the storage
+  // by the order in which it is first used, instead of by their addresses.
+  std::unordered_map<const Node *, size_t> ids;
+  for (auto &N : nodes_) {
+    size_t id = ids.size();
+    ids[&N] = id;
+  }
+
+  llvm::SHA1 hasher;
+  auto addOperand = [&](const NodeValue &NV) {
+    const Node *N = NV.getNode();
+    auto it = ids.find(N);
+    if (it != ids.end()) {
+      updateDigest(hasher, uint64_t(it->second));
+      updateDigest(hasher, uint64_t(NV.getResNo()));
+      return;
+    }
+
+    // The first use of the storage adds its description.
+    size_t id = ids.size();
+    ids[N] = id;
+    auto *S = cast<Storage>(N);
+    if (storage) {
+      storage->push_back(S);
+    }
+    updateDigest(hasher, uint64_t(id));
+    S->updateMembersDigest(hasher);
+    updateDigest(hasher, S->getType());
+    // The private variables that are not trained are constants, which the
+    // optimizer and the backends may fold into the code. Their content is
+    // added even if it is a mapped weights file, so that the digest does not
+    // depend on where the file is mapped.
+    auto *V = dyn_cast<Variable>(S);
+    if (V && V->getVisibilityKind() == VisibilityKind::Private &&
+        !V->isTraining()) {
+      auto &payload = V->getPayload();
+      hasher.update(llvm::ArrayRef<uint8_t>(
+          reinterpret_cast<const uint8_t *>(payload.getUnsafePtr()),
+          payload.getType().getSizeInBytes()));
+    }
+  };
+
+  updateDigest(hasher, uint64_t(nodes_.size()));
+  for (auto &N : nodes_) {
+    N.updateMembersDigest(hasher);
+    for (unsigned i = 0, e = N.getNumResults(); i < e; i++) {
+      updateDigest(hasher, N.getType(i));
+    }
+    for (unsigned i = 0, e = N.getNumInputs(); i < e; i++) {
+      addOperand(N.getNthInput(i));
+    }
+    if (N.hasPredicate()) {
+      addOperand(N.getPredicate());
+    }
+  }
+  return llvm::toHex(hasher.final());
+}
+
 //===----------------------------------------------------------------------===//
 //                   Graph dumping and printing
 //===----------------------------------------------------------------------===//
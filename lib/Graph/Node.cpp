@@ -175,6 +175,17 @@ public:
 
 llvm::hash_code Node::getHash() const { return HashNodeVisitor().visit(this); }
 
+void Node::updateMembersDigest(llvm::SHA1 &hasher) const {
+  switch (getKind()) {
+#define DEF_NODE(CLASS, NAME)                                                  \
+  case glow::Kinded::Kind::CLASS##Kind:                                        \
+    return static_cast<const CLASS *>(this)->updateMembersDigest(hasher);
+#include "glow/AutoGenNodes.def"
+  default:
+    llvm_unreachable("Unhandled node");
+  }
+}
+
 void Node::visit(Node *parent, NodeWalker *visitor) {
   if (hasPredicate()) {
     getPredicate().getNode()->visit(this, visitor);
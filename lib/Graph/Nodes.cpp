@@ -33,6 +33,17 @@ llvm::hash_code Variable::getHash() const {
 llvm::hash_code Placeholder::getHash() const {
   return llvm::hash_combine(getName());
 }
+
+void Variable::updateMembersDigest(llvm::SHA1 &hasher) const {
+  updateDigest(hasher, uint64_t(getKind()));
+  updateDigest(hasher, uint64_t(isTraining()));
+  updateDigest(hasher, uint64_t(getVisibilityKind()));
+}
+
+void Placeholder::updateMembersDigest(llvm::SHA1 &hasher) const {
+  updateDigest(hasher, uint64_t(getKind()));
+  updateDigest(hasher, uint64_t(isTraining()));
+}
 //===----------------------------------------------------------------------===//
 //                        Visitor methods
 //===----------------------------------------------------------------------===//
@@ -582,6 +593,58 @@ void SparseLengthsWeightedSumNode::verify() const {
          "Weights and Indices must have the same size");
 }
 
+void RowwiseQuantizedSparseLengthsWeightedSumNode::verify() const {
+  assert(getResult().getElementType() == ElemKind::FloatTy &&
+         "Result must be float");
+  assert(getData().getElementType() == ElemKind::Int8QTy &&
+         "Data must be quantized");
+  assert(getScales().getElementType() == ElemKind::FloatTy &&
+         "Scales must be float");
+  assert(getOffsets().getElementType() == ElemKind::FloatTy &&
+         "Offsets must be float");
+  assert(getWeights().getElementType() == ElemKind::FloatTy &&
+         "Weights must be float");
+  assert(getIndices().getElementType() == ElemKind::Int64ITy &&
+         "Indices must have index type");
+  assert(getLengths().getElementType() == ElemKind::Int64ITy &&
+         "Lengths must have index type");
+  assert(getIndices().dims().size() == 1 && "Indices must be 1D vector");
+  assert(getLengths().dims().size() == 1 && "Lengths must be 1D vector");
+  assert(getWeights().dims().size() == 1 && "Weights must be 1D vector");
+  assert(getWeights().dims()[0] == getIndices().dims()[0] &&
+         "Weights and Indices must have the same size");
+  assert(getScales().dims().size() == 1 &&
+         getScales().dims()[0] == getData().dims()[0] &&
+         "There must be one scale per row of Data");
+  assert(getOffsets().dims() == getScales().dims() &&
+         "There must be one offset per row of Data");
+}
+
+void FusedRowwiseQuantizedSparseLengthsWeightedSumNode::verify() const {
+  assert(getResult().getElementType() == ElemKind::FloatTy &&
+         "Result must be float");
+  assert(getData().getElementType() == ElemKind::UInt8FusedQTy &&
+         "Data must be fused row-wise quantized");
+  assert(getWeights().getElementType() == ElemKind::FloatTy &&
+         "Weights must be float");
+  assert(getIndices().getElementType() == ElemKind::Int64ITy &&
+         "Indices must have index type");
+  assert(getLengths().getElementType() == ElemKind::Int64ITy &&
+         "Lengths must have index type");
+  assert(getIndices().dims().size() == 1 && "Indices must be 1D vector");
+  assert(getLengths().dims().size() == 1 && "Lengths must be 1D vector");
+  assert(getWeights().dims().size() == 1 && "Weights must be 1D vector");
+  assert(getWeights().dims()[0] == getIndices().dims()[0] &&
+         "Weights and Indices must have the same size");
+  assert(getData().dims().size() == 2 && "Data must be 2D");
+  assert(getData().dims()[1] > 2 * sizeof(float) &&
+         "The rows of Data must hold the scale and the offset");
+  assert(getResult().dims().size() == 2 &&
+         getResult().dims()[0] == getLengths().dims()[0] &&
+         getResult().dims()[1] == getData().dims()[1] - 2 * sizeof(float) &&
+         "Invalid result shape");
+}
+
 void SGDNode::verify() const {
   assert(getGradient().getType() == getWeight().getType() &&
          "Invalid weight or gradient type");
@@ -795,6 +858,51 @@ llvm::hash_code hash_value(const glow::Type *T) {
   return llvm::hash_value((void *)(T));
 }
 
+void updateDigest(llvm::SHA1 &hasher, uint64_t value) {
+  hasher.update(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(&value), sizeof(value)));
+}
+
+void updateDigest(llvm::SHA1 &hasher, float value) {
+  updateDigest(hasher, uint64_t(toBinary(value)));
+}
+
+void updateDigest(llvm::SHA1 &hasher, llvm::StringRef value) {
+  // The length separates the string from the values that follow it.
+  updateDigest(hasher, uint64_t(value.size()));
+  hasher.update(value);
+}
+
+void updateDigest(llvm::SHA1 &hasher, llvm::ArrayRef<float> values) {
+  updateDigest(hasher, uint64_t(values.size()));
+  for (float v : values) {
+    updateDigest(hasher, v);
+  }
+}
+
+void updateDigest(llvm::SHA1 &hasher, llvm::ArrayRef<unsigned_t> values) {
+  updateDigest(hasher, uint64_t(values.size()));
+  for (auto v : values) {
+    updateDigest(hasher, uint64_t(v));
+  }
+}
+
+void updateDigest(llvm::SHA1 &hasher, llvm::ArrayRef<size_t> values) {
+  updateDigest(hasher, uint64_t(values.size()));
+  for (auto v : values) {
+    updateDigest(hasher, uint64_t(v));
+  }
+}
+
+void updateDigest(llvm::SHA1 &hasher, const glow::Type *T) {
+  updateDigest(hasher, uint64_t(T->getElementType()));
+  updateDigest(hasher, T->dims());
+  if (T->isQuantizedType()) {
+    updateDigest(hasher, T->getScale());
+    updateDigest(hasher, uint64_t(uint32_t(T->getOffset())));
+  }
+}
+
 llvm::hash_code hash_value(glow::Node *N) { return N->getHash(); }
 
 llvm::hash_code hash_value(const glow::NodeValue &NV) {
@@ -28,6 +28,7 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -418,6 +419,27 @@ void caffe2ModelLoader::loadOperator(const caffe2::OperatorDef &op) {
     return;
   }
 
+  if (typeName == "SparseLengthsSumFused8BitRowwise") {
+    auto in0 = getNodeValueOrCreateVariableByName(op.input(0));
+    auto in1 = getNodeValueOrCreateVariableByName(op.input(1));
+    auto in2 = getNodeValueOrCreateVariableByName(op.input(2));
+    auto *node =
+        G_.createFusedRowwiseQuantizedSparseLengthsSum(opName, in0, in1, in2);
+    addNodeAsOutput(op, node);
+    return;
+  }
+
+  if (typeName == "SparseLengthsWeightedSumFused8BitRowwise") {
+    auto in0 = getNodeValueOrCreateVariableByName(op.input(0));
+    auto in1 = getNodeValueOrCreateVariableByName(op.input(1));
+    auto in2 = getNodeValueOrCreateVariableByName(op.input(2));
+    auto in3 = getNodeValueOrCreateVariableByName(op.input(3));
+    auto *node = G_.createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+        opName, in0, in1, in2, in3);
+    addNodeAsOutput(op, node);
+    return;
+  }
+
   if (typeName == "ExpandDims") {
     auto in = getNodeValueOrCreateVariableByName(op.input(0));
     auto dims = getShape(dict["dims"]);
@@ -637,6 +659,42 @@ void caffe2ModelLoader::loadWeight(const caffe2::OperatorDef &op) {
     return;
   }
 
+  // Load tensors of bytes. Caffe2 uses them for fused 8-bit row-wise
+  // quantized embedding tables, whose rows end with the float scale and offset
+  // of the row, so they are loaded as UInt8FusedQTy.
+  if (typeName == "GivenTensorByteStringToUInt8Fill") {
+    /*
+     output: "data"
+     name: ""
+     type: "GivenTensorByteStringToUInt8Fill"
+     arg {
+     name: "shape"
+     ints: 3
+     ints: 10
+     }
+     arg {
+     name: "values"
+     s: "\000\002\000\000\000?\000\000\200?..."
+     }
+     */
+
+    auto *T = new Tensor();
+    for (auto &o : op.output()) {
+      tensors_[o] = T;
+    }
+
+    auto dim = getShape(dict["shape"]);
+    assert(dim.size() == 2 && "Fused row-wise quantized data must be 2D");
+    T->reset(ElemKind::UInt8FusedQTy, dim);
+
+    const std::string &values = dict["values"]->s();
+    assert(values.size() == T->size() &&
+           "The number of serialized values does not match the size of the "
+           "tensor.");
+    memcpy(T->getUnsafePtr(), values.data(), values.size());
+    return;
+  }
+
   // Load tensors with constant fill:
   if (typeName == "ConstantFill") {
     /*
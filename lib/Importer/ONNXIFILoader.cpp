@@ -16,28 +16,29 @@
 
 #include "glow/Importer/ONNXIFILoader.h"
 
+#include "glow/Support/Memory.h"
+
 #include "onnx/onnx.pb.h"
 
 namespace glow {
 namespace onnxifi {
 
-/// Creates tensor \p T from the input \p in. Note, there is no data associated
-/// with the Tensor. This method makes sure that the tensor is created with the
-/// proper shape and element type.
-static void setTensorType(const ONNX_NAMESPACE::TypeProto &in, Tensor *T) {
+/// \returns the type of the tensor described by the input \p in. Note, there
+/// is no data associated with the type. This method makes sure that the type is
+/// created with the proper shape and element type.
+static Type getTensorType(const ONNX_NAMESPACE::TypeProto &in) {
   std::vector<size_t> dim;
   for (auto d : in.tensor_type().shape().dim()) {
     dim.push_back(d.dim_value());
   }
 
   if (in.tensor_type().elem_type() == ONNX_NAMESPACE::TensorProto::FLOAT) {
-    T->reset(ElemKind::FloatTy, dim);
-  } else if (in.tensor_type().elem_type() ==
-             ONNX_NAMESPACE::TensorProto::INT64) {
-    T->reset(ElemKind::Int64ITy, dim);
-  } else {
-    assert(false && "Only float and index tensors are supported");
+    return Type(ElemKind::FloatTy, dim);
+  }
+  if (in.tensor_type().elem_type() == ONNX_NAMESPACE::TensorProto::INT64) {
+    return Type(ElemKind::Int64ITy, dim);
   }
+  llvm_unreachable("Only float and index tensors are supported");
 }
 
 void ModelLoader::loadInputs(ONNX_NAMESPACE::GraphProto &net) {
@@ -47,15 +48,18 @@ void ModelLoader::loadInputs(ONNX_NAMESPACE::GraphProto &net) {
       continue;
     }
 
-    Tensor *T = new Tensor();
-    setTensorType(in.type(), T);
-    auto *var =
-        createAndRememberVariable(in.name(), *T, VisibilityKind::Public);
-    onnxNameToInputVars_.try_emplace(in.name(), var);
+    assert(!hasNodeByName(in.name()) && "Creating an already existing node?!");
+    Type ty = getTensorType(in.type());
+    auto *PH = G_.getParent()->createPlaceholder(&ty, in.name(),
+                                                 /* isTrainable */ false);
+    nodeValueByName_[in.name()] = NodeValue(PH, 0);
+    onnxNameToInputPlaceholders_.try_emplace(in.name(), PH);
   }
 }
 
-/// Loads tensor \p T from the input \p in.
+/// Loads tensor \p T from the input \p in. The tensor references the memory of
+/// \p in if it is aligned like the buffers of the owned tensors, and holds a
+/// copy of it otherwise.
 static bool loadWeight(const onnxTensorDescriptorV1 &in, Tensor *T) {
   // Only support CPU memory tensors.
   if (in.memoryType != ONNXIFI_MEMORY_TYPE_CPU) {
@@ -67,29 +71,33 @@ static bool loadWeight(const onnxTensorDescriptorV1 &in, Tensor *T) {
     dims.push_back(in.shape[i]);
   }
 
+  ElemKind kind;
   if (in.dataType == ONNXIFI_DATATYPE_FLOAT32) {
-    T->reset(ElemKind::FloatTy, dims);
-
-    auto TH = T->getHandle<>();
-    float *data = (float *)in.buffer;
-    for (size_t i = 0; i < TH.size(); ++i) {
-      TH.raw(i) = data[i];
-    }
+    kind = ElemKind::FloatTy;
   } else if (in.dataType == ONNXIFI_DATATYPE_UINT64 ||
              in.dataType == ONNXIFI_DATATYPE_INT64) {
-    const bool inDataSigned = in.dataType == ONNXIFI_DATATYPE_INT64;
-    (void)inDataSigned;
-    T->reset(ElemKind::Int64ITy, dims);
+    kind = ElemKind::Int64ITy;
+  } else {
+    llvm_unreachable("Only float and index tensors are supported");
+  }
+
+  Type ty(kind, dims);
+  Tensor unowned(reinterpret_cast<void *>(in.buffer), &ty);
 
-    auto TH = T->getHandle<int64_t>();
-    int64_t *data = (int64_t *)in.buffer;
+#ifndef NDEBUG
+  if (in.dataType == ONNXIFI_DATATYPE_UINT64) {
+    auto TH = unowned.getHandle<int64_t>();
     for (size_t i = 0; i < TH.size(); ++i) {
-      assert((inDataSigned || data[i] >= 0) &&
+      assert(TH.raw(i) >= 0 &&
              "Disallow overflow of loaded UINT64 data into Int64ITy.");
-      TH.raw(i) = data[i];
     }
+  }
+#endif
+
+  if (in.buffer % TensorAlignment == 0) {
+    *T = std::move(unowned);
   } else {
-    llvm_unreachable("Only float and index tensors are supported");
+    T->assign(&unowned);
   }
 
   return true;
@@ -110,6 +118,23 @@ bool ModelLoader::loadWeights(uint32_t weightsCount,
   return true;
 }
 
+bool ModelLoader::setOutputPlaceholders(ONNX_NAMESPACE::GraphProto &net) {
+  if (net.output_size() == 0) {
+    return false;
+  }
+
+  for (int i = 0; i < net.output_size(); i++) {
+    const auto &outputName = net.output(i).name();
+    auto r = getNodeValueByName(outputName);
+    auto *PH = G_.getParent()->createPlaceholder(r.getType(), outputName,
+                                                 /* isTrainable */ false);
+    G_.createSave("save_" + outputName, r, PH);
+    onnxNameToOutputPlaceholders_[outputName] = PH;
+  }
+
+  return true;
+}
+
 std::unique_ptr<ModelLoader> ModelLoader::parse(
     const void *onnxModel, uint32_t onnxModelSize, uint32_t weightsCount,
     const onnxTensorDescriptorV1 *weightDescriptors, Function &F) {
@@ -131,7 +156,7 @@ std::unique_ptr<ModelLoader> ModelLoader::parse(
     return nullptr;
   }
 
-  if (!loader->setOutputNodes(graphDef)) {
+  if (!loader->setOutputPlaceholders(graphDef)) {
     return nullptr;
   }
 
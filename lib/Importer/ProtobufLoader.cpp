@@ -65,8 +65,18 @@ Variable *ProtobufLoader::createAndRememberVariable(
   assert(!hasNodeByName(name) && "Creating an already existing node?!");
   // Note: We do not support training from models loaded from protos, so
   // trainable is always set to false here.
-  Variable *node = G_.getParent()->createVariable(name, tensor, visibilityKind,
-                                                  /* trainable */ false);
+  Variable *node;
+  if (tensor.isUnowned()) {
+    // Unowned tensors reference memory whose lifetime the creator of the
+    // loader guarantees, so the variable references it too instead of copying
+    // it.
+    node = G_.getParent()->createVariable(
+        name, tensor.getUnowned(tensor.dims()), visibilityKind,
+        /* trainable */ false);
+  } else {
+    node = G_.getParent()->createVariable(name, tensor, visibilityKind,
+                                          /* trainable */ false);
+  }
   nodeValueByName_[name] = NodeValue(node, 0);
 
   return node;
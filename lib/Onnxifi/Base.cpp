@@ -17,13 +17,13 @@
 
 #include "glow/Importer/ONNXIFILoader.h"
 
-#include "llvm/ADT/SmallVector.h"
+#include <cstring>
 
 namespace glow {
 namespace onnxifi {
 
 bool BackendId::isOpSupported(Kinded::Kind opKind, ElemKind elementTy) {
-  return executionEngine_.isOpSupported(opKind, elementTy);
+  return glowBackend_->isOpSupported(opKind, elementTy);
 }
 
 bool Event::signal() {
@@ -43,11 +43,15 @@ void Event::wait() {
   cond_.wait(guard, [this] { return fired_ == true; });
 }
 
+Graph::~Graph() {
+  std::unique_lock<std::mutex> guard(inFlightMutex_);
+  inFlightDone_.wait(guard, [this] { return numInFlightRuns_ == 0; });
+}
+
 onnxStatus Graph::initGraph(const void *onnxModel, size_t onnxModelSize,
                             uint32_t weightCount,
                             const onnxTensorDescriptorV1 *weightDescriptors) {
-  // TODO: support multiple functions here.
-  function_ = backendPtr_->getEE().getModule().createFunction("inference");
+  function_ = executionEngine_.getModule().createFunction("inference");
 
   std::unique_ptr<ModelLoader> loader = ModelLoader::parse(
       onnxModel, onnxModelSize, weightCount, weightDescriptors, *function_);
@@ -56,48 +60,126 @@ onnxStatus Graph::initGraph(const void *onnxModel, size_t onnxModelSize,
     return ONNXIFI_STATUS_INTERNAL_ERROR;
   }
 
-  onnxNameToInputVar_ = loader->getInputVarsMapping();
-  onnxNameToOutputNode_ = loader->getOutputVarsMapping();
+  onnxNameToInputPH_ = loader->getInputPlaceholdersMapping();
+  onnxNameToOutputPH_ = loader->getOutputPlaceholdersMapping();
 
-  // Emit IR for the graph and compile it.
-  backendPtr_->getEE().compile(CompilationMode::Infer, function_, ctx_);
+  // Back the placeholders with owned tensors until the caller binds its
+  // memory to them. The function is compiled by the first run, when the
+  // addresses of the inputs and outputs are known.
+  for (auto &input : onnxNameToInputPH_) {
+    ctx_.allocate(input.second);
+  }
+  for (auto &output : onnxNameToOutputPH_) {
+    ctx_.allocate(output.second);
+  }
 
   return ONNXIFI_STATUS_SUCCESS;
 }
 
-onnxStatus Graph::run() {
-  // Copy tensors from the input addresses to the Glow tensors.
-  llvm::SmallVector<Tensor *, 4> tensors;
-  llvm::SmallVector<Variable *, 4> vars;
-  for (auto inputVar : inputVarToBuffer_) {
-    auto *var = inputVar.first;
-    auto *type = var->getType();
-    void *inputBuffer = reinterpret_cast<void *>(inputVar.second);
-    tensors.push_back(new Tensor(inputBuffer, type));
-    vars.push_back(var);
-  }
+Graph::IOBindings Graph::getIOBindings() {
+  std::lock_guard<std::mutex> guard(ioMutex_);
+  return ioBindings_;
+}
 
-  // Run inference.
-  auto &EE = backendPtr_->getEE();
-  updateVariables(vars, tensors);
-  EE.run();
+onnxStatus Graph::run() { return run(getIOBindings()); }
+
+onnxStatus Graph::run(const IOBindings &bindings) {
+  // The runs of the graph are serialized, and the runs of different graphs
+  // proceed in parallel.
+  std::lock_guard<std::mutex> guard(runMutex_);
+  for (const auto &binding : bindings) {
+    bindBuffer(binding.first, binding.second);
+  }
 
-  // Copy outputs to the addresses specified in the outputNodeToBuffer_.
-  for (auto outputVar : outputNodeToBuffer_) {
-    void *outputAddress = reinterpret_cast<void *>(outputVar.second);
-    const Tensor &res = outputVar.first->getPayload();
+  if (!compiled_) {
+    std::lock_guard<std::mutex> compileGuard(backendPtr_->getCompileMutex());
+    executionEngine_.compile(CompilationMode::Infer, function_, ctx_);
+    compiled_ = true;
+  }
 
-    memcpy(outputAddress, res.getUnsafePtr(),
-           res.size() * res.getType().getElementSize());
+  // Run inference. The inputs are read from and the outputs are written to
+  // the memory of the caller directly, unless they are copied.
+  for (auto &input : onnxNameToInputPH_) {
+    auto it = copiedBuffers_.find(input.second);
+    if (it != copiedBuffers_.end()) {
+      Tensor *T = ctx_.get(input.second);
+      memcpy(T->getUnsafePtr(), it->second, T->getType().getSizeInBytes());
+    }
+  }
+  executionEngine_.run();
+  for (auto &output : onnxNameToOutputPH_) {
+    auto it = copiedBuffers_.find(output.second);
+    if (it != copiedBuffers_.end()) {
+      Tensor *T = ctx_.get(output.second);
+      memcpy(it->second, T->getUnsafePtr(), T->getType().getSizeInBytes());
+    }
   }
 
   return ONNXIFI_STATUS_SUCCESS;
 }
 
+void Graph::runAsync(EventPtr inputEvent, EventPtr outputEvent) {
+  {
+    std::lock_guard<std::mutex> guard(inFlightMutex_);
+    numInFlightRuns_++;
+  }
+
+  // Use the memory that is set now, even if setIO changes it before the run
+  // starts.
+  IOBindings bindings = getIOBindings();
+  backendPtr_->getExecutor().submit([this, inputEvent, outputEvent,
+                                     bindings] {
+    // Wait for all inputs to be ready.
+    inputEvent->wait();
+
+    run(bindings);
+
+    outputEvent->signal();
+
+    // Release the graph only after the last use of its members, because
+    // onnxReleaseGraph may delete it as soon as the count drops to zero.
+    std::lock_guard<std::mutex> guard(inFlightMutex_);
+    if (--numInFlightRuns_ == 0) {
+      inFlightDone_.notify_all();
+    }
+  });
+}
+
+void Graph::bindBuffer(Placeholder *PH, void *address) {
+  auto it = copiedBuffers_.find(PH);
+  if (it != copiedBuffers_.end()) {
+    it->second = address;
+    return;
+  }
+
+  Tensor *T = ctx_.get(PH);
+  if (!T->isUnowned()) {
+    // Bind the first memory of the caller directly.
+    *T = Tensor(address, PH->getType());
+    compiled_ = false;
+    return;
+  }
+  if (T->getUnsafePtr() == address) {
+    return;
+  }
+
+  // The caller moved the placeholder to new memory. The old memory may be
+  // freed already, and recompiling for every new address costs much more
+  // than a copy, so the placeholder is backed by memory of the graph from
+  // now on and its data is copied.
+  *T = Tensor(PH->getType());
+  copiedBuffers_[PH] = address;
+  compiled_ = false;
+}
+
 onnxStatus Graph::setIO(uint32_t inputsCount,
                         const onnxTensorDescriptorV1 *inputDescriptors,
                         uint32_t outputsCount,
                         const onnxTensorDescriptorV1 *outputDescriptors) {
+  // The runs that are already enqueued keep the memory they were enqueued
+  // with. The new memory is bound by the runs that follow.
+  IOBindings bindings;
+
   // Process inputs.
   for (unsigned i = 0; i < inputsCount; ++i) {
     const auto &in = inputDescriptors[i];
@@ -106,24 +188,28 @@ onnxStatus Graph::setIO(uint32_t inputsCount,
     // The issue needs to be fixed on the caller side first. Once it is fixed
     // we'd need to handle missing variable accordingly here, e.g., return
     // ONNXIFI_STATUS_UNIDENTIFIED_NAME.
-    if (!onnxNameToInputVar_.count(in.name)) {
+    if (!onnxNameToInputPH_.count(in.name)) {
       continue;
     }
 
-    auto *input = onnxNameToInputVar_[in.name];
-    inputVarToBuffer_.insert({input, in.buffer});
+    bindings[onnxNameToInputPH_[in.name]] = reinterpret_cast<void *>(in.buffer);
   }
 
   // Process outputs.
   for (unsigned i = 0; i < outputsCount; ++i) {
     const auto &out = outputDescriptors[i];
 
-    if (!onnxNameToOutputNode_.count(out.name)) {
+    if (!onnxNameToOutputPH_.count(out.name)) {
       return ONNXIFI_STATUS_UNIDENTIFIED_NAME;
     }
 
-    auto *output = onnxNameToOutputNode_[out.name];
-    outputNodeToBuffer_.insert({output, out.buffer});
+    bindings[onnxNameToOutputPH_[out.name]] =
+        reinterpret_cast<void *>(out.buffer);
+  }
+
+  std::lock_guard<std::mutex> guard(ioMutex_);
+  for (const auto &binding : bindings) {
+    ioBindings_[binding.first] = binding.second;
   }
 
   return ONNXIFI_STATUS_SUCCESS;
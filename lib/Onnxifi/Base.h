@@ -16,8 +16,10 @@
 #ifndef GLOW_ONNXIFI_BASE_H
 #define GLOW_ONNXIFI_BASE_H
 
+#include "glow/Backends/Backend.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
 #include "glow/Importer/ONNXIFILoader.h"
+#include "glow/Support/ThreadPool.h"
 
 #include "onnx/onnxifi.h"
 
@@ -37,17 +39,31 @@ public:
   /// Create Glow ONNXIFI backend identifier with the
   /// given Glow backend \p kind and \p id.
   explicit BackendId(glow::BackendKind kind, int id)
-      : id_(id), executionEngine_(kind) {}
+      : id_(id), kind_(kind), glowBackend_(createBackend(kind)) {}
 
   /// Verify that given operation kind is supported by the backend.
   bool isOpSupported(Kinded::Kind opKind, ElemKind elementTy);
 
-  /// \returns Execution Engine associated with the Backend.
-  glow::ExecutionEngine &getEE() { return executionEngine_; }
+  /// \returns the kind of the Glow backend that compiles the graphs.
+  glow::BackendKind getBackendKind() const { return kind_; }
+
+  /// \returns the executor that runs the inference requests of all the graphs
+  /// of the backend.
+  ThreadPool &getExecutor() { return executor_; }
+
+  /// \returns the mutex that serializes the compilations of the graphs of the
+  /// backend, which may use code generators that are not thread-safe.
+  std::mutex &getCompileMutex() { return compileMutex_; }
 
 private:
   int id_;
-  glow::ExecutionEngine executionEngine_;
+  glow::BackendKind kind_;
+  /// The Glow backend that answers the queries about supported operations.
+  std::unique_ptr<glow::Backend> glowBackend_;
+  std::mutex compileMutex_;
+  /// The worker pool is declared last so that it is destroyed first, which
+  /// waits for the queued runs while the rest of the backend is still alive.
+  ThreadPool executor_;
 };
 
 typedef BackendId *BackendIdPtr;
@@ -56,8 +72,17 @@ class Backend {
 public:
   explicit Backend(BackendIdPtr backendId) : backendIdPtr_(backendId) {}
 
-  /// \returns Execution Engine associated with the Backend.
-  glow::ExecutionEngine &getEE() { return backendIdPtr_->getEE(); }
+  /// \returns the kind of the Glow backend that compiles the graphs.
+  glow::BackendKind getBackendKind() const {
+    return backendIdPtr_->getBackendKind();
+  }
+
+  /// \returns the executor of the backend.
+  ThreadPool &getExecutor() { return backendIdPtr_->getExecutor(); }
+
+  /// \returns the mutex that serializes the compilations of the graphs of the
+  /// backend.
+  std::mutex &getCompileMutex() { return backendIdPtr_->getCompileMutex(); }
 
 private:
   BackendIdPtr backendIdPtr_;
@@ -87,7 +112,12 @@ typedef Event *EventPtr;
 
 class Graph {
 public:
-  explicit Graph(BackendPtr backendPtr) : backendPtr_(backendPtr) {}
+  explicit Graph(BackendPtr backendPtr)
+      : backendPtr_(backendPtr),
+        executionEngine_(backendPtr->getBackendKind()) {}
+
+  /// Waits for the in-flight runs of the graph to complete.
+  ~Graph();
 
   BackendPtr backend() { return backendPtr_; }
 
@@ -106,32 +136,76 @@ public:
                    uint32_t outputsCount,
                    const onnxTensorDescriptorV1 *outputDescriptors);
 
-  /// Run inference.
+  /// Run inference with the inputs and outputs set by the last call of setIO.
   onnxStatus run();
 
+  /// Enqueue an inference request on the executor of the backend and return
+  /// immediately. The request runs once \p inputEvent is signalled, and
+  /// signals \p outputEvent when it completes. It uses the inputs and outputs
+  /// that are set when it is enqueued, even if setIO is called before it runs.
+  void runAsync(EventPtr inputEvent, EventPtr outputEvent);
+
 private:
+  /// Maps the input and output placeholders to the memory of the caller.
+  using IOBindings = llvm::DenseMap<Placeholder *, void *>;
+
   BackendPtr backendPtr_;
+
+  /// The Execution Engine that holds the module and the compiled function of
+  /// the graph. Every graph has its own, so that the graphs of a backend stay
+  /// compiled side by side and run concurrently.
+  glow::ExecutionEngine executionEngine_;
   Function *function_;
 
-  /// This is the compilation context that represents a single thread.
-  /// TODO: Once we finish the migration to placeholders we'll need to manage
-  /// the state properly.
+  /// Serializes the runs of the graph, which share the memory of the compiled
+  /// function.
+  std::mutex runMutex_;
+
+  /// The memory set by the last call of setIO, which is protected by
+  /// ioMutex_. Every run takes a snapshot of it.
+  IOBindings ioBindings_;
+  std::mutex ioMutex_;
+
+  /// The number of runs of the graph that were enqueued and did not complete
+  /// yet, which is protected by inFlightMutex_.
+  size_t numInFlightRuns_{0};
+  std::mutex inFlightMutex_;
+  /// Signalled when numInFlightRuns_ drops to zero.
+  std::condition_variable inFlightDone_;
+
+  /// The tensors that back the input and output placeholders of the graph.
+  /// Once a run binds the memory of the caller, they are unowned tensors that
+  /// reference it, so that the run reads its inputs from and writes its
+  /// outputs to that memory directly.
   Context ctx_;
 
-  /// Mapping between ONNX name for the input variable and Glow variable.
-  llvm::StringMap<Variable *> onnxNameToInputVar_;
+  /// Whether the function was compiled for the current tensors of ctx_. The
+  /// backends resolve the addresses of the placeholders at compile time, so
+  /// binding new memory to a placeholder requires a new compilation.
+  bool compiled_{false};
+
+  /// Maps the placeholders whose memory the caller changed after binding it
+  /// to the current memory of the caller. Such placeholders keep stable
+  /// tensors owned by ctx_, and every run copies the inputs into them and the
+  /// outputs out of them, so that new memory does not require a compilation.
+  IOBindings copiedBuffers_;
+
+  /// Mapping between ONNX name for the input variable and Glow placeholder.
+  llvm::StringMap<Placeholder *> onnxNameToInputPH_;
+
+  /// Mapping between ONNX name for the output variable and Glow placeholder.
+  llvm::StringMap<Placeholder *> onnxNameToOutputPH_;
 
-  /// Mapping between ONNX name for the output variable and Glow output
-  /// node.
-  llvm::StringMap<Variable *> onnxNameToOutputNode_;
+  /// \returns a snapshot of the memory set by the last call of setIO.
+  IOBindings getIOBindings();
 
-  /// Mapping between input var and the actual memory address.
-  /// Inputs will be read from these addresses.
-  llvm::DenseMap<Variable *, onnxPointer> inputVarToBuffer_;
+  /// Run inference with the inputs and outputs in the memory \p bindings.
+  onnxStatus run(const IOBindings &bindings);
 
-  /// Mapping between output var and the actual memory address.
-  /// Results must be written to these addresses.
-  llvm::DenseMap<Variable *, onnxPointer> outputNodeToBuffer_;
+  /// Use the memory at \p address for \p PH. The first memory bound to \p PH
+  /// backs its tensor directly, and the data of the memory bound later is
+  /// copied.
+  void bindBuffer(Placeholder *PH, void *address);
 };
 
 typedef Graph *GraphPtr;
@@ -277,7 +277,9 @@ onnxReleaseEvent(onnxEvent event) {
   return ONNXIFI_STATUS_SUCCESS;
 }
 
-/// Parse an ONNXIFI graph and convert it for a particular backend.
+/// Parse an ONNXIFI graph and convert it for a particular backend. The graph
+/// references the memory of the suitably aligned weight descriptors instead of
+/// copying it, so the memory must stay valid until the graph is released.
 ONNXIFI_PUBLIC ONNXIFI_CHECK_RESULT onnxStatus ONNXIFI_ABI onnxInitGraph(
     onnxBackend backend, const uint64_t *auxPropertiesList,
     size_t onnxModelSize, const void *onnxModel, uint32_t weightsCount,
@@ -374,30 +376,26 @@ onnxRunGraph(onnxGraph graph, const onnxMemoryFenceV1 *inputFence,
     return ONNXIFI_STATUS_UNSUPPORTED_TAG;
   }
 
+  auto *inputEvent = static_cast<glow::onnxifi::EventPtr>(inputFence->event);
+  if (!inputEvent) {
+    return ONNXIFI_STATUS_INVALID_EVENT;
+  }
+
   auto initStatus = onnxInitEvent(glowGraph->backend(), &outputFence->event);
   if (initStatus != ONNXIFI_STATUS_SUCCESS) {
     return initStatus;
   }
 
-  // Wait for all inputs to be ready.
-  auto waitStatus = onnxWaitEvent(inputFence->event);
-  if (waitStatus != ONNXIFI_STATUS_SUCCESS) {
-    return waitStatus;
-  }
-
-  // TODO: Implement async graph run procedure. For now run that sync.
-  glowGraph->run();
-
-  auto signalStatus = onnxSignalEvent(outputFence->event);
-  if (signalStatus != ONNXIFI_STATUS_SUCCESS) {
-    return signalStatus;
-  }
+  // The run waits for the input fence and signals the output fence on a
+  // worker of the backend, so the caller can enqueue other runs meanwhile.
+  glowGraph->runAsync(
+      inputEvent, static_cast<glow::onnxifi::EventPtr>(outputFence->event));
 
   return ONNXIFI_STATUS_SUCCESS;
 }
 
 /// Deinitialize an ONNXIFI graph and release associated resources.
-/// It blocks until all in-flight inference operations complete.
+/// It blocks until all in-flight inference operations of the graph complete.
 ONNXIFI_PUBLIC ONNXIFI_CHECK_RESULT onnxStatus ONNXIFI_ABI
 onnxReleaseGraph(onnxGraph graph) {
   auto *glowGraph = static_cast<glow::onnxifi::GraphPtr>(graph);
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include "glow/Backends/Backend.h"
+#include "glow/Backends/CompiledFunction.h"
+#include "glow/Graph/Context.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Node.h"
 #include "glow/Graph/Nodes.h"
@@ -33,6 +36,11 @@ llvm::cl::opt<unsigned> constVarDedupSizeOpt(
     llvm::cl::desc(
         "Max number of elements allowed for deduplicating constant variables"),
     llvm::cl::Optional, llvm::cl::init(256), llvm::cl::cat(graphOptCat));
+llvm::cl::opt<unsigned> constFoldMaxSizeOpt(
+    "const_fold_max_size",
+    llvm::cl::desc(
+        "Max number of elements of a variable created by constant folding"),
+    llvm::cl::Optional, llvm::cl::init(1 << 20), llvm::cl::cat(graphOptCat));
 
 using namespace glow;
 using llvm::cast;
@@ -821,6 +829,14 @@ static Variable *getUniquelyUsedVariable(Node &node) {
   return dyn_cast<Variable>(&node);
 }
 
+/// Replace the payload of \p V with a copy if it is an unowned tensor, which
+/// references memory that must not be modified.
+static void makePayloadOwned(Variable *V) {
+  if (V->getPayload().isUnowned()) {
+    V->getPayload() = V->getPayload().clone();
+  }
+}
+
 static void optimizeBatchNorm(Function *F) {
   auto &nodes = F->getNodes();
 
@@ -885,6 +901,11 @@ static void optimizeBatchNorm(Function *F) {
       Variable *meanV = cast<Variable>(BN->getMean());
       Variable *var = cast<Variable>(BN->getVar());
 
+      // The payloads are updated in place below, so take a copy of the
+      // payloads that only reference memory owned by someone else.
+      makePayloadOwned(filterV);
+      makePayloadOwned(cbiasV);
+
       auto filterH = filterV->getHandle<>();
 
       auto cbiasH = cbiasV->getHandle<>();
@@ -1407,6 +1428,231 @@ static void CSE(Function *F) {
   }
 }
 
+/// \returns true if the kind of \p N is one that constant folding may evaluate
+/// with the backend \p B. Nodes with side effects, gradient nodes and
+/// backend-specific nodes are never folded.
+static bool isFoldableKind(const Node *N, const Backend &B) {
+  switch (N->getKind()) {
+  case Kinded::Kind::ConvolutionNodeKind:
+  case Kinded::Kind::MaxPoolNodeKind:
+  case Kinded::Kind::AvgPoolNodeKind:
+  case Kinded::Kind::FullyConnectedNodeKind:
+  case Kinded::Kind::BatchNormalizationNodeKind:
+  case Kinded::Kind::AddNodeKind:
+  case Kinded::Kind::MulNodeKind:
+  case Kinded::Kind::SubNodeKind:
+  case Kinded::Kind::DivNodeKind:
+  case Kinded::Kind::MaxNodeKind:
+  case Kinded::Kind::MinNodeKind:
+  case Kinded::Kind::CmpLTENodeKind:
+  case Kinded::Kind::CmpEQNodeKind:
+  case Kinded::Kind::PowNodeKind:
+  case Kinded::Kind::LogNodeKind:
+  case Kinded::Kind::SelectNodeKind:
+  case Kinded::Kind::BatchedAddNodeKind:
+  case Kinded::Kind::MatMulNodeKind:
+  case Kinded::Kind::BatchedReduceAddNodeKind:
+  case Kinded::Kind::ReluNodeKind:
+  case Kinded::Kind::SigmoidNodeKind:
+  case Kinded::Kind::TanhNodeKind:
+  case Kinded::Kind::ReshapeNodeKind:
+  case Kinded::Kind::TransposeNodeKind:
+  case Kinded::Kind::ConcatNodeKind:
+  case Kinded::Kind::SliceNodeKind:
+  case Kinded::Kind::InsertTensorNodeKind:
+  case Kinded::Kind::GatherNodeKind:
+  case Kinded::Kind::TileNodeKind:
+  case Kinded::Kind::IntLookupTableNodeKind:
+  case Kinded::Kind::QuantizeNodeKind:
+  case Kinded::Kind::DequantizeNodeKind:
+  case Kinded::Kind::RescaleQuantizedNodeKind:
+  case Kinded::Kind::TopKNodeKind:
+    break;
+  default:
+    return false;
+  }
+
+  for (unsigned i = 0, e = N->getNumResults(); i < e; i++) {
+    if (!B.isOpSupported(N->getKind(), N->getNthResult(i).getElementType())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \returns true if \p N computes a constant. Private variables that are not
+/// trainable and have no writers are constants, and so are splats. Other nodes
+/// are constants if they can be folded by the backend \p B, all of their
+/// inputs are constants and none of their results has more than
+/// constFoldMaxSizeOpt elements. The answers are memoized in \p constants.
+static bool isConstantNode(Node *N, const Backend &B,
+                           std::unordered_map<Node *, bool> &constants) {
+  auto it = constants.find(N);
+  if (it != constants.end()) {
+    return it->second;
+  }
+
+  bool isConst = false;
+  if (auto *V = dyn_cast<Variable>(N)) {
+    isConst = V->isPrivate() && !V->isTraining() && !hasWriters(V);
+  } else if (isa<SplatNode>(N)) {
+    isConst = !N->hasPredicate();
+  } else if (!N->hasPredicate() && isFoldableKind(N, B)) {
+    isConst = true;
+    for (unsigned i = 0, e = N->getNumResults(); i < e && isConst; i++) {
+      isConst = N->getNthResult(i).getType()->size() <= constFoldMaxSizeOpt;
+    }
+    for (unsigned i = 0, e = N->getNumInputs(); i < e && isConst; i++) {
+      isConst = isConstantNode(N->getNthInput(i).getNode(), B, constants);
+    }
+  }
+
+  constants[N] = isConst;
+  return isConst;
+}
+
+/// Clones the constant node \p N and the constant nodes that it depends on
+/// into \p F. Variables are shared and not cloned. \p clones maps the nodes
+/// that were already cloned to their clones. \returns the clone of \p N.
+static Node *cloneConstantNode(Function *F, Node *N,
+                               std::unordered_map<Node *, Node *> &clones) {
+  if (isa<Variable>(N)) {
+    return N;
+  }
+  auto it = clones.find(N);
+  if (it != clones.end()) {
+    return it->second;
+  }
+
+  Node *copy = F->addNode(N->clone());
+  for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+    NodeValue input = N->getNthInput(i);
+    Node *inputCopy = cloneConstantNode(F, input.getNode(), clones);
+    copy->setNthInput(i, NodeValue(inputCopy, input.getResNo()));
+  }
+  clones[N] = copy;
+  return copy;
+}
+
+/// Folding must not turn small constants into much larger ones, such as the
+/// outer product of two vectors or a tiled vector. The results of a folded
+/// subgraph may have at most this many times the elements of its inputs.
+static constexpr size_t maxConstantFoldGrowth = 2;
+
+/// \returns the number of elements of the inputs of the constant subgraph
+/// rooted at \p N, where a splat counts as a single element. \p visited holds
+/// the nodes that were already counted.
+static size_t getConstantInputSize(Node *N,
+                                   std::unordered_set<Node *> &visited) {
+  if (!visited.insert(N).second) {
+    return 0;
+  }
+  if (auto *V = dyn_cast<Variable>(N)) {
+    return V->getType()->size();
+  }
+  if (isa<SplatNode>(N)) {
+    return 1;
+  }
+  size_t size = 0;
+  for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+    size += getConstantInputSize(N->getNthInput(i).getNode(), visited);
+  }
+  return size;
+}
+
+/// \returns true if replacing the used results of the constant node \p N by
+/// variables grows the constants by at most maxConstantFoldGrowth.
+static bool isFoldWithinGrowth(Node *N) {
+  size_t resultSize = 0;
+  for (unsigned i = 0, e = N->getNumResults(); i < e; i++) {
+    NodeValue result = N->getNthResult(i);
+    if (result.getNumUsers()) {
+      resultSize += result.getType()->size();
+    }
+  }
+  std::unordered_set<Node *> visited;
+  return resultSize <= maxConstantFoldGrowth * getConstantInputSize(N, visited);
+}
+
+/// Constant folding. Finds the maximal subgraphs of \p F that only depend on
+/// constant variables, evaluates them once with the backend \p B and replaces
+/// their results by new constant variables. A subgraph whose results are much
+/// larger than its inputs is not folded, but its constant subgraphs may be.
+static void constantFold(Function *F, const Backend &B) {
+  std::unordered_map<Node *, bool> constants;
+
+  // The roots of the maximal constant subgraphs are the constant nodes that
+  // have a non-constant user. Variables are already constants, and splats are
+  // left alone because they are cheaper than a variable that holds the same
+  // value.
+  std::vector<Node *> worklist;
+  for (auto &N : F->getNodes()) {
+    if (isa<SplatNode>(&N) || !isConstantNode(&N, B, constants)) {
+      continue;
+    }
+    for (auto &U : N.getUsers()) {
+      if (!isConstantNode(U.getUser(), B, constants)) {
+        worklist.push_back(&N);
+        break;
+      }
+    }
+  }
+
+  // The roots that would grow the constants too much are not folded. The
+  // subgraphs of their inputs are tried instead.
+  std::vector<Node *> roots;
+  std::unordered_set<Node *> visited;
+  while (!worklist.empty()) {
+    Node *N = worklist.back();
+    worklist.pop_back();
+    if (isa<Variable>(N) || isa<SplatNode>(N) || !visited.insert(N).second) {
+      continue;
+    }
+    if (isFoldWithinGrowth(N)) {
+      roots.push_back(N);
+      continue;
+    }
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      worklist.push_back(N->getNthInput(i).getNode());
+    }
+  }
+
+  if (roots.empty()) {
+    return;
+  }
+
+  // Copy the constant subgraphs into a temporary function that saves the
+  // results of the roots into new constant variables.
+  Module *M = F->getParent();
+  Function *foldF = M->createFunction(F->getName().str() + "_constant_fold");
+  std::unordered_map<Node *, Node *> clones;
+  std::vector<std::pair<NodeValue, Variable *>> folded;
+  for (auto *N : roots) {
+    Node *copy = cloneConstantNode(foldF, N, clones);
+    for (unsigned i = 0, e = N->getNumResults(); i < e; i++) {
+      NodeValue result = N->getNthResult(i);
+      if (!result.getNumUsers()) {
+        continue;
+      }
+      auto *V = M->createVariable(result.getType(), N->getName(),
+                                  VisibilityKind::Private, false);
+      foldF->createSave(N->getName(), NodeValue(copy, i), V);
+      folded.emplace_back(result, V);
+    }
+  }
+
+  // Evaluate the constant subgraphs.
+  ::glow::lower(foldF, B);
+  B.compile(foldF, Context())->execute();
+  M->eraseFunction(foldF);
+
+  // The results of the roots are now stored in the new variables. The nodes
+  // that computed them are left to DCE.
+  for (auto &P : folded) {
+    P.first.replaceAllUsesOfWith(P.second);
+  }
+}
+
 /// Eliminate SliceNode when the input is SplatNode.
 /// Slice(Splat(args)) -> Splat(args')
 static void optimizeSliceOfSplat(Function *F) {
@@ -1859,7 +2105,7 @@ static bool sinkRescaleQuantizedNode(Function *F) {
   return changed;
 }
 
-void glow::optimize(Function *F, CompilationMode mode) {
+void glow::optimize(Function *F, CompilationMode mode, const Backend *B) {
   // Sink transpose operations in an attempt to cancel them out.
   // Perform code sinking until a fixed-point is reached.
   // On big functions, the number of iterations until the fixpoint
@@ -1890,6 +2136,11 @@ void glow::optimize(Function *F, CompilationMode mode) {
 
     // Constant-fold transpose operations.
     optimizeTranspose(F);
+
+    // Evaluate the subgraphs that only depend on constants.
+    if (B) {
+      constantFold(F, *B);
+    }
   }
 
   // Perform Common Subexpression Elimination.
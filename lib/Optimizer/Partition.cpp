@@ -17,13 +17,19 @@
 #include "glow/Optimizer/Partition.h"
 
 #include "glow/Graph/Graph.h"
+#include "glow/Graph/Nodes.h"
 #include "glow/Graph/Utils.h"
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/Casting.h"
 
+#include <algorithm>
+
 using namespace glow;
+using llvm::dyn_cast;
 using llvm::isa;
 
 namespace {
@@ -56,6 +62,13 @@ public:
   /// \returns the number of partitions.
   Map::size_type size() const { return functions_.size(); }
 
+  /// Replace the list of partitions with \p functions, which must contain the
+  /// same partitions in a different order.
+  void reorder(FunctionList functions) {
+    assert(functions.size() == functions_.size() && "Lost a partition");
+    functions_ = std::move(functions);
+  }
+
   /// Map API.
   Map::iterator find(Node *N) { return nodeToFunction_.find(N); }
   Map::iterator begin() { return nodeToFunction_.begin(); }
@@ -63,20 +76,31 @@ public:
   Function *operator[](Node *n) { return nodeToFunction_[n]; }
 };
 
-/// If \p node has a single input that is not a variable, return it.  Otherwise
-/// return nullptr.
-Node *singleNonVariableInput(Node *node) {
-  Node *nonVarInput = nullptr;
+/// If \p node has a single input that is not a variable or placeholder, return
+/// it.  Otherwise return nullptr.
+Node *singleNonStorageInput(Node *node) {
+  Node *nonStorageInput = nullptr;
 
   for (unsigned i = 0, e = node->getNumInputs(); i < e; i++) {
     Node *in = node->getNthInput(i).getNode();
-    if (isa<Variable>(in))
+    if (isa<Storage>(in))
       continue;
-    if (nonVarInput)
+    if (nonStorageInput)
       return nullptr;
-    nonVarInput = in;
+    nonStorageInput = in;
   }
-  return nonVarInput;
+  return nonStorageInput;
+}
+
+/// \returns a new, empty partition of \p F with index \p idx. If \p F was
+/// partitioned before, the index is bumped until the name is unique.
+Function *createPartition(Function *F, size_t idx) {
+  auto *mod = F->getParent();
+  std::string name;
+  do {
+    name = std::string(F->getName()) + "_part" + std::to_string(idx++);
+  } while (mod->hasFunction(name));
+  return mod->createFunction(name);
 }
 
 /// Assign nodes to partitions and return the mapping.  This algorithm
@@ -90,12 +114,12 @@ NodeFunctionMap selectBasicBlockPartitions(Function *F) {
   // assigned to a partition before it is assigned.
   GraphPostOrderVisitor visitor(*F);
   for (auto *node : visitor.getPostOrder()) {
-    if (isa<Variable>(node))
+    if (isa<Storage>(node))
       continue;
 
     // If node has only one input, and that input has only one output, place it
     // in the same partition.
-    auto *in = singleNonVariableInput(node);
+    auto *in = singleNonStorageInput(node);
     if (in && in->getNumUsers() == 1) {
       auto it = mapping.find(in);
       assert(it != mapping.end());
@@ -104,14 +128,199 @@ NodeFunctionMap selectBasicBlockPartitions(Function *F) {
     }
 
     // Start a new partition with this node.
-    auto *newF = F->getParent()->createFunction(
-        std::string(F->getName()) + "_part" + std::to_string(mapping.size()));
-    mapping.create(node, newF);
+    mapping.create(node, createPartition(F, mapping.size()));
   }
 
   return mapping;
 }
 
+/// The state of a partition that is being grown by the cost-model partitioner.
+struct PartitionState {
+  /// The estimated cost of the nodes in the partition.
+  uint64_t cost{0};
+  /// The estimated memory used by the partition, in bytes.
+  uint64_t memory{0};
+  /// The variables and placeholders that the partition reads or writes.
+  llvm::DenseSet<Node *> storage;
+  /// The partitions that this partition directly depends on.
+  llvm::SetVector<Function *> dependencies;
+};
+
+using PartitionStateMap = llvm::DenseMap<Function *, PartitionState>;
+
+/// \returns the number of bytes that adding \p node to the partition \p P
+/// would add to its memory usage: the results of the node, and the variables
+/// and placeholders that the partition does not already use.
+uint64_t getAddedMemory(Node *node, const PartitionState &P) {
+  uint64_t bytes = 0;
+  for (unsigned i = 0, e = node->getNumResults(); i < e; i++) {
+    bytes += node->getType(i)->getSizeInBytes();
+  }
+  for (unsigned i = 0, e = node->getNumInputs(); i < e; i++) {
+    auto input = node->getNthInput(i);
+    if (isa<Storage>(input.getNode()) && !P.storage.count(input.getNode())) {
+      bytes += input.getType()->getSizeInBytes();
+    }
+  }
+  return bytes;
+}
+
+/// \returns true if partition \p from transitively depends on partition \p to.
+bool dependsOn(const PartitionStateMap &partitions, Function *from,
+               Function *to) {
+  llvm::DenseSet<Function *> visited;
+  std::vector<Function *> worklist{from};
+  while (!worklist.empty()) {
+    auto *F = worklist.back();
+    worklist.pop_back();
+    if (F == to) {
+      return true;
+    }
+    if (!visited.insert(F).second) {
+      continue;
+    }
+    for (auto *dep : partitions.find(F)->second.dependencies) {
+      worklist.push_back(dep);
+    }
+  }
+  return false;
+}
+
+/// Sort the partitions in \p mapping so that every partition comes after the
+/// partitions that it depends on.
+void sortPartitions(NodeFunctionMap &mapping,
+                    const PartitionStateMap &partitions) {
+  auto deps = [&](Function *F) {
+    const auto &D = partitions.find(F)->second.dependencies;
+    return std::vector<Function *>(D.begin(), D.end());
+  };
+
+  FunctionList order;
+  llvm::DenseSet<Function *> visited;
+  // Post-order DFS over the dependencies. The stack holds each partition on
+  // the current path along with the dependencies that are left to visit.
+  std::vector<std::pair<Function *, std::vector<Function *>>> stack;
+  for (auto *root : mapping.getFunctions()) {
+    if (!visited.insert(root).second) {
+      continue;
+    }
+    stack.emplace_back(root, deps(root));
+    while (!stack.empty()) {
+      auto &top = stack.back();
+      if (top.second.empty()) {
+        order.push_back(top.first);
+        stack.pop_back();
+        continue;
+      }
+      auto *dep = top.second.back();
+      top.second.pop_back();
+      if (visited.insert(dep).second) {
+        stack.emplace_back(dep, deps(dep));
+      }
+    }
+  }
+  mapping.reorder(std::move(order));
+}
+
+/// Assign nodes to partitions using the cost model and return the mapping.
+/// Nodes are visited in post order. Each node joins the partition of one of
+/// its inputs, preferring the partition that produces the most input bytes, as
+/// long as the partition stays close to the target cost and within the memory
+/// budget, and no cycle is formed between partitions. Otherwise the node starts
+/// a new partition.
+NodeFunctionMap selectCostModelPartitions(Function *F,
+                                          const PartitionConfig &config) {
+  GraphPostOrderVisitor visitor(*F);
+  auto postOrder = visitor.getPostOrder();
+
+  // Split the total cost evenly among the requested number of partitions.
+  llvm::DenseMap<Node *, uint64_t> costs;
+  uint64_t totalCost = 0;
+  for (auto *node : postOrder) {
+    if (isa<Storage>(node))
+      continue;
+    costs[node] = estimateCost(node).getTotal();
+    totalCost += costs[node];
+  }
+  uint64_t numPartitions = std::max(1u, config.numPartitions);
+  uint64_t targetCost = (totalCost + numPartitions - 1) / numPartitions;
+
+  NodeFunctionMap mapping;
+  PartitionStateMap partitions;
+  for (auto *node : postOrder) {
+    if (isa<Storage>(node))
+      continue;
+
+    // Collect the partitions that produce the inputs of this node, and the
+    // number of bytes that each of them produces.
+    llvm::MapVector<Function *, uint64_t> inputBytes;
+    for (unsigned i = 0, e = node->getNumInputs(); i < e; i++) {
+      auto input = node->getNthInput(i);
+      if (isa<Storage>(input.getNode()))
+        continue;
+      auto it = mapping.find(input.getNode());
+      assert(it != mapping.end() && "Input was not assigned a partition");
+      inputBytes[it->second] += input.getType()->getSizeInBytes();
+    }
+
+    // Pick the partition that saves the most cross-partition traffic.
+    Function *best = nullptr;
+    uint64_t bestBytes = 0;
+    for (auto &candidate : inputBytes) {
+      auto &P = partitions[candidate.first];
+      // Let the node join if at least half of its cost fits under the target,
+      // so that the partitions end up close to the target on either side. A
+      // save only copies its input, so it always stays with its producer.
+      if (!isa<SaveNode>(node) && P.cost + costs[node] / 2 > targetCost)
+        continue;
+      if (config.memoryBudget &&
+          P.memory + getAddedMemory(node, P) > config.memoryBudget)
+        continue;
+      bool formsCycle = false;
+      for (auto &other : inputBytes) {
+        if (other.first != candidate.first &&
+            dependsOn(partitions, other.first, candidate.first)) {
+          formsCycle = true;
+          break;
+        }
+      }
+      if (formsCycle)
+        continue;
+      if (!best || candidate.second > bestBytes) {
+        best = candidate.first;
+        bestBytes = candidate.second;
+      }
+    }
+
+    if (best) {
+      mapping.add(node, best);
+    } else {
+      best = createPartition(F, mapping.size());
+      mapping.create(node, best);
+    }
+
+    auto &P = partitions[best];
+    P.cost += costs[node];
+    P.memory += getAddedMemory(node, P);
+    for (unsigned i = 0, e = node->getNumInputs(); i < e; i++) {
+      auto *input = node->getNthInput(i).getNode();
+      if (isa<Storage>(input)) {
+        P.storage.insert(input);
+      }
+    }
+    for (auto &input : inputBytes) {
+      if (input.first != best) {
+        P.dependencies.insert(input.first);
+      }
+    }
+  }
+
+  // Nodes may have joined a partition that was created before the partitions
+  // of their other inputs.
+  sortPartitions(mapping, partitions);
+  return mapping;
+}
+
 /// Given a function \p F and partitioning \p mapping, \return a FunctionDAG
 /// that contains appropriately-partitioned functions and their dependences.
 FunctionDAG doPartitioning(Function *F, NodeFunctionMap &mapping) {
@@ -126,14 +335,16 @@ FunctionDAG doPartitioning(Function *F, NodeFunctionMap &mapping) {
     mapping[&N]->addNode(clone);
   }
 
-  // For any dependency that crosses a partition, add a variable and save
-  // node. Record the dependence in the function graph.
-  llvm::DenseMap<Node *, Variable *> variables;
+  // For any dependency that crosses a partition, add a placeholder and save
+  // node. Record the dependence in the function graph. Placeholders are used
+  // rather than variables so that the tensors that carry values between
+  // partitions are bound by the executor and are never treated as constants.
+  llvm::DenseMap<Node *, Placeholder *> placeholders;
   for (auto *F : mapping.getFunctions()) {
     for (auto &N : F->getNodes()) {
       for (unsigned inp = 0, e = N.getNumInputs(); inp < e; inp++) {
         auto input = N.getNthInput(inp);
-        if (isa<Variable>(input.getNode()))
+        if (isa<Storage>(input.getNode()))
           continue;
 
         auto *inputF = mapping[input.getNode()];
@@ -143,32 +354,32 @@ FunctionDAG doPartitioning(Function *F, NodeFunctionMap &mapping) {
         // Add this dependence to the FunctionDAG.
         G.add(F, inputF);
 
-        // If we've already created a variable for this dependence, use it.
-        auto it = variables.find(input.getNode());
-        if (it != variables.end()) {
+        // If we've already created a placeholder for this dependence, use it.
+        auto it = placeholders.find(input.getNode());
+        if (it != placeholders.end()) {
           N.setNthInput(inp, it->second);
           continue;
         }
 
-        // Create a new variable to represent this dependence.
-        auto *tmp = mod->createVariable(
+        // Create a new placeholder to represent this dependence.
+        auto *tmp = mod->createPlaceholder(
             input.getType(), std::string(input.getNode()->getName()) + "_tmp",
-            VisibilityKind::Private, false);
+            false);
         inputF->createSave("tmp", input, tmp);
-        variables[input.getNode()] = tmp;
+        placeholders[input.getNode()] = tmp;
         N.setNthInput(inp, tmp);
       }
     }
   }
 
-  // Update links between nodes in the cloned functions.  Add variables (and
-  // save nodes) where a link crosses a partition boundary.
+  // Update links between nodes in the cloned functions.  Links that cross a
+  // partition boundary already point to placeholders.
   for (auto *F : mapping.getFunctions()) {
     for (auto &N : F->getNodes()) {
       for (unsigned inp = 0, e = N.getNumInputs(); inp < e; inp++) {
         auto input = N.getNthInput(inp);
 
-        if (isa<Variable>(input.getNode()))
+        if (isa<Storage>(input.getNode()))
           continue;
 
         // Link this node to the clone of its input.
@@ -202,8 +413,76 @@ bool FunctionDAG::verify() const {
   return true;
 }
 
-FunctionDAG glow::partition(Function *F) {
-  NodeFunctionMap partitionMap = selectBasicBlockPartitions(F);
+NodeCost glow::estimateCost(Node *N) {
+  NodeCost cost;
+  if (isa<Storage>(N)) {
+    return cost;
+  }
+
+  for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+    cost.bytes += N->getNthInput(i).getType()->getSizeInBytes();
+  }
+  uint64_t outputElems = 0;
+  for (unsigned i = 0, e = N->getNumResults(); i < e; i++) {
+    cost.bytes += N->getType(i)->getSizeInBytes();
+    outputElems += N->getType(i)->size();
+  }
+
+  // Multiply-accumulate kernels perform two operations per element of the
+  // reduction; everything else is approximated by one operation per output
+  // element.
+  if (auto *FC = dyn_cast<FullyConnectedNode>(N)) {
+    cost.flops = 2 * outputElems * FC->getWeights().dims()[0];
+  } else if (auto *MM = dyn_cast<MatMulNode>(N)) {
+    cost.flops = 2 * outputElems * MM->getLHS().dims()[1];
+  } else if (auto *CN = dyn_cast<ConvolutionNode>(N)) {
+    auto filterDims = CN->getFilter().dims();
+    cost.flops = 2 * outputElems * (CN->getFilter().getType()->size() /
+                                    filterDims[0]);
+  } else if (auto *MP = dyn_cast<MaxPoolNode>(N)) {
+    cost.flops = outputElems * MP->getKernels()[0] * MP->getKernels()[1];
+  } else if (auto *AP = dyn_cast<AvgPoolNode>(N)) {
+    cost.flops = outputElems * AP->getKernels()[0] * AP->getKernels()[1];
+  } else {
+    cost.flops = outputElems;
+  }
+  return cost;
+}
+
+NodeCost glow::estimateCost(Function *F) {
+  NodeCost cost;
+  for (auto &N : F->getNodes()) {
+    cost += estimateCost(&N);
+  }
+  return cost;
+}
+
+uint64_t glow::estimateCriticalPath(const FunctionDAG &G) {
+  // The functions are topologically sorted, so the longest path that ends in
+  // each dependency is known before the function itself is visited.
+  llvm::DenseMap<Function *, uint64_t> pathCost;
+  uint64_t criticalPath = 0;
+  for (auto *F : G.getFunctions()) {
+    uint64_t longestInput = 0;
+    for (auto *dep : G.getDependencies(F)) {
+      longestInput = std::max(longestInput, pathCost[dep]);
+    }
+    pathCost[F] = longestInput + estimateCost(F).getTotal();
+    criticalPath = std::max(criticalPath, pathCost[F]);
+  }
+  return criticalPath;
+}
+
+FunctionDAG glow::partition(Function *F, const PartitionConfig &config) {
+  NodeFunctionMap partitionMap;
+  switch (config.kind) {
+  case PartitionKind::BasicBlock:
+    partitionMap = selectBasicBlockPartitions(F);
+    break;
+  case PartitionKind::CostModel:
+    partitionMap = selectCostModelPartitions(F, config);
+    break;
+  }
   auto G = doPartitioning(F, partitionMap);
   assert(G.verify());
   return G;
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <memory>
+
+using namespace glow;
+
+ThreadPool::ThreadPool(unsigned numWorkers) {
+  if (numWorkers == 0) {
+    numWorkers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  workers_.reserve(numWorkers);
+  for (unsigned i = 0; i < numWorkers; i++) {
+    workers_.emplace_back(&ThreadPool::threadMain, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(workQueueMtx_);
+    shouldStop_ = true;
+  }
+  queueNotEmpty_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::threadMain() {
+  for (;;) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(workQueueMtx_);
+      queueNotEmpty_.wait(
+          lock, [this] { return shouldStop_ || !workQueue_.empty(); });
+      // Drain the queue before exiting.
+      if (workQueue_.empty()) {
+        return;
+      }
+      task = std::move(workQueue_.front());
+      workQueue_.pop();
+    }
+    task();
+  }
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> fn) {
+  std::packaged_task<void()> task(std::move(fn));
+  auto future = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(workQueueMtx_);
+    workQueue_.push(std::move(task));
+  }
+  queueNotEmpty_.notify_one();
+  return future;
+}
+
+namespace {
+/// The state shared between the participants of a parallelFor. It is
+/// reference-counted because helper work items may still be sitting in the
+/// queue after the caller has returned.
+struct ParallelForState {
+  ParallelForState(size_t numTasks, const std::function<void(size_t)> &fn)
+      : numTasks(numTasks), fn(fn) {}
+  /// Total number of tasks.
+  const size_t numTasks;
+  /// The body of the loop. Only valid while the caller is waiting.
+  const std::function<void(size_t)> &fn;
+  /// The next task index to be claimed.
+  std::atomic<size_t> next{0};
+  /// The number of tasks that finished.
+  std::atomic<size_t> done{0};
+  std::mutex mtx;
+  std::condition_variable allDone;
+
+  /// Claim and run tasks until none are left.
+  void run() {
+    for (size_t i = next++; i < numTasks; i = next++) {
+      fn(i);
+      if (++done == numTasks) {
+        std::lock_guard<std::mutex> lock(mtx);
+        allDone.notify_all();
+      }
+    }
+  }
+};
+} // namespace
+
+void ThreadPool::parallelFor(size_t numTasks,
+                             const std::function<void(size_t)> &fn) {
+  if (numTasks == 0) {
+    return;
+  }
+  if (numTasks == 1 || workers_.empty()) {
+    for (size_t i = 0; i < numTasks; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>(numTasks, fn);
+  size_t numHelpers = std::min<size_t>(numTasks - 1, workers_.size());
+  for (size_t i = 0; i < numHelpers; i++) {
+    submit([state] { state->run(); });
+  }
+  // The calling thread takes part in the work as well.
+  state->run();
+
+  std::unique_lock<std::mutex> lock(state->mtx);
+  state->allDone.wait(lock,
+                      [&] { return state->done == state->numTasks; });
+}
@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/ExecutionEngine/RequestBatcher.h"
+#include "glow/Graph/Context.h"
+#include "glow/Graph/Graph.h"
+
+using namespace glow;
+
+using Clock = std::chrono::steady_clock;
+
+/// The number of features of the samples and of the hidden layers.
+constexpr size_t numFeatures = 512;
+
+/// The statistics of a run of the benchmark.
+struct Stats {
+  /// The number of requests that completed per second.
+  double throughput;
+  /// The median latency of the requests in milliseconds.
+  double p50;
+  /// The 99th percentile of the latency of the requests in milliseconds.
+  double p99;
+  /// The average number of requests in a batch.
+  double batchSize;
+};
+
+/// Submit \p numRequests requests to \p batcher at the average rate of \p rate
+/// requests per second, with exponentially distributed gaps between the
+/// requests, and measure the latency of every request.
+static Stats measure(RequestBatcher &batcher, double rate, size_t numRequests) {
+  using Pending = std::pair<Clock::time_point,
+                            std::future<RequestBatcher::Result>>;
+  std::deque<Pending> pending;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::vector<double> latencies;
+  Clock::time_point lastDone;
+
+  // Wait for the requests in the order of their submission, which is also
+  // the order in which the batcher completes them.
+  std::thread collector([&] {
+    for (size_t i = 0; i < numRequests; i++) {
+      Pending p;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return !pending.empty(); });
+        p = std::move(pending.front());
+        pending.pop_front();
+      }
+      p.second.get();
+      lastDone = Clock::now();
+      latencies.push_back(
+          std::chrono::duration<double, std::milli>(lastDone - p.first)
+              .count());
+    }
+  });
+
+  std::mt19937 gen;
+  std::exponential_distribution<> gap(rate);
+  size_t startBatches = batcher.getNumBatches();
+  auto start = Clock::now();
+  auto next = start;
+  for (size_t i = 0; i < numRequests; i++) {
+    next += std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(gap(gen)));
+    std::this_thread::sleep_until(next);
+    std::vector<Tensor> inputs;
+    inputs.emplace_back(ElemKind::FloatTy,
+                        llvm::ArrayRef<size_t>{1, numFeatures});
+    auto submitted = Clock::now();
+    auto result = batcher.submit(std::move(inputs));
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending.emplace_back(submitted, std::move(result));
+    }
+    cond.notify_one();
+  }
+  collector.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  Stats stats;
+  stats.throughput =
+      numRequests / std::chrono::duration<double>(lastDone - start).count();
+  stats.p50 = latencies[latencies.size() / 2];
+  stats.p99 = latencies[latencies.size() * 99 / 100];
+  stats.batchSize = double(numRequests) /
+                    double(batcher.getNumBatches() - startBatches);
+  return stats;
+}
+
+/// Measure the throughput and the latency of a three layer perceptron on the
+/// CPU backend, which serves single-sample requests at several arrival rates.
+/// Every rate is measured without batching, and with batches of up to
+/// maxBatch requests that wait at most 1 ms and 5 ms for their batch to fill.
+int main() {
+  constexpr size_t maxBatch = 32;
+  constexpr size_t numRequests = 2000;
+
+  printf("rate req/s, max batch, max delay ms, throughput req/s, avg batch, "
+         "p50 ms, p99 ms\n");
+  for (double rate : {250.0, 1000.0, 4000.0, 16000.0}) {
+    // The maximal batch size and the maximal delay in milliseconds.
+    for (auto config :
+         {std::make_pair(size_t(1), 0), std::make_pair(maxBatch, 1),
+          std::make_pair(maxBatch, 5)}) {
+      ExecutionEngine EE(BackendKind::CPU);
+      auto &mod = EE.getModule();
+      Function *F = mod.createFunction("mlp");
+      auto *input = mod.createPlaceholder(
+          ElemKind::FloatTy, {config.first, numFeatures}, "input", false);
+      Node *O = F->createFullyConnected("fc1", input, numFeatures);
+      O = F->createRELU("relu1", O);
+      O = F->createFullyConnected("fc2", O, numFeatures);
+      O = F->createRELU("relu2", O);
+      O = F->createFullyConnected("fc3", O, 10);
+      Context ctx;
+      auto *save = F->createSave(ctx, "output", O);
+      ctx.allocate(input);
+      ctx.allocate(save->getPlaceholder());
+      EE.compile(CompilationMode::Infer, F, ctx);
+
+      RequestBatcher batcher(EE, ctx, {input}, {save->getPlaceholder()},
+                             config.first,
+                             std::chrono::milliseconds(config.second));
+      Stats s = measure(batcher, rate, numRequests);
+      printf("%10.0lf, %9zu, %12d, %16.0lf, %9.2lf, %6.2lf, %6.2lf\n", rate,
+             config.first, config.second, s.throughput, s.batchSize, s.p50,
+             s.p99);
+    }
+  }
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "CPUBackend.h"
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Graph/Context.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Importer/Caffe2.h"
+
+#include "llvm/Support/FileSystem.h"
+
+using namespace glow;
+
+using Clock = std::chrono::steady_clock;
+
+/// A model of the bundle examples.
+struct Model {
+  /// The name of the model, which is also the directory of its files.
+  const char *name;
+  /// The name of the input of the model.
+  const char *inputName;
+};
+
+/// Measure the time it takes the CPU backend to compile the models of the
+/// bundle examples, with the code split into 1, 2, 4 and 8 parts that are
+/// compiled in parallel. The argument is the directory of the examples
+/// (examples/bundles by default), in which "make download_weights" was run for
+/// the models to measure. The models that were not downloaded are skipped.
+int main(int argc, char **argv) {
+  std::string examplesDir = argc > 1 ? argv[1] : "examples/bundles";
+  const Model models[] = {{"resnet50", "gpu_0/data"},
+                          {"vgg19", "data"},
+                          {"zfnet512", "gpu_0/data"}};
+
+  printf("model, parts, compile s\n");
+  for (const auto &model : models) {
+    std::string dir = examplesDir + "/" + model.name + "/" + model.name;
+    std::string netDesc = dir + "/predict_net.pb";
+    std::string netWeights = dir + "/init_net.pb";
+    if (!llvm::sys::fs::exists(netDesc) || !llvm::sys::fs::exists(netWeights)) {
+      printf("%s, skipped: the model was not downloaded to %s\n", model.name,
+             dir.c_str());
+      continue;
+    }
+
+    for (unsigned numParts : {1, 2, 4, 8}) {
+      // Every measurement uses a new engine, so that the compiled function is
+      // not taken from the cache of the engine.
+      ExecutionEngine EE;
+      auto *backend = new CPUBackend();
+      backend->setNumCodeGenParts(numParts);
+      EE.setBackend(backend);
+      Function *F = EE.getModule().createFunction(model.name);
+      Tensor data(ElemKind::FloatTy, {1, 3, 224, 224});
+      caffe2ModelLoader loader(netDesc, netWeights, {model.inputName}, {&data},
+                               *F);
+
+      Context ctx;
+      auto start = Clock::now();
+      EE.compile(CompilationMode::Infer, F, ctx);
+      double seconds =
+          std::chrono::duration<double>(Clock::now() - start).count();
+      printf("%s, %u, %.2lf\n", model.name, numParts, seconds);
+    }
+  }
+}
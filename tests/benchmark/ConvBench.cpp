@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "Bench.h"
+
+#include "glow/Support/Memory.h"
+
+using namespace glow;
+
+extern "C" {
+// Forward declare functions from libjit.
+extern void libjit_convDKKC8_f(float *outW, const float *inW,
+                               const float *filterW, const float *biasW,
+                               const size_t *outWdims, const size_t *inWdims,
+                               const size_t *filterWdims,
+                               const size_t *biasWdims,
+                               const size_t *kernelSizes,
+                               const size_t *strides, const size_t *pads,
+                               size_t group, unsigned pixelScanFirst,
+                               unsigned numDepthRegs, unsigned sizeGroupY,
+                               unsigned depthStrips);
+extern void libjit_winograd_conv_f(float *outW, const float *inW,
+                                   const float *filterW, const float *biasW,
+                                   const size_t *outWdims,
+                                   const size_t *inWdims,
+                                   const size_t *filterWdims,
+                                   const size_t *pads);
+}
+
+/// Benchmark a 3x3 stride-1 convolution of an N x H x W x C input with D
+/// output channels and a padding of 1. The convolution is computed with the
+/// direct DKKC8 kernel, or with the Winograd kernel F(m x m, 3 x 3) if m is
+/// not zero.
+class ConvBench : public Benchmark {
+  size_t inDims[4];
+  size_t outDims[4];
+  size_t filterDims[5];
+  size_t biasDims[1];
+  size_t m;
+
+  float *in{nullptr};
+  float *out{nullptr};
+  float *filter{nullptr};
+  float *bias{nullptr};
+
+public:
+  ConvBench(size_t n, size_t h, size_t w, size_t c, size_t d, size_t m)
+      : inDims{n, h, w, c}, outDims{n, h, w, d}, biasDims{d}, m(m) {
+    if (m) {
+      filterDims[0] = (m + 2) * (m + 2);
+      filterDims[1] = c;
+      filterDims[2] = d;
+    } else {
+      filterDims[0] = d / 8;
+      filterDims[1] = 3;
+      filterDims[2] = 3;
+      filterDims[3] = c;
+      filterDims[4] = 8;
+    }
+  }
+
+  virtual void setup() override {
+    size_t filterSize = m ? filterDims[0] * filterDims[1] * filterDims[2]
+                          : 9 * inDims[3] * outDims[3];
+    in = allocate(inDims[0] * inDims[1] * inDims[2] * inDims[3]);
+    out = allocate(outDims[0] * outDims[1] * outDims[2] * outDims[3]);
+    filter = allocate(filterSize);
+    bias = allocate(outDims[3]);
+  }
+
+  virtual void run() override {
+    static const size_t kernels[] = {3, 3};
+    static const size_t strides[] = {1, 1};
+    static const size_t pads[] = {1, 1, 1, 1};
+    if (m) {
+      libjit_winograd_conv_f(out, in, filter, bias, outDims, inDims,
+                             filterDims, pads);
+      return;
+    }
+    // Use the parameters that the CPU backend selects for channel counts of
+    // 16 and more.
+    unsigned numDepthRegs = 2;
+    unsigned depthStrips = 1;
+    while (2 * depthStrips * 8 * numDepthRegs * inDims[3] <= 16384 &&
+           2 * depthStrips * numDepthRegs * 8 <= outDims[3] &&
+           depthStrips < 8) {
+      depthStrips *= 2;
+    }
+    libjit_convDKKC8_f(out, in, filter, bias, outDims, inDims, filterDims,
+                       biasDims, kernels, strides, pads, 1, 0, numDepthRegs,
+                       5, depthStrips);
+  }
+
+  virtual void teardown() override {
+    alignedFree(in);
+    alignedFree(out);
+    alignedFree(filter);
+    alignedFree(bias);
+  }
+
+  double gflops() const {
+    return 2.0 * outDims[0] * outDims[1] * outDims[2] * outDims[3] * 9 *
+           inDims[3] / 1e9;
+  }
+
+private:
+  float *allocate(size_t size) {
+    float *p = (float *)alignedAlloc(size * sizeof(float), TensorAlignment);
+    std::mt19937 gen;
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    for (size_t i = 0; i < size; i++) {
+      p[i] = dis(gen);
+    }
+    return p;
+  }
+};
+
+int main() {
+  constexpr int reps = 20;
+  printf("N, H, W, C, D, direct gflops/s, F(2x2) gflops/s, F(4x4) gflops/s\n");
+
+  // The 3x3 convolutions of ResNet-50 and of a few smaller networks.
+  const size_t shapes[][5] = {{1, 56, 56, 64, 64},   {1, 28, 28, 128, 128},
+                              {1, 14, 14, 256, 256}, {1, 7, 7, 512, 512},
+                              {8, 16, 16, 64, 64},   {1, 8, 8, 32, 192}};
+  for (const auto &s : shapes) {
+    double gflops[3];
+    for (size_t m : {0, 2, 4}) {
+      ConvBench b(s[0], s[1], s[2], s[3], s[4], m);
+      gflops[m / 2] = b.gflops() / bench(&b, reps);
+    }
+    // The Winograd numbers are the effective rate, i.e. the number of
+    // operations of the direct convolution divided by the time.
+    printf("%zu, %3zu, %3zu, %4zu, %4zu, %6.2lf, %6.2lf, %6.2lf\n", s[0], s[1],
+           s[2], s[3], s[4], gflops[0], gflops[1], gflops[2]);
+  }
+}
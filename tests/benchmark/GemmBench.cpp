@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <cstdint>
 #include <cstdlib>
 #include <random>
 
@@ -25,6 +26,12 @@ extern "C" {
 extern void libjit_matmul_f(float *c, const float *a, const float *b,
                             const size_t *cDims, const size_t *aDims,
                             const size_t *bDims);
+extern void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW,
+                             const int8_t *rhsW, const size_t *outWdims,
+                             const size_t *lhsWdims, const size_t *rhsWdims,
+                             int32_t outOffset, int32_t lhsOffset,
+                             int32_t rhsOffset, int32_t outPre, int32_t outPost,
+                             int32_t outScale);
 }
 
 /// Benchmark an (m x k) * (k x n) = (m x n) matrix multiplication.
@@ -75,9 +82,55 @@ private:
   }
 };
 
+/// Benchmark an (m x k) * (k x n) = (m x n) int8 matrix multiplication.
+class Int8GemmBench : public Benchmark {
+  /// Matrices.
+  std::vector<int8_t> a;
+  std::vector<int8_t> b;
+  std::vector<int8_t> c;
+
+  /// Dimensions expressed in libjit's format.
+  size_t aDims[2];
+  size_t bDims[2];
+  size_t cDims[2];
+
+public:
+  Int8GemmBench(size_t m, size_t n, size_t k)
+      : aDims{m, k}, bDims{k, n}, cDims{m, n} {}
+
+  virtual void setup() override {
+    size_t m = cDims[0];
+    size_t n = cDims[1];
+    size_t k = aDims[1];
+    a.resize(m * k);
+    b.resize(k * n);
+    c.resize(m * n);
+    randomize(a);
+    randomize(b);
+  }
+
+  virtual void run() override {
+    libjit_matmul_i8(c.data(), a.data(), b.data(), cDims, aDims, bDims, 0, 3,
+                     -2, 2, 15, 200);
+  }
+
+  virtual void teardown() override {}
+
+  double gops() const { return 2.0 * cDims[0] * cDims[1] * aDims[1] / 1e9; }
+
+private:
+  void randomize(std::vector<int8_t> &v) {
+    std::mt19937 gen;
+    std::uniform_int_distribution<> dis(-128, 127);
+    for (auto &e : v) {
+      e = dis(gen);
+    }
+  }
+};
+
 int main() {
   constexpr int reps = 100;
-  printf("outX, outY, lhsX, lhsY, rhsX, rhsY, gflops/s, \n");
+  printf("outX, outY, lhsX, lhsY, rhsX, rhsY, gflops/s, int8 gops/s, \n");
 
   for (int i = 0; i < 2; i++) {
     for (int j = 0; j < 2; j++) {
@@ -92,8 +145,11 @@ int main() {
 
           GemmBench b(m, n, k);
           auto time = bench(&b, reps);
-          printf("%4zu, %-4zu,   %4zu, %-4zu,   %4zu,  %-4zu,   %5.2lf\n", m, n,
-                 m, k, k, n, b.gflops() / time);
+          Int8GemmBench bi8(m, n, k);
+          auto timeI8 = bench(&bi8, reps);
+          printf("%4zu, %-4zu,   %4zu, %-4zu,   %4zu,  %-4zu,   %5.2lf,  "
+                 "%5.2lf\n",
+                 m, n, m, k, k, n, b.gflops() / time, bi8.gops() / timeI8);
         }
       }
     }
@@ -28,6 +28,8 @@
 
 #include "llvm/ADT/STLExtras.h"
 
+#include <algorithm>
+
 using namespace glow;
 using llvm::cast;
 
@@ -650,6 +652,210 @@ TEST_P(CPUOnly, convDKKC8Test) {
   EXPECT_TRUE(out1.isEqual(out2));
 }
 
+TEST_P(CPUOnly, quantizedConvDKKC16Test) {
+  PseudoRNG PRNG;
+  Tensor inputs(ElemKind::Int8QTy, {3, 13, 11, 8}, 0.025, -7);
+  Tensor kernel(ElemKind::Int8QTy, {40, 3, 3, 4}, 0.003, 3);
+  Tensor bias(ElemKind::Int8QTy, {40}, 0.5, -4);
+  inputs.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  kernel.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  bias.getHandle<int8_t>().randomize(-11, 8, PRNG);
+  std::array<size_t, 4> S{{3, 7, 6, 40}};
+  llvm::ArrayRef<size_t> shape(S);
+  Tensor out1(ElemKind::Int8QTy, shape, 0.05, -17);
+  Tensor out2(ElemKind::Int8QTy, shape, 0.05, -17);
+
+  inferConvDKKC16(&inputs, &kernel, &bias, &out1, BackendKind::CPU);
+  inferConvDKKC16(&inputs, &kernel, &bias, &out2, BackendKind::Interpreter);
+
+  EXPECT_TRUE(out1.isEqual(out2, 1.0));
+}
+
+TEST_P(CPUOnly, depthwiseConvTest) {
+  PseudoRNG PRNG;
+  // 20 channels exercise both the vectorized and the scalar channels.
+  Tensor inputs(ElemKind::FloatTy, {2, 15, 13, 20});
+  Tensor kernel(ElemKind::FloatTy, {20, 3, 3, 1});
+  Tensor bias(ElemKind::FloatTy, {20});
+  inputs.getHandle().initXavier(1, PRNG);
+  kernel.getHandle().randomize(-3.0, 3.0, PRNG);
+  bias.getHandle().randomize(-0.5, 0.5, PRNG);
+  std::array<size_t, 4> S{{2, 8, 7, 20}};
+  llvm::ArrayRef<size_t> shape(S);
+
+  for (bool constFilter : {true, false}) {
+    Tensor out1(ElemKind::FloatTy, shape);
+    Tensor out2(ElemKind::FloatTy, shape);
+    inferDepthwiseConvNet(&inputs, &kernel, &bias, &out1, constFilter,
+                          BackendKind::CPU);
+    inferDepthwiseConvNet(&inputs, &kernel, &bias, &out2, constFilter,
+                          BackendKind::Interpreter);
+    EXPECT_TRUE(out1.isEqual(out2));
+  }
+}
+
+TEST_P(CPUOnly, quantizedDepthwiseConvTest) {
+  PseudoRNG PRNG;
+  Tensor inputs(ElemKind::Int8QTy, {2, 15, 13, 20}, 0.025, -7);
+  Tensor kernel(ElemKind::Int8QTy, {20, 3, 3, 1}, 0.003, 3);
+  Tensor bias(ElemKind::Int8QTy, {20}, 0.5, -4);
+  inputs.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  kernel.getHandle<int8_t>().randomize(-128, 127, PRNG);
+  bias.getHandle<int8_t>().randomize(-11, 8, PRNG);
+  std::array<size_t, 4> S{{2, 8, 7, 20}};
+  llvm::ArrayRef<size_t> shape(S);
+  Tensor out1(ElemKind::Int8QTy, shape, 0.01, -17);
+  Tensor out2(ElemKind::Int8QTy, shape, 0.01, -17);
+
+  inferDepthwiseConvNet(&inputs, &kernel, &bias, &out1, true,
+                        BackendKind::CPU);
+  inferDepthwiseConvNet(&inputs, &kernel, &bias, &out2, true,
+                        BackendKind::Interpreter);
+
+  EXPECT_TRUE(out1.isEqual(out2, 1.0));
+}
+
+TEST_P(CPUOnly, winogradConvTest) {
+  PseudoRNG PRNG;
+  // The small image is computed with 2x2 tiles and the large one with 4x4
+  // tiles. The channels are not multiples of the vector width, and the
+  // partial tiles at the borders exercise the bounds checks.
+  for (size_t size : {10, 19}) {
+    Tensor inputs(ElemKind::FloatTy, {2, size, size - 1, 12});
+    Tensor kernel(ElemKind::FloatTy, {20, 3, 3, 12});
+    Tensor bias(ElemKind::FloatTy, {20});
+    inputs.getHandle().initXavier(1, PRNG);
+    kernel.getHandle().randomize(-1.0, 1.0, PRNG);
+    bias.getHandle().randomize(-0.5, 0.5, PRNG);
+    std::array<size_t, 4> S{{2, size, size - 1, 20}};
+    llvm::ArrayRef<size_t> shape(S);
+    Tensor out1(ElemKind::FloatTy, shape);
+    Tensor out2(ElemKind::FloatTy, shape);
+
+    inferWinogradConvNet(&inputs, &kernel, &bias, &out1, BackendKind::CPU);
+    inferWinogradConvNet(&inputs, &kernel, &bias, &out2,
+                         BackendKind::Interpreter);
+
+    EXPECT_TRUE(out1.isEqual(out2, 0.001));
+  }
+}
+
+#ifdef GLOW_WITH_CPU
+/// \returns the number of times that \p kind occurs in \p kinds.
+static size_t countKind(llvm::ArrayRef<Kinded::Kind> kinds,
+                        Kinded::Kind kind) {
+  return std::count(kinds.begin(), kinds.end(), kind);
+}
+
+/// This test targets the fusion of the residual Add, the Relu and the clip
+/// into the epilogue of a convolution, and of the bias, the Relu and the clip
+/// into the epilogue of the matrix multiplication of a FullyConnected. With a
+/// public filter, the convolution keeps the generic layout of the filter; with
+/// a private filter and 64 output channels, it uses the DKKC8 layout.
+TEST_P(CPUOnly, fusedEpilogueTest) {
+  for (size_t depth : {12, 64}) {
+    PseudoRNG PRNG;
+    Tensor inputs(ElemKind::FloatTy, {2, 11, 9, 5});
+    Tensor kernel(ElemKind::FloatTy, {depth, 3, 3, 5});
+    Tensor bias(ElemKind::FloatTy, {depth});
+    Tensor residual(ElemKind::FloatTy, {2, 6, 5, depth});
+    Tensor fcWeights(ElemKind::FloatTy, {6 * 5 * depth, 21});
+    Tensor fcBias(ElemKind::FloatTy, {21});
+    inputs.getHandle().initXavier(1, PRNG);
+    kernel.getHandle().randomize(-3.0, 3.0, PRNG);
+    bias.getHandle().randomize(-0.5, 0.5, PRNG);
+    residual.getHandle().randomize(-4.0, 4.0, PRNG);
+    fcWeights.getHandle().randomize(-0.1, 0.1, PRNG);
+    fcBias.getHandle().randomize(-0.5, 0.5, PRNG);
+    Tensor out1(ElemKind::FloatTy, {2, 21});
+    Tensor out2(ElemKind::FloatTy, {2, 21});
+
+    bool constFilter = depth == 64;
+    auto kinds =
+        inferFusedEpilogueNet(&inputs, &kernel, &bias, &residual, &fcWeights,
+                              &fcBias, &out1, constFilter, BackendKind::CPU);
+    inferFusedEpilogueNet(&inputs, &kernel, &bias, &residual, &fcWeights,
+                          &fcBias, &out2, constFilter,
+                          BackendKind::Interpreter);
+
+    EXPECT_TRUE(out1.isEqual(out2, 0.001));
+    EXPECT_EQ(countKind(kinds, Kinded::Kind::CPUFusedConvAddNodeKind), 1);
+    EXPECT_EQ(countKind(kinds, Kinded::Kind::CPUFusedMatMulNodeKind), 1);
+    EXPECT_EQ(countKind(kinds, Kinded::Kind::ConvolutionNodeKind), 0);
+    EXPECT_EQ(countKind(kinds, Kinded::Kind::CPUConvDKKC8NodeKind), 0);
+    EXPECT_EQ(countKind(kinds, Kinded::Kind::MatMulNodeKind), 0);
+  }
+}
+
+/// This test targets the fusion of the Relu and the clip into the output
+/// transform of a Winograd convolution, and of the bias alone into the
+/// epilogue of the matrix multiplication of a FullyConnected.
+TEST_P(CPUOnly, fusedWinogradEpilogueTest) {
+  PseudoRNG PRNG;
+  Tensor inputs(ElemKind::FloatTy, {2, 10, 9, 6});
+  Tensor kernel(ElemKind::FloatTy, {16, 3, 3, 6});
+  Tensor bias(ElemKind::FloatTy, {16});
+  Tensor fcWeights(ElemKind::FloatTy, {10 * 9 * 16, 7});
+  Tensor fcBias(ElemKind::FloatTy, {7});
+  inputs.getHandle().initXavier(1, PRNG);
+  kernel.getHandle().randomize(-3.0, 3.0, PRNG);
+  bias.getHandle().randomize(-0.5, 0.5, PRNG);
+  fcWeights.getHandle().randomize(-0.1, 0.1, PRNG);
+  fcBias.getHandle().randomize(-0.5, 0.5, PRNG);
+  Tensor out1(ElemKind::FloatTy, {2, 7});
+  Tensor out2(ElemKind::FloatTy, {2, 7});
+
+  auto kinds = inferFusedWinogradNet(&inputs, &kernel, &bias, &fcWeights,
+                                     &fcBias, &out1, BackendKind::CPU);
+  inferFusedWinogradNet(&inputs, &kernel, &bias, &fcWeights, &fcBias, &out2,
+                        BackendKind::Interpreter);
+
+  EXPECT_TRUE(out1.isEqual(out2, 0.001));
+  EXPECT_EQ(countKind(kinds, Kinded::Kind::CPUWinogradConvNodeKind), 1);
+  EXPECT_EQ(countKind(kinds, Kinded::Kind::CPUMaxSplatNodeKind), 0);
+  EXPECT_EQ(countKind(kinds, Kinded::Kind::MinNodeKind), 0);
+  EXPECT_EQ(countKind(kinds, Kinded::Kind::CPUFusedMatMulNodeKind), 1);
+  EXPECT_EQ(countKind(kinds, Kinded::Kind::BatchedAddNodeKind), 0);
+}
+#endif // GLOW_WITH_CPU
+
+TEST_P(CPUOnly, sparseLengthsWeightedSumTest) {
+  PseudoRNG PRNG;
+  // The rows are wider than the vector width and have a tail, and one of the
+  // segments is empty.
+  Tensor data(ElemKind::FloatTy, {40, 21});
+  Tensor weights(ElemKind::FloatTy, {30});
+  Tensor indices(ElemKind::Int64ITy, {30});
+  Tensor lengths(ElemKind::Int64ITy, {6});
+  data.getHandle().randomize(-1.0, 1.0, PRNG);
+  weights.getHandle().randomize(-1.0, 1.0, PRNG);
+  auto IH = indices.getHandle<int64_t>();
+  for (size_t i = 0; i < IH.size(); i++) {
+    IH.raw(i) = PRNG.nextRandInt(0, 39);
+  }
+  lengths.getHandle<int64_t>() = {7, 0, 3, 9, 1, 10};
+
+  for (bool rowwiseQuantized : {false, true}) {
+    Tensor out1(ElemKind::FloatTy, {6, 21});
+    Tensor out2(ElemKind::FloatTy, {6, 21});
+    inferSparseLengthsWeightedSumNet(&data, &weights, &indices, &lengths,
+                                     &out1, rowwiseQuantized,
+                                     BackendKind::CPU);
+    inferSparseLengthsWeightedSumNet(&data, &weights, &indices, &lengths,
+                                     &out2, rowwiseQuantized,
+                                     BackendKind::Interpreter);
+    EXPECT_TRUE(out1.isEqual(out2, 0.0001));
+  }
+
+  Tensor out1(ElemKind::FloatTy, {6, 21});
+  Tensor out2(ElemKind::FloatTy, {6, 21});
+  inferFusedRowwiseQuantizedSparseLengthsWeightedSumNet(
+      &data, &weights, &indices, &lengths, &out1, BackendKind::CPU);
+  inferFusedRowwiseQuantizedSparseLengthsWeightedSumNet(
+      &data, &weights, &indices, &lengths, &out2, BackendKind::Interpreter);
+  EXPECT_TRUE(out1.isEqual(out2, 0.0001));
+}
+
 TEST_P(BackendCorrectnessTest, softmaxTest) {
   PseudoRNG PRNG;
   Tensor inputs(ElemKind::FloatTy, {14, 19});
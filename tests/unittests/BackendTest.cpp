@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include "glow/ExecutionEngine/BucketedExecutor.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/ExecutionEngine/RequestBatcher.h"
 #include "glow/Graph/Context.h"
 #include "glow/Graph/Graph.h"
 #include "glow/IR/IRBuilder.h"
@@ -22,7 +24,9 @@
 #include "gtest/gtest.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/FileSystem.h"
 
 using namespace glow;
 
@@ -209,6 +213,329 @@ TEST_P(BackendTest, simplePlaceholderValue) {
   EXPECT_TRUE(STensor->isEqual(data));
 }
 
+/// Check that compiling a function again reuses the compiled code, unless the
+/// constants or the bindings of the context changed.
+TEST_P(BackendTest, compileCache) {
+  auto &mod = EE_.getModule();
+  Function *F = mod.createFunction("main");
+  auto *A = mod.createPlaceholder(ElemKind::FloatTy, {4}, "A", false);
+  auto *B = mod.createVariable(ElemKind::FloatTy, {4}, "B",
+                               VisibilityKind::Private, false);
+  B->getPayload().getHandle() = {1, 2, 3, 4};
+  Context ctx;
+  auto *save = F->createSave(ctx, "ret", F->createAdd("add", A, B));
+  ctx.allocate(A)->getHandle() = {1, 1, 1, 1};
+  auto *res = ctx.allocate(save->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer, F, ctx);
+  EE_.run();
+  EXPECT_EQ(EE_.getNumCacheHits(), 0);
+  EXPECT_FLOAT_EQ(res->getHandle().at({3}), 5);
+
+  // The optimized function is found in the cache.
+  EE_.compile(CompilationMode::Infer, F, ctx);
+  EE_.run();
+  EXPECT_EQ(EE_.getNumCacheHits(), 1);
+  EXPECT_FLOAT_EQ(res->getHandle().at({3}), 5);
+
+  // A new context binds other tensors.
+  Context ctx2;
+  ctx2.allocate(A)->getHandle() = {2, 2, 2, 2};
+  auto *res2 = ctx2.allocate(save->getPlaceholder());
+  EE_.compile(CompilationMode::Infer, F, ctx2);
+  EE_.run();
+  EXPECT_EQ(EE_.getNumCacheHits(), 1);
+  EXPECT_FLOAT_EQ(res2->getHandle().at({3}), 6);
+
+  // The content of the constant changed.
+  B->getPayload().getHandle() = {4, 3, 2, 1};
+  EE_.compile(CompilationMode::Infer, F, ctx);
+  EE_.run();
+  EXPECT_EQ(EE_.getNumCacheHits(), 1);
+  EXPECT_FLOAT_EQ(res->getHandle().at({3}), 2);
+}
+
+/// Check that two functions that only differ in which placeholder of the same
+/// type they read do not share compiled code.
+TEST_P(BackendTest, compileCacheStorage) {
+  auto &mod = EE_.getModule();
+  auto *A = mod.createPlaceholder(ElemKind::FloatTy, {4}, "A", false);
+  auto *B = mod.createPlaceholder(ElemKind::FloatTy, {4}, "B", false);
+  auto *out = mod.createPlaceholder(ElemKind::FloatTy, {4}, "out", false);
+  Function *FA = mod.createFunction("readA");
+  FA->createSave("ret", FA->createTanh("tanh", A), out);
+  Function *FB = mod.createFunction("readB");
+  FB->createSave("ret", FB->createTanh("tanh", B), out);
+  EXPECT_EQ(FA->getStructuralHash(), FB->getStructuralHash());
+
+  Context ctx;
+  ctx.allocate(A)->getHandle() = {0, 0, 0, 0};
+  ctx.allocate(B)->getHandle() = {1, 1, 1, 1};
+  auto *res = ctx.allocate(out);
+
+  EE_.compile(CompilationMode::Infer, FA, ctx);
+  EE_.run();
+  EXPECT_FLOAT_EQ(res->getHandle().at({0}), 0);
+
+  EE_.compile(CompilationMode::Infer, FB, ctx);
+  EE_.run();
+  EXPECT_EQ(EE_.getNumCacheHits(), 0);
+  EXPECT_NEAR(res->getHandle().at({0}), 0.761594, 1e-5);
+}
+
+/// Check that the compiled code is not reused after a placeholder is rebound
+/// to other memory in place, because the backends may bake the addresses of
+/// the payloads into the code.
+TEST_P(BackendTest, compileCacheRebind) {
+  auto &mod = EE_.getModule();
+  Function *F = mod.createFunction("main");
+  auto *A = mod.createPlaceholder(ElemKind::FloatTy, {4}, "A", false);
+  Context ctx;
+  auto *save = F->createSave(ctx, "ret", F->createTanh("tanh", A));
+  auto *PH = save->getPlaceholder();
+  ctx.allocate(A)->getHandle() = {1, 1, 1, 1};
+  Tensor *res = ctx.allocate(PH);
+
+  EE_.compile(CompilationMode::Infer, F, ctx);
+  EE_.run();
+
+  // Rebind the input and the output to the memory of the caller, keeping the
+  // same tensors in the context.
+  std::vector<float> in{0, 0, 0, 0};
+  std::vector<float> out{-1, -1, -1, -1};
+  *ctx.get(A) = Tensor(in.data(), A->getType());
+  *res = Tensor(out.data(), PH->getType());
+  EE_.compile(CompilationMode::Infer, F, ctx);
+  EE_.run();
+  EXPECT_EQ(EE_.getNumCacheHits(), 0);
+  for (auto v : out) {
+    EXPECT_FLOAT_EQ(v, 0);
+  }
+}
+
+/// Check that the request batcher packs single requests into batches and
+/// returns the right slice of the output to every request.
+TEST_P(BackendTest, requestBatcher) {
+  auto &mod = EE_.getModule();
+  Function *F = mod.createFunction("main");
+  auto *A = mod.createPlaceholder(ElemKind::FloatTy, {4, 3}, "A", false);
+  auto *B = mod.createPlaceholder(ElemKind::FloatTy, {4, 3}, "B", false);
+  Context ctx;
+  auto *save = F->createSave(ctx, "ret", F->createMul("mul", A, B));
+  ctx.allocate(A);
+  ctx.allocate(B);
+  ctx.allocate(save->getPlaceholder());
+  EE_.compile(CompilationMode::Infer, F, ctx);
+
+  constexpr size_t numRequests = 10;
+  RequestBatcher batcher(EE_, ctx, {A, B}, {save->getPlaceholder()},
+                         /* maxBatchSize */ 0, std::chrono::milliseconds(1));
+  std::vector<std::future<RequestBatcher::Result>> results;
+  for (size_t i = 0; i < numRequests; i++) {
+    std::vector<Tensor> inputs;
+    inputs.emplace_back(ElemKind::FloatTy, llvm::ArrayRef<size_t>{1, 3});
+    inputs.emplace_back(ElemKind::FloatTy, llvm::ArrayRef<size_t>{1, 3});
+    inputs[0].getHandle() = {float(i), float(i + 1), float(i + 2)};
+    inputs[1].getHandle() = {1, 2, 3};
+    results.push_back(batcher.submit(std::move(inputs)));
+  }
+
+  for (size_t i = 0; i < numRequests; i++) {
+    auto result = results[i].get();
+    ASSERT_EQ(result.size(), 1);
+    auto H = result[0].getHandle();
+    ASSERT_EQ(H.dims(), llvm::ArrayRef<size_t>({1, 3}));
+    for (size_t j = 0; j < 3; j++) {
+      EXPECT_FLOAT_EQ(H.at({0, j}), float((i + j) * (j + 1)));
+    }
+  }
+
+  // A batch holds at most four requests.
+  EXPECT_EQ(batcher.getNumRequests(), numRequests);
+  EXPECT_GE(batcher.getNumBatches(), 3);
+}
+
+/// Check that the bucketed executor runs the smallest bucket that fits a
+/// request, shares the weights between the buckets, and cuts the outputs back
+/// to the shape of the request.
+TEST_P(BackendTest, bucketedExecutor) {
+  BucketedExecutor BE(GetParam());
+  auto &mod = BE.getModule();
+  auto *W = mod.createVariable(ElemKind::FloatTy, {3, 2}, "W",
+                               VisibilityKind::Private, false);
+  W->getPayload().getHandle() = {1, 2, 3, 4, 5, 6};
+
+  // The dynamic dimensions are the batch size and the sequence length.
+  BE.compile(CompilationMode::Infer, {{2, 4}, {8, 8}, {4, 4}},
+             [&](Module &M, llvm::ArrayRef<size_t> sizes) {
+               size_t batch = sizes[0], seq = sizes[1];
+               BucketedExecutor::Specialization spec;
+               spec.F = M.createFunction("main_" + std::to_string(batch) +
+                                         "_" + std::to_string(seq));
+               auto *X = M.createPlaceholder(ElemKind::FloatTy, {batch, 3},
+                                             "X", false);
+               auto *S = M.createPlaceholder(ElemKind::FloatTy, {batch, seq},
+                                             "S", false);
+               auto *P = M.createPlaceholder(ElemKind::FloatTy, {batch, 2},
+                                             "P", false);
+               auto *Q = M.createPlaceholder(ElemKind::FloatTy, {batch, seq},
+                                             "Q", false);
+               spec.F->createSave("saveP", spec.F->createMatMul("mm", X, W),
+                                  P);
+               spec.F->createSave("saveQ", spec.F->createMul("mul", S, S), Q);
+               spec.inputs = {X, S};
+               spec.outputs = {P, Q};
+               spec.inputDims = {{0, -1}, {0, 1}};
+               spec.outputDims = {{0, -1}, {0, 1}};
+               return spec;
+             });
+
+  Tensor X(ElemKind::FloatTy, {3, 3});
+  Tensor S(ElemKind::FloatTy, {3, 2});
+  X.getHandle() = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  S.getHandle() = {1, 2, 3, 4, 5, 6};
+  size_t idx = BE.selectBucket({&X, &S});
+  EXPECT_EQ(BE.getBucketSizes(idx), llvm::ArrayRef<size_t>({4, 4}));
+
+  Tensor P, Q;
+  BE.run({&X, &S}, {&P, &Q});
+  ASSERT_EQ(P.dims(), llvm::ArrayRef<size_t>({3, 2}));
+  ASSERT_EQ(Q.dims(), llvm::ArrayRef<size_t>({3, 2}));
+  auto PH = P.getHandle();
+  auto QH = Q.getHandle();
+  for (size_t i = 0; i < 3; i++) {
+    for (size_t j = 0; j < 2; j++) {
+      EXPECT_FLOAT_EQ(PH.at({i, j}), float(i * 2 + j + 1));
+      EXPECT_FLOAT_EQ(QH.at({i, j}), float((i * 2 + j + 1) * (i * 2 + j + 1)));
+    }
+  }
+
+  // A larger request selects the largest bucket.
+  Tensor X2(ElemKind::FloatTy, {5, 3});
+  Tensor S2(ElemKind::FloatTy, {5, 1});
+  EXPECT_EQ(BE.getBucketSizes(BE.selectBucket({&X2, &S2})),
+            llvm::ArrayRef<size_t>({8, 8}));
+}
+
+/// Check that the bucketed executor follows the declared dynamic dimensions
+/// when the shapes are ambiguous: two dynamic dimensions that have the same
+/// size in every bucket, and a static dimension that has the size of the only
+/// bucket.
+TEST_P(BackendTest, bucketedExecutorAmbiguousDims) {
+  // The batch size and the sequence length are the same in every bucket.
+  BucketedExecutor BE(GetParam());
+  BE.compile(CompilationMode::Infer, {{4, 4}, {8, 8}},
+             [&](Module &M, llvm::ArrayRef<size_t> sizes) {
+               size_t batch = sizes[0], seq = sizes[1];
+               BucketedExecutor::Specialization spec;
+               spec.F = M.createFunction("main_" + std::to_string(batch));
+               auto *S = M.createPlaceholder(ElemKind::FloatTy, {batch, seq},
+                                             "S", false);
+               auto *Q = M.createPlaceholder(ElemKind::FloatTy, {batch, seq},
+                                             "Q", false);
+               spec.F->createSave("saveQ", spec.F->createMul("mul", S, S), Q);
+               spec.inputs = {S};
+               spec.outputs = {Q};
+               spec.inputDims = {{0, 1}};
+               spec.outputDims = {{0, 1}};
+               return spec;
+             });
+
+  Tensor S(ElemKind::FloatTy, {3, 2});
+  S.getHandle() = {1, 2, 3, 4, 5, 6};
+  Tensor Q;
+  BE.run({&S}, {&Q});
+  ASSERT_EQ(Q.dims(), llvm::ArrayRef<size_t>({3, 2}));
+  auto QH = Q.getHandle();
+  for (size_t i = 0; i < 6; i++) {
+    EXPECT_FLOAT_EQ(QH.raw(i), float((i + 1) * (i + 1)));
+  }
+
+  // The static dimension of the features has the size of the only bucket.
+  BucketedExecutor BE2(GetParam());
+  BE2.compile(CompilationMode::Infer, {{4}},
+              [&](Module &M, llvm::ArrayRef<size_t> sizes) {
+                size_t batch = sizes[0];
+                BucketedExecutor::Specialization spec;
+                spec.F = M.createFunction("main");
+                auto *X = M.createPlaceholder(ElemKind::FloatTy, {batch, 4},
+                                              "X", false);
+                auto *P = M.createPlaceholder(ElemKind::FloatTy, {batch, 4},
+                                              "P", false);
+                spec.F->createSave("saveP", spec.F->createTanh("tanh", X), P);
+                spec.inputs = {X};
+                spec.outputs = {P};
+                spec.inputDims = {{0, -1}};
+                spec.outputDims = {{0, -1}};
+                return spec;
+              });
+
+  Tensor X(ElemKind::FloatTy, {2, 4});
+  X.zero();
+  Tensor P;
+  BE2.run({&X}, {&P});
+  EXPECT_EQ(P.dims(), llvm::ArrayRef<size_t>({2, 4}));
+}
+
+/// Check that the constants can be saved to a weights file and mapped back
+/// into the module of another engine.
+TEST_P(BackendTest, mapConstantWeights) {
+  llvm::SmallString<64> path;
+  llvm::sys::fs::createTemporaryFile("weights", "bin", path);
+
+  // Builds a function that adds a constant to a placeholder, and returns the
+  // placeholder of its result. The module has another constant that is not
+  // used by the function.
+  auto build = [](Module &mod, Context &ctx) {
+    Function *F = mod.createFunction("main");
+    auto *A = mod.createPlaceholder(ElemKind::FloatTy, {4}, "A", false);
+    auto *B = mod.createVariable(ElemKind::FloatTy, {4}, "B",
+                                 VisibilityKind::Private, false);
+    mod.createVariable(ElemKind::Int8QTy, {3}, 0.5, 2, "C",
+                       VisibilityKind::Private, false);
+    auto *save = F->createSave(ctx, "ret", F->createAdd("add", A, B));
+    ctx.allocate(A)->getHandle() = {1, 1, 1, 1};
+    ctx.allocate(save->getPlaceholder());
+    return std::make_pair(F, save->getPlaceholder());
+  };
+
+  {
+    ExecutionEngine EE(GetParam());
+    Context ctx;
+    build(EE.getModule(), ctx);
+    auto &mod = EE.getModule();
+    mod.getVariableByName("B")->getPayload().getHandle() = {1, 2, 3, 4};
+    mod.getVariableByName("C")->getPayload().getHandle<int8_t>() = {-1, 0, 1};
+    EE.saveConstantWeights(path);
+  }
+
+  // The constants of the new module are zero until the file is mapped.
+  Context ctx;
+  auto FP = build(EE_.getModule(), ctx);
+  EXPECT_EQ(EE_.mapConstantWeights(path), 2);
+  auto &B = EE_.getModule().getVariableByName("B")->getPayload();
+  auto &C = EE_.getModule().getVariableByName("C")->getPayload();
+  EXPECT_TRUE(B.isUnowned());
+  EXPECT_EQ(C.getHandle<int8_t>().at({0}), -1);
+  EXPECT_EQ(C.getHandle<int8_t>().at({2}), 1);
+
+  EE_.compile(CompilationMode::Infer, FP.first, ctx);
+  EE_.run();
+  auto H = ctx.get(FP.second)->getHandle();
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_FLOAT_EQ(H.at({i}), float(i + 2));
+  }
+
+  // Mapping the file again replaces the first mapping instead of keeping
+  // both of them alive.
+  EXPECT_EQ(EE_.mapConstantWeights(path), 2);
+  EXPECT_EQ(EE_.getNumMappedFiles(), 1);
+  EE_.compile(CompilationMode::Infer, FP.first, ctx);
+  EE_.run();
+  EXPECT_FLOAT_EQ(ctx.get(FP.second)->getHandle().at({3}), 5);
+  llvm::sys::fs::remove(path);
+}
+
 /// Test the basic functionality of the context.
 TEST(Context, basicContextTest) {
   Module mod;
@@ -695,6 +695,199 @@ void inferConvDKKC8(Tensor *out, BackendKind kind) {
   out->assign(&result->getVariable()->getPayload());
 }
 
+/// Compile and run a 3x3 convolution of \p inputs with \p filter and \p bias
+/// on \p kind, and copy the result to \p out. If \p constFilter is true, the
+/// filter is a private constant, which lets the CPU backend pack or transform
+/// it at compile time; otherwise it is a public variable.
+static void inferFilterConvNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                               Tensor *out, unsigned_t stride,
+                               unsigned_t group, bool constFilter,
+                               BackendKind kind) {
+  ExecutionEngine EE(kind);
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *inputVar = VarFrom(inputs);
+  auto *biasVar = VarFrom(bias);
+  auto *outVar = VarFrom(out);
+  auto *filterVar = mod.createVariable(
+      &filter->getType(), "filter",
+      constFilter ? VisibilityKind::Private : VisibilityKind::Public, false);
+  filterVar->assign(filter);
+  auto OT = mod.uniqueType(out->getType());
+  auto *conv = F->createConv("conv", inputVar, filterVar, biasVar, OT, {3, 3},
+                             {stride, stride}, {1, 1, 1, 1}, group);
+  auto result = F->createSave("ret", conv, outVar);
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+
+  updateVariables({inputVar, biasVar}, {inputs, bias});
+  EE.run();
+  out->assign(&result->getVariable()->getPayload());
+}
+
+void inferConvDKKC16(Tensor *inputs, Tensor *filter, Tensor *bias, Tensor *out,
+                     BackendKind kind) {
+  // Use padding, strides, and groups whose depth is not a multiple of the
+  // panel width.
+  inferFilterConvNet(inputs, filter, bias, out, 2, 2, true, kind);
+}
+
+void inferDepthwiseConvNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                           Tensor *out, bool constFilter, BackendKind kind) {
+  unsigned_t channels = inputs->dims()[3];
+  inferFilterConvNet(inputs, filter, bias, out, 2, channels, constFilter,
+                     kind);
+}
+
+void inferWinogradConvNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                          Tensor *out, BackendKind kind) {
+  inferFilterConvNet(inputs, filter, bias, out, 1, 1, true, kind);
+}
+
+/// Compile and run a convolution followed by a residual Add and a clipped
+/// Relu, and a FullyConnected followed by a clipped Relu, on \p kind, and copy
+/// the result to \p out. If \p constFilter is true, the filter of the
+/// convolution is a private constant. \returns the kinds of the nodes of the
+/// compiled function.
+std::vector<Kinded::Kind>
+inferFusedEpilogueNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                      Tensor *residual, Tensor *fcWeights, Tensor *fcBias,
+                      Tensor *out, bool constFilter, BackendKind kind) {
+  ExecutionEngine EE(kind);
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *inputVar = VarFrom(inputs);
+  auto *filterVar = mod.createVariable(
+      &filter->getType(), "filter",
+      constFilter ? VisibilityKind::Private : VisibilityKind::Public, false);
+  filterVar->assign(filter);
+  auto *biasVar = VarFrom(bias);
+  auto *residualVar = VarFrom(residual);
+  auto *fcWeightsVar = VarFrom(fcWeights);
+  auto *fcBiasVar = VarFrom(fcBias);
+  auto *outVar = VarFrom(out);
+  // A convolution followed by a residual connection, a Relu and a clip to 6.
+  auto *conv = F->createConv("conv", inputVar, filterVar, biasVar,
+                             residualVar->getType(), {3, 3}, {2, 2},
+                             {1, 1, 1, 1}, 1);
+  auto *add = F->createAdd("add", conv, residualVar);
+  auto *relu = F->createRELU("relu", add);
+  auto *six = F->createSplat("six", relu->getResult().getType(), 6.0);
+  auto *clip = F->createMin("clip", relu, six);
+  // A FullyConnected followed by a Relu and a clip to 2.
+  auto *fc = F->createFullyConnected("fc", clip, fcWeightsVar, fcBiasVar);
+  auto *fcRelu = F->createRELU("fcRelu", fc);
+  auto *two = F->createSplat("two", fcRelu->getResult().getType(), 2.0);
+  auto *fcClip = F->createMin("fcClip", two, fcRelu);
+  auto result = F->createSave("ret", fcClip, outVar);
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+
+  updateVariables({inputVar, biasVar, residualVar, fcWeightsVar, fcBiasVar},
+                  {inputs, bias, residual, fcWeights, fcBias});
+  EE.run();
+  out->assign(&result->getVariable()->getPayload());
+
+  std::vector<Kinded::Kind> kinds;
+  for (auto &N : F->getNodes()) {
+    kinds.push_back(N.getKind());
+  }
+  return kinds;
+}
+
+/// Compile and run a 3x3 stride-1 convolution with a private filter followed
+/// by a clipped Relu, and a FullyConnected with only a bias, on \p kind, and
+/// copy the result to \p out. \returns the kinds of the nodes of the compiled
+/// function.
+std::vector<Kinded::Kind>
+inferFusedWinogradNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                      Tensor *fcWeights, Tensor *fcBias, Tensor *out,
+                      BackendKind kind) {
+  ExecutionEngine EE(kind);
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *inputVar = VarFrom(inputs);
+  auto *filterVar = mod.createVariable(&filter->getType(), "filter",
+                                       VisibilityKind::Private, false);
+  filterVar->assign(filter);
+  auto *biasVar = VarFrom(bias);
+  auto *fcWeightsVar = VarFrom(fcWeights);
+  auto *fcBiasVar = VarFrom(fcBias);
+  auto *outVar = VarFrom(out);
+  auto idim = inputs->dims();
+  auto *convTy = mod.uniqueType(ElemKind::FloatTy,
+                                {idim[0], idim[1], idim[2], filter->dims()[0]});
+  auto *conv = F->createConv("conv", inputVar, filterVar, biasVar, convTy,
+                             {3, 3}, {1, 1}, {1, 1, 1, 1}, 1);
+  auto *relu = F->createRELU("relu", conv);
+  auto *six = F->createSplat("six", relu->getResult().getType(), 6.0);
+  auto *clip = F->createMin("clip", relu, six);
+  auto *fc = F->createFullyConnected("fc", clip, fcWeightsVar, fcBiasVar);
+  auto result = F->createSave("ret", fc, outVar);
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+
+  updateVariables({inputVar, biasVar, fcWeightsVar, fcBiasVar},
+                  {inputs, bias, fcWeights, fcBias});
+  EE.run();
+  out->assign(&result->getVariable()->getPayload());
+
+  std::vector<Kinded::Kind> kinds;
+  for (auto &N : F->getNodes()) {
+    kinds.push_back(N.getKind());
+  }
+  return kinds;
+}
+
+void inferSparseLengthsWeightedSumNet(Tensor *data, Tensor *weights,
+                                      Tensor *indices, Tensor *lengths,
+                                      Tensor *out, bool rowwiseQuantized,
+                                      BackendKind kind) {
+  ExecutionEngine EE(kind);
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *weightsVar = VarFrom(weights);
+  auto *indicesVar = VarFrom(indices);
+  auto *lengthsVar = VarFrom(lengths);
+  Node *SLWS;
+  if (rowwiseQuantized) {
+    SLWS = F->createRowwiseQuantizedSparseLengthsWeightedSum(
+        "RQSLWS", *data, weightsVar, indicesVar, lengthsVar);
+  } else {
+    SLWS = F->createSparseLengthsWeightedSum("SLWS", VarFrom(data), weightsVar,
+                                             indicesVar, lengthsVar);
+  }
+  auto result = F->createSave("ret", SLWS);
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+
+  updateVariables({weightsVar, indicesVar, lengthsVar},
+                  {weights, indices, lengths});
+  EE.run();
+  out->assign(&result->getVariable()->getPayload());
+}
+
+void inferFusedRowwiseQuantizedSparseLengthsWeightedSumNet(
+    Tensor *data, Tensor *weights, Tensor *indices, Tensor *lengths,
+    Tensor *out, BackendKind kind) {
+  ExecutionEngine EE(kind);
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *weightsVar = VarFrom(weights);
+  auto *indicesVar = VarFrom(indices);
+  auto *lengthsVar = VarFrom(lengths);
+  auto *SLWS = F->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      "FRQSLWS", *data, weightsVar, indicesVar, lengthsVar);
+  auto result = F->createSave("ret", SLWS);
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+
+  updateVariables({weightsVar, indicesVar, lengthsVar},
+                  {weights, indices, lengths});
+  EE.run();
+  out->assign(&result->getVariable()->getPayload());
+}
+
 void inferSoftMaxNet(Tensor *inputs, Tensor *selected, Tensor *out,
                      BackendKind kind) {
   ExecutionEngine EE(kind);
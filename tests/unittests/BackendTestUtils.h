@@ -18,6 +18,8 @@
 #include "glow/Graph/Graph.h"
 #include "glow/IR/IR.h"
 
+#include <vector>
+
 namespace glow {
 
 /// MockBackend used only for unit testing.
@@ -107,6 +109,34 @@ void inferNonSquareStrideConv(Tensor *out, BackendKind kind);
 
 void inferConvDKKC8(Tensor *out, BackendKind kind);
 
+void inferConvDKKC16(Tensor *inputs, Tensor *filter, Tensor *bias, Tensor *out,
+                     BackendKind kind);
+
+void inferDepthwiseConvNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                           Tensor *out, bool constFilter, BackendKind kind);
+
+void inferWinogradConvNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                          Tensor *out, BackendKind kind);
+
+std::vector<Kinded::Kind>
+inferFusedEpilogueNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                      Tensor *residual, Tensor *fcWeights, Tensor *fcBias,
+                      Tensor *out, bool constFilter, BackendKind kind);
+
+std::vector<Kinded::Kind>
+inferFusedWinogradNet(Tensor *inputs, Tensor *filter, Tensor *bias,
+                      Tensor *fcWeights, Tensor *fcBias, Tensor *out,
+                      BackendKind kind);
+
+void inferSparseLengthsWeightedSumNet(Tensor *data, Tensor *weights,
+                                      Tensor *indices, Tensor *lengths,
+                                      Tensor *out, bool rowwiseQuantized,
+                                      BackendKind kind);
+
+void inferFusedRowwiseQuantizedSparseLengthsWeightedSumNet(
+    Tensor *data, Tensor *weights, Tensor *indices, Tensor *lengths,
+    Tensor *out, BackendKind kind);
+
 void inferSmallConv(Tensor *inputs, Tensor *out, BackendKind kind);
 
 void inferSoftMaxNet(Tensor *inputs, Tensor *selected, Tensor *out,
@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2017-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "CPUBackend.h"
+#include "CPUFunction.h"
+#include "LLVMIRGen.h"
+
+#include "glow/Graph/Context.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Optimizer/Optimizer.h"
+#include "glow/Support/Random.h"
+
+#include "gtest/gtest.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+
+#include <thread>
+#include <vector>
+
+using namespace glow;
+
+#ifndef GLOW_WITH_CPU
+#error "This should be compiled with the CPU backend"
+#endif
+
+extern llvm::cl::opt<bool> fuseLoopNests;
+
+/// Check that several threads can execute a reentrant CPUFunction at the same
+/// time, each using its own execution context, and that every thread gets the
+/// result for its own input.
+TEST(CPUFunction, reentrantExecution) {
+  constexpr unsigned numThreads = 4;
+  PseudoRNG PRNG;
+  Module mod;
+  Function *F = mod.createFunction("main");
+  Context ctx;
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {4, 8}, "input",
+                                      false);
+  ctx.allocate(input);
+  auto *weights = mod.createVariable(ElemKind::FloatTy, {8, 8}, "weights");
+  weights->getPayload().getHandle().randomize(-1.0, 1.0, PRNG);
+  auto *MM = F->createMatMul("matmul", input, weights);
+  auto *tanh = F->createTanh("tanh", MM);
+  auto *save = F->createSave(ctx, "save", tanh);
+  ctx.allocate(save->getPlaceholder());
+
+  CPUBackend backend(/* reentrant */ true);
+  ::glow::optimize(F, CompilationMode::Infer);
+  ::glow::lower(F, backend);
+  ::glow::optimize(F, CompilationMode::Infer);
+  auto compiled = backend.compile(F, ctx);
+  auto *CF = static_cast<CPUFunction *>(compiled.get());
+  ASSERT_TRUE(CF->isReentrant());
+
+  // Compute the reference results for different inputs using the default
+  // context.
+  std::vector<Tensor> inputs;
+  std::vector<Tensor> expected;
+  for (unsigned i = 0; i < numThreads; i++) {
+    inputs.emplace_back(ElemKind::FloatTy, llvm::ArrayRef<size_t>{4, 8});
+    inputs.back().getHandle().randomize(-1.0, 1.0, PRNG);
+    ctx.get(input)->assign(&inputs.back());
+    CF->execute();
+    expected.push_back(ctx.get(save->getPlaceholder())->clone());
+  }
+
+  // Run all of the inputs concurrently, many times each.
+  std::vector<std::thread> threads;
+  // Every thread writes only its own flag. std::vector<bool> is not used,
+  // because it packs the flags into shared words.
+  std::vector<char> correct(numThreads, true);
+  for (unsigned i = 0; i < numThreads; i++) {
+    threads.emplace_back([&, i]() {
+      auto execCtx = CF->createExecutionContext();
+      for (unsigned iter = 0; iter < 100; iter++) {
+        execCtx->getTensor(input).copyRawFrom(&inputs[i]);
+        execCtx->execute();
+        if (!execCtx->getTensor(save->getPlaceholder())
+                 .isEqual(expected[i], 0.0)) {
+          correct[i] = false;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (unsigned i = 0; i < numThreads; i++) {
+    EXPECT_TRUE(correct[i]);
+  }
+}
+
+/// Check that a function whose code is split into parts, which are compiled
+/// separately, computes the same result as the function compiled as a whole.
+TEST(CPUFunction, splitCodeGen) {
+  PseudoRNG PRNG;
+  Module mod;
+  Function *F = mod.createFunction("main");
+  Context ctx;
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {4, 8}, "input",
+                                      false);
+  ctx.allocate(input)->getHandle().randomize(-1.0, 1.0, PRNG);
+  Node *O = input;
+  for (unsigned i = 0; i < 6; i++) {
+    auto *weights = mod.createVariable(ElemKind::FloatTy, {8, 8}, "weights");
+    weights->getPayload().getHandle().randomize(-1.0, 1.0, PRNG);
+    O = F->createMatMul("matmul", O, weights);
+    O = F->createTanh("tanh", O);
+  }
+  auto *save = F->createSave(ctx, "save", O);
+  auto *result = ctx.allocate(save->getPlaceholder());
+
+  CPUBackend backend;
+  ::glow::optimize(F, CompilationMode::Infer);
+  ::glow::lower(F, backend);
+  ::glow::optimize(F, CompilationMode::Infer);
+  backend.compile(F, ctx)->execute();
+  Tensor expected = result->clone();
+
+  result->zero();
+  backend.setNumCodeGenParts(3);
+  backend.compile(F, ctx)->execute();
+  EXPECT_TRUE(result->isEqual(expected));
+}
+
+/// Build a function in \p mod that multiplies an input of ones by weights
+/// that are all \p weight, compile it with \p backend and execute it.
+/// \returns the first element of the result.
+static float runMatMul(Module &mod, Context &ctx, CPUBackend &backend,
+                       float weight) {
+  Function *F = mod.createFunction("main");
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {4, 8}, "input",
+                                      false);
+  ctx.allocate(input)->getHandle().clear(1);
+  auto *weights = mod.createVariable(ElemKind::FloatTy, {8, 8}, "weights");
+  weights->getPayload().getHandle().clear(weight);
+  auto *MM = F->createMatMul("matmul", input, weights);
+  auto *save = F->createSave(ctx, "save", MM);
+  auto *result = ctx.allocate(save->getPlaceholder());
+
+  ::glow::optimize(F, CompilationMode::Infer);
+  ::glow::lower(F, backend);
+  ::glow::optimize(F, CompilationMode::Infer);
+  backend.compile(F, ctx)->execute();
+  return result->getHandle().at({0, 0});
+}
+
+/// Check that a function compiled by a backend with an object cache is loaded
+/// from the cache by another backend, and that the loaded code uses the
+/// weights of the module it is loaded for, not those of the module it was
+/// compiled for.
+TEST(CPUFunction, objectCache) {
+  llvm::SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("glow-object-cache", dir));
+
+  Module mod1;
+  Context ctx1;
+  CPUBackend backend1;
+  backend1.setObjectCacheDir(dir);
+  EXPECT_EQ(runMatMul(mod1, ctx1, backend1, 0.5), 4);
+  EXPECT_EQ(backend1.getObjectCache()->getNumMisses(), 1);
+  EXPECT_EQ(backend1.getObjectCache()->getNumHits(), 0);
+
+  // The first module is still alive, so the weights of the second one have
+  // other addresses.
+  Module mod2;
+  Context ctx2;
+  CPUBackend backend2;
+  backend2.setObjectCacheDir(dir);
+  EXPECT_EQ(runMatMul(mod2, ctx2, backend2, 0.25), 2);
+  EXPECT_EQ(backend2.getObjectCache()->getNumMisses(), 0);
+  EXPECT_EQ(backend2.getObjectCache()->getNumHits(), 1);
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+/// Check that a function compiled with an object cache by a backend that is
+/// not reentrant reads and writes the tensors bound in the context in place.
+TEST(CPUFunction, objectCacheInPlace) {
+  llvm::SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("glow-object-cache", dir));
+
+  Module mod;
+  Function *F = mod.createFunction("main");
+  Context ctx;
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {4, 8}, "input",
+                                      false);
+  auto *inputT = ctx.allocate(input);
+  inputT->getHandle().clear(1);
+  auto *weights = mod.createVariable(ElemKind::FloatTy, {8, 8}, "weights");
+  weights->getPayload().getHandle().clear(0.5);
+  auto *MM = F->createMatMul("matmul", input, weights);
+  auto *save = F->createSave(ctx, "save", MM);
+  auto *result = ctx.allocate(save->getPlaceholder());
+
+  CPUBackend backend;
+  backend.setObjectCacheDir(dir);
+  ::glow::optimize(F, CompilationMode::Infer);
+  ::glow::lower(F, backend);
+  ::glow::optimize(F, CompilationMode::Infer);
+  auto compiled = backend.compile(F, ctx);
+  EXPECT_FALSE(static_cast<CPUFunction *>(compiled.get())->isReentrant());
+  compiled->execute();
+  EXPECT_EQ(result->getHandle().at({0, 0}), 4);
+
+  inputT->getHandle().clear(2);
+  compiled->execute();
+  EXPECT_EQ(result->getHandle().at({0, 0}), 8);
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+using TCellGenerator = void (*)(Context &, Function *,
+                                const std::vector<Node *> &, unsigned, unsigned,
+                                std::vector<NodeValue> &);
+
+static void buildLSTM(Context &ctx, Function *F,
+                      const std::vector<Node *> &slicesX, unsigned hiddenSize,
+                      unsigned outputSize, std::vector<NodeValue> &outputs) {
+  F->createLSTM(ctx, "LSTM", slicesX, 4, hiddenSize, outputSize, outputs);
+}
+
+static void buildGRU(Context &ctx, Function *F,
+                     const std::vector<Node *> &slicesX, unsigned hiddenSize,
+                     unsigned outputSize, std::vector<NodeValue> &outputs) {
+  F->createGRU(ctx, "GRU", slicesX, 4, hiddenSize, outputSize, outputs);
+}
+
+/// A CPU backend that records the statistics of the element-wise code of the
+/// last function it compiled.
+class StatsCPUBackend : public CPUBackend {
+  /// An LLVMIRGen that copies its statistics to \p stats_ once it generated
+  /// the code of the function.
+  class StatsLLVMIRGen : public LLVMIRGen {
+    LLVMIRGen::DataParallelStats &stats_;
+
+  public:
+    StatsLLVMIRGen(IRFunction *IR, AllocationsInfo &allocationsInfo,
+                   LLVMIRGen::DataParallelStats &stats)
+        : LLVMIRGen(IR, allocationsInfo, ""), stats_(stats) {}
+
+    void generateLLVMIRForModule(llvm::IRBuilder<> &builder) override {
+      LLVMIRGen::generateLLVMIRForModule(builder);
+      stats_ = getDataParallelStats();
+    }
+  };
+
+public:
+  /// The statistics of the last compiled function.
+  mutable LLVMIRGen::DataParallelStats stats{};
+
+protected:
+  std::unique_ptr<LLVMIRGen>
+  createIRGen(IRFunction *IR, AllocationsInfo &allocationsInfo) const override {
+    return llvm::make_unique<StatsLLVMIRGen>(IR, allocationsInfo, stats);
+  }
+};
+
+/// Compile the recurrent network built by \p cell with and without the loop
+/// nests that fuse the broadcasts of the biases into the data-parallel
+/// kernels. Check that the fused code makes fewer passes over memory for the
+/// same instructions, and computes the same result.
+static void testLoopNestFusion(TCellGenerator cell) {
+  PseudoRNG PRNG;
+  Module mod;
+  Function *F = mod.createFunction("main");
+  Context ctx;
+  std::vector<Node *> slicesX;
+  for (unsigned i = 0; i < 3; i++) {
+    auto *X = mod.createPlaceholder(ElemKind::FloatTy, {4, 8}, "X", false);
+    ctx.allocate(X)->getHandle().randomize(-1.0, 1.0, PRNG);
+    slicesX.push_back(X);
+  }
+  std::vector<NodeValue> outputs;
+  cell(ctx, F, slicesX, 16, 8, outputs);
+  std::vector<Tensor *> results;
+  for (auto &output : outputs) {
+    auto *save = F->createSave(ctx, "save", output);
+    results.push_back(ctx.allocate(save->getPlaceholder()));
+  }
+
+  StatsCPUBackend backend;
+  ::glow::optimize(F, CompilationMode::Infer);
+  ::glow::lower(F, backend);
+  ::glow::optimize(F, CompilationMode::Infer);
+
+  bool oldFuseLoopNests = fuseLoopNests;
+  fuseLoopNests = false;
+  backend.compile(F, ctx)->execute();
+  auto unfused = backend.stats;
+  std::vector<Tensor> expected;
+  for (auto *result : results) {
+    expected.push_back(result->clone());
+    result->zero();
+  }
+
+  fuseLoopNests = true;
+  backend.compile(F, ctx)->execute();
+  fuseLoopNests = oldFuseLoopNests;
+  auto fused = backend.stats;
+  for (size_t i = 0, e = results.size(); i < e; i++) {
+    EXPECT_TRUE(results[i]->isEqual(expected[i]));
+  }
+
+  EXPECT_LT(fused.passes, unfused.passes);
+  EXPECT_EQ(fused.instrs, unfused.instrs);
+}
+
+/// Check the fusion of the loop nests on an LSTM.
+TEST(CPUFunction, loopNestFusionLSTM) { testLoopNestFusion(buildLSTM); }
+
+/// Check the fusion of the loop nests on a GRU.
+TEST(CPUFunction, loopNestFusionGRU) { testLoopNestFusion(buildGRU); }
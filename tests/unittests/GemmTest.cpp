@@ -25,6 +25,7 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <cassert>
 #include <string>
 
@@ -36,6 +37,34 @@ extern "C" {
 extern void libjit_matmul_f(float *c, const float *a, const float *b,
                             const size_t *cDims, const size_t *aDims,
                             const size_t *bDims);
+extern void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW,
+                             const int8_t *rhsW, const size_t *outWdims,
+                             const size_t *lhsWdims, const size_t *rhsWdims,
+                             int32_t outOffset, int32_t lhsOffset,
+                             int32_t rhsOffset, int32_t outPre, int32_t outPost,
+                             int32_t outScale);
+}
+
+/// Reference int8 matrix multiplication, which subtracts the offsets from
+/// every element and rescales every result individually.
+static void referenceMatMulI8(Tensor *out, Tensor *lhs, Tensor *rhs,
+                              int32_t outOffset, int32_t lhsOffset,
+                              int32_t rhsOffset, int32_t outPre,
+                              int32_t outPost, int32_t outScale) {
+  auto outH = out->getHandle<int8_t>();
+  auto lhsH = lhs->getHandle<int8_t>();
+  auto rhsH = rhs->getHandle<int8_t>();
+  int32_t rtn = (outPost > 0) ? (1 << (outPost - 1)) : 0;
+  for (size_t x = 0; x < outH.dims()[0]; x++) {
+    for (size_t y = 0; y < outH.dims()[1]; y++) {
+      int32_t sum = 0;
+      for (size_t i = 0; i < lhsH.dims()[1]; i++) {
+        sum += (lhsH.at({x, i}) - lhsOffset) * (rhsH.at({i, y}) - rhsOffset);
+      }
+      int32_t s = ((((sum >> outPre) * outScale) + rtn) >> outPost) + outOffset;
+      outH.at({x, y}) = std::min(std::max(s, -128), 127);
+    }
+  }
 }
 
 void infer(Tensor *out, Tensor *lhs, Tensor *rhs) {
@@ -88,3 +117,37 @@ TEST(Gemm, jitTest) {
     }
   }
 }
+
+TEST(Gemm, jitTestInt8) {
+  PseudoRNG PRNG;
+
+  for (size_t m : {1, 4, 5, 17}) {
+    for (size_t n : {1, 16, 17, 300}) {
+      for (size_t k : {1, 3, 64, 129}) {
+        Tensor lhs(ElemKind::Int8QTy, {m, k}, 1.0, 0);
+        Tensor rhs(ElemKind::Int8QTy, {k, n}, 1.0, 0);
+        lhs.getHandle<int8_t>().randomize(-128, 127, PRNG);
+        rhs.getHandle<int8_t>().randomize(-128, 127, PRNG);
+        Tensor out1(ElemKind::Int8QTy, {m, n}, 1.0, 0);
+        Tensor out2(ElemKind::Int8QTy, {m, n}, 1.0, 0);
+
+        int32_t outOffset = 5;
+        int32_t lhsOffset = -3;
+        int32_t rhsOffset = 7;
+        int32_t outPre = 2;
+        int32_t outPost = 15;
+        int32_t outScale = 150;
+        libjit_matmul_i8((int8_t *)out1.getUnsafePtr(),
+                         (int8_t *)lhs.getUnsafePtr(),
+                         (int8_t *)rhs.getUnsafePtr(), out1.dims().data(),
+                         lhs.dims().data(), rhs.dims().data(), outOffset,
+                         lhsOffset, rhsOffset, outPre, outPost, outScale);
+
+        referenceMatMulI8(&out2, &lhs, &rhs, outOffset, lhsOffset, rhsOffset,
+                          outPre, outPost, outScale);
+
+        EXPECT_TRUE(out1.isEqual(out2, 0));
+      }
+    }
+  }
+}
@@ -42,8 +42,6 @@ protected:
 
 class InterpAndCPU : public Operator {};
 
-class InterpOnly : public Operator {};
-
 TEST_P(Operator, pow) {
   auto *X = mod_.createVariable(ElemKind::FloatTy, {1, 1, 3}, "X");
   auto *Y = mod_.createVariable(ElemKind::FloatTy, {2}, "Y");
@@ -2492,6 +2490,57 @@ TEST_P(Operator, GroupConvolution) {
   EXPECT_FLOAT_EQ(result.at({0, 1, 0, 5}), (13 + 14 + 15 + 16) * 100000);
 }
 
+/// Check a strided and padded group convolution with 16 output channels per
+/// group, which the blocked kernels process 8 channels at a time, against a
+/// naive computation.
+TEST_P(Operator, GroupConvolutionDepth16) {
+  auto *input = mod_.createVariable(ElemKind::FloatTy, {2, 5, 6, 8}, "input");
+  input->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *filter =
+      mod_.createVariable(ElemKind::FloatTy, {32, 3, 3, 4}, "filter");
+  filter->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *bias = mod_.createVariable(ElemKind::FloatTy, {32}, "bias");
+  bias->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+
+  auto outTy = mod_.uniqueType(ElemKind::FloatTy, {2, 3, 3, 32});
+  ConvolutionNode *CN = F_->createConv("Conv", input, filter, bias, outTy,
+                                       {3, 3}, {2, 2}, {1, 1, 1, 1}, 2);
+  SaveNode *S = F_->createSave("save", CN);
+
+  Context ctx;
+  EE_.compile(CompilationMode::Infer, F_, ctx);
+  EE_.run();
+
+  auto result = S->getVariable()->getPayload().getHandle();
+  auto IH = input->getHandle();
+  auto FH = filter->getHandle();
+  auto BH = bias->getHandle();
+  for (size_t n = 0; n < 2; n++) {
+    for (size_t ax = 0; ax < 3; ax++) {
+      for (size_t ay = 0; ay < 3; ay++) {
+        for (size_t d = 0; d < 32; d++) {
+          size_t g = d / 16;
+          float sum = BH.at({d});
+          for (size_t fx = 0; fx < 3; fx++) {
+            for (size_t fy = 0; fy < 3; fy++) {
+              ssize_t ox = ssize_t(ax * 2 + fx) - 1;
+              ssize_t oy = ssize_t(ay * 2 + fy) - 1;
+              if (ox < 0 || oy < 0 || ox >= 5 || oy >= 6) {
+                continue;
+              }
+              for (size_t fd = 0; fd < 4; fd++) {
+                sum += FH.at({d, fx, fy, fd}) *
+                       IH.at({n, size_t(ox), size_t(oy), g * 4 + fd});
+              }
+            }
+          }
+          EXPECT_NEAR(result.at({n, ax, ay, d}), sum, 1e-5);
+        }
+      }
+    }
+  }
+}
+
 /// Check non-square padding for convolution. The first conv has non-square
 /// padding, while the second one has zero padding. The second conv's input is
 /// the same as the first one's after-padding input. All other parameters of the
@@ -2986,7 +3035,7 @@ TEST_P(Operator, testQuantizedBatchAdd) {
   }
 }
 
-TEST_P(InterpOnly, SparseLengthsSum) {
+TEST_P(InterpAndCPU, SparseLengthsSum) {
   /*
     DATA  = [
         [1.0, 1.2],
@@ -3033,7 +3082,7 @@ TEST_P(InterpOnly, SparseLengthsSum) {
   EXPECT_TRUE(expected.isEqual(result));
 }
 
-TEST_P(InterpOnly, SparseLengthsWeightedSum) {
+TEST_P(InterpAndCPU, SparseLengthsWeightedSum) {
   /*
     DATA  =   [2.0, -0.5, 13]
     WEIGHTS = [3, 1, 0, 0, 0, 0, 2, -0.5]
@@ -3084,6 +3133,164 @@ TEST_P(InterpOnly, SparseLengthsWeightedSum) {
   EXPECT_TRUE(expected.isEqual(result));
 }
 
+TEST_P(InterpAndCPU, RowwiseQuantizedSparseLengthsWeightedSum) {
+  /*
+    DATA  =   [2.0, -0.5, 13]
+    WEIGHTS = [3, 1, 0, 0, 0, 0, 2, -0.5]
+    INDICES = [1, 0, 2, 0, 1, 2, 2, 0]
+    LENGTHS = [3, 0, 3, 2]
+    OUTPUT =  [0.5, 0, 0, 25]
+  */
+  Tensor data(ElemKind::FloatTy, {3});
+  auto *weights = mod_.createVariable(ElemKind::FloatTy, {8}, "weights");
+  auto *indices = mod_.createVariable(ElemKind::Int64ITy, {8}, "indices");
+  auto *lengths = mod_.createVariable(ElemKind::Int64ITy, {4}, "lengths");
+
+  data.getHandle() = {
+      2.0,
+      -0.5,
+      13,
+  };
+  weights->getPayload().getHandle() = {
+      3, 1, 0, 0, 0, 0, 2, -0.5,
+  };
+  indices->getPayload().getHandle<int64_t>() = {
+      1, 0, 2, 0, 1, 2, 2, 0,
+  };
+  lengths->getPayload().getHandle<int64_t>() = {
+      3,
+      0,
+      3,
+      2,
+  };
+
+  auto R = F_->createRowwiseQuantizedSparseLengthsWeightedSum(
+      "RQSLWS", data, weights, indices, lengths);
+  auto S = F_->createSave("save", R);
+
+  Context ctx;
+  EE_.compile(CompilationMode::Infer, F_, ctx);
+  EE_.run();
+
+  Tensor &result = llvm::cast<Variable>(S->getOutput())->getPayload();
+  Tensor expected(ElemKind::FloatTy, {4});
+  expected.getHandle() = {
+      0.5,
+      0,
+      0,
+      25,
+  };
+
+  EXPECT_TRUE(expected.isEqual(result));
+}
+
+TEST_P(InterpAndCPU, RowwiseQuantizedSparseLengthsSum) {
+  /*
+    DATA  = [
+        [1.0, 1.2],
+        [2.3, 3.4],
+        [4.5, 5.7],
+    ]
+    INDICES = [2, 0, 1, 2, 0, 0, 0, 0]
+    LENGTHS = [2, 0, 2, 1, 3]
+    OUTPUT = [
+        [5.5, 6.9],
+        [0.0, 0.0],
+        [6.8, 9.1],
+        [1.0, 1.2],
+        [3.0, 3.6],
+    ]
+  */
+  Tensor data(ElemKind::FloatTy, {3, 2});
+  auto *indices = mod_.createVariable(ElemKind::Int64ITy, {8}, "indices");
+  auto *lengths = mod_.createVariable(ElemKind::Int64ITy, {5}, "lengths");
+
+  // The rows have two elements, which are the minimum and the maximum of the
+  // row, so they are quantized without loss.
+  data.getHandle() = {
+      1.0f, 1.2f, 2.3f, 3.4f, 4.5f, 5.7f,
+  };
+  indices->getPayload().getHandle<int64_t>() = {
+      2, 0, 1, 2, 0, 0, 0, 0,
+  };
+  lengths->getPayload().getHandle<int64_t>() = {
+      2, 0, 2, 1, 3,
+  };
+
+  auto R = F_->createRowwiseQuantizedSparseLengthsSum("RQSLS", data, indices,
+                                                      lengths);
+  auto S = F_->createSave("save", R);
+
+  Context ctx;
+  EE_.compile(CompilationMode::Infer, F_, ctx);
+  EE_.run();
+
+  Tensor &result = llvm::cast<Variable>(S->getOutput())->getPayload();
+  Tensor expected(ElemKind::FloatTy, {5, 2});
+  expected.getHandle() = {
+      5.5f, 6.9f, 0.0f, 0.0f, 6.8f, 9.1f, 1.0f, 1.2f, 3.0f, 3.6f,
+  };
+
+  EXPECT_TRUE(expected.isEqual(result));
+}
+
+TEST_P(InterpAndCPU, FusedRowwiseQuantizedSparseLengthsWeightedSum) {
+  /*
+    DATA  = [
+        [1.0, 1.2],
+        [2.3, 3.4],
+        [4.5, 5.7],
+    ]
+    WEIGHTS = [3, 1, 0, 0, 0, 0, 2, -0.5]
+    INDICES = [1, 0, 2, 0, 1, 2, 2, 0]
+    LENGTHS = [3, 0, 3, 2]
+    OUTPUT =  [
+        [7.9, 11.4],
+        [0.0, 0.0],
+        [0.0, 0.0],
+        [8.5, 10.8],
+    ]
+  */
+  Tensor data(ElemKind::FloatTy, {3, 2});
+  auto *weights = mod_.createVariable(ElemKind::FloatTy, {8}, "weights");
+  auto *indices = mod_.createVariable(ElemKind::Int64ITy, {8}, "indices");
+  auto *lengths = mod_.createVariable(ElemKind::Int64ITy, {4}, "lengths");
+
+  // The rows have two elements, which are the minimum and the maximum of the
+  // row, so they are quantized without loss.
+  data.getHandle() = {
+      1.0f, 1.2f, 2.3f, 3.4f, 4.5f, 5.7f,
+  };
+  weights->getPayload().getHandle() = {
+      3, 1, 0, 0, 0, 0, 2, -0.5,
+  };
+  indices->getPayload().getHandle<int64_t>() = {
+      1, 0, 2, 0, 1, 2, 2, 0,
+  };
+  lengths->getPayload().getHandle<int64_t>() = {
+      3,
+      0,
+      3,
+      2,
+  };
+
+  auto R = F_->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      "FRQSLWS", data, weights, indices, lengths);
+  auto S = F_->createSave("save", R);
+
+  Context ctx;
+  EE_.compile(CompilationMode::Infer, F_, ctx);
+  EE_.run();
+
+  Tensor &result = llvm::cast<Variable>(S->getOutput())->getPayload();
+  Tensor expected(ElemKind::FloatTy, {4, 2});
+  expected.getHandle() = {
+      7.9f, 11.4f, 0.0f, 0.0f, 0.0f, 0.0f, 8.5f, 10.8f,
+  };
+
+  EXPECT_TRUE(expected.isEqual(result));
+}
+
 /// Stack many slices/reshapes together. Some of these may be turned into tensor
 /// views stacked onto each other.
 TEST_P(Operator, sliceReshape) {
@@ -3362,9 +3569,6 @@ TEST_P(InterpAndCPU, insertTensorTest) {
   }
 }
 
-INSTANTIATE_TEST_CASE_P(Interpreter, InterpOnly,
-                        ::testing::Values(BackendKind::Interpreter));
-
 INSTANTIATE_TEST_CASE_P(Interpreter, InterpAndCPU,
                         ::testing::Values(BackendKind::Interpreter));
 
@@ -15,9 +15,13 @@
  */
 
 #include "glow/Support/Random.h"
+#include "glow/Support/ThreadPool.h"
 
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <vector>
+
 using namespace glow;
 
 // Test that nextRandInt generates every number in the closed interval [lb, ub].
@@ -49,3 +53,36 @@ TEST(Utils, deterministicPRNG) {
     EXPECT_EQ(dist(genA), dist(genB));
   }
 }
+
+// Test that all work items submitted to a ThreadPool are executed.
+TEST(Utils, threadPoolSubmit) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.getNumWorkers(), 4);
+  std::atomic<int> counter{0};
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 100; i++) {
+    futures.push_back(pool.submit([&counter] { counter++; }));
+  }
+  for (auto &future : futures) {
+    future.wait();
+  }
+  EXPECT_EQ(counter, 100);
+}
+
+// Test that parallelFor runs every task exactly once, also when it is invoked
+// concurrently from the workers of the same pool.
+TEST(Utils, threadPoolParallelFor) {
+  ThreadPool pool(3);
+  std::vector<std::atomic<int>> hits(1000);
+  pool.parallelFor(hits.size(), [&hits](size_t i) { hits[i]++; });
+  for (auto &hit : hits) {
+    EXPECT_EQ(hit, 1);
+  }
+
+  // Nested parallel loops must not deadlock even if all workers are busy.
+  std::atomic<int> counter{0};
+  pool.parallelFor(8, [&pool, &counter](size_t) {
+    pool.parallelFor(16, [&counter](size_t) { counter++; });
+  });
+  EXPECT_EQ(counter, 8 * 16);
+}
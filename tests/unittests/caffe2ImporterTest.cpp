@@ -348,3 +348,105 @@ TEST(caffe2, parallelBatchedMatmulRHS) {
   // We don't actually check that the output is correct, because this
   // should be covered in the OperatorTest for MatMul already.
 }
+
+/// Test loading a SparseLengthsWeightedSumFused8BitRowwise op, whose data is
+/// loaded from a GivenTensorByteStringToUInt8Fill op.
+/// DATA  = [[1.0, 2.0], [0.0, 3.0], [1.0, 2.0]] in the fused uint8 layout.
+/// WEIGHTS = [1.0, 2.0, 0.5]
+/// INDICES = [2, 0, 1]
+/// LENGTHS = [2, 1]
+/// OUTPUT = [[3.0, 6.0], [0.0, 1.5]]
+TEST(caffe2, importFusedRowwiseQuantizedSparseLengthsWeightedSum) {
+  ExecutionEngine EE{BackendKind::Interpreter};
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  std::string NetDescFilename(
+      "tests/models/caffe2Models/"
+      "fused_rowwise_quantized_sparse_lengths_weighted_sum_predict_net.pbtxt");
+  std::string NetWeightFilename(
+      "tests/models/caffe2Models/fused_rowwise_quantized_init_net.pbtxt");
+
+  Variable *output;
+  Tensor weights(ElemKind::FloatTy, {3});
+  Tensor indices(ElemKind::Int64ITy, {3});
+  Tensor lengths(ElemKind::Int64ITy, {2});
+  weights.getHandle() = {1.0, 2.0, 0.5};
+  indices.getHandle<int64_t>() = {2, 0, 1};
+  lengths.getHandle<int64_t>() = {2, 1};
+  // Destroy the loader after the graph is loaded since the following execution
+  // will not depend on anyting from the loader.
+  {
+    caffe2ModelLoader caffe2LD(NetDescFilename, NetWeightFilename,
+                               {"weights", "indices", "lengths"},
+                               {&weights, &indices, &lengths}, *F);
+    output = caffe2LD.getSingleOutput();
+  }
+
+  // The data is fused: each row holds 2 elements, its scale and its offset.
+  auto *saveNode = getSaveNodeFromVariable(output);
+  auto *SLWS =
+      llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsWeightedSumNode>(
+          saveNode->getInput().getNode());
+  ASSERT_TRUE(SLWS);
+  auto *data = llvm::dyn_cast<Variable>(SLWS->getData().getNode());
+  ASSERT_TRUE(data);
+  EXPECT_EQ(data->getElementType(), ElemKind::UInt8FusedQTy);
+  const size_t dataDims[] = {3, 10};
+  EXPECT_EQ(data->dims(), llvm::makeArrayRef(dataDims));
+
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+  EE.run();
+
+  auto result = output->getHandle();
+  std::vector<size_t> expectedDims = {2, 2};
+  std::vector<float> expectedValues = {3.0, 6.0, 0.0, 1.5};
+  EXPECT_TRUE(result.dims().vec() == expectedDims);
+  for (size_t i = 0; i < expectedValues.size(); i++) {
+    EXPECT_FLOAT_EQ(result.raw(i), expectedValues[i]);
+  }
+}
+
+/// Test loading a SparseLengthsSumFused8BitRowwise op.
+/// DATA  = [[1.0, 2.0], [0.0, 3.0], [1.0, 2.0]] in the fused uint8 layout.
+/// INDICES = [2, 0, 1, 1]
+/// LENGTHS = [1, 0, 3]
+/// OUTPUT = [[1.0, 2.0], [0.0, 0.0], [1.0, 8.0]]
+TEST(caffe2, importFusedRowwiseQuantizedSparseLengthsSum) {
+  ExecutionEngine EE{BackendKind::Interpreter};
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  std::string NetDescFilename(
+      "tests/models/caffe2Models/"
+      "fused_rowwise_quantized_sparse_lengths_sum_predict_net.pbtxt");
+  std::string NetWeightFilename(
+      "tests/models/caffe2Models/fused_rowwise_quantized_init_net.pbtxt");
+
+  Variable *output;
+  Tensor indices(ElemKind::Int64ITy, {4});
+  Tensor lengths(ElemKind::Int64ITy, {3});
+  indices.getHandle<int64_t>() = {2, 0, 1, 1};
+  lengths.getHandle<int64_t>() = {1, 0, 3};
+  // Destroy the loader after the graph is loaded since the following execution
+  // will not depend on anyting from the loader.
+  {
+    caffe2ModelLoader caffe2LD(NetDescFilename, NetWeightFilename,
+                               {"indices", "lengths"}, {&indices, &lengths},
+                               *F);
+    output = caffe2LD.getSingleOutput();
+  }
+
+  Context ctx;
+  EE.compile(CompilationMode::Infer, F, ctx);
+  EE.run();
+
+  auto result = output->getHandle();
+  std::vector<size_t> expectedDims = {3, 2};
+  std::vector<float> expectedValues = {1.0, 2.0, 0.0, 0.0, 1.0, 8.0};
+  EXPECT_TRUE(result.dims().vec() == expectedDims);
+  for (size_t i = 0; i < expectedValues.size(); i++) {
+    EXPECT_FLOAT_EQ(result.raw(i), expectedValues[i]);
+  }
+}
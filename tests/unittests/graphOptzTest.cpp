@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "glow/Backends/Backend.h"
 #include "glow/Graph/Context.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Node.h"
@@ -21,10 +22,14 @@
 #include "glow/IR/IR.h"
 #include "glow/Optimizer/Optimizer.h"
 
+#include "llvm/Support/CommandLine.h"
+
 #include "gtest/gtest.h"
 
 using namespace glow;
 
+extern llvm::cl::opt<unsigned> constFoldMaxSizeOpt;
+
 class GraphOptz : public ::testing::Test {
 public:
   GraphOptz() { F_ = mod_.createFunction("main"); }
@@ -1922,3 +1927,98 @@ TEST_F(GraphOptz, ReshapePrivateVarOneUse) {
   // The new Variable should have the same shape as the original second Reshape.
   EXPECT_TRUE(V->getType()->dims().equals(reshape2));
 }
+
+/// Check that a subgraph that only depends on constant variables is evaluated
+/// at compile time and replaced by a new constant variable.
+TEST_F(GraphOptz, constantFoldSubgraph) {
+  auto *A = mod_.createVariable(ElemKind::FloatTy, {2, 3}, "A",
+                                VisibilityKind::Private, false);
+  auto *B = mod_.createVariable(ElemKind::FloatTy, {3, 2}, "B",
+                                VisibilityKind::Private, false);
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 2}, "input", false);
+  A->getHandle() = {1, 2, 3, 4, 5, 6};
+  B->getHandle() = {1, -1, 2, -2, 3, -3};
+
+  auto *MM = F_->createMatMul("matmul", A, B);
+  auto *R = F_->createRELU("relu", MM);
+  auto *add = F_->createAdd("add", input, R);
+  F_->createSave(ctx_, "ret", add);
+  EXPECT_EQ(F_->getNodes().size(), 4);
+
+  std::unique_ptr<Backend> backend(createBackend(BackendKind::Interpreter));
+  ::glow::optimize(F_, CompilationMode::Infer, backend.get());
+
+  // The MatMul and the Relu were folded into a variable.
+  ASSERT_EQ(F_->getNodes().size(), 2);
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::MatMulNodeKind), 0);
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::ReluNodeKind), 0);
+  auto *V = llvm::dyn_cast<Variable>(add->getRHS().getNode());
+  ASSERT_TRUE(V);
+  EXPECT_TRUE(V->getType()->dims().equals({2, 2}));
+  auto H = V->getHandle();
+  EXPECT_FLOAT_EQ(H.at({0, 0}), 14);
+  EXPECT_FLOAT_EQ(H.at({0, 1}), 0);
+  EXPECT_FLOAT_EQ(H.at({1, 0}), 32);
+  EXPECT_FLOAT_EQ(H.at({1, 1}), 0);
+  // The original variables are unused and have been removed.
+  EXPECT_EQ(mod_.getVars().size(), 1);
+}
+
+/// Check that constant folding does not create variables larger than the
+/// size limit.
+TEST_F(GraphOptz, constantFoldSizeLimit) {
+  auto *A = mod_.createVariable(ElemKind::FloatTy, {4, 64}, "A",
+                                VisibilityKind::Private, false);
+  auto *B = mod_.createVariable(ElemKind::FloatTy, {64, 1}, "B",
+                                VisibilityKind::Private, false);
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 64}, "input", false);
+  A->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  B->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+
+  // The Tanh of A has more elements than the limit, the Tanh of B does not.
+  auto *TA = F_->createTanh("tanhA", A);
+  auto *TB = F_->createTanh("tanhB", B);
+  auto *mul = F_->createMul("mul", input, TA);
+  auto *MM = F_->createMatMul("matmul", mul, TB);
+  F_->createSave(ctx_, "ret", MM);
+
+  std::unique_ptr<Backend> backend(createBackend(BackendKind::Interpreter));
+  unsigned oldLimit = constFoldMaxSizeOpt;
+  constFoldMaxSizeOpt = 128;
+  ::glow::optimize(F_, CompilationMode::Infer, backend.get());
+  constFoldMaxSizeOpt = oldLimit;
+
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::TanhNodeKind), 1);
+  EXPECT_EQ(mul->getRHS().getNode(), TA);
+  EXPECT_TRUE(llvm::isa<Variable>(MM->getRHS().getNode()));
+}
+
+/// Check that constant folding does not replace constants by a much larger
+/// result, but still folds the subgraphs of its inputs.
+TEST_F(GraphOptz, constantFoldGrowth) {
+  auto *A = mod_.createVariable(ElemKind::FloatTy, {4, 1}, "A",
+                                VisibilityKind::Private, false);
+  auto *B = mod_.createVariable(ElemKind::FloatTy, {1, 64}, "B",
+                                VisibilityKind::Private, false);
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 64}, "input", false);
+  A->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  B->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+
+  // The outer product has almost four times the elements of A and B, the Tanh
+  // of B has as many elements as B.
+  auto *T = F_->createTanh("tanh", B);
+  auto *MM = F_->createMatMul("matmul", A, T);
+  auto *add = F_->createAdd("add", input, MM);
+  F_->createSave(ctx_, "ret", add);
+
+  std::unique_ptr<Backend> backend(createBackend(BackendKind::Interpreter));
+  ::glow::optimize(F_, CompilationMode::Infer, backend.get());
+
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::MatMulNodeKind), 1);
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::TanhNodeKind), 0);
+  EXPECT_TRUE(llvm::isa<Variable>(MM->getRHS().getNode()));
+  EXPECT_EQ(MM->getLHS().getNode(), A);
+}
@@ -912,3 +912,32 @@ TEST(Graph, placeholder) {
   K = F->createSoftMax("SoftMax", K, S);
   F->createSave("Save", K);
 }
+
+/// Check that the structural hash of a function depends on its structure and
+/// on the content of its constants, but not on the addresses or the names of
+/// its nodes.
+TEST(Graph, structuralHash) {
+  auto build = [](Module &M, llvm::StringRef nodeName, float weight,
+                  unsigned_t axis, bool trainable) {
+    Function *F = M.createFunction("F");
+    auto *X = M.createPlaceholder(ElemKind::FloatTy, {2, 3}, "X", false);
+    auto *W = M.createVariable(ElemKind::FloatTy, {2, 3}, "W",
+                               VisibilityKind::Private, trainable);
+    W->getPayload().getHandle().clear(weight);
+    Node *N = F->createMul(nodeName, X, W);
+    N = F->createTranspose("transpose", N, {1, 0});
+    N = F->createConcat("concat", {N, N}, axis);
+    F->createSave("save", N);
+    return F;
+  };
+
+  Module M1, M2, M3, M4, M5, M6;
+  auto hash = build(M1, "mul", 1, 0, false)->getStructuralHash();
+  EXPECT_EQ(hash, build(M2, "anotherMul", 1, 0, false)->getStructuralHash());
+  EXPECT_NE(hash, build(M3, "mul", 2, 0, false)->getStructuralHash());
+  EXPECT_NE(hash, build(M4, "mul", 1, 1, false)->getStructuralHash());
+
+  // The content of the trainable variables is not part of the hash.
+  EXPECT_EQ(build(M5, "mul", 1, 0, true)->getStructuralHash(),
+            build(M6, "mul", 3, 0, true)->getStructuralHash());
+}
@@ -15,6 +15,8 @@
  */
 
 #include "glow/CodeGen/MemoryAllocator.h"
+#include "glow/CodeGen/MemoryPlanner.h"
+#include "glow/Support/Random.h"
 
 #include "gtest/gtest.h"
 
@@ -320,3 +322,92 @@ TEST(MemAlloc, testGetMemorySize) {
   MemoryAllocator MA2("test1", 102);
   EXPECT_EQ(MA2.getMemorySize(), 102);
 }
+
+/// \returns true if no two buffers of \p sizes, which are live during
+/// \p lifetimes, share memory in the placement of \p MP while they are live.
+static bool
+isValidPlan(const MemoryPlanner &MP, const std::vector<uint64_t> &sizes,
+            const std::vector<std::pair<size_t, size_t>> &lifetimes) {
+  for (size_t i = 0; i < sizes.size(); i++) {
+    for (size_t j = i + 1; j < sizes.size(); j++) {
+      if (lifetimes[i].first > lifetimes[j].second ||
+          lifetimes[j].first > lifetimes[i].second) {
+        continue;
+      }
+      uint64_t a = MP.getAddress(reinterpret_cast<void *>(i + 1));
+      uint64_t b = MP.getAddress(reinterpret_cast<void *>(j + 1));
+      if (a < b + sizes[j] && b < a + sizes[i]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+TEST(MemoryPlanner, packing) {
+  // A and B are live at the same time, and so are B and C. Placing the
+  // buffers in the order of their allocation leaves a hole that is too small
+  // for C where A was.
+  MemoryPlanner MP("test");
+  void *A = reinterpret_cast<void *>(1);
+  void *B = reinterpret_cast<void *>(2);
+  void *C = reinterpret_cast<void *>(3);
+  MP.addBuffer(A, 64, 0, 1);
+  MP.addBuffer(B, 128, 0, 3);
+  MP.addBuffer(C, 128, 2, 3);
+  EXPECT_EQ(MP.getLowerBound(), 256);
+
+  EXPECT_EQ(MP.plan(MemoryPlanner::Strategy::FirstFit), 320);
+  EXPECT_EQ(MP.getAddress(C), 192);
+  EXPECT_GT(MP.getFragmentation(), 0);
+
+  EXPECT_EQ(MP.plan(MemoryPlanner::Strategy::GreedyBySize), 256);
+  EXPECT_EQ(MP.plan(MemoryPlanner::Strategy::GreedyByBreadth), 256);
+
+  EXPECT_EQ(MP.plan(), 256);
+  EXPECT_NE(MP.getStrategy(), MemoryPlanner::Strategy::FirstFit);
+  EXPECT_EQ(MP.getFragmentation(), 0);
+  EXPECT_EQ(MP.getAddress(B), 0);
+  EXPECT_EQ(MP.getAddress(C), 128);
+}
+
+TEST(MemoryPlanner, alignment) {
+  // The buffers are aligned to hold values of any type.
+  MemoryPlanner MP("test");
+  MP.addBuffer(reinterpret_cast<void *>(1), 10, 0, 1);
+  MP.addBuffer(reinterpret_cast<void *>(2), 10, 1, 2);
+  MP.addBuffer(reinterpret_cast<void *>(3), 10, 3, 4);
+  EXPECT_EQ(MP.plan(), 128);
+  EXPECT_EQ(MP.getAddress(reinterpret_cast<void *>(3)), 0);
+}
+
+TEST(MemoryPlanner, randomLifetimes) {
+  PseudoRNG PRNG;
+  for (unsigned iter = 0; iter < 20; iter++) {
+    MemoryPlanner MP("test");
+    std::vector<uint64_t> sizes;
+    std::vector<std::pair<size_t, size_t>> lifetimes;
+    for (size_t i = 0; i < 50; i++) {
+      size_t begin = PRNG.nextRandInt(0, 100);
+      sizes.push_back(64 * PRNG.nextRandInt(1, 16));
+      lifetimes.emplace_back(begin, begin + PRNG.nextRandInt(0, 20));
+      MP.addBuffer(reinterpret_cast<void *>(i + 1), sizes.back(),
+                   lifetimes.back().first, lifetimes.back().second);
+    }
+
+    uint64_t firstFit = MP.plan(MemoryPlanner::Strategy::FirstFit);
+    EXPECT_TRUE(isValidPlan(MP, sizes, lifetimes));
+    EXPECT_GE(firstFit, MP.getLowerBound());
+    MP.plan(MemoryPlanner::Strategy::GreedyBySize);
+    EXPECT_TRUE(isValidPlan(MP, sizes, lifetimes));
+    MP.plan(MemoryPlanner::Strategy::GreedyByBreadth);
+    EXPECT_TRUE(isValidPlan(MP, sizes, lifetimes));
+
+    // The best placement is never worse than the placement in the order of
+    // allocation.
+    uint64_t best = MP.plan();
+    EXPECT_TRUE(isValidPlan(MP, sizes, lifetimes));
+    EXPECT_LE(best, firstFit);
+    EXPECT_GE(best, MP.getLowerBound());
+  }
+}
@@ -16,12 +16,18 @@
 
 #include "BackendTestUtils.h"
 
+#include "glow/ExecutionEngine/DAGExecutor.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Optimizer/Partition.h"
 
 #include "gtest/gtest.h"
 
 #include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <limits>
 
 using namespace glow;
 
@@ -32,14 +38,52 @@ public:
 protected:
   Module mod_;
   Function *F_;
+
+  /// Create \p numTowers independent towers of \p depth fully connected
+  /// layers of width \p width that all read \p input, and add up their
+  /// results. \returns the placeholder that holds the sum.
+  Placeholder *createTowers(Placeholder *input, unsigned numTowers,
+                            unsigned depth, unsigned width) {
+    Node *I = F_->createFullyConnected("initial_fc", input, width);
+    Node *sum = nullptr;
+    for (unsigned i = 0; i < numTowers; i++) {
+      std::string tower = "tower" + std::to_string(i);
+      Node *T = I;
+      for (unsigned j = 0; j < depth; j++) {
+        std::string layer = tower + "_" + std::to_string(j);
+        T = F_->createFullyConnected(layer + "_fc", T, width);
+        T = F_->createTanh(layer + "_tanh", T);
+      }
+      sum = sum ? F_->createAdd(tower + "_add", sum, T) : T;
+    }
+    auto *output = mod_.createPlaceholder(sum->getType(0), "output", false);
+    F_->createSave("ret", sum, output);
+    return output;
+  }
+
+  /// Run the un-partitioned function with the tensors in \p ctx, and \returns
+  /// a copy of \p output. The tensor that backs \p output is cleared. A clone
+  /// of the function is compiled, so that the function that is partitioned
+  /// afterwards is not lowered.
+  Tensor executeReference(Context &ctx, Placeholder *output) {
+    ExecutionEngine EE;
+    EE.compile(CompilationMode::Infer, F_->clone("reference"), ctx);
+    EE.run();
+    Tensor ref = ctx.get(output)->clone();
+    ctx.get(output)->zero();
+    return ref;
+  }
 };
 
 /// Execute a graph of functions serially, which is the simplest approach.
+/// The placeholders that connect the partitions are backed by one shared
+/// context.
 static void executeSerial(const FunctionDAG &G, llvm::ArrayRef<Variable *> vars,
                           llvm::ArrayRef<Tensor *> inputs) {
+  Context ctx;
+  ctx.allocate(G.getFunctions().front()->getParent()->getPlaceholders());
   for (auto *F : G.getFunctions()) {
     ExecutionEngine EE;
-    Context ctx;
     EE.compile(CompilationMode::Infer, F, ctx);
 
     updateVariables(vars, inputs);
@@ -158,6 +202,208 @@ TEST_F(PartitionTest, Branchover) {
   EXPECT_TRUE(ref.isEqual(test));
 }
 
+TEST_F(PartitionTest, ParallelExecution) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 32}, "input", false);
+  auto *output = createTowers(input, 4, 2, 16);
+
+  Context ctx;
+  Tensor in(ElemKind::FloatTy, {4, 32});
+  in.getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  ctx.insert(input, in.clone());
+  ctx.allocate(output);
+
+  auto G = glow::partition(F_);
+  ASSERT_GT(G.getFunctions().size(), 4);
+
+  // Infer using the un-partitioned graph.
+  Tensor ref = executeReference(ctx, output);
+
+  // Infer using the partitioned graph, several times to exercise different
+  // interleavings of the towers.
+  DAGExecutor executor(BackendKind::Interpreter, 4);
+  executor.compile(CompilationMode::Infer, G, ctx);
+  EXPECT_EQ(executor.getTensor(output)->getUnsafePtr(),
+            ctx.get(output)->getUnsafePtr());
+  for (unsigned i = 0; i < 10; i++) {
+    executor.run();
+    EXPECT_TRUE(ref.isEqual(*ctx.get(output)));
+    ctx.get(output)->zero();
+  }
+}
+
+TEST_F(PartitionTest, CostModelTowers) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 32}, "input", false);
+  auto *output = createTowers(input, 4, 2, 16);
+
+  Context ctx;
+  Tensor in(ElemKind::FloatTy, {4, 32});
+  in.getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  ctx.insert(input, in.clone());
+  ctx.allocate(output);
+
+  auto basicBlockG = glow::partition(F_);
+  PartitionConfig config;
+  config.kind = PartitionKind::CostModel;
+  config.numPartitions = 4;
+  auto G = glow::partition(F_, config);
+  ASSERT_TRUE(G.verify());
+
+  // The towers are kept whole instead of being cut at every fan-out, and they
+  // can still run in parallel.
+  EXPECT_GT(G.getFunctions().size(), 1);
+  EXPECT_LT(G.getFunctions().size(), basicBlockG.getFunctions().size());
+  EXPECT_LT(estimateCriticalPath(G), estimateCost(F_).getTotal());
+
+  Tensor ref = executeReference(ctx, output);
+  DAGExecutor executor(BackendKind::Interpreter, 4);
+  executor.compile(CompilationMode::Infer, G, ctx);
+  executor.run();
+  EXPECT_TRUE(ref.isEqual(*ctx.get(output)));
+}
+
+TEST_F(PartitionTest, CostModelChain) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 32}, "input", false);
+  Node *N = input;
+  for (unsigned i = 0; i < 8; i++) {
+    N = F_->createFullyConnected("fc" + std::to_string(i), N, 32);
+    N = F_->createRELU("relu" + std::to_string(i), N);
+  }
+  auto *output =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 32}, "output", false);
+  F_->createSave("ret", N, output);
+
+  Context ctx;
+  Tensor in(ElemKind::FloatTy, {4, 32});
+  in.getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  ctx.insert(input, in.clone());
+  ctx.allocate(output);
+
+  // A chain is a single basic block, but the cost model splits it into
+  // partitions of similar cost.
+  ASSERT_EQ(glow::partition(F_).getFunctions().size(), 1);
+  PartitionConfig config;
+  config.kind = PartitionKind::CostModel;
+  config.numPartitions = 4;
+  auto G = glow::partition(F_, config);
+  ASSERT_EQ(G.getFunctions().size(), 4);
+  uint64_t maxCost = 0;
+  uint64_t minCost = std::numeric_limits<uint64_t>::max();
+  for (auto *F : G.getFunctions()) {
+    maxCost = std::max(maxCost, estimateCost(F).getTotal());
+    minCost = std::min(minCost, estimateCost(F).getTotal());
+  }
+  EXPECT_LT(maxCost, 2 * minCost);
+
+  Tensor ref = executeReference(ctx, output);
+  DAGExecutor executor(BackendKind::Interpreter, 2);
+  executor.compile(CompilationMode::Infer, G, ctx);
+  executor.run();
+  EXPECT_TRUE(ref.isEqual(*ctx.get(output)));
+}
+
+TEST_F(PartitionTest, CostModelMemoryBudget) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 64}, "input", false);
+  auto *output = createTowers(input, 2, 4, 64);
+
+  Context ctx;
+  Tensor in(ElemKind::FloatTy, {4, 64});
+  in.getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  ctx.insert(input, in.clone());
+  ctx.allocate(output);
+
+  PartitionConfig config;
+  config.kind = PartitionKind::CostModel;
+  auto unlimitedG = glow::partition(F_, config);
+  EXPECT_EQ(unlimitedG.getFunctions().size(), 1);
+
+  // Each fully connected layer has 16KB of weights, so a budget of 40KB
+  // allows at most two of them in each partition.
+  config.memoryBudget = 40 * 1024;
+  auto G = glow::partition(F_, config);
+  ASSERT_TRUE(G.verify());
+  EXPECT_GE(G.getFunctions().size(), 5);
+  for (auto *F : G.getFunctions()) {
+    unsigned numFC = 0;
+    for (auto &N : F->getNodes()) {
+      numFC += llvm::isa<FullyConnectedNode>(&N);
+    }
+    EXPECT_LE(numFC, 2);
+  }
+
+  Tensor ref = executeReference(ctx, output);
+  DAGExecutor executor(BackendKind::Interpreter, 2);
+  executor.compile(CompilationMode::Infer, G, ctx);
+  executor.run();
+  EXPECT_TRUE(ref.isEqual(*ctx.get(output)));
+}
+
+/// Report the estimated critical path and the measured execution time of a
+/// wide model for both partitioning strategies.
+TEST_F(PartitionTest, CriticalPathReport) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {4, 64}, "input", false);
+  auto *output = createTowers(input, 8, 4, 64);
+
+  Context ctx;
+  Tensor in(ElemKind::FloatTy, {4, 64});
+  in.getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  ctx.insert(input, in.clone());
+  ctx.allocate(output);
+  Tensor ref = executeReference(ctx, output);
+
+  uint64_t totalCost = estimateCost(F_).getTotal();
+  llvm::outs() << "total cost: " << totalCost << "\n";
+
+  auto report = [&](llvm::StringRef name, const PartitionConfig &config) {
+    auto G = glow::partition(F_, config);
+    ASSERT_TRUE(G.verify());
+    uint64_t criticalPath = estimateCriticalPath(G);
+    // The partitions only add the Saves of the values that cross from one
+    // partition to another, so the critical path costs at most as much as the
+    // whole function and these Saves.
+    uint64_t boundaryCost = 0;
+    for (auto *PF : G.getFunctions()) {
+      for (auto &N : PF->getNodes()) {
+        auto *SN = llvm::dyn_cast<SaveNode>(&N);
+        if (SN && SN->getPlaceholder() != output) {
+          boundaryCost += estimateCost(SN).getTotal();
+        }
+      }
+    }
+    EXPECT_LE(criticalPath, totalCost + boundaryCost);
+
+    DAGExecutor executor(BackendKind::Interpreter, 4);
+    executor.compile(CompilationMode::Infer, G, ctx);
+    constexpr unsigned numRuns = 5;
+    auto begin = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < numRuns; i++) {
+      executor.run();
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+    EXPECT_TRUE(ref.isEqual(*ctx.get(output)));
+
+    llvm::outs() << name << ": " << G.getFunctions().size()
+                 << " partitions, critical path: " << criticalPath << " ("
+                 << llvm::format("%.2f", double(criticalPath) / totalCost)
+                 << " of total), "
+                 << llvm::format("%.3f", elapsed.count() / numRuns)
+                 << " ms per run\n";
+  };
+
+  report("basic-block", PartitionConfig());
+  for (unsigned numPartitions : {2, 4, 8}) {
+    PartitionConfig config;
+    config.kind = PartitionKind::CostModel;
+    config.numPartitions = numPartitions;
+    report("cost-model/" + std::to_string(numPartitions), config);
+  }
+}
+
 TEST_F(PartitionTest, Train) {
   auto *input = mod_.createVariable(ElemKind::FloatTy, {1, 8}, "input",
                                     VisibilityKind::Public, false);
@@ -34,6 +34,73 @@ BB.newBackendSpecificInstr("CPUConvDKKC8")
     .addMember(MemberType::Unsigned, "Group")
     .autoIRGen();
 
+BB.newBackendSpecificInstr("CPUConvDKKC16")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUDepthwiseConv")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUWinogradConv")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUFusedConv")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUFusedConvAdd")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addOperand("Residual", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUFusedMatMul")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("LHS", OperandKind::In)
+    .addOperand("RHS", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .autoIRGen();
+
 BB.includeBackendSpecificVerification("glow/CPUSpecificInstrsVerification.h");
 
 #endif // GLOW_WITH_CPU
@@ -33,4 +33,89 @@ void CPUConvDKKC8Inst::verify() const {
          "Invalid Element Type");
 }
 
+void CPUConvDKKC16Inst::verify() const {
+  assert(getSrc()->dims()[3] % getGroup() == 0 &&
+         "Input channels must be divisible by group.");
+  assert(getDest()->dims()[3] % getGroup() == 0 &&
+         "Output channels must be divisible by group.");
+  assert(getDest()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getSrc()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getFilter()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getBias()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+}
+
+void CPUDepthwiseConvInst::verify() const {
+  assert(getSrc()->dims()[3] == getDest()->dims()[3] &&
+         "Depthwise convolution must preserve the channels.");
+  assert(getFilter()->dims()[2] == getDest()->dims()[3] &&
+         "Invalid filter dimensions");
+  assert(getDest()->getElementType() == getSrc()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getFilter()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getBias()->getElementType() &&
+         "Invalid Element Type");
+}
+
+void CPUWinogradConvInst::verify() const {
+  assert(getFilter()->dims()[1] == getSrc()->dims()[3] &&
+         "Invalid filter dimensions");
+  assert(getFilter()->dims()[2] == getDest()->dims()[3] &&
+         "Invalid filter dimensions");
+  assert(getDest()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getSrc()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getFilter()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getBias()->getElementType() &&
+         "Invalid Element Type");
+}
+
+void CPUFusedConvInst::verify() const {
+  assert(getSrc()->dims()[3] % getGroup() == 0 &&
+         "Input channels must be divisible by group.");
+  assert(getDest()->dims()[3] % getGroup() == 0 &&
+         "Output channels must be divisible by group.");
+  assert(getDest()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getSrc()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getFilter()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getBias()->getElementType() &&
+         "Invalid Element Type");
+}
+
+void CPUFusedConvAddInst::verify() const {
+  assert(getSrc()->dims()[3] % getGroup() == 0 &&
+         "Input channels must be divisible by group.");
+  assert(getDest()->dims()[3] % getGroup() == 0 &&
+         "Output channels must be divisible by group.");
+  assert(getDest()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getSrc()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getFilter()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getBias()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getType() == getResidual()->getType() &&
+         "Invalid residual type");
+}
+
+void CPUFusedMatMulInst::verify() const {
+  assert(getDest()->dims()[0] == getLHS()->dims()[0] &&
+         getDest()->dims()[1] == getRHS()->dims()[1] &&
+         getLHS()->dims()[1] == getRHS()->dims()[0] && "Invalid dimensions");
+  assert(getBias()->dims()[0] == getDest()->dims()[1] &&
+         "Invalid bias dimensions");
+  assert(getDest()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+}
+
 #endif // GLOW_WITH_CPU
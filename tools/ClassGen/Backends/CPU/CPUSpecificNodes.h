@@ -33,6 +33,91 @@ BB.newNode("CPUConvDKKC8")
     .setDocstring("This is a cpu-specific convolution implementation where the "
                   "filter is transposed to the shape [D/8, K, K, C, 8]");
 
+BB.newNode("CPUConvDKKC16")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific quantized convolution where the "
+                  "filter of each group is packed into zero-padded panels of "
+                  "16 output channels with the shape [G * ceil(D/G/16), K, K, "
+                  "C/G, 16]");
+
+BB.newNode("CPUDepthwiseConv")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific depthwise convolution, where each "
+                  "channel is convolved with its own filter. The filter is "
+                  "transposed to the shape [K, K, C]");
+
+BB.newNode("CPUWinogradConv")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific 3x3 stride-1 convolution that uses "
+                  "the Winograd algorithm F(m x m, 3 x 3). The filter is "
+                  "transformed ahead of time to the shape [(m + 2)^2, C, D]. "
+                  "The output is clamped to [ClampMin, ClampMax], which fuses "
+                  "the Max and Min with splats that follow the convolution");
+
+BB.newNode("CPUFusedConv")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific float convolution whose output is "
+                  "clamped to [ClampMin, ClampMax], which fuses the Max and "
+                  "Min with splats (e.g. Relu) that follow the convolution. "
+                  "The filter has the regular layout, or the DKKC8 layout "
+                  "[D/8, K, K, C, 8]");
+
+BB.newNode("CPUFusedConvAdd")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addInput("Residual")
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::Unsigned, "Group")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .addResultFromCtorArg()
+    .setDocstring("This is a CPUFusedConv that adds the tensor Residual to the "
+                  "output of the convolution before clamping it, which fuses "
+                  "the residual connections of ResNet-style networks");
+
+BB.newNode("CPUFusedMatMul")
+    .addInput("LHS")
+    .addInput("RHS")
+    .addInput("Bias")
+    .addMember(MemberType::Float, "ClampMin")
+    .addMember(MemberType::Float, "ClampMax")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific float matrix multiplication that "
+                  "adds the vector Bias to every row of the result and clamps "
+                  "it to [ClampMin, ClampMax]. It fuses a lowered "
+                  "FullyConnected node and the Relu that follows it");
+
 BB.includeBackendSpecificVerification("glow/CPUSpecificNodesVerification.h");
 
 #endif // GLOW_WITH_CPU
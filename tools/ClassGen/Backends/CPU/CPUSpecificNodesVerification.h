@@ -30,4 +30,110 @@ void CPUConvDKKC8Node::verify() const {
   assert(exp == odim && "Invalid output dimensions");
 }
 
+void CPUConvDKKC16Node::verify() const {
+  ShapeNHWC idim(getInput().getType()->dims());
+  ShapeNHWC odim(getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(idim.h, idim.w, getKernels(),
+                                           getStrides(), getPads());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, getBias().dims()[0]);
+  (void)exp;
+  assert(exp == odim && "Invalid output dimensions");
+  auto filterDims = getFilter().dims();
+  size_t panelsPerGroup = (odim.c / getGroup() + 15) / 16;
+  (void)filterDims;
+  (void)panelsPerGroup;
+  assert(filterDims.size() == 5 && filterDims[4] == 16 &&
+         filterDims[0] == getGroup() * panelsPerGroup &&
+         filterDims[3] == idim.c / getGroup() && "Invalid filter dimensions");
+  assert(getInput().getElementType() == ElemKind::Int8QTy &&
+         getFilter().getElementType() == ElemKind::Int8QTy &&
+         getResult().getElementType() == ElemKind::Int8QTy &&
+         "Only quantized convolutions are supported");
+}
+
+void CPUDepthwiseConvNode::verify() const {
+  ShapeNHWC idim(getInput().getType()->dims());
+  ShapeNHWC odim(getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(idim.h, idim.w, getKernels(),
+                                           getStrides(), getPads());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, idim.c);
+  (void)exp;
+  assert(exp == odim && "Invalid output dimensions");
+  auto filterDims = getFilter().dims();
+  (void)filterDims;
+  assert(filterDims.size() == 3 && filterDims[0] == getKernels()[0] &&
+         filterDims[1] == getKernels()[1] && filterDims[2] == idim.c &&
+         "Invalid filter dimensions");
+  assert(getBias().dims()[0] == idim.c && "Invalid bias dimensions");
+}
+
+void CPUWinogradConvNode::verify() const {
+  ShapeNHWC idim(getInput().getType()->dims());
+  ShapeNHWC odim(getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(idim.h, idim.w, {3, 3}, {1, 1},
+                                           getPads());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, getBias().dims()[0]);
+  (void)exp;
+  assert(exp == odim && "Invalid output dimensions");
+  auto filterDims = getFilter().dims();
+  (void)filterDims;
+  assert(filterDims.size() == 3 &&
+         (filterDims[0] == 4 * 4 || filterDims[0] == 6 * 6) &&
+         filterDims[1] == idim.c && filterDims[2] == odim.c &&
+         "Invalid filter dimensions");
+  assert(getInput().getElementType() == ElemKind::FloatTy &&
+         getFilter().getElementType() == ElemKind::FloatTy &&
+         getResult().getElementType() == ElemKind::FloatTy &&
+         "Only float convolutions are supported");
+}
+
+/// Verify the operands of the fused convolution \p N, whose filter has the
+/// regular or the DKKC8 layout.
+template <class FusedConvNode>
+static void verifyCPUFusedConv(const FusedConvNode *N) {
+  ShapeNHWC idim(N->getInput().getType()->dims());
+  ShapeNHWC odim(N->getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(idim.h, idim.w, N->getKernels(),
+                                           N->getStrides(), N->getPads());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, N->getBias().dims()[0]);
+  (void)exp;
+  assert(exp == odim && "Invalid output dimensions");
+  auto filterDims = N->getFilter().dims();
+  (void)filterDims;
+  assert((filterDims.size() == 4 ||
+          (filterDims.size() == 5 && filterDims[4] == 8)) &&
+         "Invalid filter dimensions");
+  assert(N->getInput().getElementType() == ElemKind::FloatTy &&
+         N->getFilter().getElementType() == ElemKind::FloatTy &&
+         N->getResult().getElementType() == ElemKind::FloatTy &&
+         "Only float convolutions are supported");
+  assert(N->getClampMin() <= N->getClampMax() && "Invalid clamp range");
+}
+
+void CPUFusedConvNode::verify() const { verifyCPUFusedConv(this); }
+
+void CPUFusedConvAddNode::verify() const {
+  verifyCPUFusedConv(this);
+  assert(getResidual().getType() == getResult().getType() &&
+         "Invalid residual type");
+}
+
+void CPUFusedMatMulNode::verify() const {
+  auto lhs = getLHS().dims();
+  auto rhs = getRHS().dims();
+  auto dest = getResult().dims();
+  (void)lhs;
+  (void)rhs;
+  (void)dest;
+  assert(lhs.size() == 2 && rhs.size() == 2 && dest.size() == 2 &&
+         "Invalid matrix dimensions");
+  assert(lhs[0] == dest[0] && lhs[1] == rhs[0] && rhs[1] == dest[1] &&
+         "Invalid matrix dimensions");
+  assert(getBias().dims().size() == 1 && getBias().dims()[0] == dest[1] &&
+         "Invalid bias dimensions");
+  assert(getResult().getElementType() == ElemKind::FloatTy &&
+         "Only float matrix multiplications are supported");
+  assert(getClampMin() <= getClampMax() && "Invalid clamp range");
+}
+
 #endif // GLOW_WITH_CPU
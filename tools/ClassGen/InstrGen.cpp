@@ -208,6 +208,41 @@ int main(int argc, char **argv) {
                   {"Lengths", "ElemKind::Int64ITy"})
       .autoVerify(VerifyKind::SameShape, {"Weights", "Indices"});
 
+  BB.newInstr("RowwiseQuantizedSparseLengthsWeightedSum")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Data", OperandKind::In)
+      .addOperand("Scales", OperandKind::In)
+      .addOperand("Offsets", OperandKind::In)
+      .addOperand("Weights", OperandKind::In)
+      .addOperand("Indices", OperandKind::In)
+      .addOperand("Lengths", OperandKind::In)
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType, {"Data", "ElemKind::Int8QTy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Dest", "Scales", "Offsets", "Weights"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Indices", "ElemKind::Int64ITy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Lengths", "ElemKind::Int64ITy"})
+      .autoVerify(VerifyKind::SameShape, {"Weights", "Indices"})
+      .autoVerify(VerifyKind::SameShape, {"Scales", "Offsets"});
+
+  BB.newInstr("FusedRowwiseQuantizedSparseLengthsWeightedSum")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Data", OperandKind::In)
+      .addOperand("Weights", OperandKind::In)
+      .addOperand("Indices", OperandKind::In)
+      .addOperand("Lengths", OperandKind::In)
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Data", "ElemKind::UInt8FusedQTy"})
+      .autoVerify(VerifyKind::SameElementType, {"Dest", "Weights"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Indices", "ElemKind::Int64ITy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Lengths", "ElemKind::Int64ITy"})
+      .autoVerify(VerifyKind::SameShape, {"Weights", "Indices"});
+
   /// Adds the 'Slice' operand to each one of the slices in the batch.
   BB.newInstr("BatchedAdd")
       .addOperand("Dest", OperandKind::Out)
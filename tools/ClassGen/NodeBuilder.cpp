@@ -372,6 +372,32 @@ void NodeBuilder::emitHasher(std::ostream &os) const {
 
   os << ");\n}\n";
 }
+
+void NodeBuilder::emitMembersDigest(std::ostream &os) const {
+  os << "\nvoid " << name_
+     << "Node::updateMembersDigest(llvm::SHA1 &hasher) const {\n"
+     << "  updateDigest(hasher, uint64_t(getKind()));\n";
+
+  if (!enum_.empty()) {
+    os << "  updateDigest(hasher, uint64_t(getMode()));\n";
+  }
+
+  for (const auto &mem : members_) {
+    auto ty = mem.first;
+    // The operands are added by the users of this method.
+    if (ty == MemberType::VectorNodeValue) {
+      continue;
+    }
+    if (ty == MemberType::Unsigned || ty == MemberType::Boolean) {
+      os << "  updateDigest(hasher, uint64_t(get" << mem.second << "()));\n";
+    } else {
+      os << "  updateDigest(hasher, get" << mem.second << "());\n";
+    }
+  }
+
+  os << "}\n";
+}
+
 void NodeBuilder::emitVisitor(std::ostream &os) const {
   os << "\nvoid " << name_
      << "Node::visit(Node *parent, NodeWalker *visitor) {\n"
@@ -425,6 +451,7 @@ void NodeBuilder::emitNodeClass(std::ostream &os) const {
      << "  std::string getDebugDesc() const;\n"
      << "  bool isEqual(const " << name_ << "Node &other) const;\n"
      << "  llvm::hash_code getHash() const;\n"
+     << "  void updateMembersDigest(llvm::SHA1 &hasher) const;\n"
      << "  void visit(Node *parent, NodeWalker *visitor);\n"
      << "  Node* clone() const;\n"
      << "  void verify() const;\n";
@@ -448,6 +475,7 @@ void NodeBuilder::emitCppMethods(std::ostream &os) const {
   emitEquator(os);
   emitCloner(os);
   emitHasher(os);
+  emitMembersDigest(os);
   if (!enum_.empty()) {
     emitEnumModePrinters(os);
   }
@@ -183,6 +183,10 @@ private:
   /// Emit the getHash method that computes a hash of a node.
   void emitHasher(std::ostream &os) const;
 
+  /// Emit the updateMembersDigest method that adds the members of a node,
+  /// without its operands, to a digest.
+  void emitMembersDigest(std::ostream &os) const;
+
   /// Emit the 'visit' method that implements node visitors.
   void emitVisitor(std::ostream &os) const;
 
@@ -301,6 +301,32 @@ int main(int argc, char **argv) {
                     "Weights[0] * Slice(0) + Weights[1] * Slice(1) + ... "
                     "It implies that len(Weights) == len(Indices).");
 
+  BB.newNode("RowwiseQuantizedSparseLengthsWeightedSum")
+      .addInput("Data")
+      .addInput("Scales")
+      .addInput("Offsets")
+      .addInput("Weights")
+      .addInput("Indices")
+      .addInput("Lengths")
+      .addResultFromCtorArg()
+      .setDocstring("Same as SparseLengthsWeightedSum, but Data is quantized "
+                    "to int8 row by row: the i-th row of Data is dequantized "
+                    "as Data[i] * Scales[i] + Offsets[i] before it is "
+                    "scaled by its weight and aggregated. The result is in "
+                    "float.");
+
+  BB.newNode("FusedRowwiseQuantizedSparseLengthsWeightedSum")
+      .addInput("Data")
+      .addInput("Weights")
+      .addInput("Indices")
+      .addInput("Lengths")
+      .addResultFromCtorArg()
+      .setDocstring("Same as RowwiseQuantizedSparseLengthsWeightedSum, but "
+                    "the scale and the offset of each row are stored in the "
+                    "last 8 bytes of the row of Data, whose element type is "
+                    "UInt8FusedQTy. The rows of the result are 8 elements "
+                    "shorter than the rows of Data.");
+
   //===--------------------------------------------------------------------===//
   //                Non-linearities
   //===--------------------------------------------------------------------===//